@@ -97,6 +97,15 @@ public:
         UpdateCameraVectors();
     }
 
+    // 直接设置位置和朝向（脚本化的相机路径使用）
+    void SetPose(const glm::vec3& position, float yaw, float pitch)
+    {
+        Position = position;
+        Yaw = yaw;
+        Pitch = pitch;
+        UpdateCameraVectors();
+    }
+
     // Scroll Scale
     void ProcessMouseScroll(float yoffset)
     {
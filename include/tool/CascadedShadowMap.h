@@ -0,0 +1,232 @@
+#pragma once
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <tool/Shader.h>
+
+#include <string>
+#include <vector>
+#include <cmath>
+#include <algorithm>
+
+// 平行光的级联阴影（27-ShadowMapping-2-RenderShadow）
+// 1. 相机视锥体（近平面到 ShadowDistance）按 practical split scheme 分成若干段：
+//    split_i = λ * n * (f / n)^(i / N) + (1 - λ) * (n + (f - n) * i / N)，λ 在对数划分和均匀划分之间插值
+// 2. 每一段用包围球拟合正交投影，包围球的大小只和视锥体形状有关，相机旋转时阴影贴图的覆盖范围不变；
+//    球心在光源空间中对齐到 texel 网格，相机移动时阴影边缘不会闪烁
+// 3. 所有级联放在一张 GL_TEXTURE_2D_ARRAY 深度纹理中，每层一个级联，比较模式打开，着色器用 sampler2DArrayShadow 做硬件 PCF
+// 4. 正交投影的近平面只包住包围球，包围球和光源之间的投射体用 GL_DEPTH_CLAMP 压到近平面上（pancaking），
+//    所以每个级联的投射体剔除只需要测试光源空间的 xy 范围和远平面
+//
+// 着色器一侧的 uniform（csm.fs）：
+//   sampler2DArrayShadow shadowMap; mat4 lightSpaceMatrices[]; float cascadeSplits[]; float cascadeTexelSizes[]; int cascadeCount;
+
+class CascadedShadowMap
+{
+public:
+    static const unsigned int MaxCascades = 4u;
+
+    // 光照着色器中级联 uniform 的句柄，着色器创建之后用 GetUniforms 解析一次，每帧 Bind 时不再拼接和查找名字
+    struct Uniforms
+    {
+        UniformHandle ShadowMap;
+        UniformHandle CascadeCount;
+        UniformHandle LightSpaceMatrices[MaxCascades];
+        UniformHandle CascadeSplits[MaxCascades];
+        UniformHandle CascadeTexelSizes[MaxCascades];
+    };
+
+    static Uniforms GetUniforms(const Shader& shader)
+    {
+        Uniforms uniforms;
+        uniforms.ShadowMap = shader.GetUniform("shadowMap");
+        uniforms.CascadeCount = shader.GetUniform("cascadeCount");
+        for (unsigned int i = 0; i < MaxCascades; i++)
+        {
+            std::string index = "[" + std::to_string(i) + "]";
+            uniforms.LightSpaceMatrices[i] = shader.GetUniform("lightSpaceMatrices" + index);
+            uniforms.CascadeSplits[i] = shader.GetUniform("cascadeSplits" + index);
+            uniforms.CascadeTexelSizes[i] = shader.GetUniform("cascadeTexelSizes" + index);
+        }
+        return uniforms;
+    }
+
+    CascadedShadowMap(unsigned int resolution = 2048u, unsigned int cascadeCount = 4u)
+        :
+        Resolution(resolution),
+        CascadeCount(std::min(std::max(cascadeCount, 1u), MaxCascades))
+    {
+        glGenTextures(1, &DepthArray);
+        glBindTexture(GL_TEXTURE_2D_ARRAY, DepthArray);
+        glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_DEPTH_COMPONENT24, Resolution, Resolution, CascadeCount, 0, GL_DEPTH_COMPONENT, GL_FLOAT, NULL);
+        // 硬件 PCF：比较之后再做双线性过滤
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_COMPARE_MODE, GL_COMPARE_REF_TO_TEXTURE);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_COMPARE_FUNC, GL_LEQUAL);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_BORDER);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_BORDER);
+        GLfloat borderColor[] = { 1.0f, 1.0f, 1.0f, 1.0f };
+        glTexParameterfv(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_BORDER_COLOR, borderColor);
+
+        glGenFramebuffers(1, &FBO);
+        glBindFramebuffer(GL_FRAMEBUFFER, FBO);
+        glFramebufferTextureLayer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, DepthArray, 0, 0);
+        // 不需要使用颜色数据
+        glDrawBuffer(GL_NONE);
+        glReadBuffer(GL_NONE);
+        if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+            std::cout << "Cascaded shadow map framebuffer not complete!" << std::endl;
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    }
+
+    void Destroy()
+    {
+        glDeleteTextures(1, &DepthArray);
+        glDeleteFramebuffers(1, &FBO);
+        DepthArray = FBO = 0;
+    }
+
+    // λ = 1 完全按对数划分（近处分辨率最高），λ = 0 均匀划分
+    inline void SetSplitLambda(float lambda) { SplitLambda = lambda; }
+    inline void SetShadowDistance(float distance) { ShadowDistance = distance; }
+
+    // 每帧更新级联：相机的视图矩阵和透视参数（fovY 为角度），lightDirection 是光线照射的方向（从光源指向场景）
+    void Update(const glm::mat4& view, float fovY, float aspect, float nearPlane, const glm::vec3& lightDirection)
+    {
+        glm::mat4 inverseView = glm::inverse(view);
+        float tanHalfY = std::tan(glm::radians(fovY) * 0.5f);
+        float tanHalfX = tanHalfY * aspect;
+        float farPlane = std::max(ShadowDistance, nearPlane + 0.01f);
+
+        // 光源空间只旋转不平移，texel 对齐在这个固定的坐标系中进行
+        glm::vec3 direction = glm::normalize(lightDirection);
+        glm::vec3 up = std::abs(direction.y) > 0.99f ? glm::vec3(0.0f, 0.0f, 1.0f) : glm::vec3(0.0f, 1.0f, 0.0f);
+        LightRotation = glm::lookAt(glm::vec3(0.0f), direction, up);
+
+        float previousSplit = nearPlane;
+        for (unsigned int i = 0; i < CascadeCount; i++)
+        {
+            float t = static_cast<float>(i + 1) / static_cast<float>(CascadeCount);
+            float logSplit = nearPlane * std::pow(farPlane / nearPlane, t);
+            float uniformSplit = nearPlane + (farPlane - nearPlane) * t;
+            float split = SplitLambda * logSplit + (1.0f - SplitLambda) * uniformSplit;
+
+            // 这一段视锥体的 8 个角点（世界空间）
+            glm::vec3 corners[8];
+            float depths[2] = { previousSplit, split };
+            for (int d = 0; d < 2; d++)
+                for (int y = 0; y < 2; y++)
+                    for (int x = 0; x < 2; x++)
+                    {
+                        glm::vec4 viewCorner((x ? 1.0f : -1.0f) * tanHalfX * depths[d], (y ? 1.0f : -1.0f) * tanHalfY * depths[d], -depths[d], 1.0f);
+                        corners[d * 4 + y * 2 + x] = glm::vec3(inverseView * viewCorner);
+                    }
+
+            // 包围球：球心是角点的平均值，半径向上取整到 1/16，避免浮点误差让大小每帧抖动
+            glm::vec3 center(0.0f);
+            for (const glm::vec3& corner : corners)
+                center += corner;
+            center /= 8.0f;
+            float radius = 0.0f;
+            for (const glm::vec3& corner : corners)
+                radius = std::max(radius, glm::length(corner - center));
+            radius = std::ceil(radius * 16.0f) / 16.0f;
+
+            // 球心对齐到 texel 网格
+            float texelSize = 2.0f * radius / static_cast<float>(Resolution);
+            glm::vec3 lightCenter = glm::vec3(LightRotation * glm::vec4(center, 1.0f));
+            lightCenter.x = std::floor(lightCenter.x / texelSize) * texelSize;
+            lightCenter.y = std::floor(lightCenter.y / texelSize) * texelSize;
+
+            Cascade& cascade = Cascades[i];
+            cascade.SplitDepth = split;
+            cascade.TexelSize = texelSize;
+            cascade.LightMin = glm::vec3(lightCenter.x - radius, lightCenter.y - radius, lightCenter.z - radius);
+            cascade.LightMax = glm::vec3(lightCenter.x + radius, lightCenter.y + radius, lightCenter.z + radius);
+            // 光源看向 -Z，近平面是离光源最近的 z = LightMax.z
+            glm::mat4 projection = glm::ortho(cascade.LightMin.x, cascade.LightMax.x, cascade.LightMin.y, cascade.LightMax.y, -cascade.LightMax.z, -cascade.LightMin.z);
+            cascade.LightSpaceMatrix = projection * LightRotation;
+            previousSplit = split;
+        }
+    }
+
+    // 投射体（世界空间 AABB）是否需要画进第 cascade 个级联
+    // 比远平面更远的（完全在包围球后面）和 xy 范围之外的剔除，近平面之前的保留（深度被钳制到近平面）
+    bool IsCasterVisible(unsigned int cascade, const glm::vec3& worldMin, const glm::vec3& worldMax) const
+    {
+        glm::vec3 center = (worldMin + worldMax) * 0.5f;
+        glm::vec3 extent = (worldMax - worldMin) * 0.5f;
+        glm::vec3 lightCenter = glm::vec3(LightRotation * glm::vec4(center, 1.0f));
+        glm::mat3 rotation = glm::mat3(LightRotation);
+        glm::vec3 lightExtent;
+        for (int r = 0; r < 3; r++)
+            lightExtent[r] = std::abs(rotation[0][r]) * extent.x + std::abs(rotation[1][r]) * extent.y + std::abs(rotation[2][r]) * extent.z;
+        const Cascade& c = Cascades[cascade];
+        return lightCenter.x + lightExtent.x >= c.LightMin.x && lightCenter.x - lightExtent.x <= c.LightMax.x
+            && lightCenter.y + lightExtent.y >= c.LightMin.y && lightCenter.y - lightExtent.y <= c.LightMax.y
+            && lightCenter.z + lightExtent.z >= c.LightMin.z;
+    }
+
+    // 开始渲染第 cascade 个级联：绑定对应的层、设置视口、清空深度、打开深度钳制和多边形偏移
+    void BeginCascade(unsigned int cascade)
+    {
+        glBindFramebuffer(GL_FRAMEBUFFER, FBO);
+        glFramebufferTextureLayer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, DepthArray, 0, static_cast<GLint>(cascade));
+        glViewport(0, 0, Resolution, Resolution);
+        glClear(GL_DEPTH_BUFFER_BIT);
+        glEnable(GL_DEPTH_CLAMP);
+        glEnable(GL_POLYGON_OFFSET_FILL);
+        glPolygonOffset(1.5f, 2.0f);
+    }
+
+    void End()
+    {
+        glDisable(GL_POLYGON_OFFSET_FILL);
+        glDisable(GL_DEPTH_CLAMP);
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    }
+
+    // 设置光照着色器的级联 uniform（uniforms 来自同一个着色器的 GetUniforms），阴影纹理绑定到 textureUnit
+    void Bind(const Shader& shader, const Uniforms& uniforms, unsigned int textureUnit) const
+    {
+        shader.SetInt(uniforms.ShadowMap, static_cast<int>(textureUnit));
+        shader.SetInt(uniforms.CascadeCount, static_cast<int>(CascadeCount));
+        for (unsigned int i = 0; i < CascadeCount; i++)
+        {
+            shader.SetMat4f(uniforms.LightSpaceMatrices[i], Cascades[i].LightSpaceMatrix);
+            shader.SetFloat(uniforms.CascadeSplits[i], Cascades[i].SplitDepth);
+            shader.SetFloat(uniforms.CascadeTexelSizes[i], Cascades[i].TexelSize);
+        }
+        glActiveTexture(GL_TEXTURE0 + textureUnit);
+        glBindTexture(GL_TEXTURE_2D_ARRAY, DepthArray);
+    }
+
+    inline unsigned int GetCascadeCount() const { return CascadeCount; }
+    inline unsigned int GetResolution() const { return Resolution; }
+    inline unsigned int GetTexture() const { return DepthArray; }
+    inline const glm::mat4& GetLightSpaceMatrix(unsigned int cascade) const { return Cascades[cascade].LightSpaceMatrix; }
+    inline float GetSplitDepth(unsigned int cascade) const { return Cascades[cascade].SplitDepth; }
+    // 每个 texel 覆盖的世界空间宽度
+    inline float GetTexelSize(unsigned int cascade) const { return Cascades[cascade].TexelSize; }
+
+private:
+    struct Cascade
+    {
+        glm::mat4 LightSpaceMatrix = glm::mat4(1.0f);
+        glm::vec3 LightMin = glm::vec3(0.0f);   // 光源空间（只旋转）中的正交投影范围
+        glm::vec3 LightMax = glm::vec3(0.0f);
+        float SplitDepth = 0.0f;                // 这一段的远端（观察空间深度）
+        float TexelSize = 0.0f;
+    };
+
+    unsigned int Resolution;
+    unsigned int CascadeCount;
+    float SplitLambda = 0.75f;
+    float ShadowDistance = 50.0f;
+    unsigned int DepthArray = 0;
+    unsigned int FBO = 0;
+    glm::mat4 LightRotation = glm::mat4(1.0f);
+    Cascade Cascades[MaxCascades];
+};
@@ -0,0 +1,545 @@
+#pragma once
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+#include <glm/glm.hpp>
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <cmath>
+#include <cstdint>
+#include <algorithm>
+
+#include <tool/JobSystem.h>
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#include <xmmintrin.h>
+#define CLUSTERED_LIGHTS_SSE 1
+#endif
+
+// 分簇光照（clustered shading）的光源分配
+// 1. 把视锥体按屏幕划分成 TileCountX * TileCountY 个格子，深度方向按指数划分成 SliceCount 层，每个小块（froxel）是一个簇
+// 2. 每帧把光源（包围球）分配到和它相交的簇，得到每个簇的光源列表
+// 3. 光照着色器根据像素所在的簇只计算列表中的光源，而不是全部光源
+//
+// 光源分配有两条路径：
+// 1. CPU：每个光源先算出投影后覆盖的簇范围，再在范围内逐个测试包围球和簇的 AABB（SSE 一次测试 4 个簇），
+//    每个深度层一个任务，交给 JobSystem 并行
+// 2. compute shader（需要 GL 4.3，glad 只生成了 3.3 core，相关函数通过 glfwGetProcAddress 手动加载）：
+//    每个工作组处理一层，每个线程处理一个簇，光源分批读入共享内存
+//
+// 结果放在三个缓冲纹理（GL_TEXTURE_BUFFER，3.3 core 就有）中，片段着色器用 texelFetch 读取：
+//   lightData    RGBA32F：每个光源两个 texel，(世界空间位置, 半径)、(颜色, 二次衰减系数)
+//   lightGrid    RG32UI ：每个簇一个 texel，(在 lightIndices 中的偏移, 数量)
+//   lightIndices R32UI  ：所有簇的光源下标连续存放
+// compute 路径把同样的缓冲绑定成 SSBO 写入，片段着色器不需要改。着色器中的常量要和这里一致。
+
+#ifndef GL_COMPUTE_SHADER
+#define GL_COMPUTE_SHADER 0x91B9
+#endif
+#ifndef GL_SHADER_STORAGE_BUFFER
+#define GL_SHADER_STORAGE_BUFFER 0x90D2
+#endif
+#ifndef GL_SHADER_STORAGE_BARRIER_BIT
+#define GL_SHADER_STORAGE_BARRIER_BIT 0x00002000
+#endif
+#ifndef GL_TEXTURE_FETCH_BARRIER_BIT
+#define GL_TEXTURE_FETCH_BARRIER_BIT 0x00000008
+#endif
+
+// 和 lightData 中的两个 texel 一一对应
+struct ClusterLight
+{
+    glm::vec3 Position;
+    float Radius;
+    glm::vec3 Color;
+    float Quadratic;
+};
+static_assert(sizeof(ClusterLight) == 32, "ClusterLight must match two RGBA32F texels");
+
+class ClusteredLights
+{
+public:
+    static const unsigned int TileCountX = 16u;
+    static const unsigned int TileCountY = 9u;
+    static const unsigned int SliceCount = 24u;
+    static const unsigned int ClusterCount = TileCountX * TileCountY * SliceCount;
+    // compute 路径的光源下标缓冲大小固定，平均每个簇最多 128 个光源，超出的部分被丢弃
+    static const unsigned int ComputeIndexCapacity = ClusterCount * 128u;
+    static_assert(TileCountX % 4u == 0u, "SSE path tests 4 clusters of a row at once");
+
+    struct CullStats
+    {
+        unsigned int VisibleLights = 0u;
+        unsigned int IndexCount = 0u;
+        unsigned int MaxPerCluster = 0u;
+        unsigned int NonEmptyClusters = 0u;
+    };
+
+    // jobs 为空时在当前线程完成全部计算
+    ClusteredLights(JobSystem* jobs = nullptr)
+        :
+        Jobs(jobs),
+        Grid(ClusterCount, glm::uvec2(0u)),
+        SliceCandidates(SliceCount),
+        SliceLists(SliceCount, std::vector<std::vector<unsigned int>>(TileCountX * TileCountY))
+    {
+        for (std::vector<float>* bounds : { &MinX, &MinY, &MinZ, &MaxX, &MaxY, &MaxZ })
+            bounds->resize(ClusterCount);
+    }
+
+    ClusteredLights(const ClusteredLights&) = delete;
+    ClusteredLights& operator=(const ClusteredLights&) = delete;
+
+    // 投影参数改变时（比如滚轮缩放 fov）重新计算簇的观察空间 AABB，参数不变时直接返回
+    void SetProjection(float fovY, float aspect, float nearPlane, float farPlane)
+    {
+        if (fovY == FovY && aspect == Aspect && nearPlane == Near && farPlane == Far)
+            return;
+        FovY = fovY;
+        Aspect = aspect;
+        Near = nearPlane;
+        Far = farPlane;
+        TanHalfY = std::tan(fovY * 0.5f);
+        TanHalfX = TanHalfY * aspect;
+        SliceScale = static_cast<float>(SliceCount) / std::log(farPlane / nearPlane);
+
+        // 观察空间中相机看向 -Z，这里的 Z 统一用正的深度
+        for (unsigned int s = 0; s < SliceCount; s++)
+        {
+            float zNear = SliceDepth(s);
+            float zFar = SliceDepth(s + 1u);
+            for (unsigned int y = 0; y < TileCountY; y++)
+            {
+                float y0 = (-1.0f + 2.0f * y / TileCountY) * TanHalfY;
+                float y1 = (-1.0f + 2.0f * (y + 1u) / TileCountY) * TanHalfY;
+                for (unsigned int x = 0; x < TileCountX; x++)
+                {
+                    float x0 = (-1.0f + 2.0f * x / TileCountX) * TanHalfX;
+                    float x1 = (-1.0f + 2.0f * (x + 1u) / TileCountX) * TanHalfX;
+                    unsigned int cluster = GetClusterIndex(x, y, s);
+                    MinX[cluster] = std::min(x0 * zNear, x0 * zFar);
+                    MaxX[cluster] = std::max(x1 * zNear, x1 * zFar);
+                    MinY[cluster] = std::min(y0 * zNear, y0 * zFar);
+                    MaxY[cluster] = std::max(y1 * zNear, y1 * zFar);
+                    MinZ[cluster] = zNear;
+                    MaxZ[cluster] = zFar;
+                }
+            }
+        }
+    }
+
+    // CPU 路径：把光源分配到簇，结果在 GetGrid / GetIndices 中，useSimd 为 false 时使用标量测试（用于对比和验证）
+    void Cull(const std::vector<ClusterLight>& lights, const glm::mat4& view, bool useSimd = true)
+    {
+        unsigned int lightCount = static_cast<unsigned int>(lights.size());
+        Bounds.resize(lightCount);
+
+        // 1. 光源变换到观察空间，算出覆盖的簇范围
+        ForEach(lightCount, 256u, [&](unsigned int first, unsigned int last)
+        {
+            for (unsigned int i = first; i < last; i++)
+                Bounds[i] = ComputeBounds(lights[i], view);
+        });
+
+        // 2. 按深度层分桶，每层只需要看覆盖到它的光源
+        for (std::vector<unsigned int>& candidates : SliceCandidates)
+            candidates.clear();
+        for (unsigned int i = 0; i < lightCount; i++)
+        {
+            if (Bounds[i].bVisible)
+                for (unsigned int s = Bounds[i].MinZ; s <= Bounds[i].MaxZ; s++)
+                    SliceCandidates[s].push_back(i);
+        }
+
+        // 3. 每个深度层独立地测试，写到自己的列表中
+        ForEach(SliceCount, 1u, [&](unsigned int first, unsigned int last)
+        {
+            for (unsigned int s = first; s < last; s++)
+                CullSlice(s, useSimd);
+        });
+
+        // 4. 合并成连续的下标数组
+        Stats = CullStats();
+        size_t total = 0;
+        for (const auto& slice : SliceLists)
+            for (const auto& list : slice)
+                total += list.size();
+        Indices.resize(total);
+        unsigned int offset = 0u;
+        for (unsigned int s = 0; s < SliceCount; s++)
+        {
+            for (unsigned int tile = 0; tile < TileCountX * TileCountY; tile++)
+            {
+                const std::vector<unsigned int>& list = SliceLists[s][tile];
+                unsigned int count = static_cast<unsigned int>(list.size());
+                Grid[s * TileCountX * TileCountY + tile] = glm::uvec2(offset, count);
+                std::copy(list.begin(), list.end(), Indices.begin() + offset);
+                offset += count;
+                Stats.MaxPerCluster = std::max(Stats.MaxPerCluster, count);
+                Stats.NonEmptyClusters += count > 0u ? 1u : 0u;
+            }
+        }
+        Stats.IndexCount = offset;
+        for (const LightBounds& bounds : Bounds)
+            Stats.VisibleLights += bounds.bVisible ? 1u : 0u;
+    }
+
+    // 不做任何范围裁剪，逐个测试所有光源和所有簇（只用于验证 Cull 的结果）
+    bool IntersectsCluster(const ClusterLight& light, const glm::mat4& view, unsigned int cluster) const
+    {
+        glm::vec3 center = glm::vec3(view * glm::vec4(light.Position, 1.0f));
+        return SphereIntersectsCluster(center.x, center.y, -center.z, light.Radius, cluster);
+    }
+
+    inline const std::vector<glm::uvec2>& GetGrid() const { return Grid; }
+    inline const std::vector<unsigned int>& GetIndices() const { return Indices; }
+    // 只统计 CPU 路径（Cull）的结果，compute 路径的结果留在 GPU 上不读回，CullCompute 之后全部为 0
+    inline const CullStats& GetStats() const { return Stats; }
+    // 着色器计算深度层：slice = floor(log(depth / clusterNear) * clusterSliceScale)
+    inline float GetNear() const { return Near; }
+    inline float GetSliceScale() const { return SliceScale; }
+
+    static inline unsigned int GetClusterIndex(unsigned int x, unsigned int y, unsigned int slice)
+    {
+        return (slice * TileCountY + y) * TileCountX + x;
+    }
+
+    // 上传光源数据（两条路径都需要）
+    void UploadLights(const std::vector<ClusterLight>& lights)
+    {
+        CreateBuffers();
+        glBindBuffer(GL_TEXTURE_BUFFER, LightBuffer);
+        GLsizeiptr size = static_cast<GLsizeiptr>(std::max<size_t>(lights.size(), 1u) * sizeof(ClusterLight));
+        // 先 orphan 再写，不等待上一帧还在读的数据
+        glBufferData(GL_TEXTURE_BUFFER, size, nullptr, GL_STREAM_DRAW);
+        if (!lights.empty())
+            glBufferSubData(GL_TEXTURE_BUFFER, 0, static_cast<GLsizeiptr>(lights.size() * sizeof(ClusterLight)), lights.data());
+        glBindBuffer(GL_TEXTURE_BUFFER, 0);
+        LightCount = static_cast<unsigned int>(lights.size());
+    }
+
+    // 上传 CPU 路径的结果
+    void UploadClusters()
+    {
+        CreateBuffers();
+        glBindBuffer(GL_TEXTURE_BUFFER, GridBuffer);
+        GridBufferSize = Grid.size() * sizeof(glm::uvec2);
+        glBufferData(GL_TEXTURE_BUFFER, static_cast<GLsizeiptr>(GridBufferSize), Grid.data(), GL_STREAM_DRAW);
+        glBindBuffer(GL_TEXTURE_BUFFER, IndexBuffer);
+        IndexBufferSize = std::max<size_t>(Indices.size(), 1u) * sizeof(unsigned int);
+        glBufferData(GL_TEXTURE_BUFFER, static_cast<GLsizeiptr>(IndexBufferSize), nullptr, GL_STREAM_DRAW);
+        if (!Indices.empty())
+            glBufferSubData(GL_TEXTURE_BUFFER, 0, static_cast<GLsizeiptr>(Indices.size() * sizeof(unsigned int)), Indices.data());
+        glBindBuffer(GL_TEXTURE_BUFFER, 0);
+    }
+
+    // 编译 compute shader，驱动不支持时返回 false（继续使用 CPU 路径）
+    bool InitCompute(const char* computeShaderPath)
+    {
+        GLint major = 0, minor = 0;
+        glGetIntegerv(GL_MAJOR_VERSION, &major);
+        glGetIntegerv(GL_MINOR_VERSION, &minor);
+        bool bSupported = major > 4 || (major == 4 && minor >= 3)
+            || (glfwExtensionSupported("GL_ARB_compute_shader") && glfwExtensionSupported("GL_ARB_shader_storage_buffer_object"));
+        if (!bSupported)
+            return false;
+        DispatchCompute = reinterpret_cast<DispatchComputeProc>(glfwGetProcAddress("glDispatchCompute"));
+        MemoryBarrierFunction = reinterpret_cast<MemoryBarrierProc>(glfwGetProcAddress("glMemoryBarrier"));
+        if (DispatchCompute == nullptr || MemoryBarrierFunction == nullptr)
+            return false;
+
+        std::ifstream file(computeShaderPath);
+        if (!file)
+        {
+            std::cout << "[CLUSTERED LIGHTS ERROR]: Failed to read compute shader: " << computeShaderPath << std::endl;
+            return false;
+        }
+        std::stringstream stream;
+        stream << file.rdbuf();
+        std::string code = stream.str();
+        const char* source = code.c_str();
+
+        unsigned int shader = glCreateShader(GL_COMPUTE_SHADER);
+        glShaderSource(shader, 1, &source, nullptr);
+        glCompileShader(shader);
+        int success = 0;
+        char infoLog[1024];
+        glGetShaderiv(shader, GL_COMPILE_STATUS, &success);
+        if (!success)
+        {
+            glGetShaderInfoLog(shader, sizeof(infoLog), nullptr, infoLog);
+            std::cout << "[CLUSTERED LIGHTS ERROR]: Compute shader compilation failed\n" << infoLog << std::endl;
+            glDeleteShader(shader);
+            return false;
+        }
+        ComputeProgram = glCreateProgram();
+        glAttachShader(ComputeProgram, shader);
+        glLinkProgram(ComputeProgram);
+        glDeleteShader(shader);
+        glGetProgramiv(ComputeProgram, GL_LINK_STATUS, &success);
+        if (!success)
+        {
+            glGetProgramInfoLog(ComputeProgram, sizeof(infoLog), nullptr, infoLog);
+            std::cout << "[CLUSTERED LIGHTS ERROR]: Compute program linking failed\n" << infoLog << std::endl;
+            glDeleteProgram(ComputeProgram);
+            ComputeProgram = 0;
+            return false;
+        }
+        CreateBuffers();
+        return true;
+    }
+
+    inline bool HasCompute() const { return ComputeProgram != 0; }
+
+    // compute 路径：用 UploadLights 上传的光源在 GPU 上分配，之后的 texelFetch 能看到结果
+    void CullCompute(const glm::mat4& view)
+    {
+        if (ComputeProgram == 0)
+            return;
+        // 不保留上一次 CPU 路径的统计
+        Stats = CullStats();
+        glBindBuffer(GL_TEXTURE_BUFFER, GridBuffer);
+        if (GridBufferSize != ClusterCount * sizeof(glm::uvec2))
+        {
+            GridBufferSize = ClusterCount * sizeof(glm::uvec2);
+            glBufferData(GL_TEXTURE_BUFFER, static_cast<GLsizeiptr>(GridBufferSize), nullptr, GL_DYNAMIC_COPY);
+        }
+        glBindBuffer(GL_TEXTURE_BUFFER, IndexBuffer);
+        if (IndexBufferSize != ComputeIndexCapacity * sizeof(unsigned int))
+        {
+            IndexBufferSize = ComputeIndexCapacity * sizeof(unsigned int);
+            glBufferData(GL_TEXTURE_BUFFER, static_cast<GLsizeiptr>(IndexBufferSize), nullptr, GL_DYNAMIC_COPY);
+        }
+        glBindBuffer(GL_TEXTURE_BUFFER, 0);
+        // 全局下标计数器清零
+        unsigned int zero = 0u;
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, CounterBuffer);
+        glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, sizeof(zero), &zero);
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+        glUseProgram(ComputeProgram);
+        glUniformMatrix4fv(glGetUniformLocation(ComputeProgram, "view"), 1, GL_FALSE, &view[0][0]);
+        glUniform1i(glGetUniformLocation(ComputeProgram, "lightCount"), static_cast<int>(LightCount));
+        glUniform1f(glGetUniformLocation(ComputeProgram, "clusterNear"), Near);
+        glUniform1f(glGetUniformLocation(ComputeProgram, "clusterFar"), Far);
+        glUniform2f(glGetUniformLocation(ComputeProgram, "tanHalfFov"), TanHalfX, TanHalfY);
+        glUniform1ui(glGetUniformLocation(ComputeProgram, "indexCapacity"), ComputeIndexCapacity);
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, LightBuffer);
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, GridBuffer);
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, IndexBuffer);
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 3, CounterBuffer);
+        DispatchCompute(1u, 1u, SliceCount);
+        MemoryBarrierFunction(GL_TEXTURE_FETCH_BARRIER_BIT | GL_SHADER_STORAGE_BARRIER_BIT);
+        glUseProgram(0);
+    }
+
+    // 把 lightData / lightGrid / lightIndices 绑定到 firstUnit 开始的三个纹理单元
+    void Bind(unsigned int firstUnit) const
+    {
+        glActiveTexture(GL_TEXTURE0 + firstUnit);
+        glBindTexture(GL_TEXTURE_BUFFER, LightTexture);
+        glActiveTexture(GL_TEXTURE0 + firstUnit + 1u);
+        glBindTexture(GL_TEXTURE_BUFFER, GridTexture);
+        glActiveTexture(GL_TEXTURE0 + firstUnit + 2u);
+        glBindTexture(GL_TEXTURE_BUFFER, IndexTexture);
+        glActiveTexture(GL_TEXTURE0);
+    }
+
+    // 和 StreamBuffer 一样不在析构函数里调用 OpenGL
+    void Destroy()
+    {
+        if (LightBuffer == 0)
+            return;
+        unsigned int buffers[4] = { LightBuffer, GridBuffer, IndexBuffer, CounterBuffer };
+        unsigned int textures[3] = { LightTexture, GridTexture, IndexTexture };
+        glDeleteBuffers(4, buffers);
+        glDeleteTextures(3, textures);
+        if (ComputeProgram != 0)
+            glDeleteProgram(ComputeProgram);
+        LightBuffer = GridBuffer = IndexBuffer = CounterBuffer = 0;
+        LightTexture = GridTexture = IndexTexture = 0;
+        ComputeProgram = 0;
+    }
+
+private:
+    typedef void (APIENTRYP DispatchComputeProc)(GLuint x, GLuint y, GLuint z);
+    typedef void (APIENTRYP MemoryBarrierProc)(GLbitfield barriers);
+
+    // 观察空间包围球（z 为正的深度）和覆盖的簇范围
+    struct LightBounds
+    {
+        glm::vec4 Sphere;
+        unsigned int MinX, MaxX, MinY, MaxY, MinZ, MaxZ;
+        bool bVisible;
+    };
+
+    JobSystem* Jobs;
+
+    float FovY = 0.0f, Aspect = 0.0f, Near = 0.0f, Far = 0.0f;
+    float TanHalfX = 0.0f, TanHalfY = 0.0f, SliceScale = 0.0f;
+    // 簇的观察空间 AABB（SoA，同一行的 TileCountX 个簇连续存放）
+    std::vector<float> MinX, MinY, MinZ, MaxX, MaxY, MaxZ;
+
+    std::vector<LightBounds> Bounds;
+    std::vector<glm::uvec2> Grid;
+    std::vector<unsigned int> Indices;
+    // 每层覆盖到的光源、每层每个格子的光源列表，每帧清空但保留容量
+    std::vector<std::vector<unsigned int>> SliceCandidates;
+    std::vector<std::vector<std::vector<unsigned int>>> SliceLists;
+    CullStats Stats;
+
+    unsigned int LightCount = 0u;
+    unsigned int LightBuffer = 0, GridBuffer = 0, IndexBuffer = 0, CounterBuffer = 0;
+    unsigned int LightTexture = 0, GridTexture = 0, IndexTexture = 0;
+    size_t GridBufferSize = 0, IndexBufferSize = 0;
+    unsigned int ComputeProgram = 0;
+    DispatchComputeProc DispatchCompute = nullptr;
+    // Windows 头文件把 MemoryBarrier 定义成了宏，这里换个名字
+    MemoryBarrierProc MemoryBarrierFunction = nullptr;
+
+    template<typename Function>
+    void ForEach(unsigned int count, unsigned int grainSize, const Function& function)
+    {
+        if (Jobs != nullptr)
+            Jobs->ParallelFor(0u, count, grainSize, function);
+        else
+            function(0u, count);
+    }
+
+    inline float SliceDepth(unsigned int slice) const
+    {
+        return Near * std::pow(Far / Near, static_cast<float>(slice) / SliceCount);
+    }
+
+    inline unsigned int DepthToSlice(float depth) const
+    {
+        float slice = std::floor(std::log(depth / Near) * SliceScale);
+        return static_cast<unsigned int>(std::clamp(slice, 0.0f, static_cast<float>(SliceCount - 1u)));
+    }
+
+    // 把观察空间坐标范围变换到格子下标范围，low 取最小深度还是最大深度要保证结果偏保守
+    static inline bool TileRange(float low, float high, float nearDepth, float farDepth, float tanHalf, unsigned int tileCount, unsigned int& first, unsigned int& last)
+    {
+        float ndcLow = low / ((low < 0.0f ? nearDepth : farDepth) * tanHalf);
+        float ndcHigh = high / ((high > 0.0f ? nearDepth : farDepth) * tanHalf);
+        if (ndcHigh < -1.0f || ndcLow > 1.0f)
+            return false;
+        float scale = 0.5f * static_cast<float>(tileCount);
+        first = static_cast<unsigned int>(std::clamp(std::floor((ndcLow + 1.0f) * scale), 0.0f, static_cast<float>(tileCount - 1u)));
+        last = static_cast<unsigned int>(std::clamp(std::floor((ndcHigh + 1.0f) * scale), 0.0f, static_cast<float>(tileCount - 1u)));
+        return true;
+    }
+
+    LightBounds ComputeBounds(const ClusterLight& light, const glm::mat4& view) const
+    {
+        LightBounds bounds;
+        glm::vec3 center = glm::vec3(view * glm::vec4(light.Position, 1.0f));
+        float depth = -center.z;
+        float radius = light.Radius;
+        bounds.Sphere = glm::vec4(center.x, center.y, depth, radius);
+        bounds.bVisible = depth + radius > Near && depth - radius < Far;
+        if (!bounds.bVisible)
+            return bounds;
+        float nearDepth = std::max(depth - radius, Near);
+        float farDepth = std::min(depth + radius, Far);
+        bounds.bVisible = TileRange(center.x - radius, center.x + radius, nearDepth, farDepth, TanHalfX, TileCountX, bounds.MinX, bounds.MaxX)
+            && TileRange(center.y - radius, center.y + radius, nearDepth, farDepth, TanHalfY, TileCountY, bounds.MinY, bounds.MaxY);
+        bounds.MinZ = DepthToSlice(nearDepth);
+        bounds.MaxZ = DepthToSlice(farDepth);
+        return bounds;
+    }
+
+    // 包围球到 AABB 的距离平方不超过半径平方
+    inline bool SphereIntersectsCluster(float x, float y, float z, float radius, unsigned int cluster) const
+    {
+        float dx = std::max(MinX[cluster] - x, 0.0f) + std::max(x - MaxX[cluster], 0.0f);
+        float dy = std::max(MinY[cluster] - y, 0.0f) + std::max(y - MaxY[cluster], 0.0f);
+        float dz = std::max(MinZ[cluster] - z, 0.0f) + std::max(z - MaxZ[cluster], 0.0f);
+        return dx * dx + dy * dy + dz * dz <= radius * radius;
+    }
+
+    void CullSlice(unsigned int slice, bool useSimd)
+    {
+        std::vector<std::vector<unsigned int>>& lists = SliceLists[slice];
+        for (std::vector<unsigned int>& list : lists)
+            list.clear();
+
+        for (unsigned int i : SliceCandidates[slice])
+        {
+            const LightBounds& bounds = Bounds[i];
+            const glm::vec4& sphere = bounds.Sphere;
+            for (unsigned int y = bounds.MinY; y <= bounds.MaxY; y++)
+            {
+                unsigned int row = GetClusterIndex(0u, y, slice);
+                std::vector<unsigned int>* rowLists = &lists[y * TileCountX];
+#ifdef CLUSTERED_LIGHTS_SSE
+                if (useSimd)
+                {
+                    __m128 x = _mm_set1_ps(sphere.x), yy = _mm_set1_ps(sphere.y), z = _mm_set1_ps(sphere.z);
+                    __m128 radius2 = _mm_set1_ps(sphere.w * sphere.w);
+                    __m128 zero = _mm_setzero_ps();
+                    for (unsigned int group = bounds.MinX / 4u; group <= bounds.MaxX / 4u; group++)
+                    {
+                        unsigned int first = row + group * 4u;
+                        __m128 dx = _mm_add_ps(_mm_max_ps(_mm_sub_ps(_mm_loadu_ps(&MinX[first]), x), zero), _mm_max_ps(_mm_sub_ps(x, _mm_loadu_ps(&MaxX[first])), zero));
+                        __m128 dy = _mm_add_ps(_mm_max_ps(_mm_sub_ps(_mm_loadu_ps(&MinY[first]), yy), zero), _mm_max_ps(_mm_sub_ps(yy, _mm_loadu_ps(&MaxY[first])), zero));
+                        __m128 dz = _mm_add_ps(_mm_max_ps(_mm_sub_ps(_mm_loadu_ps(&MinZ[first]), z), zero), _mm_max_ps(_mm_sub_ps(z, _mm_loadu_ps(&MaxZ[first])), zero));
+                        __m128 distance2 = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)), _mm_mul_ps(dz, dz));
+                        int mask = _mm_movemask_ps(_mm_cmple_ps(distance2, radius2));
+                        for (unsigned int lane = 0; lane < 4u; lane++)
+                        {
+                            unsigned int tile = group * 4u + lane;
+                            if ((mask & (1 << lane)) && tile >= bounds.MinX && tile <= bounds.MaxX)
+                                rowLists[tile].push_back(i);
+                        }
+                    }
+                    continue;
+                }
+#endif
+                for (unsigned int x = bounds.MinX; x <= bounds.MaxX; x++)
+                {
+                    if (SphereIntersectsCluster(sphere.x, sphere.y, sphere.z, sphere.w, row + x))
+                        rowLists[x].push_back(i);
+                }
+            }
+        }
+    }
+
+    void CreateBuffers()
+    {
+        if (LightBuffer != 0)
+            return;
+        unsigned int buffers[4];
+        glGenBuffers(4, buffers);
+        LightBuffer = buffers[0];
+        GridBuffer = buffers[1];
+        IndexBuffer = buffers[2];
+        CounterBuffer = buffers[3];
+        // 先分配最小的存储，缓冲纹理要求缓冲对象已经有数据存储
+        for (unsigned int buffer : { LightBuffer, GridBuffer, IndexBuffer })
+        {
+            glBindBuffer(GL_TEXTURE_BUFFER, buffer);
+            glBufferData(GL_TEXTURE_BUFFER, 16, nullptr, GL_STREAM_DRAW);
+        }
+        glBindBuffer(GL_TEXTURE_BUFFER, 0);
+        glBindBuffer(GL_ARRAY_BUFFER, CounterBuffer);
+        glBufferData(GL_ARRAY_BUFFER, sizeof(unsigned int), nullptr, GL_DYNAMIC_COPY);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+        unsigned int textures[3];
+        glGenTextures(3, textures);
+        LightTexture = textures[0];
+        GridTexture = textures[1];
+        IndexTexture = textures[2];
+        glBindTexture(GL_TEXTURE_BUFFER, LightTexture);
+        glTexBuffer(GL_TEXTURE_BUFFER, GL_RGBA32F, LightBuffer);
+        glBindTexture(GL_TEXTURE_BUFFER, GridTexture);
+        glTexBuffer(GL_TEXTURE_BUFFER, GL_RG32UI, GridBuffer);
+        glBindTexture(GL_TEXTURE_BUFFER, IndexTexture);
+        glTexBuffer(GL_TEXTURE_BUFFER, GL_R32UI, IndexBuffer);
+        glBindTexture(GL_TEXTURE_BUFFER, 0);
+    }
+};
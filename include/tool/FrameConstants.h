@@ -0,0 +1,160 @@
+#pragma once
+#include <glad/glad.h>
+
+#include <iostream>
+#include <cstdint>
+#include <cstring>
+#include <algorithm>
+#include <glm/glm.hpp>
+
+#include <tool/StreamBuffer.h>
+
+// 每帧的常量数据（相机、光源、材质、每个物体的矩阵）分配器
+// 每帧从三重缓冲的 uniform buffer（StreamBuffer）中按 GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT 对齐切出一段段数据，
+// 用 glBindBufferRange 把某一段绑定到 uniform 块的绑定点，代替逐个 glUniform* 和每帧 glBufferSubData：
+// 1. 持久映射时 Allocate 直接返回映射的指针，整帧没有任何上传调用；不支持时退回到每帧一次
+//    glMapBufferRange(GL_MAP_UNSYNCHRONIZED_BIT)，这时 Submit 之后（解除映射）才能绘制
+// 2. 每帧结束时 EndFrame 插入 fence，3 帧之后再写同一段之前等待它（正常情况下不会等待）
+// 3. glBufferSubData 更新正在被之前的绘制使用的缓冲时，驱动要么等待 GPU，要么复制一份数据（重命名），每个物体一次就是一次复制
+// uniform 块使用 std140 布局，对应的 C++ 结构体只用 vec4 / mat4，不需要手动填充
+
+// 21-UniformBufferObject 的 Matrices 块加上相机位置
+struct CameraConstants
+{
+    glm::mat4 View;
+    glm::mat4 Projection;
+    glm::vec4 ViewPosition;
+};
+
+// 每个物体的矩阵（std140 的 mat3 每列按 vec4 对齐，法线矩阵直接用 mat4）
+struct ObjectConstants
+{
+    glm::mat4 Model;
+    glm::mat4 NormalMatrix;
+};
+
+struct FrameConstantSlice
+{
+    void* Data = nullptr;
+    // 在整个缓冲中的偏移，直接传给 glBindBufferRange
+    GLintptr Offset = 0;
+    GLsizeiptr Size = 0;
+
+    inline bool IsValid() const { return Size > 0; }
+};
+
+// 着色器里的 uniform 块连接到绑定点（GL 3.3 不能在 GLSL 里写 layout(binding = N)）
+inline void BindUniformBlock(unsigned int program, const char* blockName, unsigned int binding)
+{
+    unsigned int index = glGetUniformBlockIndex(program, blockName);
+    if (index != GL_INVALID_INDEX)
+        glUniformBlockBinding(program, index, binding);
+}
+
+inline size_t GetUniformBufferAlignment()
+{
+    GLint alignment = 256;
+    glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment);
+    return static_cast<size_t>(std::max(alignment, 1));
+}
+
+// count 个 size 字节的分配按对齐之后需要的容量
+inline size_t GetUniformAllocationSize(size_t size, size_t count = 1u)
+{
+    size_t alignment = GetUniformBufferAlignment();
+    return (size + alignment - 1u) / alignment * alignment * count;
+}
+
+class FrameConstantAllocator
+{
+public:
+    // frameCapacity 是每帧最多分配的字节数（包括对齐的空隙，用 GetUniformAllocationSize 计算）
+    explicit FrameConstantAllocator(size_t frameCapacity, unsigned int frameCount = 3u, bool allowPersistent = true)
+        :
+        Alignment(GetUniformBufferAlignment()),
+        Buffer(GL_UNIFORM_BUFFER, frameCapacity, frameCount, Alignment, allowPersistent)
+    {
+    }
+
+    FrameConstantAllocator(const FrameConstantAllocator&) = delete;
+    FrameConstantAllocator& operator=(const FrameConstantAllocator&) = delete;
+
+    void Destroy() { Buffer.Destroy(); }
+
+    void BeginFrame()
+    {
+        Mapped = static_cast<unsigned char*>(Buffer.Map());
+        Cursor = 0u;
+        Allocations = 0u;
+        Binds = 0u;
+    }
+
+    // 返回的 Data 只写，不要读
+    FrameConstantSlice Allocate(size_t size)
+    {
+        size_t offset = (Cursor + Alignment - 1u) / Alignment * Alignment;
+        if (Mapped == nullptr || offset + size > Buffer.GetRegionSize())
+        {
+            if (!bReportedOverflow)
+                std::cout << "[FRAME CONSTANTS ERROR]: " << (Mapped == nullptr ? "Allocate called outside BeginFrame/Submit" : "frame capacity exceeded") << std::endl;
+            bReportedOverflow = true;
+            return FrameConstantSlice();
+        }
+        Cursor = offset + size;
+        Allocations++;
+        FrameConstantSlice slice;
+        slice.Data = Mapped + offset;
+        slice.Offset = static_cast<GLintptr>(Buffer.GetOffset() + offset);
+        slice.Size = static_cast<GLsizeiptr>(size);
+        return slice;
+    }
+
+    template <typename T>
+    FrameConstantSlice Push(const T& value)
+    {
+        FrameConstantSlice slice = Allocate(sizeof(T));
+        if (slice.IsValid())
+            std::memcpy(slice.Data, &value, sizeof(T));
+        return slice;
+    }
+
+    // 这一帧的数据写完了：非持久映射时解除映射，之后才能用这些数据绘制
+    void Submit()
+    {
+        if (Mapped != nullptr)
+            Buffer.Unmap();
+        Mapped = nullptr;
+    }
+
+    void Bind(unsigned int binding, const FrameConstantSlice& slice)
+    {
+        if (!slice.IsValid())
+            return;
+        glBindBufferRange(GL_UNIFORM_BUFFER, binding, Buffer.GetID(), slice.Offset, slice.Size);
+        Binds++;
+    }
+
+    // 这一帧使用常量的绘制命令都已经发出
+    void EndFrame()
+    {
+        Submit();
+        Buffer.Fence();
+    }
+
+    inline size_t GetAlignment() const { return Alignment; }
+    inline size_t GetCapacity() const { return Buffer.GetRegionSize(); }
+    inline size_t GetUsedBytes() const { return Cursor; }
+    inline unsigned int GetAllocationCount() const { return Allocations; }
+    inline unsigned int GetBindCount() const { return Binds; }
+    inline bool IsPersistent() const { return Buffer.IsPersistent(); }
+    inline unsigned int GetStallCount() const { return Buffer.GetStallCount(); }
+
+private:
+    size_t Alignment;
+    StreamBuffer Buffer;
+    unsigned char* Mapped = nullptr;
+    size_t Cursor = 0u;
+    unsigned int Allocations = 0u;
+    unsigned int Binds = 0u;
+    bool bReportedOverflow = false;
+};
@@ -0,0 +1,56 @@
+#pragma once
+#include <glm/glm.hpp>
+
+// 视锥体：6 个平面（left, right, bottom, top, near, far），法线朝内
+// 平面方程 dot(n, p) + d >= 0 表示点 p 在平面内侧
+struct Frustum
+{
+    glm::vec4 Planes[6];
+
+    // 从 projection * view 矩阵中提取视锥体平面（Gribb-Hartmann），得到的是世界空间的平面
+    static Frustum FromMatrix(const glm::mat4& viewProjection)
+    {
+        // glm 是列主序，m[col][row]，这里取出每一行
+        glm::vec4 row0(viewProjection[0][0], viewProjection[1][0], viewProjection[2][0], viewProjection[3][0]);
+        glm::vec4 row1(viewProjection[0][1], viewProjection[1][1], viewProjection[2][1], viewProjection[3][1]);
+        glm::vec4 row2(viewProjection[0][2], viewProjection[1][2], viewProjection[2][2], viewProjection[3][2]);
+        glm::vec4 row3(viewProjection[0][3], viewProjection[1][3], viewProjection[2][3], viewProjection[3][3]);
+
+        Frustum frustum;
+        frustum.Planes[0] = row3 + row0;
+        frustum.Planes[1] = row3 - row0;
+        frustum.Planes[2] = row3 + row1;
+        frustum.Planes[3] = row3 - row1;
+        frustum.Planes[4] = row3 + row2;
+        frustum.Planes[5] = row3 - row2;
+        // 归一化之后 dot(n, p) + d 才是真正的距离，球体测试需要
+        for (glm::vec4& plane : frustum.Planes)
+            plane /= glm::length(glm::vec3(plane));
+        return frustum;
+    }
+
+    bool IntersectsSphere(const glm::vec3& center, float radius) const
+    {
+        for (const glm::vec4& plane : Planes)
+        {
+            if (glm::dot(glm::vec3(plane), center) + plane.w < -radius)
+                return false;
+        }
+        return true;
+    }
+
+    // 只要有一个平面把包围盒完全挡在外侧就返回 false（保守测试，可能把视锥外的盒子判为相交）
+    bool IntersectsAABB(const glm::vec3& minCorner, const glm::vec3& maxCorner) const
+    {
+        for (const glm::vec4& plane : Planes)
+        {
+            // 沿法线方向最远的顶点（p-vertex）
+            glm::vec3 p(plane.x >= 0.0f ? maxCorner.x : minCorner.x,
+                        plane.y >= 0.0f ? maxCorner.y : minCorner.y,
+                        plane.z >= 0.0f ? maxCorner.z : minCorner.z);
+            if (glm::dot(glm::vec3(plane), p) + plane.w < 0.0f)
+                return false;
+        }
+        return true;
+    }
+};
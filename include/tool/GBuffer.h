@@ -0,0 +1,125 @@
+#pragma once
+#include <glad/glad.h>
+
+#include <iostream>
+#include <iomanip>
+
+// 延迟渲染的 G-buffer（33-DeferredShading、34-SSAO 共用）
+//
+// Full    : 0 位置 RGBA16F，1 法线 RGBA16F，2 albedo + 高光 RGBA8，深度 + 模板 D24S8
+// Compact : 位置不存储，由深度和逆投影矩阵重建；1 法线八面体编码 RG16（[-1, 1] 映射到 [0, 1]），2 albedo + 高光 RGBA8
+//
+// 两种布局的颜色附件编号相同（Compact 的 0 号输出对应 GL_NONE），几何 pass 用同一个着色器，
+// 通过 uniform uGBufferLayout 选择写入/读取方式（和 Mesh.h 的 uVertexLayout 一样）
+// 深度在两种布局下都是纹理，Compact 布局下光照/SSAO 着色器从 gDepth 采样
+
+enum class GBufferLayout
+{
+    Full = 0,
+    Compact = 1
+};
+
+class GBuffer
+{
+public:
+    GBuffer(int width, int height, GBufferLayout layout = GBufferLayout::Full)
+        :
+        Layout(layout)
+    {
+        glGenFramebuffers(1, &FBO);
+        glBindFramebuffer(GL_FRAMEBUFFER, FBO);
+        if (Layout == GBufferLayout::Full)
+        {
+            Position = CreateTarget(width, height, GL_RGBA16F, GL_RGBA, GL_FLOAT, GL_COLOR_ATTACHMENT0);
+            Normal = CreateTarget(width, height, GL_RGBA16F, GL_RGBA, GL_FLOAT, GL_COLOR_ATTACHMENT1);
+        }
+        else
+            Normal = CreateTarget(width, height, GL_RG16, GL_RG, GL_UNSIGNED_SHORT, GL_COLOR_ATTACHMENT1);
+        AlbedoSpec = CreateTarget(width, height, GL_RGBA8, GL_RGBA, GL_UNSIGNED_BYTE, GL_COLOR_ATTACHMENT2);
+        // 和默认帧缓冲一样使用 24 位深度 + 8 位模板，blit 深度时格式才能匹配
+        Depth = CreateTarget(width, height, GL_DEPTH24_STENCIL8, GL_DEPTH_STENCIL, GL_UNSIGNED_INT_24_8, GL_DEPTH_STENCIL_ATTACHMENT);
+
+        // tell OpenGL which color attachments we'll use (of this framebuffer) for rendering
+        GLenum attachments[3] = { Layout == GBufferLayout::Full ? GLenum(GL_COLOR_ATTACHMENT0) : GLenum(GL_NONE), GL_COLOR_ATTACHMENT1, GL_COLOR_ATTACHMENT2 };
+        glDrawBuffers(3, attachments);
+        if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+            std::cout << "Framebuffer not complete!" << std::endl;
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    }
+
+    void Destroy()
+    {
+        unsigned int textures[4] = { Position, Normal, AlbedoSpec, Depth };
+        glDeleteTextures(4, textures);
+        glDeleteFramebuffers(1, &FBO);
+        Position = Normal = AlbedoSpec = Depth = FBO = 0;
+    }
+
+    inline unsigned int GetFBO() const { return FBO; }
+    // Compact 布局下为 0
+    inline unsigned int GetPosition() const { return Position; }
+    inline unsigned int GetNormal() const { return Normal; }
+    inline unsigned int GetAlbedoSpec() const { return AlbedoSpec; }
+    inline unsigned int GetDepth() const { return Depth; }
+    inline GBufferLayout GetLayout() const { return Layout; }
+
+    // 每个像素的颜色附件字节数（不含深度）
+    static unsigned int GetColorBytesPerPixel(GBufferLayout layout)
+    {
+        return layout == GBufferLayout::Full ? 8u + 8u + 4u : 4u + 4u;
+    }
+
+    static const unsigned int DepthBytesPerPixel = 4u;
+
+    // 每帧 G-buffer 的读写字节数：几何 pass 写一次，readPasses 个全屏 pass 各读一次
+    // 深度两种布局都要写；Full 布局的全屏 pass 不读深度，Compact 布局每个全屏 pass 都要读深度重建位置
+    static double GetBytesPerFrame(GBufferLayout layout, unsigned int width, unsigned int height, unsigned int readPasses)
+    {
+        double pixels = static_cast<double>(width) * height;
+        double color = GetColorBytesPerPixel(layout) * (1.0 + readPasses);
+        double depth = DepthBytesPerPixel * (layout == GBufferLayout::Full ? 1.0 : 1.0 + readPasses);
+        return pixels * (color + depth);
+    }
+
+    // 1080p 和 4K 下两种布局每帧的 G-buffer 带宽（只算每个像素读写一次，纹理缓存命中之外的重复采样不计）
+    static void PrintBandwidthReport(unsigned int readPasses)
+    {
+        const unsigned int resolutions[2][2] = { { 1920u, 1080u }, { 3840u, 2160u } };
+        std::cout << "G-buffer bandwidth (1 write + " << readPasses << " full-screen read" << (readPasses > 1 ? "s" : "") << " per frame)" << std::endl;
+        std::cout << "    bytes/pixel: full " << GetColorBytesPerPixel(GBufferLayout::Full) + DepthBytesPerPixel
+                  << ", compact " << GetColorBytesPerPixel(GBufferLayout::Compact) + DepthBytesPerPixel << std::endl;
+        std::cout << std::setw(16) << "resolution" << std::setw(14) << "full(MB)" << std::setw(14) << "compact(MB)"
+                  << std::setw(14) << "saved(MB)" << std::setw(18) << "saved@60fps(GB/s)" << std::endl;
+        for (const auto& resolution : resolutions)
+        {
+            double full = GetBytesPerFrame(GBufferLayout::Full, resolution[0], resolution[1], readPasses) / (1024.0 * 1024.0);
+            double compact = GetBytesPerFrame(GBufferLayout::Compact, resolution[0], resolution[1], readPasses) / (1024.0 * 1024.0);
+            std::cout << std::setw(11) << resolution[0] << "x" << std::setw(4) << std::left << resolution[1] << std::right
+                      << std::fixed << std::setprecision(1)
+                      << std::setw(14) << full << std::setw(14) << compact << std::setw(14) << full - compact
+                      << std::setprecision(2) << std::setw(18) << (full - compact) * 60.0 / 1024.0 << std::endl;
+        }
+    }
+
+private:
+    GBufferLayout Layout;
+    unsigned int FBO = 0;
+    unsigned int Position = 0;
+    unsigned int Normal = 0;
+    unsigned int AlbedoSpec = 0;
+    unsigned int Depth = 0;
+
+    static unsigned int CreateTarget(int width, int height, GLenum internalFormat, GLenum format, GLenum type, GLenum attachment)
+    {
+        unsigned int texture;
+        glGenTextures(1, &texture);
+        glBindTexture(GL_TEXTURE_2D, texture);
+        glTexImage2D(GL_TEXTURE_2D, 0, internalFormat, width, height, 0, format, type, NULL);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, attachment, GL_TEXTURE_2D, texture, 0);
+        return texture;
+    }
+};
@@ -0,0 +1,318 @@
+#pragma once
+#include <glad/glad.h>
+
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <map>
+
+// 基于 GL_TIME_ELAPSED 查询的 GPU 分析器，支持嵌套的命名区间（比如 "SSAO" 下面的 "SSAO blur"）
+//
+// GL_TIME_ELAPSED 同一时间只能有一个查询处于激活状态，所以嵌套区间是分段计时的：
+// 每次进入/离开区间都会结束当前查询并开始新的查询，每一段的时间记到当前最内层的区间上（self time），
+// 父区间的总时间 = 自身时间 + 所有子区间的总时间。
+//
+// 查询结果延迟 FramesInFlight 帧读取（多缓冲查询池），读取前先检查 GL_QUERY_RESULT_AVAILABLE，
+// 结果还没准备好时直接丢弃这一帧的数据，渲染线程永远不会等待 GPU。
+class GpuProfiler
+{
+public:
+    static const unsigned int FramesInFlight = 3u;
+
+    // 一帧中一个区间的结果
+    struct ScopeResult
+    {
+        std::string Name;
+        int Depth;
+        double TotalMs;
+        double SelfMs;
+        double StartMs;     // 相对于帧开始的时间（按区间顺序累加得到，用于导出 trace）
+    };
+
+    struct FrameResult
+    {
+        unsigned int Frame;
+        std::vector<ScopeResult> Scopes;
+    };
+
+    GpuProfiler(size_t maxHistory = 10000u)
+        :
+        MaxHistory(maxHistory)
+    {
+    }
+
+    ~GpuProfiler()
+    {
+        // 没有 OpenGL 上下文时不能删除查询对象，这里交给驱动在上下文销毁时回收
+    }
+
+    void BeginFrame()
+    {
+        FrameSlot& slot = Slots[FrameIndex % FramesInFlight];
+        if (slot.bPending)
+            Resolve(slot);
+        slot.Frame = FrameIndex;
+        slot.Scopes.clear();
+        slot.Segments.clear();
+        slot.bPending = false;
+        ScopeStack.clear();
+        bInFrame = true;
+    }
+
+    void EndFrame()
+    {
+        if (!ScopeStack.empty())
+        {
+            std::cout << "[GPU PROFILER ERROR]: " << ScopeStack.size() << " scope(s) still open at end of frame" << std::endl;
+            while (!ScopeStack.empty())
+                PopScope();
+        }
+        FrameSlot& slot = Slots[FrameIndex % FramesInFlight];
+        slot.bPending = !slot.Segments.empty();
+        bInFrame = false;
+        FrameIndex++;
+    }
+
+    void PushScope(const std::string& name)
+    {
+        if (!bInFrame)
+            return;
+        FrameSlot& slot = Slots[FrameIndex % FramesInFlight];
+        if (!ScopeStack.empty())
+            glEndQuery(GL_TIME_ELAPSED);
+
+        ScopeRecord record;
+        record.Name = name;
+        record.Depth = static_cast<int>(ScopeStack.size());
+        record.Parent = ScopeStack.empty() ? -1 : ScopeStack.back();
+        slot.Scopes.push_back(record);
+        ScopeStack.push_back(static_cast<int>(slot.Scopes.size()) - 1);
+        BeginSegment(slot);
+    }
+
+    void PopScope()
+    {
+        if (!bInFrame || ScopeStack.empty())
+            return;
+        FrameSlot& slot = Slots[FrameIndex % FramesInFlight];
+        glEndQuery(GL_TIME_ELAPSED);
+        ScopeStack.pop_back();
+        // 回到父区间，继续给父区间计时
+        if (!ScopeStack.empty())
+            BeginSegment(slot);
+    }
+
+    // 读取所有还没读取的帧（会等待 GPU），只在退出前导出数据时调用
+    void Flush()
+    {
+        glFinish();
+        for (unsigned int i = 0; i < FramesInFlight; i++)
+        {
+            FrameSlot& slot = Slots[(FrameIndex + i) % FramesInFlight];
+            if (slot.bPending)
+                Resolve(slot);
+        }
+    }
+
+    inline const std::vector<FrameResult>& GetHistory() const { return History; }
+    inline unsigned int GetDroppedFrames() const { return DroppedFrames; }
+
+    // 最近 frames 帧每个区间的平均时间
+    void PrintSummary(size_t frames = 120u) const
+    {
+        if (History.empty())
+            return;
+        size_t first = History.size() > frames ? History.size() - frames : 0u;
+        std::vector<std::string> order;
+        std::map<std::string, std::pair<double, int>> totals;
+        std::map<std::string, int> depths;
+        for (size_t i = first; i < History.size(); i++)
+        {
+            for (const ScopeResult& scope : History[i].Scopes)
+            {
+                if (totals.find(scope.Name) == totals.end())
+                    order.push_back(scope.Name);
+                totals[scope.Name].first += scope.TotalMs;
+                totals[scope.Name].second++;
+                depths[scope.Name] = scope.Depth;
+            }
+        }
+        std::cout << "[GPU PROFILER] average over last " << History.size() - first << " frames:" << std::endl;
+        for (const std::string& name : order)
+        {
+            std::cout << "    " << std::string(depths[name] * 2, ' ') << std::left << std::setw(24 - depths[name] * 2) << name
+                      << std::right << std::fixed << std::setprecision(3) << std::setw(9)
+                      << totals[name].first / totals[name].second << " ms" << std::endl;
+        }
+        if (DroppedFrames > 0)
+            std::cout << "    (" << DroppedFrames << " frames dropped because results were not ready)" << std::endl;
+    }
+
+    // frame,scope,depth,total_ms,self_ms
+    bool ExportCSV(const std::string& path) const
+    {
+        std::ofstream file(path, std::ios::trunc);
+        if (!file)
+            return false;
+        file << "frame,scope,depth,total_ms,self_ms\n";
+        file << std::fixed << std::setprecision(4);
+        for (const FrameResult& frame : History)
+        {
+            for (const ScopeResult& scope : frame.Scopes)
+                file << frame.Frame << "," << scope.Name << "," << scope.Depth << "," << scope.TotalMs << "," << scope.SelfMs << "\n";
+        }
+        return static_cast<bool>(file);
+    }
+
+    // Chrome trace 格式（chrome://tracing 或 Perfetto 打开），帧按 GPU 时间首尾相连排列
+    bool ExportChromeTrace(const std::string& path) const
+    {
+        std::ofstream file(path, std::ios::trunc);
+        if (!file)
+            return false;
+        file << "{\"traceEvents\":[\n";
+        file << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":1,\"args\":{\"name\":\"GPU\"}}";
+        file << std::fixed << std::setprecision(3);
+        double frameStartUs = 0.0;
+        for (const FrameResult& frame : History)
+        {
+            double frameUs = 0.0;
+            for (const ScopeResult& scope : frame.Scopes)
+            {
+                file << ",\n{\"name\":\"" << scope.Name << "\",\"cat\":\"gpu\",\"ph\":\"X\",\"pid\":1,\"tid\":1"
+                     << ",\"ts\":" << frameStartUs + scope.StartMs * 1000.0
+                     << ",\"dur\":" << scope.TotalMs * 1000.0
+                     << ",\"args\":{\"frame\":" << frame.Frame << ",\"self_ms\":" << scope.SelfMs << "}}";
+                if (scope.Depth == 0)
+                    frameUs += scope.TotalMs * 1000.0;
+            }
+            frameStartUs += frameUs;
+        }
+        file << "\n]}\n";
+        return static_cast<bool>(file);
+    }
+
+private:
+    struct ScopeRecord
+    {
+        std::string Name;
+        int Depth;
+        int Parent;
+    };
+
+    struct Segment
+    {
+        unsigned int Query;
+        int Scope;
+    };
+
+    struct FrameSlot
+    {
+        unsigned int Frame = 0u;
+        bool bPending = false;
+        std::vector<ScopeRecord> Scopes;
+        std::vector<Segment> Segments;
+        // 查询对象池，每帧复用
+        std::vector<unsigned int> Queries;
+    };
+
+    void BeginSegment(FrameSlot& slot)
+    {
+        size_t index = slot.Segments.size();
+        if (index == slot.Queries.size())
+        {
+            unsigned int query;
+            glGenQueries(1, &query);
+            slot.Queries.push_back(query);
+        }
+        slot.Segments.push_back({ slot.Queries[index], ScopeStack.back() });
+        glBeginQuery(GL_TIME_ELAPSED, slot.Queries[index]);
+    }
+
+    void Resolve(FrameSlot& slot)
+    {
+        slot.bPending = false;
+        // 查询按提交顺序完成，最后一个可用说明前面的都可用
+        int available = 0;
+        glGetQueryObjectiv(slot.Segments.back().Query, GL_QUERY_RESULT_AVAILABLE, &available);
+        if (!available)
+        {
+            DroppedFrames++;
+            return;
+        }
+
+        std::vector<double> selfMs(slot.Scopes.size(), 0.0);
+        for (const Segment& segment : slot.Segments)
+        {
+            GLuint64 elapsed = 0;
+            glGetQueryObjectui64v(segment.Query, GL_QUERY_RESULT, &elapsed);
+            selfMs[segment.Scope] += static_cast<double>(elapsed) / 1.0e6;
+        }
+        // 子区间总是在父区间之后记录，倒序累加得到总时间
+        std::vector<double> totalMs(selfMs);
+        for (int i = static_cast<int>(slot.Scopes.size()) - 1; i >= 0; i--)
+        {
+            if (slot.Scopes[i].Parent >= 0)
+                totalMs[slot.Scopes[i].Parent] += totalMs[i];
+        }
+
+        FrameResult result;
+        result.Frame = slot.Frame;
+        // 区间起始时间：父区间起点 + 之前兄弟区间的总时间（近似，忽略父区间在子区间之前的自身时间分布）
+        std::vector<double> cursor(slot.Scopes.size(), 0.0);
+        double rootCursor = 0.0;
+        for (size_t i = 0; i < slot.Scopes.size(); i++)
+        {
+            const ScopeRecord& record = slot.Scopes[i];
+            double start;
+            if (record.Parent < 0)
+            {
+                start = rootCursor;
+                rootCursor += totalMs[i];
+            }
+            else
+            {
+                start = cursor[record.Parent];
+                cursor[record.Parent] += totalMs[i];
+            }
+            cursor[i] = start;
+            result.Scopes.push_back({ record.Name, record.Depth, totalMs[i], selfMs[i], start });
+        }
+        History.push_back(result);
+        if (History.size() > MaxHistory)
+            History.erase(History.begin());
+    }
+
+    FrameSlot Slots[FramesInFlight];
+    std::vector<int> ScopeStack;
+    std::vector<FrameResult> History;
+    size_t MaxHistory;
+    unsigned int FrameIndex = 0u;
+    unsigned int DroppedFrames = 0u;
+    bool bInFrame = false;
+};
+
+// RAII 区间：{ GpuProfileScope scope(profiler, "SSAO"); ... }
+class GpuProfileScope
+{
+public:
+    GpuProfileScope(GpuProfiler& profiler, const std::string& name)
+        :
+        Profiler(profiler)
+    {
+        Profiler.PushScope(name);
+    }
+
+    ~GpuProfileScope()
+    {
+        Profiler.PopScope();
+    }
+
+    GpuProfileScope(const GpuProfileScope&) = delete;
+    GpuProfileScope& operator=(const GpuProfileScope&) = delete;
+
+private:
+    GpuProfiler& Profiler;
+};
@@ -0,0 +1,327 @@
+#pragma once
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+#include <glm/glm.hpp>
+#include <glm/gtc/constants.hpp>
+
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <cstdlib>
+#include <algorithm>
+
+#include <tool/Camera.h>
+#include <tool/ImageWriter.h>
+
+// 无窗口（headless）渲染模式
+// 使用 GLFW 3.4 的 null 平台 + OSMesa / surfaceless EGL 上下文（llvmpipe 即可），不需要显示器和 GPU。
+// 固定帧数、固定 DeltaTime、相机沿脚本路径移动，保证每次运行渲染的内容完全一致，可用于性能基线和回归测试。
+//
+// 命令行参数：
+//   --headless                开启 headless 模式
+//   --frames=N                渲染帧数（默认 120）
+//   --capture=F1,F2,...       需要截图的帧号（默认最后一帧）
+//   --output=DIR              截图输出目录（默认当前目录）
+//   --context=osmesa|egl      上下文创建方式（默认 osmesa）
+// 例如：./bin/main --headless --frames=300 --capture=0,150,299 --output=captures
+
+struct HeadlessOptions
+{
+    bool bEnabled = false;
+    int Frames = 120;
+    std::vector<int> CaptureFrames;
+    std::string OutputDir = ".";
+    bool bUseEGL = false;
+};
+
+inline HeadlessOptions ParseHeadlessOptions(int argc, char** argv)
+{
+    HeadlessOptions options;
+    for (int i = 1; i < argc; i++)
+    {
+        std::string arg = argv[i];
+        auto value = [&arg](const char* prefix) { return arg.substr(std::string(prefix).size()); };
+        if (arg == "--headless")
+            options.bEnabled = true;
+        else if (arg.rfind("--frames=", 0) == 0)
+            options.Frames = std::max(1, std::atoi(value("--frames=").c_str()));
+        else if (arg.rfind("--output=", 0) == 0)
+            options.OutputDir = value("--output=");
+        else if (arg.rfind("--context=", 0) == 0)
+            options.bUseEGL = value("--context=") == "egl";
+        else if (arg.rfind("--capture=", 0) == 0)
+        {
+            std::string list = value("--capture=");
+            size_t start = 0;
+            while (start <= list.size())
+            {
+                size_t comma = list.find(',', start);
+                std::string item = list.substr(start, comma == std::string::npos ? std::string::npos : comma - start);
+                if (!item.empty())
+                    options.CaptureFrames.push_back(std::atoi(item.c_str()));
+                if (comma == std::string::npos)
+                    break;
+                start = comma + 1;
+            }
+        }
+    }
+    if (options.CaptureFrames.empty())
+        options.CaptureFrames.push_back(options.Frames - 1);
+    return options;
+}
+
+// 在 glfwInit 之前调用：选择 null 平台
+inline void ConfigureHeadlessPlatform(const HeadlessOptions& options)
+{
+    if (options.bEnabled)
+        glfwInitHint(GLFW_PLATFORM, GLFW_PLATFORM_NULL);
+}
+
+// 在 glfwCreateWindow 之前调用：选择离屏上下文
+inline void ConfigureHeadlessWindowHints(const HeadlessOptions& options)
+{
+    if (!options.bEnabled)
+        return;
+    glfwWindowHint(GLFW_CONTEXT_CREATION_API, options.bUseEGL ? GLFW_EGL_CONTEXT_API : GLFW_OSMESA_CONTEXT_API);
+    glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+}
+
+// 脚本化的相机路径：关键帧之间线性插值
+class CameraPath
+{
+public:
+    struct Keyframe
+    {
+        float Time;
+        glm::vec3 Position;
+        float Yaw;
+        float Pitch;
+    };
+
+    CameraPath& Add(float time, const glm::vec3& position, float yaw, float pitch)
+    {
+        Keyframes.push_back({ time, position, yaw, pitch });
+        return *this;
+    }
+
+    // 围绕 center 转一圈，相机始终看向 center
+    static CameraPath Orbit(const glm::vec3& center, float radius, float height, float duration, int steps = 16)
+    {
+        CameraPath path;
+        for (int i = 0; i <= steps; i++)
+        {
+            float t = static_cast<float>(i) / static_cast<float>(steps);
+            float angle = glm::two_pi<float>() * t;
+            glm::vec3 position = center + glm::vec3(std::cos(angle) * radius, height, std::sin(angle) * radius);
+            glm::vec3 front = glm::normalize(center - position);
+            float yaw = glm::degrees(std::atan2(front.z, front.x));
+            float pitch = glm::degrees(std::asin(front.y));
+            // 保持 yaw 连续，避免在 ±180 度处插值跳变
+            if (!path.Keyframes.empty())
+            {
+                float previous = path.Keyframes.back().Yaw;
+                while (yaw - previous > 180.0f) yaw -= 360.0f;
+                while (yaw - previous < -180.0f) yaw += 360.0f;
+            }
+            path.Add(duration * t, position, yaw, pitch);
+        }
+        return path;
+    }
+
+    void Apply(Camera& camera, float time) const
+    {
+        if (Keyframes.empty())
+            return;
+        if (time <= Keyframes.front().Time)
+        {
+            camera.SetPose(Keyframes.front().Position, Keyframes.front().Yaw, Keyframes.front().Pitch);
+            return;
+        }
+        for (size_t i = 1; i < Keyframes.size(); i++)
+        {
+            const Keyframe& a = Keyframes[i - 1];
+            const Keyframe& b = Keyframes[i];
+            if (time <= b.Time)
+            {
+                float t = (time - a.Time) / std::max(b.Time - a.Time, 1e-6f);
+                camera.SetPose(glm::mix(a.Position, b.Position, t), glm::mix(a.Yaw, b.Yaw, t), glm::mix(a.Pitch, b.Pitch, t));
+                return;
+            }
+        }
+        camera.SetPose(Keyframes.back().Position, Keyframes.back().Yaw, Keyframes.back().Pitch);
+    }
+
+    inline bool IsEmpty() const { return Keyframes.empty(); }
+
+private:
+    std::vector<Keyframe> Keyframes;
+};
+
+// headless 渲染循环的辅助类：驱动相机、计时、截图
+// 用法：
+//   while (!glfwWindowShouldClose(window) && !runner.IsFinished())
+//   {
+//       runner.BeginFrame(camera, DeltaTime);
+//       ... render ...
+//       runner.EndFrame();
+//       glfwSwapBuffers(window);
+//   }
+class HeadlessRunner
+{
+public:
+    // 固定 60 FPS 的时间步长
+    const float FixedDeltaTime = 1.0f / 60.0f;
+
+    HeadlessRunner(const HeadlessOptions& options, const CameraPath& path, int width, int height)
+        :
+        Options(options),
+        Path(path),
+        Width(width),
+        Height(height)
+    {
+        if (Options.bEnabled)
+            glGenQueries(4, &Queries[0][0]);
+    }
+
+    ~HeadlessRunner()
+    {
+        if (Options.bEnabled)
+            PrintReport();
+    }
+
+    // 注册额外需要截图的帧缓冲附件，bHDR 为 true 时保存为 EXR
+    void AddCapture(const std::string& name, unsigned int framebuffer, unsigned int attachment, bool bHDR = false)
+    {
+        Captures.push_back({ name, framebuffer, attachment, bHDR });
+    }
+
+    inline bool IsEnabled() const { return Options.bEnabled; }
+    inline bool IsFinished() const { return Options.bEnabled && Frame >= Options.Frames; }
+
+    void BeginFrame(Camera& camera, float& deltaTime)
+    {
+        if (!Options.bEnabled)
+            return;
+        deltaTime = FixedDeltaTime;
+        Path.Apply(camera, Frame * FixedDeltaTime);
+        CpuStart = std::chrono::high_resolution_clock::now();
+        // 用时间戳而不是 GL_TIME_ELAPSED，这样不会和 GpuProfiler 的区间查询冲突（同一时间只能有一个 GL_TIME_ELAPSED 查询）
+        glQueryCounter(Queries[Frame % 2][0], GL_TIMESTAMP);
+    }
+
+    void EndFrame()
+    {
+        if (!Options.bEnabled)
+            return;
+        glQueryCounter(Queries[Frame % 2][1], GL_TIMESTAMP);
+        // CPU 时间只统计提交渲染命令的开销，不包括截图
+        CpuMs.push_back(std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - CpuStart).count());
+        // 读取上一帧的 GPU 时间，这一帧的查询留到下一帧再读，避免等待
+        if (Frame > 0)
+            GpuMs.push_back(ReadQueryMs(Queries[(Frame - 1) % 2]));
+
+        if (std::find(Options.CaptureFrames.begin(), Options.CaptureFrames.end(), Frame) != Options.CaptureFrames.end())
+            CaptureFrame();
+
+        Frame++;
+        if (Frame == Options.Frames)
+            GpuMs.push_back(ReadQueryMs(Queries[(Frame - 1) % 2]));
+    }
+
+private:
+    struct Capture
+    {
+        std::string Name;
+        unsigned int Framebuffer;
+        unsigned int Attachment;
+        bool bHDR;
+    };
+
+    double ReadQueryMs(const unsigned int queries[2])
+    {
+        GLuint64 start = 0, end = 0;
+        glGetQueryObjectui64v(queries[0], GL_QUERY_RESULT, &start);
+        glGetQueryObjectui64v(queries[1], GL_QUERY_RESULT, &end);
+        return static_cast<double>(end - start) / 1.0e6;
+    }
+
+    void CaptureFrame()
+    {
+        int previousFramebuffer = 0;
+        glGetIntegerv(GL_READ_FRAMEBUFFER_BINDING, &previousFramebuffer);
+        glPixelStorei(GL_PACK_ALIGNMENT, 1);
+
+        std::string prefix = Options.OutputDir + "/frame_" + std::to_string(Frame) + "_";
+        // 默认帧缓冲
+        GLboolean doubleBuffered = GL_TRUE;
+        glGetBooleanv(GL_DOUBLEBUFFER, &doubleBuffered);
+        glBindFramebuffer(GL_READ_FRAMEBUFFER, 0);
+        glReadBuffer(doubleBuffered ? GL_BACK : GL_FRONT);
+        SaveReadBuffer(prefix + "default.png", false);
+        for (const Capture& capture : Captures)
+        {
+            glBindFramebuffer(GL_READ_FRAMEBUFFER, capture.Framebuffer);
+            glReadBuffer(capture.Attachment);
+            SaveReadBuffer(prefix + capture.Name + (capture.bHDR ? ".exr" : ".png"), capture.bHDR);
+        }
+
+        glBindFramebuffer(GL_READ_FRAMEBUFFER, previousFramebuffer);
+        glPixelStorei(GL_PACK_ALIGNMENT, 4);
+    }
+
+    void SaveReadBuffer(const std::string& path, bool bHDR)
+    {
+        bool bSaved;
+        if (bHDR)
+        {
+            std::vector<float> pixels(static_cast<size_t>(Width) * Height * 3);
+            glReadPixels(0, 0, Width, Height, GL_RGB, GL_FLOAT, pixels.data());
+            bSaved = WriteEXR(path, Width, Height, pixels.data());
+        }
+        else
+        {
+            std::vector<unsigned char> pixels(static_cast<size_t>(Width) * Height * 4);
+            glReadPixels(0, 0, Width, Height, GL_RGBA, GL_UNSIGNED_BYTE, pixels.data());
+            bSaved = WritePNG(path, Width, Height, 4, pixels.data());
+        }
+        if (!bSaved)
+            std::cout << "[HEADLESS ERROR]: Failed to write capture: " << path << std::endl;
+    }
+
+    void PrintReport() const
+    {
+        std::cout << "frame,cpu_ms,gpu_ms" << std::endl;
+        for (size_t i = 0; i < CpuMs.size(); i++)
+            std::cout << i << "," << std::fixed << std::setprecision(3) << CpuMs[i] << "," << (i < GpuMs.size() ? GpuMs[i] : 0.0) << std::endl;
+        if (CpuMs.empty())
+            return;
+
+        auto summary = [](const char* label, std::vector<double> values)
+        {
+            std::sort(values.begin(), values.end());
+            double sum = 0.0;
+            for (double v : values)
+                sum += v;
+            std::cout << "[HEADLESS] " << label << " avg: " << std::fixed << std::setprecision(3) << sum / values.size()
+                      << " ms, min: " << values.front() << " ms, median: " << values[values.size() / 2]
+                      << " ms, max: " << values.back() << " ms" << std::endl;
+        };
+        summary("cpu", CpuMs);
+        if (!GpuMs.empty())
+            summary("gpu", GpuMs);
+    }
+
+    HeadlessOptions Options;
+    CameraPath Path;
+    int Width;
+    int Height;
+    int Frame = 0;
+    // 两帧交替使用，每帧一对（开始、结束）时间戳查询
+    unsigned int Queries[2][2] = { { 0u, 0u }, { 0u, 0u } };
+    std::chrono::high_resolution_clock::time_point CpuStart;
+    std::vector<double> CpuMs;
+    std::vector<double> GpuMs;
+    std::vector<Capture> Captures;
+};
@@ -0,0 +1,1030 @@
+#pragma once
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <algorithm>
+
+#include <tool/JobSystem.h>
+#include <tool/MappedFile.h>
+#include <tool/VertexCompression.h>
+#include <tool/TextureLoader.h>
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#include <xmmintrin.h>
+#define IBL_PRECOMPUTE_SSE 1
+#endif
+
+// 基于图像的光照（IBL）的 CPU 预计算和磁盘缓存（36-IBL-specular、36-IBL-specular-textured）
+// 和章节 Shaders/ 中各个 pass 的计算相同：
+// 1. 等距柱状投影 HDR → 512² 环境立方体贴图（双线性采样），再逐级 2x2 平均生成 mip
+// 2. 辐照度 32²：对环境贴图 32² 那一级的全部 texel 按立体角加权求和（SSE 一次算 4 个 texel），
+//    和 irradiance_convolution.fs 的半球积分结果相同，但没有采样噪声
+// 3. 预过滤 128²，5 级 mip，粗糙度 = mip / 4：1024 个 GGX 重要性采样，按 pdf 选择环境贴图的 mip（和 prefilter.fs 相同）；
+//    V = N 的假设下切线空间的采样方向和法线无关，每个粗糙度只生成一次
+// 4. BRDF LUT 512² RG：split-sum 积分（和 brdf.fs 相同），SSE 一次算 4 个采样
+// 5. 辐照度的 L2 球谐（9 个 RGB 系数）：从环境贴图投影，pbr.fs 可以直接求值代替辐照度贴图（uIrradianceMode）
+// 每一行一个任务，交给 JobSystem 并行。计算部分不调用 OpenGL，没有 GPU 的机器也能运行（Benchmark-IBLPrecompute）
+//
+// 缓存文件（.iblcache，放在 HDR 文件旁边）的格式类似 KTX2/DDS：文件头里是每张贴图的描述，数据按 mip、面的顺序排列，都是半精度浮点
+// [IBLCacheHeader（含球谐系数）][环境 RGB16F][辐照度 RGB16F][预过滤 RGB16F * 5 级][BRDF LUT RG16F]（各段 16 字节对齐）
+// 加载时直接映射文件，用 glTexImage2D 上传每个面的每级 mip，不需要任何计算
+
+// 修改计算方法或文件布局时都要增加版本号
+// 2：文件头加入辐照度球谐系数
+const uint32_t IBL_CACHE_VERSION = 2u;
+const char IBL_CACHE_MAGIC[4] = { 'L', 'O', 'G', 'I' };
+const char* const IBL_CACHE_EXTENSION = ".iblcache";
+
+const float IBL_PI = 3.14159265359f;
+
+enum IBLImageIndex
+{
+    IBL_ENVIRONMENT = 0,
+    IBL_IRRADIANCE = 1,
+    IBL_PREFILTER = 2,
+    IBL_BRDF_LUT = 3,
+    IBL_IMAGE_COUNT = 4
+};
+
+// 正方形的浮点贴图（立方体贴图 6 个面，二维贴图 1 个面），Levels[mip * FaceCount + face]
+struct IBLImage
+{
+    unsigned int Size = 0;
+    unsigned int FaceCount = 0;
+    unsigned int MipCount = 0;
+    unsigned int Channels = 0;
+    std::vector<std::vector<float>> Levels;
+
+    void Allocate(unsigned int size, unsigned int faceCount, unsigned int mipCount, unsigned int channels)
+    {
+        Size = size;
+        FaceCount = faceCount;
+        MipCount = mipCount;
+        Channels = channels;
+        Levels.assign(faceCount * mipCount, std::vector<float>());
+        for (unsigned int mip = 0; mip < mipCount; mip++)
+            for (unsigned int face = 0; face < faceCount; face++)
+                Levels[mip * faceCount + face].assign(static_cast<size_t>(GetMipSize(mip)) * GetMipSize(mip) * channels, 0.0f);
+    }
+
+    inline unsigned int GetMipSize(unsigned int mip) const { return std::max(1u, Size >> mip); }
+    inline float* GetLevel(unsigned int mip, unsigned int face) { return Levels[mip * FaceCount + face].data(); }
+    inline const float* GetLevel(unsigned int mip, unsigned int face) const { return Levels[mip * FaceCount + face].data(); }
+};
+
+// L2 球谐表示的辐照度，系数已经乘上余弦瓣的卷积系数并除以 π，和辐照度贴图存的值相同：
+// E(N) / π = Σ Coefficients[i] * Y_i(N)
+const unsigned int IRRADIANCE_SH_COEFFICIENT_COUNT = 9u;
+
+struct IrradianceSH
+{
+    glm::vec3 Coefficients[IRRADIANCE_SH_COEFFICIENT_COUNT];
+};
+
+struct IBLMaps
+{
+    IBLImage Images[IBL_IMAGE_COUNT];
+    IrradianceSH SH;
+};
+
+// 和章节原来 GPU 路径相同的尺寸和采样数
+struct IBLBakeSettings
+{
+    unsigned int EnvironmentSize = 512u;
+    unsigned int IrradianceSize = 32u;
+    unsigned int PrefilterSize = 128u;
+    unsigned int PrefilterMipCount = 5u;
+    unsigned int BRDFLUTSize = 512u;
+    unsigned int SampleCount = 1024u;
+};
+
+struct IBLBakeTimings
+{
+    double LoadMs = 0.0;
+    double EnvironmentMs = 0.0;
+    double IrradianceMs = 0.0;
+    double PrefilterMs = 0.0;
+    double BRDFMs = 0.0;
+    double SHMs = 0.0;
+
+    inline double GetTotalMs() const { return LoadMs + EnvironmentMs + IrradianceMs + PrefilterMs + BRDFMs + SHMs; }
+};
+
+template<typename Function>
+void IBLParallelFor(JobSystem* jobs, unsigned int count, unsigned int grainSize, const Function& function)
+{
+    if (jobs != nullptr)
+        jobs->ParallelFor(0u, count, grainSize, function);
+    else
+        function(0u, count);
+}
+
+inline double IBLElapsedMs(std::chrono::high_resolution_clock::time_point start)
+{
+    return std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+}
+
+// 立方体贴图面上的点（u, v ∈ [-1, 1]，v 沿行向下）对应的方向，和 OpenGL 规范中立方体贴图的面选择表一致
+inline glm::vec3 CubeFaceDirection(unsigned int face, float u, float v)
+{
+    switch (face)
+    {
+    case 0: return glm::vec3(1.0f, -v, -u);
+    case 1: return glm::vec3(-1.0f, -v, u);
+    case 2: return glm::vec3(u, 1.0f, v);
+    case 3: return glm::vec3(u, -1.0f, -v);
+    case 4: return glm::vec3(u, -v, 1.0f);
+    default: return glm::vec3(-u, -v, -1.0f);
+    }
+}
+
+// 方向 → 面和面上的 (u, v)，CubeFaceDirection 的逆运算
+inline unsigned int CubeFaceFromDirection(const glm::vec3& direction, float& u, float& v)
+{
+    glm::vec3 a = glm::abs(direction);
+    if (a.x >= a.y && a.x >= a.z)
+    {
+        float inv = 1.0f / a.x;
+        u = (direction.x > 0.0f ? -direction.z : direction.z) * inv;
+        v = -direction.y * inv;
+        return direction.x > 0.0f ? 0u : 1u;
+    }
+    if (a.y >= a.z)
+    {
+        float inv = 1.0f / a.y;
+        u = direction.x * inv;
+        v = (direction.y > 0.0f ? direction.z : -direction.z) * inv;
+        return direction.y > 0.0f ? 2u : 3u;
+    }
+    float inv = 1.0f / a.z;
+    u = (direction.z > 0.0f ? direction.x : -direction.x) * inv;
+    v = -direction.y * inv;
+    return direction.z > 0.0f ? 4u : 5u;
+}
+
+// texel (x, y) 中心的方向（未归一化）
+inline glm::vec3 CubeTexelDirection(unsigned int face, unsigned int x, unsigned int y, unsigned int size)
+{
+    float u = 2.0f * (static_cast<float>(x) + 0.5f) / static_cast<float>(size) - 1.0f;
+    float v = 2.0f * (static_cast<float>(y) + 0.5f) / static_cast<float>(size) - 1.0f;
+    return CubeFaceDirection(face, u, v);
+}
+
+// 一个 texel 在单位球上覆盖的立体角
+inline float CubeTexelSolidAngle(unsigned int x, unsigned int y, unsigned int size)
+{
+    auto areaElement = [](float u, float v) { return std::atan2(u * v, std::sqrt(u * u + v * v + 1.0f)); };
+    float step = 2.0f / static_cast<float>(size);
+    float u0 = static_cast<float>(x) * step - 1.0f;
+    float v0 = static_cast<float>(y) * step - 1.0f;
+    float u1 = u0 + step;
+    float v1 = v0 + step;
+    return areaElement(u0, v0) - areaElement(u0, v1) - areaElement(u1, v0) + areaElement(u1, v1);
+}
+
+// 一个面的某级 mip 的双线性采样（面边缘夹取，不跨面过滤）
+inline glm::vec3 SampleCubeFace(const IBLImage& cube, unsigned int mip, unsigned int face, float u, float v)
+{
+    int size = static_cast<int>(cube.GetMipSize(mip));
+    const float* texels = cube.GetLevel(mip, face);
+    float x = (u * 0.5f + 0.5f) * size - 0.5f;
+    float y = (v * 0.5f + 0.5f) * size - 0.5f;
+    x = std::min(std::max(x, 0.0f), static_cast<float>(size - 1));
+    y = std::min(std::max(y, 0.0f), static_cast<float>(size - 1));
+    int x0 = static_cast<int>(x);
+    int y0 = static_cast<int>(y);
+    int x1 = std::min(x0 + 1, size - 1);
+    int y1 = std::min(y0 + 1, size - 1);
+    float fx = x - x0;
+    float fy = y - y0;
+    const float* t00 = texels + (y0 * size + x0) * 3;
+    const float* t10 = texels + (y0 * size + x1) * 3;
+    const float* t01 = texels + (y1 * size + x0) * 3;
+    const float* t11 = texels + (y1 * size + x1) * 3;
+    glm::vec3 result;
+    for (int c = 0; c < 3; c++)
+    {
+        float top = t00[c] + (t10[c] - t00[c]) * fx;
+        float bottom = t01[c] + (t11[c] - t01[c]) * fx;
+        result[c] = top + (bottom - top) * fy;
+    }
+    return result;
+}
+
+// 相当于 textureLod(cube, direction, lod)：三线性过滤
+inline glm::vec3 SampleCube(const IBLImage& cube, const glm::vec3& direction, float lod)
+{
+    float u, v;
+    unsigned int face = CubeFaceFromDirection(direction, u, v);
+    lod = std::min(std::max(lod, 0.0f), static_cast<float>(cube.MipCount - 1));
+    unsigned int mip0 = static_cast<unsigned int>(lod);
+    unsigned int mip1 = std::min(mip0 + 1, cube.MipCount - 1);
+    glm::vec3 c0 = SampleCubeFace(cube, mip0, face, u, v);
+    float t = lod - static_cast<float>(mip0);
+    if (t <= 0.0f || mip1 == mip0)
+        return c0;
+    return glm::mix(c0, SampleCubeFace(cube, mip1, face, u, v), t);
+}
+
+// 读取等距柱状投影的 HDR 图片（和章节一样上下翻转，第 0 行是 v = 0）
+inline bool LoadEquirectangular(const std::string& path, IBLImage& image)
+{
+    // 读完恢复原来的翻转状态，不影响之后加载的模型纹理
+    bool previousFlip = TextureFlipEnabled();
+    SetTextureFlip(true);
+    int width, height, nrComponents;
+    float* data = stbi_loadf(path.c_str(), &width, &height, &nrComponents, 3);
+    SetTextureFlip(previousFlip);
+    if (data == nullptr)
+        return false;
+    // 长方形图片，Size 存宽度，高度由数据长度得到
+    image.Size = static_cast<unsigned int>(width);
+    image.FaceCount = 1u;
+    image.MipCount = 1u;
+    image.Channels = 3u;
+    image.Levels.assign(1, std::vector<float>(data, data + static_cast<size_t>(width) * height * 3));
+    stbi_image_free(data);
+    return true;
+}
+
+// 等距柱状投影 → 立方体贴图（equirectangular_to_cubemap.fs），水平方向环绕采样，之后生成全部 mip
+inline void EquirectangularToCubemap(const IBLImage& equirect, IBLImage& cube, unsigned int size, JobSystem* jobs = nullptr)
+{
+    unsigned int mipCount = 1u;
+    while ((size >> mipCount) > 0u)
+        mipCount++;
+    cube.Allocate(size, 6u, mipCount, 3u);
+
+    int width = static_cast<int>(equirect.Size);
+    int height = static_cast<int>(equirect.Levels[0].size() / (static_cast<size_t>(width) * 3));
+    const float* source = equirect.Levels[0].data();
+    IBLParallelFor(jobs, 6u * size, 16u, [&](unsigned int first, unsigned int last)
+    {
+        for (unsigned int row = first; row < last; row++)
+        {
+            unsigned int face = row / size;
+            unsigned int y = row % size;
+            float* dest = cube.GetLevel(0u, face) + static_cast<size_t>(y) * size * 3;
+            for (unsigned int x = 0; x < size; x++)
+            {
+                glm::vec3 v = glm::normalize(CubeTexelDirection(face, x, y, size));
+                // SampleSphericalMap
+                float s = (std::atan2(v.z, v.x) * (0.5f / IBL_PI) + 0.5f) * width - 0.5f;
+                float t = (std::asin(v.y) * (1.0f / IBL_PI) + 0.5f) * height - 0.5f;
+                t = std::min(std::max(t, 0.0f), static_cast<float>(height - 1));
+                float sf = std::floor(s);
+                int x0 = (static_cast<int>(sf) % width + width) % width;
+                int x1 = (x0 + 1) % width;
+                int y0 = static_cast<int>(t);
+                int y1 = std::min(y0 + 1, height - 1);
+                float fx = s - sf;
+                float fy = t - static_cast<float>(y0);
+                for (int c = 0; c < 3; c++)
+                {
+                    float top = source[(y0 * width + x0) * 3 + c] * (1.0f - fx) + source[(y0 * width + x1) * 3 + c] * fx;
+                    float bottom = source[(y1 * width + x0) * 3 + c] * (1.0f - fx) + source[(y1 * width + x1) * 3 + c] * fx;
+                    dest[x * 3 + c] = top * (1.0f - fy) + bottom * fy;
+                }
+            }
+        }
+    });
+
+    // 相当于 glGenerateMipmap：每级 2x2 平均
+    for (unsigned int mip = 1; mip < mipCount; mip++)
+    {
+        unsigned int mipSize = cube.GetMipSize(mip);
+        unsigned int parentSize = cube.GetMipSize(mip - 1);
+        for (unsigned int face = 0; face < 6u; face++)
+        {
+            const float* parent = cube.GetLevel(mip - 1, face);
+            float* dest = cube.GetLevel(mip, face);
+            for (unsigned int y = 0; y < mipSize; y++)
+                for (unsigned int x = 0; x < mipSize; x++)
+                    for (unsigned int c = 0; c < 3u; c++)
+                        dest[(y * mipSize + x) * 3 + c] = 0.25f * (parent[((2 * y) * parentSize + 2 * x) * 3 + c] + parent[((2 * y) * parentSize + 2 * x + 1) * 3 + c]
+                                                                 + parent[((2 * y + 1) * parentSize + 2 * x) * 3 + c] + parent[((2 * y + 1) * parentSize + 2 * x + 1) * 3 + c]);
+        }
+    }
+}
+
+// 辐照度：E(N) = 1/π ∫ L(ω) max(N·ω, 0) dω
+// 在环境贴图边长不超过 max(size, 32) 的那一级上对全部 texel 求和，辐照度是极低频的信号，这一级已经足够精确
+inline void ConvolveIrradiance(const IBLImage& environment, IBLImage& irradiance, unsigned int size, JobSystem* jobs = nullptr)
+{
+    irradiance.Allocate(size, 6u, 1u, 3u);
+
+    unsigned int sourceMip = 0;
+    while (sourceMip + 1 < environment.MipCount && environment.GetMipSize(sourceMip) > std::max(size, 32u))
+        sourceMip++;
+    unsigned int sourceSize = environment.GetMipSize(sourceMip);
+
+    // 源 texel 的方向和 L * dω / π，按 4 个一组补齐（补上的权重为 0）
+    size_t sourceCount = static_cast<size_t>(sourceSize) * sourceSize * 6;
+    size_t paddedCount = (sourceCount + 3) & ~static_cast<size_t>(3);
+    std::vector<float> dx(paddedCount, 0.0f), dy(paddedCount, 0.0f), dz(paddedCount, 0.0f);
+    std::vector<float> r(paddedCount, 0.0f), g(paddedCount, 0.0f), b(paddedCount, 0.0f);
+    for (unsigned int face = 0; face < 6u; face++)
+    {
+        const float* texels = environment.GetLevel(sourceMip, face);
+        for (unsigned int y = 0; y < sourceSize; y++)
+        {
+            for (unsigned int x = 0; x < sourceSize; x++)
+            {
+                size_t i = (static_cast<size_t>(face) * sourceSize + y) * sourceSize + x;
+                glm::vec3 direction = glm::normalize(CubeTexelDirection(face, x, y, sourceSize));
+                float weight = CubeTexelSolidAngle(x, y, sourceSize) / IBL_PI;
+                dx[i] = direction.x;
+                dy[i] = direction.y;
+                dz[i] = direction.z;
+                r[i] = texels[(y * sourceSize + x) * 3 + 0] * weight;
+                g[i] = texels[(y * sourceSize + x) * 3 + 1] * weight;
+                b[i] = texels[(y * sourceSize + x) * 3 + 2] * weight;
+            }
+        }
+    }
+
+    IBLParallelFor(jobs, 6u * size, 4u, [&](unsigned int first, unsigned int last)
+    {
+        for (unsigned int row = first; row < last; row++)
+        {
+            unsigned int face = row / size;
+            unsigned int y = row % size;
+            float* dest = irradiance.GetLevel(0u, face) + static_cast<size_t>(y) * size * 3;
+            for (unsigned int x = 0; x < size; x++)
+            {
+                glm::vec3 n = glm::normalize(CubeTexelDirection(face, x, y, size));
+                float sum[3] = { 0.0f, 0.0f, 0.0f };
+#ifdef IBL_PRECOMPUTE_SSE
+                __m128 nx = _mm_set1_ps(n.x), ny = _mm_set1_ps(n.y), nz = _mm_set1_ps(n.z);
+                __m128 zero = _mm_setzero_ps();
+                __m128 sumR = zero, sumG = zero, sumB = zero;
+                for (size_t i = 0; i < paddedCount; i += 4)
+                {
+                    __m128 cosine = _mm_add_ps(_mm_add_ps(_mm_mul_ps(nx, _mm_loadu_ps(&dx[i])), _mm_mul_ps(ny, _mm_loadu_ps(&dy[i]))), _mm_mul_ps(nz, _mm_loadu_ps(&dz[i])));
+                    cosine = _mm_max_ps(cosine, zero);
+                    sumR = _mm_add_ps(sumR, _mm_mul_ps(cosine, _mm_loadu_ps(&r[i])));
+                    sumG = _mm_add_ps(sumG, _mm_mul_ps(cosine, _mm_loadu_ps(&g[i])));
+                    sumB = _mm_add_ps(sumB, _mm_mul_ps(cosine, _mm_loadu_ps(&b[i])));
+                }
+                alignas(16) float lanes[4];
+                __m128 sums[3] = { sumR, sumG, sumB };
+                for (int c = 0; c < 3; c++)
+                {
+                    _mm_store_ps(lanes, sums[c]);
+                    sum[c] = lanes[0] + lanes[1] + lanes[2] + lanes[3];
+                }
+#else
+                for (size_t i = 0; i < paddedCount; i++)
+                {
+                    float cosine = std::max(n.x * dx[i] + n.y * dy[i] + n.z * dz[i], 0.0f);
+                    sum[0] += cosine * r[i];
+                    sum[1] += cosine * g[i];
+                    sum[2] += cosine * b[i];
+                }
+#endif
+                dest[x * 3 + 0] = sum[0];
+                dest[x * 3 + 1] = sum[1];
+                dest[x * 3 + 2] = sum[2];
+            }
+        }
+    });
+}
+
+// 实数球谐基函数，l = 0..2
+inline void EvaluateSHBasis(const glm::vec3& n, float basis[IRRADIANCE_SH_COEFFICIENT_COUNT])
+{
+    basis[0] = 0.282095f;
+    basis[1] = 0.488603f * n.y;
+    basis[2] = 0.488603f * n.z;
+    basis[3] = 0.488603f * n.x;
+    basis[4] = 1.092548f * n.x * n.y;
+    basis[5] = 1.092548f * n.y * n.z;
+    basis[6] = 0.315392f * (3.0f * n.z * n.z - 1.0f);
+    basis[7] = 1.092548f * n.x * n.z;
+    basis[8] = 0.546274f * (n.x * n.x - n.y * n.y);
+}
+
+// 和 pbr.fs 的 EvaluateIrradianceSH 相同
+inline glm::vec3 EvaluateIrradianceSH(const IrradianceSH& sh, const glm::vec3& n)
+{
+    float basis[IRRADIANCE_SH_COEFFICIENT_COUNT];
+    EvaluateSHBasis(n, basis);
+    glm::vec3 result(0.0f);
+    for (unsigned int i = 0; i < IRRADIANCE_SH_COEFFICIENT_COUNT; i++)
+        result += sh.Coefficients[i] * basis[i];
+    return glm::max(result, glm::vec3(0.0f));
+}
+
+// 把环境贴图第 mip 级投影到球谐：L_lm = Σ L(ω) Y_lm(ω) dω，再乘余弦瓣的卷积系数 A_l / π（A0 = π，A1 = 2π/3，A2 = π/4）
+// 每一行一个任务，行内用 double 累加，最后按行的顺序合并，结果和线程数无关
+inline IrradianceSH ProjectIrradianceSH(const IBLImage& environment, unsigned int mip, JobSystem* jobs = nullptr)
+{
+    const unsigned int coefficientFloats = IRRADIANCE_SH_COEFFICIENT_COUNT * 3u;
+    unsigned int size = environment.GetMipSize(mip);
+    std::vector<double> rowSums(static_cast<size_t>(6u * size) * coefficientFloats, 0.0);
+    IBLParallelFor(jobs, 6u * size, 16u, [&](unsigned int first, unsigned int last)
+    {
+        float basis[IRRADIANCE_SH_COEFFICIENT_COUNT];
+        for (unsigned int row = first; row < last; row++)
+        {
+            unsigned int face = row / size;
+            unsigned int y = row % size;
+            const float* texels = environment.GetLevel(mip, face) + static_cast<size_t>(y) * size * 3;
+            double* sum = &rowSums[static_cast<size_t>(row) * coefficientFloats];
+            for (unsigned int x = 0; x < size; x++)
+            {
+                EvaluateSHBasis(glm::normalize(CubeTexelDirection(face, x, y, size)), basis);
+                float weight = CubeTexelSolidAngle(x, y, size);
+                for (unsigned int i = 0; i < IRRADIANCE_SH_COEFFICIENT_COUNT; i++)
+                    for (unsigned int c = 0; c < 3u; c++)
+                        sum[i * 3 + c] += static_cast<double>(texels[x * 3 + c] * basis[i] * weight);
+            }
+        }
+    });
+
+    const float band[IRRADIANCE_SH_COEFFICIENT_COUNT] = { 1.0f, 2.0f / 3.0f, 2.0f / 3.0f, 2.0f / 3.0f, 0.25f, 0.25f, 0.25f, 0.25f, 0.25f };
+    IrradianceSH sh;
+    for (unsigned int i = 0; i < IRRADIANCE_SH_COEFFICIENT_COUNT; i++)
+    {
+        double total[3] = { 0.0, 0.0, 0.0 };
+        for (unsigned int row = 0; row < 6u * size; row++)
+            for (unsigned int c = 0; c < 3u; c++)
+                total[c] += rowSums[static_cast<size_t>(row) * coefficientFloats + i * 3 + c];
+        sh.Coefficients[i] = glm::vec3(static_cast<float>(total[0]), static_cast<float>(total[1]), static_cast<float>(total[2])) * band[i];
+    }
+    return sh;
+}
+
+// 球谐和卷积得到的辐照度贴图逐 texel 比较，按立体角加权，相对误差 = |SH - 卷积| / |卷积|（RGB 长度）
+struct IrradianceSHError
+{
+    double MeanRelative = 0.0;
+    double RMSRelative = 0.0;
+    double MaxRelative = 0.0;
+};
+
+inline IrradianceSHError CompareIrradianceSH(const IrradianceSH& sh, const IBLImage& irradiance)
+{
+    IrradianceSHError error;
+    double totalWeight = 0.0;
+    unsigned int size = irradiance.Size;
+    for (unsigned int face = 0; face < 6u; face++)
+    {
+        const float* texels = irradiance.GetLevel(0u, face);
+        for (unsigned int y = 0; y < size; y++)
+        {
+            for (unsigned int x = 0; x < size; x++)
+            {
+                const float* texel = texels + (static_cast<size_t>(y) * size + x) * 3;
+                glm::vec3 reference(texel[0], texel[1], texel[2]);
+                glm::vec3 approximation = EvaluateIrradianceSH(sh, glm::normalize(CubeTexelDirection(face, x, y, size)));
+                double relative = glm::length(approximation - reference) / std::max(glm::length(reference), 1e-4f);
+                double weight = CubeTexelSolidAngle(x, y, size);
+                error.MeanRelative += relative * weight;
+                error.RMSRelative += relative * relative * weight;
+                error.MaxRelative = std::max(error.MaxRelative, relative);
+                totalWeight += weight;
+            }
+        }
+    }
+    error.MeanRelative /= totalWeight;
+    error.RMSRelative = std::sqrt(error.RMSRelative / totalWeight);
+    return error;
+}
+
+inline void PrintIrradianceSHError(const IrradianceSHError& error)
+{
+    std::cout << std::fixed << std::setprecision(2) << "irradiance SH vs convolution: mean " << error.MeanRelative * 100.0
+              << "%, rms " << error.RMSRelative * 100.0 << "%, max " << error.MaxRelative * 100.0 << "%" << std::endl;
+}
+
+// prefilter.fs / brdf.fs 中的 Hammersley 序列
+inline float RadicalInverseVdC(uint32_t bits)
+{
+    bits = (bits << 16u) | (bits >> 16u);
+    bits = ((bits & 0x55555555u) << 1u) | ((bits & 0xAAAAAAAAu) >> 1u);
+    bits = ((bits & 0x33333333u) << 2u) | ((bits & 0xCCCCCCCCu) >> 2u);
+    bits = ((bits & 0x0F0F0F0Fu) << 4u) | ((bits & 0xF0F0F0F0u) >> 4u);
+    bits = ((bits & 0x00FF00FFu) << 8u) | ((bits & 0xFF00FF00u) >> 8u);
+    return static_cast<float>(bits) * 2.3283064365386963e-10f;
+}
+
+// 切线空间（N = +Z）中的 GGX 重要性采样半程向量
+inline glm::vec3 ImportanceSampleGGX(unsigned int i, unsigned int sampleCount, float roughness)
+{
+    float a = roughness * roughness;
+    float phi = 2.0f * IBL_PI * static_cast<float>(i) / static_cast<float>(sampleCount);
+    float xiY = RadicalInverseVdC(i);
+    float cosTheta = std::sqrt((1.0f - xiY) / (1.0f + (a * a - 1.0f) * xiY));
+    float sinTheta = std::sqrt(std::max(0.0f, 1.0f - cosTheta * cosTheta));
+    return glm::vec3(std::cos(phi) * sinTheta, std::sin(phi) * sinTheta, cosTheta);
+}
+
+// 预过滤环境贴图，第 mip 级的粗糙度为 mip / (mipCount - 1)
+// 粗糙度为 0 的第 0 级，着色器直接采样环境贴图第 0 级（512² 采样到 128² 会有锯齿），这里改为采样边长和输出相同的那一级
+inline void PrefilterEnvironment(const IBLImage& environment, IBLImage& prefilter, unsigned int size, unsigned int mipCount, unsigned int sampleCount, JobSystem* jobs = nullptr)
+{
+    prefilter.Allocate(size, 6u, mipCount, 3u);
+
+    struct PrefilterSample
+    {
+        glm::vec3 L;    // 切线空间中的光线方向
+        float Lod;
+    };
+
+    float environmentSize = static_cast<float>(environment.Size);
+    float saTexel = 4.0f * IBL_PI / (6.0f * environmentSize * environmentSize);
+    for (unsigned int mip = 0; mip < mipCount; mip++)
+    {
+        unsigned int mipSize = prefilter.GetMipSize(mip);
+        float roughness = mipCount > 1 ? static_cast<float>(mip) / static_cast<float>(mipCount - 1) : 0.0f;
+
+        std::vector<PrefilterSample> samples;
+        if (roughness == 0.0f)
+            samples.push_back(PrefilterSample{ glm::vec3(0.0f, 0.0f, 1.0f), std::log2(environmentSize / static_cast<float>(mipSize)) });
+        else
+        {
+            float a = roughness * roughness;
+            float a2 = a * a;
+            for (unsigned int i = 0; i < sampleCount; i++)
+            {
+                glm::vec3 H = ImportanceSampleGGX(i, sampleCount, roughness);
+                // V = N = +Z
+                glm::vec3 L = 2.0f * H.z * H - glm::vec3(0.0f, 0.0f, 1.0f);
+                if (L.z <= 0.0f)
+                    continue;
+                float NdotH2 = H.z * H.z;
+                float denominator = NdotH2 * (a2 - 1.0f) + 1.0f;
+                float D = a2 / (IBL_PI * denominator * denominator);
+                // pdf = D * NdotH / (4 * HdotV)，V = N 时 NdotH = HdotV
+                float pdf = D * 0.25f + 0.0001f;
+                float saSample = 1.0f / (static_cast<float>(sampleCount) * pdf + 0.0001f);
+                samples.push_back(PrefilterSample{ L, 0.5f * std::log2(saSample / saTexel) });
+            }
+        }
+
+        IBLParallelFor(jobs, 6u * mipSize, 2u, [&](unsigned int first, unsigned int last)
+        {
+            for (unsigned int row = first; row < last; row++)
+            {
+                unsigned int face = row / mipSize;
+                unsigned int y = row % mipSize;
+                float* dest = prefilter.GetLevel(mip, face) + static_cast<size_t>(y) * mipSize * 3;
+                for (unsigned int x = 0; x < mipSize; x++)
+                {
+                    glm::vec3 N = glm::normalize(CubeTexelDirection(face, x, y, mipSize));
+                    glm::vec3 up = std::abs(N.z) < 0.999f ? glm::vec3(0.0f, 0.0f, 1.0f) : glm::vec3(1.0f, 0.0f, 0.0f);
+                    glm::vec3 tangent = glm::normalize(glm::cross(up, N));
+                    glm::vec3 bitangent = glm::cross(N, tangent);
+
+                    glm::vec3 color(0.0f);
+                    float totalWeight = 0.0f;
+                    for (const PrefilterSample& sample : samples)
+                    {
+                        glm::vec3 L = tangent * sample.L.x + bitangent * sample.L.y + N * sample.L.z;
+                        color += SampleCube(environment, L, sample.Lod) * sample.L.z;
+                        totalWeight += sample.L.z;
+                    }
+                    color /= totalWeight;
+                    dest[x * 3 + 0] = color.r;
+                    dest[x * 3 + 1] = color.g;
+                    dest[x * 3 + 2] = color.b;
+                }
+            }
+        });
+    }
+}
+
+// split-sum 的 BRDF 积分：x = NdotV，y = 粗糙度，RG = (A, B)
+// 每一行（同一个粗糙度）先生成切线空间的半程向量，V 在 XZ 平面上，只用到 H 的 x、z 分量
+inline void IntegrateBRDFLUT(IBLImage& lut, unsigned int size, unsigned int sampleCount, JobSystem* jobs = nullptr)
+{
+    lut.Allocate(size, 1u, 1u, 2u);
+    unsigned int paddedCount = (sampleCount + 3u) & ~3u;
+
+    IBLParallelFor(jobs, size, 8u, [&](unsigned int first, unsigned int last)
+    {
+        // 补上的采样 Hz = 1、Hx = 0，NdotL = 2 * NdotV - NdotV > 0，用 valid 屏蔽
+        std::vector<float> hx(paddedCount, 0.0f), hz(paddedCount, 1.0f), valid(paddedCount, 0.0f);
+        for (unsigned int y = first; y < last; y++)
+        {
+            float roughness = (static_cast<float>(y) + 0.5f) / static_cast<float>(size);
+            float k = roughness * roughness * 0.5f;
+            for (unsigned int i = 0; i < sampleCount; i++)
+            {
+                glm::vec3 H = ImportanceSampleGGX(i, sampleCount, roughness);
+                hx[i] = H.x;
+                hz[i] = H.z;
+                valid[i] = 1.0f;
+            }
+
+            float* dest = lut.GetLevel(0u, 0u) + static_cast<size_t>(y) * size * 2;
+            for (unsigned int x = 0; x < size; x++)
+            {
+                float NdotV = (static_cast<float>(x) + 0.5f) / static_cast<float>(size);
+                float vx = std::sqrt(1.0f - NdotV * NdotV);
+                float vz = NdotV;
+                float gv = NdotV / (NdotV * (1.0f - k) + k);
+                float A = 0.0f, B = 0.0f;
+#ifdef IBL_PRECOMPUTE_SSE
+                __m128 zero = _mm_setzero_ps();
+                __m128 one = _mm_set1_ps(1.0f);
+                __m128 vxs = _mm_set1_ps(vx), vzs = _mm_set1_ps(vz);
+                __m128 ks = _mm_set1_ps(k), oneMinusK = _mm_set1_ps(1.0f - k);
+                __m128 gvOverNdotV = _mm_set1_ps(gv / NdotV);
+                __m128 sumA = zero, sumB = zero;
+                for (unsigned int i = 0; i < paddedCount; i += 4)
+                {
+                    __m128 Hx = _mm_loadu_ps(&hx[i]);
+                    __m128 Hz = _mm_loadu_ps(&hz[i]);
+                    __m128 VdotH = _mm_max_ps(_mm_add_ps(_mm_mul_ps(vxs, Hx), _mm_mul_ps(vzs, Hz)), zero);
+                    __m128 NdotL = _mm_sub_ps(_mm_mul_ps(_mm_add_ps(VdotH, VdotH), Hz), vzs);
+                    __m128 mask = _mm_and_ps(_mm_cmpgt_ps(NdotL, zero), _mm_cmpgt_ps(_mm_loadu_ps(&valid[i]), zero));
+                    __m128 gl = _mm_div_ps(NdotL, _mm_add_ps(_mm_mul_ps(NdotL, oneMinusK), ks));
+                    // G_Vis = G * VdotH / (NdotH * NdotV)
+                    __m128 gVis = _mm_div_ps(_mm_mul_ps(_mm_mul_ps(gl, gvOverNdotV), VdotH), Hz);
+                    __m128 t = _mm_sub_ps(one, VdotH);
+                    __m128 t2 = _mm_mul_ps(t, t);
+                    __m128 fc = _mm_mul_ps(_mm_mul_ps(t2, t2), t);
+                    gVis = _mm_and_ps(mask, gVis);
+                    sumA = _mm_add_ps(sumA, _mm_mul_ps(_mm_sub_ps(one, fc), gVis));
+                    sumB = _mm_add_ps(sumB, _mm_mul_ps(fc, gVis));
+                }
+                alignas(16) float lanes[4];
+                _mm_store_ps(lanes, sumA);
+                A = lanes[0] + lanes[1] + lanes[2] + lanes[3];
+                _mm_store_ps(lanes, sumB);
+                B = lanes[0] + lanes[1] + lanes[2] + lanes[3];
+#else
+                for (unsigned int i = 0; i < sampleCount; i++)
+                {
+                    float VdotH = std::max(vx * hx[i] + vz * hz[i], 0.0f);
+                    float NdotL = 2.0f * VdotH * hz[i] - vz;
+                    if (NdotL <= 0.0f)
+                        continue;
+                    float gl = NdotL / (NdotL * (1.0f - k) + k);
+                    float gVis = gl * gv * VdotH / (hz[i] * NdotV);
+                    float fc = std::pow(1.0f - VdotH, 5.0f);
+                    A += (1.0f - fc) * gVis;
+                    B += fc * gVis;
+                }
+#endif
+                dest[x * 2 + 0] = A / static_cast<float>(sampleCount);
+                dest[x * 2 + 1] = B / static_cast<float>(sampleCount);
+            }
+        }
+    });
+}
+
+// 完整的 CPU 预计算，不需要 OpenGL 上下文
+inline bool BakeIBL(const std::string& hdrPath, const IBLBakeSettings& settings, IBLMaps& maps, IBLBakeTimings& timings, JobSystem* jobs = nullptr)
+{
+    auto start = std::chrono::high_resolution_clock::now();
+    IBLImage equirect;
+    if (!LoadEquirectangular(hdrPath, equirect))
+    {
+        std::cout << "Failed to load HDR image: " << hdrPath << std::endl;
+        return false;
+    }
+    timings.LoadMs = IBLElapsedMs(start);
+
+    start = std::chrono::high_resolution_clock::now();
+    IBLImage environment;
+    EquirectangularToCubemap(equirect, environment, settings.EnvironmentSize, jobs);
+    timings.EnvironmentMs = IBLElapsedMs(start);
+
+    start = std::chrono::high_resolution_clock::now();
+    ConvolveIrradiance(environment, maps.Images[IBL_IRRADIANCE], settings.IrradianceSize, jobs);
+    timings.IrradianceMs = IBLElapsedMs(start);
+
+    // 球谐是低频信号，在 128² 那一级上投影就足够了
+    start = std::chrono::high_resolution_clock::now();
+    unsigned int shMip = 0;
+    while (shMip + 1 < environment.MipCount && environment.GetMipSize(shMip) > 128u)
+        shMip++;
+    maps.SH = ProjectIrradianceSH(environment, shMip, jobs);
+    timings.SHMs = IBLElapsedMs(start);
+
+    start = std::chrono::high_resolution_clock::now();
+    PrefilterEnvironment(environment, maps.Images[IBL_PREFILTER], settings.PrefilterSize, settings.PrefilterMipCount, settings.SampleCount, jobs);
+    timings.PrefilterMs = IBLElapsedMs(start);
+
+    start = std::chrono::high_resolution_clock::now();
+    IntegrateBRDFLUT(maps.Images[IBL_BRDF_LUT], settings.BRDFLUTSize, settings.SampleCount, jobs);
+    timings.BRDFMs = IBLElapsedMs(start);
+
+    // 背景只采样第 0 级，缓存中只保留第 0 级
+    environment.MipCount = 1u;
+    environment.Levels.resize(6u);
+    maps.Images[IBL_ENVIRONMENT] = std::move(environment);
+    return true;
+}
+
+inline void PrintIBLBakeTimings(const IBLBakeTimings& timings)
+{
+    std::cout << std::fixed << std::setprecision(1)
+              << "IBL bake (cpu): load " << timings.LoadMs << " ms, environment " << timings.EnvironmentMs
+              << " ms, irradiance " << timings.IrradianceMs << " ms, prefilter " << timings.PrefilterMs
+              << " ms, brdf " << timings.BRDFMs << " ms, sh " << timings.SHMs << " ms, total " << timings.GetTotalMs() << " ms" << std::endl;
+}
+
+// 缓存文件
+// ------------------------------------------------------------------------
+
+// 一张贴图：数据按 mip、面的顺序连续存放，每个 texel Channels 个半精度浮点
+struct IBLCacheImage
+{
+    uint32_t Size;
+    uint32_t FaceCount;
+    uint32_t MipCount;
+    uint32_t Channels;
+    uint64_t Offset;
+    uint64_t ByteSize;
+};
+
+struct IBLCacheHeader
+{
+    char Magic[4];
+    uint32_t Version;
+    uint64_t SourceHash;        // HDR 文件的 FNV-1a 哈希
+    uint64_t FileSize;
+    uint32_t SampleCount;
+    uint32_t ImageCount;
+    IBLCacheImage Images[IBL_IMAGE_COUNT];
+    float IrradianceSH[IRRADIANCE_SH_COEFFICIENT_COUNT * 3];
+};
+
+inline uint64_t HashIBLSource(const std::string& hdrPath)
+{
+    MappedFile source;
+    if (!source.Open(hdrPath))
+        return 0ull;
+    return HashBytes(source.GetData(), source.GetSize());
+}
+
+inline uint64_t GetIBLLevelByteSize(const IBLCacheImage& image, uint32_t mip)
+{
+    uint64_t size = std::max(1u, image.Size >> mip);
+    return size * size * image.Channels * sizeof(uint16_t);
+}
+
+inline bool WriteIBLCache(const std::string& cachePath, uint64_t sourceHash, uint32_t sampleCount, const IBLMaps& maps)
+{
+    IBLCacheHeader header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.Magic, IBL_CACHE_MAGIC, sizeof(header.Magic));
+    header.Version = IBL_CACHE_VERSION;
+    header.SourceHash = sourceHash;
+    header.SampleCount = sampleCount;
+    header.ImageCount = IBL_IMAGE_COUNT;
+    for (unsigned int i = 0; i < IRRADIANCE_SH_COEFFICIENT_COUNT; i++)
+        for (unsigned int c = 0; c < 3u; c++)
+            header.IrradianceSH[i * 3 + c] = maps.SH.Coefficients[i][c];
+    uint64_t offset = sizeof(IBLCacheHeader);
+    for (unsigned int i = 0; i < IBL_IMAGE_COUNT; i++)
+    {
+        const IBLImage& image = maps.Images[i];
+        IBLCacheImage& entry = header.Images[i];
+        entry.Size = image.Size;
+        entry.FaceCount = image.FaceCount;
+        entry.MipCount = image.MipCount;
+        entry.Channels = image.Channels;
+        entry.Offset = (offset + 15ull) & ~15ull;
+        entry.ByteSize = 0;
+        for (uint32_t mip = 0; mip < entry.MipCount; mip++)
+            entry.ByteSize += GetIBLLevelByteSize(entry, mip) * entry.FaceCount;
+        offset = entry.Offset + entry.ByteSize;
+    }
+    header.FileSize = offset;
+
+    // 先写临时文件再改名，避免中途失败留下半个缓存
+    std::string tempPath = cachePath + ".tmp";
+    std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+    if (!file)
+        return false;
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    std::vector<uint16_t> halfs;
+    for (unsigned int i = 0; i < IBL_IMAGE_COUNT; i++)
+    {
+        static const char zeros[16] = {};
+        uint64_t current = static_cast<uint64_t>(file.tellp());
+        if (header.Images[i].Offset > current)
+            file.write(zeros, static_cast<std::streamsize>(header.Images[i].Offset - current));
+        for (const std::vector<float>& level : maps.Images[i].Levels)
+        {
+            halfs.resize(level.size());
+            for (size_t t = 0; t < level.size(); t++)
+                halfs[t] = FloatToHalf(level[t]);
+            file.write(reinterpret_cast<const char*>(halfs.data()), static_cast<std::streamsize>(halfs.size() * sizeof(uint16_t)));
+        }
+    }
+    file.close();
+    if (!file)
+    {
+        std::remove(tempPath.c_str());
+        return false;
+    }
+    std::remove(cachePath.c_str());
+    return std::rename(tempPath.c_str(), cachePath.c_str()) == 0;
+}
+
+// 映射好的缓存文件
+class IBLCacheView
+{
+public:
+    // 打开并校验缓存，哈希、版本任意一个不匹配都返回 false
+    bool Open(const std::string& cachePath, uint64_t sourceHash)
+    {
+        if (!File.Open(cachePath) || File.GetSize() < sizeof(IBLCacheHeader))
+            return false;
+        Header = reinterpret_cast<const IBLCacheHeader*>(File.GetData());
+        if (std::memcmp(Header->Magic, IBL_CACHE_MAGIC, sizeof(Header->Magic)) != 0
+            || Header->Version != IBL_CACHE_VERSION
+            || Header->ImageCount != IBL_IMAGE_COUNT
+            || Header->SourceHash != sourceHash
+            || Header->FileSize != File.GetSize()
+            || !ValidateImages())
+        {
+            File.Close();
+            Header = nullptr;
+            return false;
+        }
+        return true;
+    }
+
+    inline const IBLCacheImage& GetImage(unsigned int index) const { return Header->Images[index]; }
+    inline uint64_t GetFileSize() const { return Header->FileSize; }
+
+    IrradianceSH GetIrradianceSH() const
+    {
+        IrradianceSH sh;
+        for (unsigned int i = 0; i < IRRADIANCE_SH_COEFFICIENT_COUNT; i++)
+            sh.Coefficients[i] = glm::vec3(Header->IrradianceSH[i * 3 + 0], Header->IrradianceSH[i * 3 + 1], Header->IrradianceSH[i * 3 + 2]);
+        return sh;
+    }
+
+    const uint16_t* GetLevel(unsigned int index, uint32_t mip, uint32_t face) const
+    {
+        const IBLCacheImage& image = Header->Images[index];
+        uint64_t offset = image.Offset;
+        for (uint32_t m = 0; m < mip; m++)
+            offset += GetIBLLevelByteSize(image, m) * image.FaceCount;
+        offset += GetIBLLevelByteSize(image, mip) * face;
+        return reinterpret_cast<const uint16_t*>(File.GetData() + offset);
+    }
+
+private:
+    // 文件被截断或损坏时返回 false，调用者重新烘焙，GetLevel 不会越界读取
+    // 尺寸先限制在合理范围内，后面按 mip 累加的字节数不会溢出；数据区先除后比较
+    bool ValidateImages() const
+    {
+        uint64_t fileSize = File.GetSize();
+        for (unsigned int i = 0; i < IBL_IMAGE_COUNT; i++)
+        {
+            const IBLCacheImage& image = Header->Images[i];
+            if (image.Size == 0u || image.Size > 16384u
+                || (image.FaceCount != 1u && image.FaceCount != 6u)
+                || (image.Channels != 2u && image.Channels != 3u)
+                || image.MipCount == 0u || image.MipCount > 15u || (image.Size >> (image.MipCount - 1u)) == 0u)
+                return false;
+
+            uint64_t byteSize = 0ull;
+            for (uint32_t mip = 0; mip < image.MipCount; mip++)
+                byteSize += GetIBLLevelByteSize(image, mip) * image.FaceCount;
+            if (image.ByteSize != byteSize
+                || image.Offset % 16ull != 0ull
+                || image.Offset < sizeof(IBLCacheHeader)
+                || image.Offset > fileSize
+                || image.ByteSize > fileSize - image.Offset)
+                return false;
+        }
+        return true;
+    }
+
+    MappedFile File;
+    const IBLCacheHeader* Header = nullptr;
+};
+
+// 上传到 OpenGL
+// ------------------------------------------------------------------------
+
+struct IBLTextures
+{
+    unsigned int Environment = 0;
+    unsigned int Irradiance = 0;
+    unsigned int Prefilter = 0;
+    unsigned int BRDFLUT = 0;
+};
+
+// 缓存中的一张贴图 → 立方体贴图或二维纹理，每级 mip 都来自文件
+inline unsigned int UploadIBLImage(const IBLCacheView& cache, unsigned int index)
+{
+    const IBLCacheImage& image = cache.GetImage(index);
+    GLenum target = image.FaceCount == 6u ? GL_TEXTURE_CUBE_MAP : GL_TEXTURE_2D;
+    GLenum internalFormat = image.Channels == 3u ? GL_RGB16F : GL_RG16F;
+    GLenum format = image.Channels == 3u ? GL_RGB : GL_RG;
+
+    unsigned int texture;
+    glGenTextures(1, &texture);
+    glBindTexture(target, texture);
+    // RGB16F 的一行不一定是 4 字节的倍数
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 2);
+    for (uint32_t mip = 0; mip < image.MipCount; mip++)
+    {
+        GLsizei size = static_cast<GLsizei>(std::max(1u, image.Size >> mip));
+        for (uint32_t face = 0; face < image.FaceCount; face++)
+        {
+            GLenum faceTarget = image.FaceCount == 6u ? GL_TEXTURE_CUBE_MAP_POSITIVE_X + face : GL_TEXTURE_2D;
+            glTexImage2D(faceTarget, mip, internalFormat, size, size, 0, format, GL_HALF_FLOAT, cache.GetLevel(index, mip, face));
+        }
+    }
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+
+    glTexParameteri(target, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(target, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    if (target == GL_TEXTURE_CUBE_MAP)
+        glTexParameteri(target, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+    glTexParameteri(target, GL_TEXTURE_MIN_FILTER, image.MipCount > 1u ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR);
+    glTexParameteri(target, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(target, GL_TEXTURE_MAX_LEVEL, static_cast<GLint>(image.MipCount - 1u));
+    return texture;
+}
+
+// 辐照度球谐的 uniform 缓冲：std140 布局下 9 个 vec4（w 不用），对应 pbr.fs 中的 IrradianceSH 块
+const unsigned int IRRADIANCE_SH_BINDING = 0u;
+
+inline unsigned int CreateIrradianceSHBuffer(const IrradianceSH& sh)
+{
+    glm::vec4 data[IRRADIANCE_SH_COEFFICIENT_COUNT];
+    for (unsigned int i = 0; i < IRRADIANCE_SH_COEFFICIENT_COUNT; i++)
+        data[i] = glm::vec4(sh.Coefficients[i], 0.0f);
+    unsigned int ubo;
+    glGenBuffers(1, &ubo);
+    glBindBuffer(GL_UNIFORM_BUFFER, ubo);
+    glBufferData(GL_UNIFORM_BUFFER, sizeof(data), data, GL_STATIC_DRAW);
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+    glBindBufferBase(GL_UNIFORM_BUFFER, IRRADIANCE_SH_BINDING, ubo);
+    return ubo;
+}
+
+inline void BindIrradianceSHBlock(unsigned int program)
+{
+    unsigned int blockIndex = glGetUniformBlockIndex(program, "IrradianceSH");
+    if (blockIndex != GL_INVALID_INDEX)
+        glUniformBlockBinding(program, blockIndex, IRRADIANCE_SH_BINDING);
+}
+
+// 把立方体贴图的一级 mip 读回 CPU（--ibl=gpu 时用来投影球谐）
+inline void ReadCubemapLevel(unsigned int texture, unsigned int mip, IBLImage& image)
+{
+    GLint size = 0;
+    glBindTexture(GL_TEXTURE_CUBE_MAP, texture);
+    glGetTexLevelParameteriv(GL_TEXTURE_CUBE_MAP_POSITIVE_X, static_cast<GLint>(mip), GL_TEXTURE_WIDTH, &size);
+    image.Allocate(static_cast<unsigned int>(size), 6u, 1u, 3u);
+    glPixelStorei(GL_PACK_ALIGNMENT, 4);
+    for (unsigned int face = 0; face < 6u; face++)
+        glGetTexImage(GL_TEXTURE_CUBE_MAP_POSITIVE_X + face, static_cast<GLint>(mip), GL_RGB, GL_FLOAT, image.GetLevel(0u, face));
+}
+
+// 从缓存加载 IBL 贴图；缓存不存在或者 HDR 文件改变时先在 CPU 上预计算并写缓存（bBaked = true）
+inline bool LoadOrBakeIBL(const std::string& hdrPath, IBLTextures& textures, IrradianceSH& sh, bool& bBaked)
+{
+    std::string cachePath = hdrPath + IBL_CACHE_EXTENSION;
+    uint64_t sourceHash = HashIBLSource(hdrPath);
+    bBaked = false;
+
+    IBLCacheView cache;
+    if (!cache.Open(cachePath, sourceHash))
+    {
+        IBLBakeSettings settings;
+        IBLMaps maps;
+        IBLBakeTimings timings;
+        JobSystem jobs;
+        if (!BakeIBL(hdrPath, settings, maps, timings, &jobs))
+            return false;
+        PrintIBLBakeTimings(timings);
+        bBaked = true;
+        if (!WriteIBLCache(cachePath, sourceHash, settings.SampleCount, maps) || !cache.Open(cachePath, sourceHash))
+        {
+            std::cout << "Failed to write IBL cache: " << cachePath << std::endl;
+            return false;
+        }
+    }
+
+    textures.Environment = UploadIBLImage(cache, IBL_ENVIRONMENT);
+    textures.Irradiance = UploadIBLImage(cache, IBL_IRRADIANCE);
+    textures.Prefilter = UploadIBLImage(cache, IBL_PREFILTER);
+    textures.BRDFLUT = UploadIBLImage(cache, IBL_BRDF_LUT);
+    sh = cache.GetIrradianceSH();
+    return true;
+}
@@ -0,0 +1,200 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <fstream>
+
+// 简单的图像写出工具（不依赖第三方库），用于保存帧缓冲截图
+// PNG 使用不压缩的 deflate 块，EXR 使用 NO_COMPRESSION 的 32 位浮点扫描线
+
+namespace ImageWriterDetail
+{
+    inline uint32_t Crc32(const unsigned char* data, size_t size, uint32_t crc = 0xFFFFFFFFu)
+    {
+        static uint32_t table[256];
+        static bool bTableReady = false;
+        if (!bTableReady)
+        {
+            for (uint32_t i = 0; i < 256; i++)
+            {
+                uint32_t c = i;
+                for (int k = 0; k < 8; k++)
+                    c = (c & 1u) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+                table[i] = c;
+            }
+            bTableReady = true;
+        }
+        for (size_t i = 0; i < size; i++)
+            crc = table[(crc ^ data[i]) & 0xFFu] ^ (crc >> 8);
+        return crc;
+    }
+
+    inline void PutU32BE(std::vector<unsigned char>& out, uint32_t value)
+    {
+        out.push_back(static_cast<unsigned char>(value >> 24));
+        out.push_back(static_cast<unsigned char>(value >> 16));
+        out.push_back(static_cast<unsigned char>(value >> 8));
+        out.push_back(static_cast<unsigned char>(value));
+    }
+
+    template<typename T>
+    inline void PutLE(std::vector<unsigned char>& out, T value)
+    {
+        const unsigned char* bytes = reinterpret_cast<const unsigned char*>(&value);
+        out.insert(out.end(), bytes, bytes + sizeof(T));
+    }
+
+    inline void PutString(std::vector<unsigned char>& out, const char* str)
+    {
+        while (*str)
+            out.push_back(static_cast<unsigned char>(*str++));
+        out.push_back(0);
+    }
+
+    inline void WriteChunk(std::vector<unsigned char>& png, const char* type, const std::vector<unsigned char>& data)
+    {
+        PutU32BE(png, static_cast<uint32_t>(data.size()));
+        size_t start = png.size();
+        png.insert(png.end(), type, type + 4);
+        png.insert(png.end(), data.begin(), data.end());
+        PutU32BE(png, Crc32(&png[start], png.size() - start) ^ 0xFFFFFFFFu);
+    }
+}
+
+// 写出 8 位 PNG，channels 为 3 或 4，flipY 用于 glReadPixels 读出的自下而上的数据
+inline bool WritePNG(const std::string& path, int width, int height, int channels, const unsigned char* pixels, bool flipY = true)
+{
+    using namespace ImageWriterDetail;
+    if (channels != 3 && channels != 4)
+        return false;
+
+    // 每行前面加一个过滤类型字节（0 = None）
+    size_t rowSize = static_cast<size_t>(width) * channels;
+    std::vector<unsigned char> raw;
+    raw.reserve((rowSize + 1) * height);
+    for (int y = 0; y < height; y++)
+    {
+        int srcY = flipY ? height - 1 - y : y;
+        raw.push_back(0);
+        raw.insert(raw.end(), pixels + srcY * rowSize, pixels + (srcY + 1) * rowSize);
+    }
+
+    // zlib 流：不压缩的 deflate 块 + adler32
+    std::vector<unsigned char> zlib = { 0x78, 0x01 };
+    size_t offset = 0;
+    do
+    {
+        size_t blockSize = raw.size() - offset < 65535u ? raw.size() - offset : 65535u;
+        bool bFinal = offset + blockSize == raw.size();
+        zlib.push_back(bFinal ? 1 : 0);
+        zlib.push_back(static_cast<unsigned char>(blockSize & 0xFF));
+        zlib.push_back(static_cast<unsigned char>(blockSize >> 8));
+        zlib.push_back(static_cast<unsigned char>(~blockSize & 0xFF));
+        zlib.push_back(static_cast<unsigned char>((~blockSize >> 8) & 0xFF));
+        zlib.insert(zlib.end(), raw.begin() + offset, raw.begin() + offset + blockSize);
+        offset += blockSize;
+    } while (offset < raw.size());
+    uint32_t a = 1, b = 0;
+    for (unsigned char c : raw)
+    {
+        a = (a + c) % 65521u;
+        b = (b + a) % 65521u;
+    }
+    PutU32BE(zlib, (b << 16) | a);
+
+    std::vector<unsigned char> png = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+    std::vector<unsigned char> header;
+    PutU32BE(header, static_cast<uint32_t>(width));
+    PutU32BE(header, static_cast<uint32_t>(height));
+    header.push_back(8);                        // bit depth
+    header.push_back(channels == 4 ? 6 : 2);    // color type: RGBA / RGB
+    header.push_back(0);
+    header.push_back(0);
+    header.push_back(0);
+    WriteChunk(png, "IHDR", header);
+    WriteChunk(png, "IDAT", zlib);
+    WriteChunk(png, "IEND", {});
+
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    file.write(reinterpret_cast<const char*>(png.data()), static_cast<std::streamsize>(png.size()));
+    return static_cast<bool>(file);
+}
+
+// 写出 32 位浮点 RGB 的 OpenEXR（HDR 帧缓冲使用），pixels 为 RGB 交错
+inline bool WriteEXR(const std::string& path, int width, int height, const float* pixels, bool flipY = true)
+{
+    using namespace ImageWriterDetail;
+    std::vector<unsigned char> exr = { 0x76, 0x2F, 0x31, 0x01, 2, 0, 0, 0 };
+
+    // channels：必须按字母顺序
+    PutString(exr, "channels");
+    PutString(exr, "chlist");
+    PutLE<int32_t>(exr, 3 * 18 + 1);
+    for (const char* channel : { "B", "G", "R" })
+    {
+        PutString(exr, channel);
+        PutLE<int32_t>(exr, 2);     // FLOAT
+        PutLE<int32_t>(exr, 0);     // pLinear + reserved
+        PutLE<int32_t>(exr, 1);     // xSampling
+        PutLE<int32_t>(exr, 1);     // ySampling
+    }
+    exr.push_back(0);
+    PutString(exr, "compression");
+    PutString(exr, "compression");
+    PutLE<int32_t>(exr, 1);
+    exr.push_back(0);               // NO_COMPRESSION
+    for (const char* window : { "dataWindow", "displayWindow" })
+    {
+        PutString(exr, window);
+        PutString(exr, "box2i");
+        PutLE<int32_t>(exr, 16);
+        PutLE<int32_t>(exr, 0);
+        PutLE<int32_t>(exr, 0);
+        PutLE<int32_t>(exr, width - 1);
+        PutLE<int32_t>(exr, height - 1);
+    }
+    PutString(exr, "lineOrder");
+    PutString(exr, "lineOrder");
+    PutLE<int32_t>(exr, 1);
+    exr.push_back(0);               // INCREASING_Y
+    PutString(exr, "pixelAspectRatio");
+    PutString(exr, "float");
+    PutLE<int32_t>(exr, 4);
+    PutLE<float>(exr, 1.0f);
+    PutString(exr, "screenWindowCenter");
+    PutString(exr, "v2f");
+    PutLE<int32_t>(exr, 8);
+    PutLE<float>(exr, 0.0f);
+    PutLE<float>(exr, 0.0f);
+    PutString(exr, "screenWindowWidth");
+    PutString(exr, "float");
+    PutLE<int32_t>(exr, 4);
+    PutLE<float>(exr, 1.0f);
+    exr.push_back(0);               // end of header
+
+    // 每条扫描线一个块
+    size_t lineDataSize = static_cast<size_t>(width) * 3 * sizeof(float);
+    size_t tableStart = exr.size();
+    uint64_t blockOffset = tableStart + static_cast<uint64_t>(height) * sizeof(uint64_t);
+    for (int y = 0; y < height; y++)
+    {
+        PutLE<uint64_t>(exr, blockOffset);
+        blockOffset += 8 + lineDataSize;
+    }
+    for (int y = 0; y < height; y++)
+    {
+        int srcY = flipY ? height - 1 - y : y;
+        const float* row = pixels + static_cast<size_t>(srcY) * width * 3;
+        PutLE<int32_t>(exr, y);
+        PutLE<int32_t>(exr, static_cast<int32_t>(lineDataSize));
+        for (int channel = 2; channel >= 0; channel--)
+        {
+            for (int x = 0; x < width; x++)
+                PutLE<float>(exr, row[x * 3 + channel]);
+        }
+    }
+
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    file.write(reinterpret_cast<const char*>(exr.data()), static_cast<std::streamsize>(exr.size()));
+    return static_cast<bool>(file);
+}
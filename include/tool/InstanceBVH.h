@@ -0,0 +1,279 @@
+#pragma once
+#include <glm/glm.hpp>
+
+#include <vector>
+#include <cstring>
+#include <algorithm>
+#include <limits>
+
+#include <tool/Frustum.h>
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#include <xmmintrin.h>
+#define INSTANCE_BVH_SSE 1
+#endif
+
+// 静态实例（小行星带之类）的 4 叉 BVH，用于 CPU 视锥体剔除
+// 1. 每个实例用世界空间包围球表示（模型的局部包围球经过实例矩阵变换）
+// 2. 构建时把实例按 BVH 顺序重新排列，每个节点覆盖一段连续的实例，完全在视锥体内的节点直接 memcpy 整段矩阵
+// 3. 节点把 4 个子节点的包围盒按 SoA 排列（MinX[4]、MinY[4]...），一次 SSE 运算测试 4 个子节点对一个平面
+class InstanceBVH
+{
+public:
+    // 叶节点最多包含的实例数
+    static const unsigned int LeafSize = 16u;
+
+    struct CullStats
+    {
+        unsigned int NodesVisited = 0u;
+        unsigned int SpheresTested = 0u;
+        unsigned int Visible = 0u;
+    };
+
+    // localCenter / localRadius：模型空间的包围球
+    void Build(const std::vector<glm::mat4>& matrices, const glm::vec3& localCenter, float localRadius)
+    {
+        Matrices = matrices;
+        Spheres.resize(Matrices.size());
+        for (size_t i = 0; i < Matrices.size(); i++)
+        {
+            const glm::mat4& m = Matrices[i];
+            // 非均匀缩放时取最大的轴向缩放，保证包围球仍然包住模型
+            float scale = std::max(glm::length(glm::vec3(m[0])), std::max(glm::length(glm::vec3(m[1])), glm::length(glm::vec3(m[2]))));
+            Spheres[i] = glm::vec4(glm::vec3(m * glm::vec4(localCenter, 1.0f)), localRadius * scale);
+        }
+
+        Nodes.clear();
+        Nodes.reserve(Matrices.size() / LeafSize + 1);
+        if (!Matrices.empty())
+            BuildNode(0u, static_cast<unsigned int>(Matrices.size()));
+    }
+
+    // 把可见实例的矩阵写入 out（容量至少为 GetInstanceCount()），返回可见数量
+    // out 可以直接是映射的缓冲指针：只会顺序写入，不会读取
+    size_t Cull(const Frustum& frustum, glm::mat4* out, CullStats* stats = nullptr) const
+    {
+        CullStats localStats;
+        size_t visible = 0;
+        if (Nodes.empty())
+            return 0;
+
+        int stack[256];
+        int stackSize = 0;
+        stack[stackSize++] = 0;
+        while (stackSize > 0)
+        {
+            const Node& node = Nodes[stack[--stackSize]];
+            localStats.NodesVisited++;
+
+            int outside[4] = { 0, 0, 0, 0 };
+            int partial[4] = { 0, 0, 0, 0 };
+            TestNode(node, frustum, outside, partial);
+
+            for (int lane = 0; lane < 4; lane++)
+            {
+                if (node.Count[lane] == 0u || outside[lane])
+                    continue;
+                if (!partial[lane])
+                {
+                    // 完全在视锥体内，整段拷贝
+                    std::memcpy(out + visible, &Matrices[node.First[lane]], node.Count[lane] * sizeof(glm::mat4));
+                    visible += node.Count[lane];
+                }
+                else if (node.Child[lane] >= 0)
+                {
+                    stack[stackSize++] = node.Child[lane];
+                }
+                else
+                {
+                    unsigned int end = node.First[lane] + node.Count[lane];
+                    for (unsigned int i = node.First[lane]; i < end; i++)
+                    {
+                        if (frustum.IntersectsSphere(glm::vec3(Spheres[i]), Spheres[i].w))
+                            out[visible++] = Matrices[i];
+                    }
+                    localStats.SpheresTested += node.Count[lane];
+                }
+            }
+        }
+
+        localStats.Visible = static_cast<unsigned int>(visible);
+        if (stats != nullptr)
+            *stats = localStats;
+        return visible;
+    }
+
+    inline size_t GetInstanceCount() const { return Matrices.size(); }
+    inline size_t GetNodeCount() const { return Nodes.size(); }
+    // BVH 顺序的实例矩阵
+    inline const std::vector<glm::mat4>& GetMatrices() const { return Matrices; }
+
+private:
+    struct alignas(16) Node
+    {
+        float MinX[4], MinY[4], MinZ[4];
+        float MaxX[4], MaxY[4], MaxZ[4];
+        // >= 0：内部节点索引，-1：叶节点
+        int Child[4];
+        unsigned int First[4];
+        unsigned int Count[4];
+    };
+
+    // 4 个子节点对 6 个平面的测试：outside = 完全在某个平面外侧，partial = 和某个平面相交（需要继续向下测试）
+    static void TestNode(const Node& node, const Frustum& frustum, int outside[4], int partial[4])
+    {
+#ifdef INSTANCE_BVH_SSE
+        __m128 minX = _mm_load_ps(node.MinX), minY = _mm_load_ps(node.MinY), minZ = _mm_load_ps(node.MinZ);
+        __m128 maxX = _mm_load_ps(node.MaxX), maxY = _mm_load_ps(node.MaxY), maxZ = _mm_load_ps(node.MaxZ);
+        __m128 zero = _mm_setzero_ps();
+        __m128 outsideMask = zero;
+        __m128 partialMask = zero;
+        for (const glm::vec4& plane : frustum.Planes)
+        {
+            __m128 nx = _mm_set1_ps(plane.x), ny = _mm_set1_ps(plane.y), nz = _mm_set1_ps(plane.z), d = _mm_set1_ps(plane.w);
+            // p-vertex：沿法线最远的角点，n-vertex：最近的角点
+            __m128 px = plane.x >= 0.0f ? maxX : minX, nx_ = plane.x >= 0.0f ? minX : maxX;
+            __m128 py = plane.y >= 0.0f ? maxY : minY, ny_ = plane.y >= 0.0f ? minY : maxY;
+            __m128 pz = plane.z >= 0.0f ? maxZ : minZ, nz_ = plane.z >= 0.0f ? minZ : maxZ;
+            __m128 farDistance = _mm_add_ps(_mm_add_ps(_mm_mul_ps(nx, px), _mm_mul_ps(ny, py)), _mm_add_ps(_mm_mul_ps(nz, pz), d));
+            __m128 nearDistance = _mm_add_ps(_mm_add_ps(_mm_mul_ps(nx, nx_), _mm_mul_ps(ny, ny_)), _mm_add_ps(_mm_mul_ps(nz, nz_), d));
+            outsideMask = _mm_or_ps(outsideMask, _mm_cmplt_ps(farDistance, zero));
+            partialMask = _mm_or_ps(partialMask, _mm_cmplt_ps(nearDistance, zero));
+        }
+        int outsideBits = _mm_movemask_ps(outsideMask);
+        int partialBits = _mm_movemask_ps(partialMask);
+        for (int lane = 0; lane < 4; lane++)
+        {
+            outside[lane] = (outsideBits >> lane) & 1;
+            partial[lane] = (partialBits >> lane) & 1;
+        }
+#else
+        for (const glm::vec4& plane : frustum.Planes)
+        {
+            for (int lane = 0; lane < 4; lane++)
+            {
+                float px = plane.x >= 0.0f ? node.MaxX[lane] : node.MinX[lane];
+                float py = plane.y >= 0.0f ? node.MaxY[lane] : node.MinY[lane];
+                float pz = plane.z >= 0.0f ? node.MaxZ[lane] : node.MinZ[lane];
+                float qx = plane.x >= 0.0f ? node.MinX[lane] : node.MaxX[lane];
+                float qy = plane.y >= 0.0f ? node.MinY[lane] : node.MaxY[lane];
+                float qz = plane.z >= 0.0f ? node.MinZ[lane] : node.MaxZ[lane];
+                outside[lane] |= plane.x * px + plane.y * py + plane.z * pz + plane.w < 0.0f;
+                partial[lane] |= plane.x * qx + plane.y * qy + plane.z * qz + plane.w < 0.0f;
+            }
+        }
+#endif
+    }
+
+    void ComputeBounds(unsigned int first, unsigned int count, glm::vec3& minCorner, glm::vec3& maxCorner) const
+    {
+        minCorner = glm::vec3(std::numeric_limits<float>::max());
+        maxCorner = glm::vec3(-std::numeric_limits<float>::max());
+        for (unsigned int i = first; i < first + count; i++)
+        {
+            glm::vec3 center(Spheres[i]);
+            minCorner = glm::min(minCorner, center - Spheres[i].w);
+            maxCorner = glm::max(maxCorner, center + Spheres[i].w);
+        }
+    }
+
+    // 按包围球中心最长轴的中位数把 [first, first + count) 分成两半
+    unsigned int Split(unsigned int first, unsigned int count)
+    {
+        glm::vec3 minCenter(std::numeric_limits<float>::max());
+        glm::vec3 maxCenter(-std::numeric_limits<float>::max());
+        for (unsigned int i = first; i < first + count; i++)
+        {
+            minCenter = glm::min(minCenter, glm::vec3(Spheres[i]));
+            maxCenter = glm::max(maxCenter, glm::vec3(Spheres[i]));
+        }
+        glm::vec3 extent = maxCenter - minCenter;
+        int axis = extent.x > extent.y ? (extent.x > extent.z ? 0 : 2) : (extent.y > extent.z ? 1 : 2);
+
+        // 对索引排序，然后同时重排球和矩阵
+        std::vector<unsigned int> order(count);
+        for (unsigned int i = 0; i < count; i++)
+            order[i] = first + i;
+        unsigned int half = count / 2;
+        std::nth_element(order.begin(), order.begin() + half, order.end(),
+            [this, axis](unsigned int a, unsigned int b) { return Spheres[a][axis] < Spheres[b][axis]; });
+        std::vector<glm::vec4> spheres(count);
+        std::vector<glm::mat4> matrices(count);
+        for (unsigned int i = 0; i < count; i++)
+        {
+            spheres[i] = Spheres[order[i]];
+            matrices[i] = Matrices[order[i]];
+        }
+        std::copy(spheres.begin(), spheres.end(), Spheres.begin() + first);
+        std::copy(matrices.begin(), matrices.end(), Matrices.begin() + first);
+        return half;
+    }
+
+    int BuildNode(unsigned int first, unsigned int count)
+    {
+        int index = static_cast<int>(Nodes.size());
+        Nodes.emplace_back();
+
+        // 分成最多 4 段
+        unsigned int ranges[4][2];
+        int rangeCount = 0;
+        if (count <= LeafSize)
+        {
+            ranges[rangeCount][0] = first;
+            ranges[rangeCount++][1] = count;
+        }
+        else
+        {
+            unsigned int half = Split(first, count);
+            unsigned int halves[2][2] = { { first, half }, { first + half, count - half } };
+            for (auto& range : halves)
+            {
+                if (range[1] > LeafSize)
+                {
+                    unsigned int quarter = Split(range[0], range[1]);
+                    ranges[rangeCount][0] = range[0];
+                    ranges[rangeCount++][1] = quarter;
+                    ranges[rangeCount][0] = range[0] + quarter;
+                    ranges[rangeCount++][1] = range[1] - quarter;
+                }
+                else
+                {
+                    ranges[rangeCount][0] = range[0];
+                    ranges[rangeCount++][1] = range[1];
+                }
+            }
+        }
+
+        // 先递归构建子节点（Nodes 可能会重新分配，所以最后再写入当前节点）
+        Node node;
+        for (int lane = 0; lane < 4; lane++)
+        {
+            if (lane >= rangeCount)
+            {
+                // 空子节点：包围盒取反，任何平面测试都在外侧
+                node.MinX[lane] = node.MinY[lane] = node.MinZ[lane] = std::numeric_limits<float>::max();
+                node.MaxX[lane] = node.MaxY[lane] = node.MaxZ[lane] = -std::numeric_limits<float>::max();
+                node.Child[lane] = -1;
+                node.First[lane] = 0u;
+                node.Count[lane] = 0u;
+                continue;
+            }
+            unsigned int childFirst = ranges[lane][0];
+            unsigned int childCount = ranges[lane][1];
+            glm::vec3 minCorner, maxCorner;
+            ComputeBounds(childFirst, childCount, minCorner, maxCorner);
+            node.MinX[lane] = minCorner.x; node.MinY[lane] = minCorner.y; node.MinZ[lane] = minCorner.z;
+            node.MaxX[lane] = maxCorner.x; node.MaxY[lane] = maxCorner.y; node.MaxZ[lane] = maxCorner.z;
+            node.First[lane] = childFirst;
+            node.Count[lane] = childCount;
+            node.Child[lane] = childCount > LeafSize ? BuildNode(childFirst, childCount) : -1;
+        }
+        Nodes[index] = node;
+        return index;
+    }
+
+    std::vector<Node> Nodes;
+    std::vector<glm::mat4> Matrices;
+    // xyz：世界空间球心，w：半径
+    std::vector<glm::vec4> Spheres;
+};
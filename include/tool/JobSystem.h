@@ -0,0 +1,271 @@
+#pragma once
+#include <iostream>
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <functional>
+#include <algorithm>
+#include <memory>
+
+struct Job;
+
+// 任务计数器：Run 时加一，任务完成时减一，减到 0 表示这一组任务全部完成
+// 也可以作为其他任务的依赖：依赖的计数器归零之后任务才会进入队列
+class JobCounter
+{
+public:
+    JobCounter() = default;
+    JobCounter(const JobCounter&) = delete;
+    JobCounter& operator=(const JobCounter&) = delete;
+
+    inline bool IsDone() const { return Count.load(std::memory_order_acquire) == 0; }
+    inline int GetCount() const { return Count.load(std::memory_order_acquire); }
+
+private:
+    friend class JobSystem;
+
+    std::atomic<int> Count{ 0 };
+    std::mutex Mutex;
+    // 等待这个计数器归零的任务
+    std::vector<Job*> Continuations;
+};
+
+struct Job
+{
+    std::function<void()> Function;
+    JobCounter* Signal;
+};
+
+// 工作窃取（work-stealing）任务系统
+// 1. 每个线程一个双端队列：自己从尾部取（后进先出，缓存友好），空闲线程从别人的头部偷（先进先出，偷到的通常是大块任务）
+// 2. 创建 JobSystem 的线程是 0 号线程，Wait 时也会执行任务，不会空等
+// 3. 队列都为空时工作线程睡眠，有新任务时唤醒
+//
+// 用法：
+//   JobSystem jobs;
+//   jobs.ParallelFor(0, count, 1024, [&](unsigned int first, unsigned int last) { ... });
+//
+//   JobCounter generated, bounded;
+//   jobs.Run([&] { ... }, &generated);
+//   jobs.Run([&] { ... }, &bounded, &generated);    // generated 归零之后才执行
+//   jobs.Wait(bounded);
+class JobSystem
+{
+public:
+    // threadCount 包括调用线程，0 表示使用全部硬件线程
+    JobSystem(unsigned int threadCount = 0u)
+    {
+        if (threadCount == 0u)
+            threadCount = std::max(1u, std::thread::hardware_concurrency());
+        for (unsigned int i = 0; i < threadCount; i++)
+            Queues.emplace_back(new WorkerQueue());
+        LocalSystem() = this;
+        LocalIndex() = 0u;
+        for (unsigned int i = 1; i < threadCount; i++)
+            Workers.emplace_back(&JobSystem::WorkerLoop, this, i);
+    }
+
+    ~JobSystem()
+    {
+        {
+            std::lock_guard<std::mutex> lock(SleepMutex);
+            bStop = true;
+        }
+        WakeCondition.notify_all();
+        for (std::thread& worker : Workers)
+            worker.join();
+        for (auto& queue : Queues)
+        {
+            for (Job* job : queue->Jobs)
+                delete job;
+        }
+        if (LocalSystem() == this)
+            LocalSystem() = nullptr;
+    }
+
+    JobSystem(const JobSystem&) = delete;
+    JobSystem& operator=(const JobSystem&) = delete;
+
+    // 提交任务，signal 不为空时任务完成后计数减一，dependency 不为空时等它归零后才执行
+    void Run(std::function<void()> function, JobCounter* signal = nullptr, JobCounter* dependency = nullptr)
+    {
+        if (signal != nullptr)
+            signal->Count.fetch_add(1, std::memory_order_relaxed);
+        Job* job = new Job{ std::move(function), signal };
+        if (dependency != nullptr)
+        {
+            std::lock_guard<std::mutex> lock(dependency->Mutex);
+            if (dependency->Count.load(std::memory_order_acquire) != 0)
+            {
+                dependency->Continuations.push_back(job);
+                return;
+            }
+        }
+        Push(job);
+    }
+
+    // 等待计数器归零，等待期间当前线程也执行任务
+    void Wait(JobCounter& counter)
+    {
+        while (!counter.IsDone())
+        {
+            if (!RunOne())
+                std::this_thread::yield();
+        }
+        // Finish 在持有锁的时候把计数减到 0，这里拿一次锁，保证 Finish 已经不再访问 counter（counter 可能马上被销毁）
+        std::lock_guard<std::mutex> lock(counter.Mutex);
+    }
+
+    // fork/join：把 [begin, end) 按 grainSize 切块并行执行 function(first, last)，返回时全部完成
+    template<typename Function>
+    void ParallelFor(unsigned int begin, unsigned int end, unsigned int grainSize, const Function& function)
+    {
+        if (end <= begin)
+            return;
+        grainSize = std::max(1u, grainSize);
+        if (end - begin <= grainSize || Queues.size() == 1u)
+        {
+            function(begin, end);
+            return;
+        }
+        JobCounter counter;
+        // 最后一块留给当前线程直接执行
+        unsigned int first = begin;
+        for (; first + grainSize < end; first += grainSize)
+        {
+            unsigned int last = first + grainSize;
+            Run([&function, first, last] { function(first, last); }, &counter);
+        }
+        function(first, end);
+        Wait(counter);
+    }
+
+    inline unsigned int GetThreadCount() const { return static_cast<unsigned int>(Queues.size()); }
+    // 从其他线程的队列偷到任务的次数
+    inline unsigned int GetStealCount() const { return Steals.load(std::memory_order_relaxed); }
+
+private:
+    // 每个队列独占缓存行，避免伪共享
+    struct alignas(64) WorkerQueue
+    {
+        std::mutex Mutex;
+        std::deque<Job*> Jobs;
+    };
+
+    static JobSystem*& LocalSystem()
+    {
+        thread_local JobSystem* system = nullptr;
+        return system;
+    }
+
+    static unsigned int& LocalIndex()
+    {
+        thread_local unsigned int index = 0u;
+        return index;
+    }
+
+    // 不属于这个任务系统的线程提交的任务放到 0 号队列
+    unsigned int GetLocalIndex() const
+    {
+        return LocalSystem() == this ? LocalIndex() : 0u;
+    }
+
+    void Push(Job* job)
+    {
+        WorkerQueue& queue = *Queues[GetLocalIndex()];
+        {
+            std::lock_guard<std::mutex> lock(queue.Mutex);
+            queue.Jobs.push_back(job);
+        }
+        Pending.fetch_add(1);
+        if (Sleeping.load() > 0)
+        {
+            std::lock_guard<std::mutex> lock(SleepMutex);
+            WakeCondition.notify_one();
+        }
+    }
+
+    Job* Pop()
+    {
+        unsigned int local = GetLocalIndex();
+        {
+            WorkerQueue& queue = *Queues[local];
+            std::lock_guard<std::mutex> lock(queue.Mutex);
+            if (!queue.Jobs.empty())
+            {
+                Job* job = queue.Jobs.back();
+                queue.Jobs.pop_back();
+                Pending.fetch_sub(1);
+                return job;
+            }
+        }
+        // 自己的队列空了，从下一个线程开始依次尝试偷
+        for (size_t offset = 1; offset < Queues.size(); offset++)
+        {
+            WorkerQueue& victim = *Queues[(local + offset) % Queues.size()];
+            std::lock_guard<std::mutex> lock(victim.Mutex);
+            if (!victim.Jobs.empty())
+            {
+                Job* job = victim.Jobs.front();
+                victim.Jobs.pop_front();
+                Pending.fetch_sub(1);
+                Steals.fetch_add(1, std::memory_order_relaxed);
+                return job;
+            }
+        }
+        return nullptr;
+    }
+
+    bool RunOne()
+    {
+        Job* job = Pop();
+        if (job == nullptr)
+            return false;
+        job->Function();
+        if (job->Signal != nullptr)
+            Finish(*job->Signal);
+        delete job;
+        return true;
+    }
+
+    void Finish(JobCounter& counter)
+    {
+        std::vector<Job*> ready;
+        {
+            std::lock_guard<std::mutex> lock(counter.Mutex);
+            if (counter.Count.fetch_sub(1, std::memory_order_acq_rel) == 1)
+                ready.swap(counter.Continuations);
+        }
+        for (Job* job : ready)
+            Push(job);
+    }
+
+    void WorkerLoop(unsigned int index)
+    {
+        LocalSystem() = this;
+        LocalIndex() = index;
+        while (true)
+        {
+            if (RunOne())
+                continue;
+            std::unique_lock<std::mutex> lock(SleepMutex);
+            Sleeping.fetch_add(1);
+            WakeCondition.wait(lock, [this] { return bStop || Pending.load() > 0; });
+            Sleeping.fetch_sub(1);
+            if (bStop)
+                return;
+        }
+    }
+
+    std::vector<std::unique_ptr<WorkerQueue>> Queues;
+    std::vector<std::thread> Workers;
+    std::atomic<int> Pending{ 0 };
+    std::atomic<int> Sleeping{ 0 };
+    std::atomic<unsigned int> Steals{ 0u };
+    std::mutex SleepMutex;
+    std::condition_variable WakeCondition;
+    bool bStop = false;
+};
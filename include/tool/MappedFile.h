@@ -0,0 +1,113 @@
+#pragma once
+#include <cstdint>
+#include <string>
+
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// 只读内存映射文件
+class MappedFile
+{
+public:
+    MappedFile() = default;
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    ~MappedFile() { Close(); }
+
+    bool Open(const std::string& path)
+    {
+        Close();
+#ifdef _WIN32
+        FileHandle = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (FileHandle == INVALID_HANDLE_VALUE)
+            return false;
+        LARGE_INTEGER size;
+        if (!GetFileSizeEx(FileHandle, &size) || size.QuadPart == 0)
+        {
+            Close();
+            return false;
+        }
+        Size = static_cast<size_t>(size.QuadPart);
+        MappingHandle = CreateFileMappingA(FileHandle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (MappingHandle == nullptr)
+        {
+            Close();
+            return false;
+        }
+        Data = static_cast<const unsigned char*>(MapViewOfFile(MappingHandle, FILE_MAP_READ, 0, 0, 0));
+#else
+        int fd = open(path.c_str(), O_RDONLY);
+        if (fd < 0)
+            return false;
+        struct stat st;
+        if (fstat(fd, &st) != 0 || st.st_size == 0)
+        {
+            close(fd);
+            return false;
+        }
+        Size = static_cast<size_t>(st.st_size);
+        void* ptr = mmap(nullptr, Size, PROT_READ, MAP_PRIVATE, fd, 0);
+        close(fd);
+        Data = ptr == MAP_FAILED ? nullptr : static_cast<const unsigned char*>(ptr);
+#endif
+        if (Data == nullptr)
+        {
+            Close();
+            return false;
+        }
+        return true;
+    }
+
+    void Close()
+    {
+#ifdef _WIN32
+        if (Data != nullptr)
+            UnmapViewOfFile(Data);
+        if (MappingHandle != nullptr)
+            CloseHandle(MappingHandle);
+        if (FileHandle != INVALID_HANDLE_VALUE)
+            CloseHandle(FileHandle);
+        MappingHandle = nullptr;
+        FileHandle = INVALID_HANDLE_VALUE;
+#else
+        if (Data != nullptr)
+            munmap(const_cast<unsigned char*>(Data), Size);
+#endif
+        Data = nullptr;
+        Size = 0;
+    }
+
+    inline const unsigned char* GetData() const { return Data; }
+    inline size_t GetSize() const { return Size; }
+
+private:
+    const unsigned char* Data = nullptr;
+    size_t Size = 0;
+#ifdef _WIN32
+    HANDLE FileHandle = INVALID_HANDLE_VALUE;
+    HANDLE MappingHandle = nullptr;
+#endif
+};
+
+// FNV-1a 64 位哈希
+inline uint64_t HashBytes(const unsigned char* data, size_t size, uint64_t hash = 14695981039346656037ull)
+{
+    for (size_t i = 0; i < size; i++)
+    {
+        hash ^= data[i];
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
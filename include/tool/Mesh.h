@@ -1,7 +1,11 @@
 #pragma once
 #include <vector>
+#include <limits>
+#include <string>
+#include <unordered_map>
 #include <glm/glm.hpp>
 #include <tool/Shader.h>
+#include <tool/VertexCompression.h>
 
 #define MAX_BONE_INFLUENCE 4
 
@@ -27,36 +31,190 @@ struct Texture
     std::string Path;
 };
 
+// GPU 上的顶点布局（加载时选择，CPU 端的 Vertices 始终是完整的 Vertex）
+enum class VertexLayout
+{
+    // 交错的完整 Vertex，兼容所有章节的着色器
+    Full = 0,
+    // 两个流：位置流 float3（深度/阴影 pass 只需要读这个流），属性流 12 字节：
+    // 八面体法线 snorm16x2 + 八面体切线 snorm8x2 + 副切线符号 + half UV
+    Compressed = 1,
+    // 同 Compressed，位置按网格包围盒量化为 unorm16，着色器中用 uPositionScale / uPositionBias 还原
+    Quantized = 2
+};
+
+// 压缩布局的属性流
+struct PackedVertexAttributes
+{
+    int16_t Normal[2];      // location 1：八面体编码
+    int8_t Tangent[4];      // location 3：xy 八面体编码，z 副切线符号（±1），w 未使用
+    uint16_t TexCoord[2];   // location 2：半精度
+};
+
+// 绘制统计（Mesh::Draw 和 RenderQueue 共享），每帧 Reset，用于比较两条路径每帧的绑定和绘制次数
+struct DrawStats
+{
+    unsigned int Draws = 0;
+    unsigned int ProgramBinds = 0;  // 只有 RenderQueue 统计（Mesh::Draw 不切换着色器）
+    unsigned int VAOBinds = 0;      // 包括绘制完恢复为 0 的绑定
+    unsigned int TextureBinds = 0;
+    unsigned int Filtered = 0;      // RenderQueue 发现状态没变而跳过的绑定
+
+    void Reset() { Draws = 0; ProgramBinds = 0; VAOBinds = 0; TextureBinds = 0; Filtered = 0; }
+};
+
+// 纹理组合相同的网格共用一个材质 ID（RenderQueue 按它排序，相邻的绘制不用重新绑定纹理），需要在 GL 线程调用
+inline uint32_t RegisterMaterial(const std::vector<Texture>& textures)
+{
+    static std::unordered_map<std::string, uint32_t> materials;
+    std::string key;
+    for (const Texture& texture : textures)
+        key += std::to_string(texture.ID) + texture.Type + ';';
+    return materials.emplace(key, static_cast<uint32_t>(materials.size())).first->second;
+}
+
 class Mesh
 {
 public:
     std::vector<Vertex> Vertices;
     std::vector<unsigned int> Indices;
     std::vector<Texture> Textures;
+    VertexLayout Layout;
 
-    Mesh(std::vector<Vertex> vertices, std::vector<unsigned int> indices, std::vector<Texture> textures)
+    Mesh(std::vector<Vertex> vertices, std::vector<unsigned int> indices, std::vector<Texture> textures, VertexLayout layout = VertexLayout::Full)
     {
         Vertices = vertices;
         Indices = indices;
         Textures = textures;
+        Layout = layout;
+        SamplerNames = GetSamplerNames(Textures);
+        MaterialID = RegisterMaterial(Textures);
+
+        glm::vec3 minCorner(std::numeric_limits<float>::max());
+        glm::vec3 maxCorner(-std::numeric_limits<float>::max());
+        for (const Vertex& vertex : Vertices)
+        {
+            minCorner = glm::min(minCorner, vertex.Position);
+            maxCorner = glm::max(maxCorner, vertex.Position);
+        }
+        if (!Vertices.empty())
+            BoundsCenter = (minCorner + maxCorner) * 0.5f;
 
         SetupMesh();
     }
 
-    // 绘制
-    void Draw(Shader shader)
+    // 每个顶点在显存中的字节数
+    static size_t GetVertexStride(VertexLayout layout)
+    {
+        switch (layout)
+        {
+        case VertexLayout::Compressed:
+            return sizeof(float) * 3 + sizeof(PackedVertexAttributes);
+        case VertexLayout::Quantized:
+            return sizeof(uint16_t) * 4 + sizeof(PackedVertexAttributes);
+        default:
+            return sizeof(Vertex);
+        }
+    }
+
+    // 只绘制位置时每个顶点读取的字节数（完整布局的位置和其它属性交错存放，按整个 Vertex 计算）
+    static size_t GetPositionStride(VertexLayout layout)
+    {
+        switch (layout)
+        {
+        case VertexLayout::Compressed:
+            return sizeof(float) * 3;
+        case VertexLayout::Quantized:
+            return sizeof(uint16_t) * 4;
+        default:
+            return sizeof(Vertex);
+        }
+    }
+
+    // 顶点缓冲占用的显存
+    inline size_t GetVertexMemory() const { return Vertices.size() * GetVertexStride(Layout); }
+
+    // 绘制（按场景顺序逐个绘制时使用，每次都重新绑定纹理和 VAO，大量绘制使用 RenderQueue）
+    void Draw(const Shader& shader) const
+    {
+        DrawStats& stats = GetDrawStats();
+        for (unsigned int i = 0; i < Textures.size(); i++)
+        {
+            // 在绑定之前激活纹理单元
+            glActiveTexture(GL_TEXTURE0 + i);
+            // 采样器的值没有变化时 Shader 不会调用 glUniform1i
+            shader.SetInt(SamplerNames[i].c_str(), i);
+            glBindTexture(GL_TEXTURE_2D, Textures[i].ID);
+            stats.TextureBinds++;
+        }
+
+        // 压缩布局需要着色器解码（uVertexLayout 默认为 0，画完恢复，不影响同一个着色器绘制的其他物体）
+        if (Layout != VertexLayout::Full)
+        {
+            shader.SetInt("uVertexLayout", static_cast<int>(Layout));
+            shader.SetVec3f("uPositionScale", PositionScale);
+            shader.SetVec3f("uPositionBias", PositionBias);
+        }
+
+        // 绘制网格
+        glBindVertexArray(VAO);
+        glDrawElements(GL_TRIANGLES, static_cast<unsigned int>(Indices.size()), GL_UNSIGNED_INT, (void*)0);
+        glBindVertexArray(0u);
+        stats.VAOBinds += 2u;
+        stats.Draws++;
+
+        if (Layout != VertexLayout::Full)
+            shader.SetInt("uVertexLayout", 0);
+
+        glActiveTexture(GL_TEXTURE0);
+    }
+
+    // 只绘制位置（深度/阴影 pass），压缩布局下只读取位置流，不绑定纹理
+    // 着色器和 Draw 一样用 uVertexLayout / uPositionScale / uPositionBias 还原量化的位置
+    void DrawPositions(const Shader& shader) const
+    {
+        DrawStats& stats = GetDrawStats();
+        shader.SetInt("uVertexLayout", static_cast<int>(Layout));
+        shader.SetVec3f("uPositionScale", PositionScale);
+        shader.SetVec3f("uPositionBias", PositionBias);
+
+        glBindVertexArray(PositionVAO);
+        glDrawElements(GL_TRIANGLES, static_cast<unsigned int>(Indices.size()), GL_UNSIGNED_INT, (void*)0);
+        glBindVertexArray(0u);
+        stats.VAOBinds += 2u;
+        stats.Draws++;
+    }
+
+    // Full 布局时 PositionVAO == VAO，PositionVBO == VBO
+    unsigned int VAO, VBO, EBO;
+    unsigned int PositionVAO, PositionVBO;
+    // 量化位置的还原参数：position = quantized * PositionScale + PositionBias（非量化布局为 1 和 0）
+    glm::vec3 PositionScale = glm::vec3(1.0f);
+    glm::vec3 PositionBias = glm::vec3(0.0f);
+    // 第 i 个纹理对应的采样器 uniform（uMaterial.TextureDiffuseN 等，N 从 1 开始），构造时生成，绘制时不再拼接字符串
+    std::vector<std::string> SamplerNames;
+    uint32_t MaterialID = 0u;
+    // 模型空间包围盒中心（RenderQueue 用它计算深度）
+    glm::vec3 BoundsCenter = glm::vec3(0.0f);
+
+    static DrawStats& GetDrawStats()
+    {
+        static DrawStats stats;
+        return stats;
+    }
+
+    static std::vector<std::string> GetSamplerNames(const std::vector<Texture>& textures)
     {
         unsigned int diffuseNr = 1;
         unsigned int specularNr = 1;
         unsigned int normalNr = 1;
         unsigned int heightNr = 1;
-        for (unsigned int i = 0; i < Textures.size(); i++)
+        std::vector<std::string> names;
+        for (const Texture& texture : textures)
         {
-            // 在绑定之前激活纹理单元
-            glActiveTexture(GL_TEXTURE0 + i);
             // 获取纹理序号（uTextureDiffuseN 中的 N）
             std::string number;
-            std::string name = Textures[i].Type;
+            const std::string& name = texture.Type;
             if (name == "TextureDiffuse")
                 number = std::to_string(diffuseNr++);
             else if (name == "TextureSpecular")
@@ -65,27 +223,21 @@ public:
                 number = std::to_string(normalNr++);
             else if (name == "TextureHeight")
                 number = std::to_string(heightNr++);
-
-            shader.SetInt(("uMaterial." + name + number).c_str(), i);
-            std::cout << ("uMaterial." + name + number) << std::endl;
-            
-            glBindTexture(GL_TEXTURE_2D, Textures[i].ID);
+            names.push_back("uMaterial." + name + number);
         }
-
-        // 绘制网格
-        glBindVertexArray(VAO);
-        glDrawElements(GL_TRIANGLES, static_cast<unsigned int>(Indices.size()), GL_UNSIGNED_INT, (void*)0);
-        glBindVertexArray(0u);
-
-        glActiveTexture(GL_TEXTURE0);
+        return names;
     }
 
-    unsigned int VAO, VBO, EBO;
-
 private:
     // 设置网格
     void SetupMesh()
     {
+        if (Layout != VertexLayout::Full)
+        {
+            SetupCompressedMesh();
+            return;
+        }
+
         glGenVertexArrays(1, &VAO);
         glGenBuffers(1, &VBO);
         glGenBuffers(1, &EBO);
@@ -119,5 +271,102 @@ private:
         glVertexAttribPointer(6u, 4, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, Weights));
 
         glBindVertexArray(0u);
+
+        PositionVAO = VAO;
+        PositionVBO = VBO;
+    }
+
+    // 压缩布局：位置流 + 属性流两个缓冲，另外建一个只引用位置流的 VAO
+    void SetupCompressedMesh()
+    {
+        std::vector<PackedVertexAttributes> attributes(Vertices.size());
+        for (size_t i = 0; i < Vertices.size(); i++)
+        {
+            const Vertex& vertex = Vertices[i];
+            PackedVertexAttributes& packed = attributes[i];
+            glm::vec2 normal = OctahedralEncode(vertex.Normal);
+            packed.Normal[0] = PackSnorm16(normal.x);
+            packed.Normal[1] = PackSnorm16(normal.y);
+            glm::vec2 tangent = OctahedralEncode(vertex.Tangent);
+            packed.Tangent[0] = PackSnorm8(tangent.x);
+            packed.Tangent[1] = PackSnorm8(tangent.y);
+            // 副切线只保存相对 cross(N, T) 的方向
+            packed.Tangent[2] = glm::dot(glm::cross(vertex.Normal, vertex.Tangent), vertex.Bitangent) < 0.0f ? -127 : 127;
+            packed.Tangent[3] = 0;
+            packed.TexCoord[0] = FloatToHalf(vertex.TexCoord.x);
+            packed.TexCoord[1] = FloatToHalf(vertex.TexCoord.y);
+        }
+
+        glGenVertexArrays(1, &VAO);
+        glGenVertexArrays(1, &PositionVAO);
+        glGenBuffers(1, &PositionVBO);
+        glGenBuffers(1, &VBO);
+        glGenBuffers(1, &EBO);
+
+        // 位置流
+        glBindBuffer(GL_ARRAY_BUFFER, PositionVBO);
+        if (Layout == VertexLayout::Quantized)
+        {
+            glm::vec3 minCorner(std::numeric_limits<float>::max());
+            glm::vec3 maxCorner(-std::numeric_limits<float>::max());
+            for (const Vertex& vertex : Vertices)
+            {
+                minCorner = glm::min(minCorner, vertex.Position);
+                maxCorner = glm::max(maxCorner, vertex.Position);
+            }
+            PositionBias = minCorner;
+            PositionScale = glm::max(maxCorner - minCorner, glm::vec3(1e-6f));
+            // 每个位置 4 个 uint16，第 4 个分量只用于 8 字节对齐
+            std::vector<uint16_t> positions(Vertices.size() * 4, 0u);
+            for (size_t i = 0; i < Vertices.size(); i++)
+            {
+                glm::vec3 normalized = (Vertices[i].Position - PositionBias) / PositionScale;
+                positions[i * 4 + 0] = PackUnorm16(normalized.x);
+                positions[i * 4 + 1] = PackUnorm16(normalized.y);
+                positions[i * 4 + 2] = PackUnorm16(normalized.z);
+            }
+            glBufferData(GL_ARRAY_BUFFER, positions.size() * sizeof(uint16_t), positions.data(), GL_STATIC_DRAW);
+        }
+        else
+        {
+            std::vector<glm::vec3> positions(Vertices.size());
+            for (size_t i = 0; i < Vertices.size(); i++)
+                positions[i] = Vertices[i].Position;
+            glBufferData(GL_ARRAY_BUFFER, positions.size() * sizeof(glm::vec3), positions.data(), GL_STATIC_DRAW);
+        }
+
+        // 属性流
+        glBindBuffer(GL_ARRAY_BUFFER, VBO);
+        glBufferData(GL_ARRAY_BUFFER, attributes.size() * sizeof(PackedVertexAttributes), attributes.data(), GL_STATIC_DRAW);
+
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, Indices.size() * sizeof(unsigned int), &Indices[0], GL_STATIC_DRAW);
+
+        for (unsigned int vao : { VAO, PositionVAO })
+        {
+            glBindVertexArray(vao);
+            glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
+            // 顶点位置
+            glBindBuffer(GL_ARRAY_BUFFER, PositionVBO);
+            glEnableVertexAttribArray(0u);
+            if (Layout == VertexLayout::Quantized)
+                glVertexAttribPointer(0u, 3, GL_UNSIGNED_SHORT, GL_TRUE, 4 * sizeof(uint16_t), (void*)0);
+            else
+                glVertexAttribPointer(0u, 3, GL_FLOAT, GL_FALSE, sizeof(glm::vec3), (void*)0);
+            if (vao == PositionVAO)
+                continue;
+
+            glBindBuffer(GL_ARRAY_BUFFER, VBO);
+            // 顶点法线（八面体编码）
+            glEnableVertexAttribArray(1u);
+            glVertexAttribPointer(1u, 2, GL_SHORT, GL_TRUE, sizeof(PackedVertexAttributes), (void*)offsetof(PackedVertexAttributes, Normal));
+            // 顶点纹理（半精度）
+            glEnableVertexAttribArray(2u);
+            glVertexAttribPointer(2u, 2, GL_HALF_FLOAT, GL_FALSE, sizeof(PackedVertexAttributes), (void*)offsetof(PackedVertexAttributes, TexCoord));
+            // 顶点切线（八面体编码 + 副切线符号）
+            glEnableVertexAttribArray(3u);
+            glVertexAttribPointer(3u, 4, GL_BYTE, GL_TRUE, sizeof(PackedVertexAttributes), (void*)offsetof(PackedVertexAttributes, Tangent));
+        }
+        glBindVertexArray(0u);
     }
 };
\ No newline at end of file
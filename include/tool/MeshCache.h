@@ -0,0 +1,251 @@
+#pragma once
+#include <tool/Mesh.h>
+
+#include <tool/MappedFile.h>
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <fstream>
+
+// 二进制网格缓存（.meshcache）
+// 第一次加载模型时由 Assimp 解析，然后把处理好的顶点、索引、纹理引用和每个网格的范围写到源文件旁边，
+// 之后只要源文件哈希和后处理标记一致，就直接内存映射缓存文件，不再做任何解析。
+//
+// 文件布局（各段 16 字节对齐）：
+// [MeshCacheHeader][Vertex * VertexCount][uint32 * IndexCount][MeshCacheRange * MeshCount][MeshCacheTextureRef * TextureRefCount][字符串池]
+
+// 修改 Vertex 结构、文件布局或者导入时的网格处理（2：MeshOptimizer）时都要增加版本号
+const uint32_t MESH_CACHE_VERSION = 2u;
+const char MESH_CACHE_MAGIC[4] = { 'L', 'O', 'G', 'M' };
+const char* const MESH_CACHE_EXTENSION = ".meshcache";
+
+struct MeshCacheHeader
+{
+    char Magic[4];
+    uint32_t Version;
+    uint32_t VertexStride;      // sizeof(Vertex)，结构体变化时缓存自动失效
+    uint32_t ImportFlags;       // Assimp 后处理标记
+    uint64_t SourceHash;        // 源文件（以及同名 .mtl）的 FNV-1a 哈希
+    uint64_t FileSize;
+    uint32_t MeshCount;
+    uint32_t TextureRefCount;
+    uint64_t VertexCount;
+    uint64_t IndexCount;
+    uint64_t VertexOffset;
+    uint64_t IndexOffset;
+    uint64_t MeshTableOffset;
+    uint64_t TextureTableOffset;
+    uint64_t StringOffset;
+    uint64_t StringSize;
+};
+
+// 一个网格在顶点/索引/纹理表中的范围
+struct MeshCacheRange
+{
+    uint32_t FirstVertex;
+    uint32_t VertexCount;
+    uint32_t FirstIndex;
+    uint32_t IndexCount;
+    uint32_t FirstTexture;
+    uint32_t TextureCount;
+};
+
+// 纹理引用，字符串都存在字符串池中
+struct MeshCacheTextureRef
+{
+    uint32_t TypeOffset;
+    uint32_t TypeLength;
+    uint32_t PathOffset;
+    uint32_t PathLength;
+};
+
+// 计算源文件哈希，同名的 .mtl 也算进去（材质改了缓存也要失效）
+inline uint64_t HashSourceAsset(const std::string& path)
+{
+    uint64_t hash = 14695981039346656037ull;
+    MappedFile source;
+    if (!source.Open(path))
+        return 0ull;
+    hash = HashBytes(source.GetData(), source.GetSize(), hash);
+
+    std::string mtlPath = path.substr(0, path.find_last_of('.')) + ".mtl";
+    MappedFile mtl;
+    if (mtl.Open(mtlPath))
+        hash = HashBytes(mtl.GetData(), mtl.GetSize(), hash);
+    return hash;
+}
+
+inline uint64_t AlignCacheOffset(uint64_t offset)
+{
+    return (offset + 15ull) & ~15ull;
+}
+
+// 把已经处理好的网格写入缓存文件
+inline bool WriteMeshCache(const std::string& cachePath, uint64_t sourceHash, uint32_t importFlags, const std::vector<Mesh>& meshes)
+{
+    MeshCacheHeader header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.Magic, MESH_CACHE_MAGIC, sizeof(header.Magic));
+    header.Version = MESH_CACHE_VERSION;
+    header.VertexStride = sizeof(Vertex);
+    header.ImportFlags = importFlags;
+    header.SourceHash = sourceHash;
+    header.MeshCount = static_cast<uint32_t>(meshes.size());
+
+    std::vector<MeshCacheRange> ranges;
+    std::vector<MeshCacheTextureRef> textureRefs;
+    std::string strings;
+    for (const Mesh& mesh : meshes)
+    {
+        MeshCacheRange range;
+        range.FirstVertex = static_cast<uint32_t>(header.VertexCount);
+        range.VertexCount = static_cast<uint32_t>(mesh.Vertices.size());
+        range.FirstIndex = static_cast<uint32_t>(header.IndexCount);
+        range.IndexCount = static_cast<uint32_t>(mesh.Indices.size());
+        range.FirstTexture = static_cast<uint32_t>(textureRefs.size());
+        range.TextureCount = static_cast<uint32_t>(mesh.Textures.size());
+        ranges.push_back(range);
+        header.VertexCount += mesh.Vertices.size();
+        header.IndexCount += mesh.Indices.size();
+
+        for (const Texture& texture : mesh.Textures)
+        {
+            MeshCacheTextureRef ref;
+            ref.TypeOffset = static_cast<uint32_t>(strings.size());
+            ref.TypeLength = static_cast<uint32_t>(texture.Type.size());
+            strings += texture.Type;
+            ref.PathOffset = static_cast<uint32_t>(strings.size());
+            ref.PathLength = static_cast<uint32_t>(texture.Path.size());
+            strings += texture.Path;
+            textureRefs.push_back(ref);
+        }
+    }
+    header.TextureRefCount = static_cast<uint32_t>(textureRefs.size());
+    header.VertexOffset = AlignCacheOffset(sizeof(MeshCacheHeader));
+    header.IndexOffset = AlignCacheOffset(header.VertexOffset + header.VertexCount * sizeof(Vertex));
+    header.MeshTableOffset = AlignCacheOffset(header.IndexOffset + header.IndexCount * sizeof(uint32_t));
+    header.TextureTableOffset = AlignCacheOffset(header.MeshTableOffset + ranges.size() * sizeof(MeshCacheRange));
+    header.StringOffset = AlignCacheOffset(header.TextureTableOffset + textureRefs.size() * sizeof(MeshCacheTextureRef));
+    header.StringSize = strings.size();
+    header.FileSize = header.StringOffset + header.StringSize;
+
+    // 先写临时文件再改名，避免中途失败留下半个缓存
+    std::string tempPath = cachePath + ".tmp";
+    std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+    if (!file)
+        return false;
+    auto pad = [&file](uint64_t offset)
+    {
+        static const char zeros[16] = {};
+        uint64_t current = static_cast<uint64_t>(file.tellp());
+        if (offset > current)
+            file.write(zeros, static_cast<std::streamsize>(offset - current));
+    };
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    pad(header.VertexOffset);
+    for (const Mesh& mesh : meshes)
+        file.write(reinterpret_cast<const char*>(mesh.Vertices.data()), static_cast<std::streamsize>(mesh.Vertices.size() * sizeof(Vertex)));
+    pad(header.IndexOffset);
+    for (const Mesh& mesh : meshes)
+        file.write(reinterpret_cast<const char*>(mesh.Indices.data()), static_cast<std::streamsize>(mesh.Indices.size() * sizeof(uint32_t)));
+    pad(header.MeshTableOffset);
+    file.write(reinterpret_cast<const char*>(ranges.data()), static_cast<std::streamsize>(ranges.size() * sizeof(MeshCacheRange)));
+    pad(header.TextureTableOffset);
+    file.write(reinterpret_cast<const char*>(textureRefs.data()), static_cast<std::streamsize>(textureRefs.size() * sizeof(MeshCacheTextureRef)));
+    pad(header.StringOffset);
+    file.write(strings.data(), static_cast<std::streamsize>(strings.size()));
+    file.close();
+    if (!file)
+    {
+        std::remove(tempPath.c_str());
+        return false;
+    }
+    std::remove(cachePath.c_str());
+    return std::rename(tempPath.c_str(), cachePath.c_str()) == 0;
+}
+
+// 映射好的缓存文件，各段直接指向映射内存
+class MeshCacheView
+{
+public:
+    // 打开并校验缓存，哈希、标记、版本任意一个不匹配或者各段超出文件范围都返回 false
+    bool Open(const std::string& cachePath, uint64_t sourceHash, uint32_t importFlags)
+    {
+        if (!File.Open(cachePath) || File.GetSize() < sizeof(MeshCacheHeader))
+            return false;
+        Header = reinterpret_cast<const MeshCacheHeader*>(File.GetData());
+        if (std::memcmp(Header->Magic, MESH_CACHE_MAGIC, sizeof(Header->Magic)) != 0
+            || Header->Version != MESH_CACHE_VERSION
+            || Header->VertexStride != sizeof(Vertex)
+            || Header->ImportFlags != importFlags
+            || Header->SourceHash != sourceHash
+            || Header->FileSize != File.GetSize()
+            || !ValidateSections())
+        {
+            File.Close();
+            return false;
+        }
+        return true;
+    }
+
+    inline uint32_t GetMeshCount() const { return Header->MeshCount; }
+    inline const MeshCacheRange& GetRange(uint32_t i) const { return Section<MeshCacheRange>(Header->MeshTableOffset)[i]; }
+    inline const Vertex* GetVertices(const MeshCacheRange& range) const { return Section<Vertex>(Header->VertexOffset) + range.FirstVertex; }
+    inline const uint32_t* GetIndices(const MeshCacheRange& range) const { return Section<uint32_t>(Header->IndexOffset) + range.FirstIndex; }
+    inline const MeshCacheTextureRef& GetTextureRef(const MeshCacheRange& range, uint32_t i) const { return Section<MeshCacheTextureRef>(Header->TextureTableOffset)[range.FirstTexture + i]; }
+    inline std::string GetString(uint32_t offset, uint32_t length) const { return std::string(Section<char>(Header->StringOffset) + offset, length); }
+
+private:
+    template<typename T>
+    const T* Section(uint64_t offset) const { return reinterpret_cast<const T*>(File.GetData() + offset); }
+
+    // [offset, offset + count * stride) 必须在文件内并且 16 字节对齐（先除后比较，count 很大时不会溢出）
+    bool IsSectionInFile(uint64_t offset, uint64_t count, uint64_t stride) const
+    {
+        uint64_t size = File.GetSize();
+        return offset % 16ull == 0ull && offset <= size && count <= (size - offset) / stride;
+    }
+
+    // 文件被截断或损坏时返回 false，调用者重新用 Assimp 导入，不会越界读取
+    bool ValidateSections() const
+    {
+        if (!IsSectionInFile(Header->VertexOffset, Header->VertexCount, sizeof(Vertex))
+            || !IsSectionInFile(Header->IndexOffset, Header->IndexCount, sizeof(uint32_t))
+            || !IsSectionInFile(Header->MeshTableOffset, Header->MeshCount, sizeof(MeshCacheRange))
+            || !IsSectionInFile(Header->TextureTableOffset, Header->TextureRefCount, sizeof(MeshCacheTextureRef))
+            || !IsSectionInFile(Header->StringOffset, Header->StringSize, 1ull))
+            return false;
+
+        const MeshCacheRange* ranges = Section<MeshCacheRange>(Header->MeshTableOffset);
+        const uint32_t* indices = Section<uint32_t>(Header->IndexOffset);
+        for (uint32_t i = 0; i < Header->MeshCount; i++)
+        {
+            const MeshCacheRange& range = ranges[i];
+            if (static_cast<uint64_t>(range.FirstVertex) + range.VertexCount > Header->VertexCount
+                || static_cast<uint64_t>(range.FirstIndex) + range.IndexCount > Header->IndexCount
+                || static_cast<uint64_t>(range.FirstTexture) + range.TextureCount > Header->TextureRefCount)
+                return false;
+            // 索引是网格内的相对下标，越界会让 GPU 读到其他网格或缓冲之外的数据
+            for (uint32_t index = 0; index < range.IndexCount; index++)
+            {
+                if (indices[range.FirstIndex + index] >= range.VertexCount)
+                    return false;
+            }
+        }
+
+        const MeshCacheTextureRef* refs = Section<MeshCacheTextureRef>(Header->TextureTableOffset);
+        for (uint32_t i = 0; i < Header->TextureRefCount; i++)
+        {
+            if (static_cast<uint64_t>(refs[i].TypeOffset) + refs[i].TypeLength > Header->StringSize
+                || static_cast<uint64_t>(refs[i].PathOffset) + refs[i].PathLength > Header->StringSize)
+                return false;
+        }
+        return true;
+    }
+
+    MappedFile File;
+    const MeshCacheHeader* Header = nullptr;
+};
@@ -0,0 +1,379 @@
+#pragma once
+#include <tool/Mesh.h>
+
+#include <vector>
+#include <cstdint>
+#include <cstring>
+#include <cmath>
+#include <algorithm>
+#include <unordered_map>
+
+// 导入时的网格优化（只在 Assimp 解析时执行一次，结果写进 .meshcache）
+// 1. WeldVertices       : 合并完全相同的顶点（obj 每个面都有自己的顶点，不合并的话索引缓冲等于没用）
+// 2. OptimizeVertexCache: Forsyth 算法重排三角形，提高 post-transform 顶点缓存命中率
+// 3. OptimizeOverdraw   : 按顶点缓存刷新点把三角形分簇，朝外、靠外的簇先画（Sander 等人的 Tipsify 论文），减少 overdraw
+// 4. OptimizeVertexFetch: 按第一次被索引的顺序重排顶点，顶点读取是顺序的
+//
+// ACMR（average cache miss ratio）= 变换的顶点数 / 三角形数，最好 0.5，最差 3
+// ATVR（average transformed vertex ratio）= 变换的顶点数 / 顶点数，最好 1
+
+// 统计顶点缓存用的 FIFO 缓存大小（和常见硬件、meshoptimizer 的分析器一致）
+const unsigned int VERTEX_CACHE_ANALYZE_SIZE = 16u;
+
+struct VertexCacheStats
+{
+    float ACMR = 0.0f;
+    float ATVR = 0.0f;
+    unsigned int Transformed = 0u;
+};
+
+// 模拟 FIFO 顶点缓存
+inline VertexCacheStats AnalyzeVertexCache(const std::vector<unsigned int>& indices, size_t vertexCount, unsigned int cacheSize = VERTEX_CACHE_ANALYZE_SIZE)
+{
+    VertexCacheStats stats;
+    if (indices.empty() || vertexCount == 0)
+        return stats;
+    // 记录每个顶点进入缓存时的时间戳，时间戳足够新说明还在缓存中
+    std::vector<unsigned int> timestamps(vertexCount, 0u);
+    unsigned int timestamp = cacheSize + 1u;
+    for (unsigned int index : indices)
+    {
+        if (timestamp - timestamps[index] > cacheSize)
+        {
+            timestamps[index] = timestamp++;
+            stats.Transformed++;
+        }
+    }
+    stats.ACMR = static_cast<float>(stats.Transformed) / static_cast<float>(indices.size() / 3);
+    stats.ATVR = static_cast<float>(stats.Transformed) / static_cast<float>(vertexCount);
+    return stats;
+}
+
+// 合并相同的顶点（比较位置、法线、纹理坐标、切线、副切线的二进制值），返回合并后的顶点数
+inline size_t WeldVertices(std::vector<Vertex>& vertices, std::vector<unsigned int>& indices)
+{
+    struct Key
+    {
+        float Data[14];
+        bool operator==(const Key& other) const { return std::memcmp(Data, other.Data, sizeof(Data)) == 0; }
+    };
+    struct KeyHash
+    {
+        size_t operator()(const Key& key) const
+        {
+            uint64_t hash = 14695981039346656037ull;
+            const unsigned char* bytes = reinterpret_cast<const unsigned char*>(key.Data);
+            for (size_t i = 0; i < sizeof(key.Data); i++)
+            {
+                hash ^= bytes[i];
+                hash *= 1099511628211ull;
+            }
+            return static_cast<size_t>(hash);
+        }
+    };
+
+    std::unordered_map<Key, unsigned int, KeyHash> unique;
+    unique.reserve(vertices.size());
+    std::vector<unsigned int> remap(vertices.size());
+    std::vector<Vertex> welded;
+    welded.reserve(vertices.size());
+    for (size_t i = 0; i < vertices.size(); i++)
+    {
+        const Vertex& vertex = vertices[i];
+        Key key;
+        std::memcpy(key.Data + 0, &vertex.Position, sizeof(glm::vec3));
+        std::memcpy(key.Data + 3, &vertex.Normal, sizeof(glm::vec3));
+        std::memcpy(key.Data + 6, &vertex.TexCoord, sizeof(glm::vec2));
+        std::memcpy(key.Data + 8, &vertex.Tangent, sizeof(glm::vec3));
+        std::memcpy(key.Data + 11, &vertex.Bitangent, sizeof(glm::vec3));
+        auto result = unique.emplace(key, static_cast<unsigned int>(welded.size()));
+        if (result.second)
+            welded.push_back(vertex);
+        remap[i] = result.first->second;
+    }
+    for (unsigned int& index : indices)
+        index = remap[index];
+    vertices.swap(welded);
+    return vertices.size();
+}
+
+// Forsyth, "Linear-Speed Vertex Cache Optimisation"：贪心地选择分数最高的三角形，
+// 顶点分数由它在模拟 LRU 缓存中的位置和剩余未绘制的三角形数（valence）决定
+inline void OptimizeVertexCache(std::vector<unsigned int>& indices, size_t vertexCount)
+{
+    const int cacheSize = 32;
+    const float cacheDecayPower = 1.5f;
+    const float lastTriangleScore = 0.75f;
+    const float valenceBoostScale = 2.0f;
+    const float valenceBoostPower = 0.5f;
+
+    size_t triangleCount = indices.size() / 3;
+    if (triangleCount == 0)
+        return;
+
+    auto vertexScore = [&](int cachePosition, unsigned int valence)
+    {
+        if (valence == 0u)
+            return -1.0f;
+        float score = 0.0f;
+        if (cachePosition >= 0)
+        {
+            if (cachePosition < 3)
+                score = lastTriangleScore;
+            else
+                score = std::pow(1.0f - static_cast<float>(cachePosition - 3) / static_cast<float>(cacheSize - 3), cacheDecayPower);
+        }
+        return score + valenceBoostScale * std::pow(static_cast<float>(valence), -valenceBoostPower);
+    };
+
+    // 顶点 -> 三角形邻接表
+    std::vector<unsigned int> valence(vertexCount, 0u);
+    for (unsigned int index : indices)
+        valence[index]++;
+    std::vector<unsigned int> adjacencyOffset(vertexCount + 1, 0u);
+    for (size_t v = 0; v < vertexCount; v++)
+        adjacencyOffset[v + 1] = adjacencyOffset[v] + valence[v];
+    std::vector<unsigned int> adjacency(indices.size());
+    std::vector<unsigned int> fill(adjacencyOffset.begin(), adjacencyOffset.end() - 1);
+    for (size_t t = 0; t < triangleCount; t++)
+        for (int k = 0; k < 3; k++)
+            adjacency[fill[indices[t * 3 + k]]++] = static_cast<unsigned int>(t);
+
+    std::vector<int> cachePosition(vertexCount, -1);
+    std::vector<float> score(vertexCount);
+    for (size_t v = 0; v < vertexCount; v++)
+        score[v] = vertexScore(-1, valence[v]);
+    std::vector<float> triangleScore(triangleCount);
+    std::vector<bool> emitted(triangleCount, false);
+    for (size_t t = 0; t < triangleCount; t++)
+        triangleScore[t] = score[indices[t * 3]] + score[indices[t * 3 + 1]] + score[indices[t * 3 + 2]];
+
+    std::vector<unsigned int> result;
+    result.reserve(indices.size());
+    std::vector<unsigned int> cache, nextCache;
+    cache.reserve(cacheSize + 3);
+    nextCache.reserve(cacheSize + 3);
+    size_t scanCursor = 0;
+    long long best = -1;
+
+    for (size_t emittedCount = 0; emittedCount < triangleCount; emittedCount++)
+    {
+        // 缓存中的三角形都画完了，线性扫描找下一个分数最高的三角形（通常是新的连通块）
+        if (best < 0)
+        {
+            float bestScore = -1e30f;
+            for (size_t t = scanCursor; t < triangleCount; t++)
+            {
+                if (!emitted[t] && triangleScore[t] > bestScore)
+                {
+                    bestScore = triangleScore[t];
+                    best = static_cast<long long>(t);
+                }
+            }
+            while (scanCursor < triangleCount && emitted[scanCursor])
+                scanCursor++;
+        }
+
+        size_t triangle = static_cast<size_t>(best);
+        emitted[triangle] = true;
+        unsigned int tri[3] = { indices[triangle * 3], indices[triangle * 3 + 1], indices[triangle * 3 + 2] };
+        result.insert(result.end(), tri, tri + 3);
+
+        // 从邻接表中移除这个三角形
+        for (unsigned int v : tri)
+        {
+            unsigned int* begin = &adjacency[adjacencyOffset[v]];
+            unsigned int* end = begin + valence[v];
+            unsigned int* it = std::find(begin, end, static_cast<unsigned int>(triangle));
+            if (it != end)
+            {
+                std::swap(*it, *(end - 1));
+                valence[v]--;
+            }
+        }
+
+        // 更新 LRU 缓存：新三角形的顶点放到最前面
+        nextCache.assign(tri, tri + 3);
+        for (unsigned int v : cache)
+            if (v != tri[0] && v != tri[1] && v != tri[2])
+                nextCache.push_back(v);
+        cache.swap(nextCache);
+
+        // 重新计算缓存中（以及刚被挤出缓存）的顶点分数和相关三角形分数，同时找出最好的三角形
+        best = -1;
+        float bestScore = -1e30f;
+        for (size_t i = 0; i < cache.size(); i++)
+        {
+            unsigned int v = cache[i];
+            int position = i < static_cast<size_t>(cacheSize) ? static_cast<int>(i) : -1;
+            cachePosition[v] = position;
+            float newScore = vertexScore(position, valence[v]);
+            float delta = newScore - score[v];
+            score[v] = newScore;
+            for (unsigned int a = adjacencyOffset[v]; a < adjacencyOffset[v] + valence[v]; a++)
+            {
+                unsigned int t = adjacency[a];
+                triangleScore[t] += delta;
+                if (triangleScore[t] > bestScore)
+                {
+                    bestScore = triangleScore[t];
+                    best = static_cast<long long>(t);
+                }
+            }
+        }
+        if (cache.size() > static_cast<size_t>(cacheSize))
+            cache.resize(cacheSize);
+    }
+    indices.swap(result);
+}
+
+// 减少 overdraw：在顶点缓存优化之后的三角形序列上，以缓存刷新点（三个顶点都未命中的三角形）为界分簇，
+// 然后按簇的朝外程度 dot(簇中心 - 网格中心, 簇法线) 从大到小排序，外面的、朝外的先画，挡住后面的像素。
+// 簇内顺序不变，所以顶点缓存命中率基本不变；如果 ACMR 变差超过 threshold 倍就放弃这次重排。
+inline void OptimizeOverdraw(std::vector<unsigned int>& indices, const std::vector<Vertex>& vertices, float threshold = 1.05f)
+{
+    size_t triangleCount = indices.size() / 3;
+    if (triangleCount < 2)
+        return;
+
+    // 1. 分簇
+    std::vector<size_t> clusterStarts;
+    {
+        std::vector<unsigned int> timestamps(vertices.size(), 0u);
+        unsigned int cacheSize = VERTEX_CACHE_ANALYZE_SIZE;
+        unsigned int timestamp = cacheSize + 1u;
+        for (size_t t = 0; t < triangleCount; t++)
+        {
+            int misses = 0;
+            for (int k = 0; k < 3; k++)
+            {
+                unsigned int v = indices[t * 3 + k];
+                if (timestamp - timestamps[v] > cacheSize)
+                {
+                    timestamps[v] = timestamp++;
+                    misses++;
+                }
+            }
+            if (t == 0 || misses == 3)
+                clusterStarts.push_back(t);
+        }
+    }
+    if (clusterStarts.size() < 2)
+        return;
+
+    // 2. 网格中心（面积加权）
+    glm::dvec3 meshCenter(0.0);
+    double meshArea = 0.0;
+    for (size_t t = 0; t < triangleCount; t++)
+    {
+        const glm::vec3& a = vertices[indices[t * 3]].Position;
+        const glm::vec3& b = vertices[indices[t * 3 + 1]].Position;
+        const glm::vec3& c = vertices[indices[t * 3 + 2]].Position;
+        double area = glm::length(glm::cross(b - a, c - a));
+        meshCenter += glm::dvec3(a + b + c) / 3.0 * area;
+        meshArea += area;
+    }
+    meshCenter = meshArea > 0.0 ? meshCenter / meshArea : glm::dvec3(0.0);
+
+    // 3. 每个簇的排序值
+    struct Cluster
+    {
+        size_t First;
+        size_t Count;
+        double SortKey;
+    };
+    std::vector<Cluster> clusters;
+    for (size_t c = 0; c < clusterStarts.size(); c++)
+    {
+        size_t first = clusterStarts[c];
+        size_t last = c + 1 < clusterStarts.size() ? clusterStarts[c + 1] : triangleCount;
+        glm::dvec3 center(0.0), normal(0.0);
+        double area = 0.0;
+        for (size_t t = first; t < last; t++)
+        {
+            glm::dvec3 a(vertices[indices[t * 3]].Position);
+            glm::dvec3 b(vertices[indices[t * 3 + 1]].Position);
+            glm::dvec3 c3(vertices[indices[t * 3 + 2]].Position);
+            glm::dvec3 n = glm::cross(b - a, c3 - a);
+            double triangleArea = glm::length(n);
+            center += (a + b + c3) / 3.0 * triangleArea;
+            normal += n;
+            area += triangleArea;
+        }
+        double normalLength = glm::length(normal);
+        double key = 0.0;
+        if (area > 0.0 && normalLength > 0.0)
+            key = glm::dot(center / area - meshCenter, normal / normalLength);
+        clusters.push_back({ first, last - first, key });
+    }
+    std::stable_sort(clusters.begin(), clusters.end(), [](const Cluster& a, const Cluster& b) { return a.SortKey > b.SortKey; });
+
+    std::vector<unsigned int> result;
+    result.reserve(indices.size());
+    for (const Cluster& cluster : clusters)
+        result.insert(result.end(), indices.begin() + cluster.First * 3, indices.begin() + (cluster.First + cluster.Count) * 3);
+
+    if (AnalyzeVertexCache(result, vertices.size()).ACMR <= AnalyzeVertexCache(indices, vertices.size()).ACMR * threshold)
+        indices.swap(result);
+}
+
+// 按第一次被索引的顺序重排顶点，没有被引用的顶点会被删除
+inline void OptimizeVertexFetch(std::vector<Vertex>& vertices, std::vector<unsigned int>& indices)
+{
+    const unsigned int unused = ~0u;
+    std::vector<unsigned int> remap(vertices.size(), unused);
+    std::vector<Vertex> ordered;
+    ordered.reserve(vertices.size());
+    for (unsigned int& index : indices)
+    {
+        if (remap[index] == unused)
+        {
+            remap[index] = static_cast<unsigned int>(ordered.size());
+            ordered.push_back(vertices[index]);
+        }
+        index = remap[index];
+    }
+    vertices.swap(ordered);
+}
+
+// 优化前后的统计
+struct MeshOptimizeReport
+{
+    size_t VerticesBefore = 0;
+    size_t VerticesAfter = 0;
+    size_t Triangles = 0;
+    unsigned int TransformedBefore = 0u;
+    unsigned int TransformedAfter = 0u;
+
+    void Add(const MeshOptimizeReport& other)
+    {
+        VerticesBefore += other.VerticesBefore;
+        VerticesAfter += other.VerticesAfter;
+        Triangles += other.Triangles;
+        TransformedBefore += other.TransformedBefore;
+        TransformedAfter += other.TransformedAfter;
+    }
+
+    float ACMRBefore() const { return Triangles > 0 ? static_cast<float>(TransformedBefore) / Triangles : 0.0f; }
+    float ACMRAfter() const { return Triangles > 0 ? static_cast<float>(TransformedAfter) / Triangles : 0.0f; }
+    float ATVRBefore() const { return VerticesBefore > 0 ? static_cast<float>(TransformedBefore) / VerticesBefore : 0.0f; }
+    float ATVRAfter() const { return VerticesAfter > 0 ? static_cast<float>(TransformedAfter) / VerticesAfter : 0.0f; }
+};
+
+// 完整的优化流程
+inline MeshOptimizeReport OptimizeMesh(std::vector<Vertex>& vertices, std::vector<unsigned int>& indices)
+{
+    MeshOptimizeReport report;
+    report.VerticesBefore = vertices.size();
+    report.Triangles = indices.size() / 3;
+    report.TransformedBefore = AnalyzeVertexCache(indices, vertices.size()).Transformed;
+
+    WeldVertices(vertices, indices);
+    OptimizeVertexCache(indices, vertices.size());
+    OptimizeOverdraw(indices, vertices);
+    OptimizeVertexFetch(vertices, indices);
+
+    report.VerticesAfter = vertices.size();
+    report.TransformedAfter = AnalyzeVertexCache(indices, vertices.size()).Transformed;
+    return report;
+}
@@ -0,0 +1,570 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <algorithm>
+
+#include <tool/JobSystem.h>
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#include <immintrin.h>
+#define MIP_GENERATOR_SSE 1
+// AVX2 版本用函数级的 target 属性编译，不需要给整个程序加 -mavx2，运行时检测 CPU 支持后才调用
+#if defined(__GNUC__) || defined(__clang__)
+#define MIP_GENERATOR_AVX2 1
+#define MIP_GENERATOR_AVX2_TARGET __attribute__((target("avx2")))
+#elif defined(_MSC_VER)
+#include <intrin.h>
+#define MIP_GENERATOR_AVX2 1
+#define MIP_GENERATOR_AVX2_TARGET
+#endif
+#endif
+
+// CPU 上生成 mip 链，代替运行时的 glGenerateMipmap（TextureCompression.h 写 .dds 时使用）
+// 1. 可分离的重采样滤波：先纵向再横向，每个输出像素的抽头（源像素下标和权重）预先算好，
+//    支持非 2 的幂的尺寸（比如 500 → 250 → 125 → 62）；每一级从上一级的浮点结果生成，中间不量化
+//    Box：2x2 平均（和 glGenerateMipmap 相同）；Kaiser：Kaiser 窗 sinc（半径 3，alpha 4）；Lanczos：Lanczos3
+// 2. sRGB 颜色先查表转到线性空间再滤波，最后编码回 sRGB（glGenerateMipmap 对非 sRGB 格式直接平均 gamma 空间的值，mip 会偏暗）
+// 3. 法线贴图每一级滤波后重新归一化
+// 4. alpha 测试的贴图（草、窗户）每一级缩放 alpha，使 alpha >= 参考值的像素比例和第 0 级相同，远处不会越来越稀
+// 纵向一次处理一整行（SSE 4 个 float，AVX2 8 个），横向每个 RGBA 像素一个 __m128（AVX2 同时算 2 个像素），
+// 三个版本运算顺序相同，结果逐位一致；每一行一个任务交给 JobSystem 并行
+
+enum class MipFilter
+{
+    Box,
+    Kaiser,
+    Lanczos,
+    Count
+};
+
+inline const char* GetMipFilterName(MipFilter filter)
+{
+    switch (filter)
+    {
+    case MipFilter::Box: return "box";
+    case MipFilter::Kaiser: return "kaiser";
+    case MipFilter::Lanczos: return "lanczos";
+    default: return "unknown";
+    }
+}
+
+enum class MipSimd
+{
+    Scalar,
+    SSE,
+    AVX2,
+    Count
+};
+
+inline const char* GetMipSimdName(MipSimd simd)
+{
+    switch (simd)
+    {
+    case MipSimd::Scalar: return "scalar";
+    case MipSimd::SSE: return "sse";
+    case MipSimd::AVX2: return "avx2";
+    default: return "unknown";
+    }
+}
+
+inline bool IsMipSimdSupported(MipSimd simd)
+{
+    switch (simd)
+    {
+    case MipSimd::Scalar:
+        return true;
+    case MipSimd::SSE:
+#ifdef MIP_GENERATOR_SSE
+        return true;
+#else
+        return false;
+#endif
+    case MipSimd::AVX2:
+#if defined(MIP_GENERATOR_AVX2) && (defined(__GNUC__) || defined(__clang__))
+        return __builtin_cpu_supports("avx2");
+#elif defined(MIP_GENERATOR_AVX2) && defined(_MSC_VER)
+        {
+            // 还要检查操作系统是否保存 YMM 寄存器（OSXSAVE + XCR0）
+            int info[4];
+            __cpuid(info, 1);
+            bool osxsave = (info[2] & (1 << 27)) != 0;
+            __cpuidex(info, 7, 0);
+            bool avx2 = (info[1] & (1 << 5)) != 0;
+            return avx2 && osxsave && (_xgetbv(0) & 6u) == 6u;
+        }
+#else
+        return false;
+#endif
+    default:
+        return false;
+    }
+}
+
+inline MipSimd GetBestMipSimd()
+{
+    if (IsMipSimdSupported(MipSimd::AVX2))
+        return MipSimd::AVX2;
+    if (IsMipSimdSupported(MipSimd::SSE))
+        return MipSimd::SSE;
+    return MipSimd::Scalar;
+}
+
+struct MipSettings
+{
+    MipFilter Filter = MipFilter::Kaiser;
+    // 颜色按 sRGB 编码存储：在线性空间滤波
+    bool bSRGB = true;
+    // 切线空间法线贴图（xyz = rgb * 2 - 1）：每一级重新归一化，不做 sRGB 转换
+    bool bNormalMap = false;
+    // 和纹理的环绕方式一致：GL_REPEAT 时边缘的滤波核采样到对面的像素，GL_CLAMP_TO_EDGE 时重复边缘像素
+    bool bWrap = true;
+    // 大于 0 时保持 alpha >= AlphaCoverageReference 的覆盖率（alpha 测试的阈值）
+    float AlphaCoverageReference = 0.0f;
+    // 不支持时退回到支持的最好的版本
+    MipSimd Simd = MipSimd::AVX2;
+};
+
+// ----------------------------------------------------------------------------
+// 滤波核
+// ----------------------------------------------------------------------------
+
+const float MIP_PI = 3.14159265359f;
+const float MIP_KAISER_ALPHA = 4.0f;
+
+inline float GetMipFilterRadius(MipFilter filter)
+{
+    return filter == MipFilter::Box ? 0.5f : 3.0f;
+}
+
+inline float Sinc(float x)
+{
+    if (std::fabs(x) < 1e-5f)
+        return 1.0f;
+    return std::sin(MIP_PI * x) / (MIP_PI * x);
+}
+
+// 第一类零阶修正贝塞尔函数（级数展开）
+inline float BesselI0(float x)
+{
+    float sum = 1.0f;
+    float term = 1.0f;
+    float halfX2 = x * x * 0.25f;
+    for (int k = 1; k < 32; k++)
+    {
+        term *= halfX2 / static_cast<float>(k * k);
+        sum += term;
+        if (term < sum * 1e-8f)
+            break;
+    }
+    return sum;
+}
+
+// x 以目标像素为单位
+inline float EvaluateMipFilter(MipFilter filter, float x)
+{
+    float radius = GetMipFilterRadius(filter);
+    x = std::fabs(x);
+    if (filter == MipFilter::Box)
+        return x <= radius ? 1.0f : 0.0f;
+    if (x >= radius)
+        return 0.0f;
+    if (filter == MipFilter::Lanczos)
+        return Sinc(x) * Sinc(x / radius);
+    float t = x / radius;
+    return Sinc(x) * BesselI0(MIP_KAISER_ALPHA * std::sqrt(1.0f - t * t)) / BesselI0(MIP_KAISER_ALPHA);
+}
+
+// 一个方向上每个输出像素的抽头，Indices/Weights[output * TapCount + tap]
+struct MipFilterTaps
+{
+    unsigned int TapCount = 0u;
+    std::vector<int> Indices;
+    std::vector<float> Weights;
+};
+
+inline void BuildMipFilterTaps(MipFilter filter, unsigned int sourceSize, unsigned int targetSize, bool wrap, MipFilterTaps& taps)
+{
+    float scale = static_cast<float>(sourceSize) / static_cast<float>(targetSize);
+    float support = GetMipFilterRadius(filter) * scale;
+    taps.TapCount = static_cast<unsigned int>(std::ceil(support * 2.0f)) + 1u;
+    taps.Indices.assign(static_cast<size_t>(targetSize) * taps.TapCount, 0);
+    taps.Weights.assign(static_cast<size_t>(targetSize) * taps.TapCount, 0.0f);
+    int size = static_cast<int>(sourceSize);
+    for (unsigned int i = 0; i < targetSize; i++)
+    {
+        // 像素中心在 +0.5 处
+        float center = (static_cast<float>(i) + 0.5f) * scale;
+        int first = static_cast<int>(std::floor(center - support));
+        int* indices = &taps.Indices[static_cast<size_t>(i) * taps.TapCount];
+        float* weights = &taps.Weights[static_cast<size_t>(i) * taps.TapCount];
+        float sum = 0.0f;
+        for (unsigned int t = 0; t < taps.TapCount; t++)
+        {
+            int j = first + static_cast<int>(t);
+            weights[t] = EvaluateMipFilter(filter, (static_cast<float>(j) + 0.5f - center) / scale);
+            indices[t] = wrap ? ((j % size) + size) % size : std::min(std::max(j, 0), size - 1);
+            sum += weights[t];
+        }
+        if (std::fabs(sum) < 1e-6f)
+        {
+            std::fill(weights, weights + taps.TapCount, 0.0f);
+            weights[0] = 1.0f;
+            indices[0] = std::min(std::max(static_cast<int>(center), 0), size - 1);
+            continue;
+        }
+        for (unsigned int t = 0; t < taps.TapCount; t++)
+            weights[t] /= sum;
+    }
+}
+
+// ----------------------------------------------------------------------------
+// 纵向：输出行 = Σ weight * 源行（count 个 float）
+// 横向：每个 RGBA 输出像素 = Σ weight * 源像素
+// ----------------------------------------------------------------------------
+
+inline void FilterColumnsScalar(const float* const* rows, const float* weights, unsigned int tapCount, unsigned int count, float* output)
+{
+    for (unsigned int i = 0; i < count; i++)
+    {
+        float sum = 0.0f;
+        for (unsigned int t = 0; t < tapCount; t++)
+            sum = sum + weights[t] * rows[t][i];
+        output[i] = sum;
+    }
+}
+
+inline void FilterRowScalar(const float* source, const MipFilterTaps& taps, unsigned int targetWidth, float* output)
+{
+    for (unsigned int x = 0; x < targetWidth; x++)
+    {
+        const int* indices = &taps.Indices[static_cast<size_t>(x) * taps.TapCount];
+        const float* weights = &taps.Weights[static_cast<size_t>(x) * taps.TapCount];
+        for (unsigned int c = 0; c < 4u; c++)
+        {
+            float sum = 0.0f;
+            for (unsigned int t = 0; t < taps.TapCount; t++)
+                sum = sum + weights[t] * source[indices[t] * 4 + static_cast<int>(c)];
+            output[x * 4u + c] = sum;
+        }
+    }
+}
+
+#ifdef MIP_GENERATOR_SSE
+inline void FilterColumnsSSE(const float* const* rows, const float* weights, unsigned int tapCount, unsigned int count, float* output)
+{
+    for (unsigned int i = 0; i < count; i += 4u)
+    {
+        __m128 sum = _mm_setzero_ps();
+        for (unsigned int t = 0; t < tapCount; t++)
+            sum = _mm_add_ps(sum, _mm_mul_ps(_mm_set1_ps(weights[t]), _mm_loadu_ps(rows[t] + i)));
+        _mm_storeu_ps(output + i, sum);
+    }
+}
+
+inline void FilterRowSSE(const float* source, const MipFilterTaps& taps, unsigned int targetWidth, float* output)
+{
+    for (unsigned int x = 0; x < targetWidth; x++)
+    {
+        const int* indices = &taps.Indices[static_cast<size_t>(x) * taps.TapCount];
+        const float* weights = &taps.Weights[static_cast<size_t>(x) * taps.TapCount];
+        __m128 sum = _mm_setzero_ps();
+        for (unsigned int t = 0; t < taps.TapCount; t++)
+            sum = _mm_add_ps(sum, _mm_mul_ps(_mm_set1_ps(weights[t]), _mm_loadu_ps(source + indices[t] * 4)));
+        _mm_storeu_ps(output + x * 4u, sum);
+    }
+}
+#endif
+
+#ifdef MIP_GENERATOR_AVX2
+MIP_GENERATOR_AVX2_TARGET inline void FilterColumnsAVX2(const float* const* rows, const float* weights, unsigned int tapCount, unsigned int count, float* output)
+{
+    unsigned int i = 0u;
+    for (; i + 8u <= count; i += 8u)
+    {
+        __m256 sum = _mm256_setzero_ps();
+        for (unsigned int t = 0; t < tapCount; t++)
+            sum = _mm256_add_ps(sum, _mm256_mul_ps(_mm256_set1_ps(weights[t]), _mm256_loadu_ps(rows[t] + i)));
+        _mm256_storeu_ps(output + i, sum);
+    }
+    // count 是 4 的倍数，最多剩下一个像素
+    for (; i < count; i += 4u)
+    {
+        __m128 sum = _mm_setzero_ps();
+        for (unsigned int t = 0; t < tapCount; t++)
+            sum = _mm_add_ps(sum, _mm_mul_ps(_mm_set1_ps(weights[t]), _mm_loadu_ps(rows[t] + i)));
+        _mm_storeu_ps(output + i, sum);
+    }
+}
+
+MIP_GENERATOR_AVX2_TARGET inline void FilterRowAVX2(const float* source, const MipFilterTaps& taps, unsigned int targetWidth, float* output)
+{
+    unsigned int x = 0u;
+    for (; x + 2u <= targetWidth; x += 2u)
+    {
+        const int* indices0 = &taps.Indices[static_cast<size_t>(x) * taps.TapCount];
+        const int* indices1 = indices0 + taps.TapCount;
+        const float* weights0 = &taps.Weights[static_cast<size_t>(x) * taps.TapCount];
+        const float* weights1 = weights0 + taps.TapCount;
+        __m256 sum = _mm256_setzero_ps();
+        for (unsigned int t = 0; t < taps.TapCount; t++)
+        {
+            __m256 pixels = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps(source + indices0[t] * 4)), _mm_loadu_ps(source + indices1[t] * 4), 1);
+            __m256 weights = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_set1_ps(weights0[t])), _mm_set1_ps(weights1[t]), 1);
+            sum = _mm256_add_ps(sum, _mm256_mul_ps(weights, pixels));
+        }
+        _mm256_storeu_ps(output + x * 4u, sum);
+    }
+    for (; x < targetWidth; x++)
+    {
+        const int* indices = &taps.Indices[static_cast<size_t>(x) * taps.TapCount];
+        const float* weights = &taps.Weights[static_cast<size_t>(x) * taps.TapCount];
+        __m128 sum = _mm_setzero_ps();
+        for (unsigned int t = 0; t < taps.TapCount; t++)
+            sum = _mm_add_ps(sum, _mm_mul_ps(_mm_set1_ps(weights[t]), _mm_loadu_ps(source + indices[t] * 4)));
+        _mm_storeu_ps(output + x * 4u, sum);
+    }
+}
+#endif
+
+inline void FilterColumns(MipSimd simd, const float* const* rows, const float* weights, unsigned int tapCount, unsigned int count, float* output)
+{
+#ifdef MIP_GENERATOR_AVX2
+    if (simd == MipSimd::AVX2)
+        return FilterColumnsAVX2(rows, weights, tapCount, count, output);
+#endif
+#ifdef MIP_GENERATOR_SSE
+    if (simd != MipSimd::Scalar)
+        return FilterColumnsSSE(rows, weights, tapCount, count, output);
+#endif
+    FilterColumnsScalar(rows, weights, tapCount, count, output);
+}
+
+inline void FilterRow(MipSimd simd, const float* source, const MipFilterTaps& taps, unsigned int targetWidth, float* output)
+{
+#ifdef MIP_GENERATOR_AVX2
+    if (simd == MipSimd::AVX2)
+        return FilterRowAVX2(source, taps, targetWidth, output);
+#endif
+#ifdef MIP_GENERATOR_SSE
+    if (simd != MipSimd::Scalar)
+        return FilterRowSSE(source, taps, targetWidth, output);
+#endif
+    FilterRowScalar(source, taps, targetWidth, output);
+}
+
+// ----------------------------------------------------------------------------
+// sRGB 转换
+// ----------------------------------------------------------------------------
+
+inline const float* GetSRGBDecodeTable()
+{
+    static std::vector<float> table = []
+    {
+        std::vector<float> values(256);
+        for (int i = 0; i < 256; i++)
+        {
+            float c = i / 255.0f;
+            values[i] = c <= 0.04045f ? c / 12.92f : std::pow((c + 0.055f) / 1.055f, 2.4f);
+        }
+        return values;
+    }();
+    return table.data();
+}
+
+// 线性值按 16 位量化查表
+inline const unsigned char* GetSRGBEncodeTable()
+{
+    static std::vector<unsigned char> table = []
+    {
+        std::vector<unsigned char> values(65536);
+        for (int i = 0; i < 65536; i++)
+        {
+            float c = i / 65535.0f;
+            float s = c <= 0.0031308f ? c * 12.92f : 1.055f * std::pow(c, 1.0f / 2.4f) - 0.055f;
+            values[i] = static_cast<unsigned char>(std::min(255.0f, std::max(0.0f, s * 255.0f + 0.5f)));
+        }
+        return values;
+    }();
+    return table.data();
+}
+
+// 8 位 RGBA 中 alpha >= reference 的像素比例
+inline float GetAlphaCoverage(const unsigned char* rgba, size_t pixelCount, float reference)
+{
+    if (pixelCount == 0u)
+        return 0.0f;
+    size_t covered = 0u;
+    for (size_t i = 0; i < pixelCount; i++)
+        covered += rgba[i * 4u + 3u] / 255.0f >= reference ? 1u : 0u;
+    return static_cast<float>(covered) / static_cast<float>(pixelCount);
+}
+
+inline float GetAlphaCoverage(const float* rgba, size_t pixelCount, float reference, float scale)
+{
+    if (pixelCount == 0u)
+        return 0.0f;
+    size_t covered = 0u;
+    for (size_t i = 0; i < pixelCount; i++)
+        covered += rgba[i * 4u + 3u] * scale >= reference ? 1u : 0u;
+    return static_cast<float>(covered) / static_cast<float>(pixelCount);
+}
+
+// 找到使覆盖率最接近 targetCoverage 的 alpha 缩放（覆盖率随缩放单调不减，二分查找）
+inline float FindAlphaCoverageScale(const float* rgba, size_t pixelCount, float reference, float targetCoverage)
+{
+    float low = 0.0f;
+    float high = 1.0f;
+    while (GetAlphaCoverage(rgba, pixelCount, reference, high) < targetCoverage && high < 256.0f)
+        high *= 2.0f;
+    for (int iteration = 0; iteration < 16; iteration++)
+    {
+        float middle = (low + high) * 0.5f;
+        if (GetAlphaCoverage(rgba, pixelCount, reference, middle) < targetCoverage)
+            low = middle;
+        else
+            high = middle;
+    }
+    return high;
+}
+
+// ----------------------------------------------------------------------------
+// mip 链
+// ----------------------------------------------------------------------------
+
+template <typename Function>
+void MipParallelFor(JobSystem* jobs, unsigned int count, unsigned int grain, const Function& function)
+{
+    if (jobs != nullptr)
+        jobs->ParallelFor(0u, count, grain, function);
+    else
+        function(0u, count);
+}
+
+// 滤波之后：截断负瓣造成的越界值，法线重新归一化
+inline void ResolvePixels(float* pixels, size_t pixelCount, const MipSettings& settings)
+{
+    for (size_t i = 0; i < pixelCount; i++)
+    {
+        float* pixel = pixels + i * 4u;
+        for (unsigned int c = 0; c < 4u; c++)
+            pixel[c] = std::min(1.0f, std::max(0.0f, pixel[c]));
+        if (settings.bNormalMap)
+        {
+            float x = pixel[0] * 2.0f - 1.0f;
+            float y = pixel[1] * 2.0f - 1.0f;
+            float z = pixel[2] * 2.0f - 1.0f;
+            float length = std::sqrt(x * x + y * y + z * z);
+            if (length > 1e-6f)
+            {
+                pixel[0] = x / length * 0.5f + 0.5f;
+                pixel[1] = y / length * 0.5f + 0.5f;
+                pixel[2] = z / length * 0.5f + 0.5f;
+            }
+            else
+            {
+                pixel[0] = 0.5f;
+                pixel[1] = 0.5f;
+                pixel[2] = 1.0f;
+            }
+        }
+    }
+}
+
+// 把一级浮点图像滤波成下一级（先纵向再横向）
+inline void DownsampleLevel(const std::vector<float>& source, unsigned int width, unsigned int height, std::vector<float>& target,
+    const MipSettings& settings, MipSimd simd, JobSystem* jobs)
+{
+    unsigned int targetWidth = std::max(1u, width >> 1);
+    unsigned int targetHeight = std::max(1u, height >> 1);
+    MipFilterTaps horizontal, vertical;
+    BuildMipFilterTaps(settings.Filter, width, targetWidth, settings.bWrap, horizontal);
+    BuildMipFilterTaps(settings.Filter, height, targetHeight, settings.bWrap, vertical);
+
+    // 纵向结果：targetHeight 行，每行 width 个像素
+    std::vector<float> columns(static_cast<size_t>(width) * targetHeight * 4u);
+    target.resize(static_cast<size_t>(targetWidth) * targetHeight * 4u);
+    auto filterRows = [&](unsigned int first, unsigned int last)
+    {
+        std::vector<const float*> rows(vertical.TapCount);
+        for (unsigned int y = first; y < last; y++)
+        {
+            const int* indices = &vertical.Indices[static_cast<size_t>(y) * vertical.TapCount];
+            for (unsigned int t = 0; t < vertical.TapCount; t++)
+                rows[t] = source.data() + static_cast<size_t>(indices[t]) * width * 4u;
+            float* column = columns.data() + static_cast<size_t>(y) * width * 4u;
+            FilterColumns(simd, rows.data(), &vertical.Weights[static_cast<size_t>(y) * vertical.TapCount], vertical.TapCount, width * 4u, column);
+            float* row = target.data() + static_cast<size_t>(y) * targetWidth * 4u;
+            FilterRow(simd, column, horizontal, targetWidth, row);
+            ResolvePixels(row, targetWidth, settings);
+        }
+    };
+    MipParallelFor(jobs, targetHeight, 16u, filterRows);
+}
+
+// 转换 [first, last) 个 float 分量（first 是 4 的倍数，第 4 个分量是 alpha）
+inline void DecodeLevel(const unsigned char* input, size_t first, size_t last, bool srgb, float* output)
+{
+    const float* decode = GetSRGBDecodeTable();
+    for (size_t i = first; i < last; i++)
+        output[i] = (srgb && (i & 3u) != 3u) ? decode[input[i]] : input[i] / 255.0f;
+}
+
+inline void QuantizeLevel(const float* input, size_t first, size_t last, bool srgb, unsigned char* output)
+{
+    const unsigned char* encode = GetSRGBEncodeTable();
+    for (size_t i = first; i < last; i++)
+    {
+        if (srgb && (i & 3u) != 3u)
+            output[i] = encode[static_cast<unsigned int>(input[i] * 65535.0f + 0.5f)];
+        else
+            output[i] = static_cast<unsigned char>(input[i] * 255.0f + 0.5f);
+    }
+}
+
+// 生成完整的 mip 链（直到 1x1），levels[0] 是原图的拷贝，每级都是 RGBA8
+inline void GenerateMipChain(const unsigned char* rgba, unsigned int width, unsigned int height, const MipSettings& settings,
+    std::vector<std::vector<unsigned char>>& levels, JobSystem* jobs = nullptr)
+{
+    MipSimd simd = settings.Simd;
+    while (!IsMipSimdSupported(simd))
+        simd = static_cast<MipSimd>(static_cast<int>(simd) - 1);
+    bool srgb = settings.bSRGB && !settings.bNormalMap;
+
+    size_t pixelCount = static_cast<size_t>(width) * height;
+    levels.clear();
+    levels.emplace_back(rgba, rgba + pixelCount * 4u);
+    float targetCoverage = settings.AlphaCoverageReference > 0.0f ? GetAlphaCoverage(rgba, pixelCount, settings.AlphaCoverageReference) : 0.0f;
+
+    std::vector<float> current(pixelCount * 4u);
+    size_t rowFloats = static_cast<size_t>(width) * 4u;
+    MipParallelFor(jobs, height, 64u, [&](unsigned int first, unsigned int last)
+    {
+        DecodeLevel(rgba, first * rowFloats, last * rowFloats, srgb, current.data());
+    });
+
+    std::vector<float> next;
+    while (width > 1u || height > 1u)
+    {
+        DownsampleLevel(current, width, height, next, settings, simd, jobs);
+        width = std::max(1u, width >> 1);
+        height = std::max(1u, height >> 1);
+        if (settings.AlphaCoverageReference > 0.0f)
+        {
+            size_t count = next.size() / 4u;
+            float scale = FindAlphaCoverageScale(next.data(), count, settings.AlphaCoverageReference, targetCoverage);
+            for (size_t i = 0; i < count; i++)
+                next[i * 4u + 3u] = std::min(1.0f, next[i * 4u + 3u] * scale);
+        }
+        levels.emplace_back(next.size());
+        rowFloats = static_cast<size_t>(width) * 4u;
+        unsigned char* output = levels.back().data();
+        MipParallelFor(jobs, height, 64u, [&](unsigned int first, unsigned int last)
+        {
+            QuantizeLevel(next.data(), first * rowFloats, last * rowFloats, srgb, output);
+        });
+        current.swap(next);
+    }
+}
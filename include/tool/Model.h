@@ -1,10 +1,16 @@
 #pragma once
 #include <tool/Mesh.h>
+#include <tool/RenderQueue.h>
+#include <tool/MeshCache.h>
+#include <tool/MeshOptimizer.h>
 
 #include <assimp/Importer.hpp>
 #include <assimp/scene.h>
 #include <assimp/postprocess.h>
 
+#include <tool/TextureLoader.h>
+#include <tool/TextureRegistry.h>
+
 #define STB_IMAGE_IMPLEMENTATION
 #include <tool/stb_image.h>
 
@@ -17,47 +23,23 @@ unsigned int TextureFromFile(const char* path, const std::string& directory, boo
     unsigned int textureID;
     glGenTextures(1, &textureID);
 
+    // 材质直接引用 .dds 时 stbi 无法解码，不管是否翻转都只能按原样上传
+    if (IsCompressedTexturePath(filename))
+    {
+        if (!TryLoadCompressedTexture(textureID, filename, isModel, gamma))
+            std::cout << "[TEXTURE LOAD ERROR]: Invalid or unsupported DDS texture at path: " << path << std::endl;
+        return textureID;
+    }
+    // 有离线压缩好的 .dds（Benchmark-TextureCompression 生成）时直接上传压缩数据和全部 mip，
+    // 章节打开了 stbi 的上下翻转时还是解码原图（.dds 中是不翻转的数据）
+    if (!TextureFlipEnabled() && TryLoadCompressedTexture(textureID, filename, isModel, gamma))
+        return textureID;
+
     int width, height, nrChannels;
     unsigned char* data = stbi_load(filename.c_str(), &width, &height, &nrChannels, 0);
     if (data != nullptr)
     {
-        unsigned int internalFormat;
-        unsigned int dataFormat;
-        if (nrChannels == 1)
-        {
-            internalFormat = GL_RED;
-            dataFormat = GL_RED;
-        }
-        else if (nrChannels == 3)
-        {
-            internalFormat = gamma ? GL_SRGB : GL_RGB;
-            dataFormat = GL_RGB;
-        }
-        else if (nrChannels == 4)
-        {
-            internalFormat = gamma ? GL_SRGB_ALPHA : GL_RGBA;
-            dataFormat = GL_RGBA;
-        }
-
-        glBindTexture(GL_TEXTURE_2D, textureID);
-        // 如果是 rgba 设置过滤 gl_clamp_to_edge，不然会边缘插值，边缘会达不到效果
-        // 这里我在main函数中加载纹理和加载模型中使用的函数都是这一个，需要处理一下，模型必须是 GL_REPEAT 否则可能只绘制半边纹理
-        // 然后为了实现正确的混合效果，需要做 else 中的判断
-        if (isModel)
-        {
-            glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-            glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-        }
-        else
-        {
-            glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, dataFormat == GL_RGBA ? GL_CLAMP_TO_EDGE : GL_REPEAT);
-            glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, dataFormat == GL_RGBA ? GL_CLAMP_TO_EDGE : GL_REPEAT);
-        }
-        glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-        glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-
-        glTexImage2D(GL_TEXTURE_2D, 0, internalFormat, width, height, 0, dataFormat, GL_UNSIGNED_BYTE, data);
-        glGenerateMipmap(GL_TEXTURE_2D);
+        UploadTextureData(textureID, data, width, height, nrChannels, isModel, gamma);
     }
     else
     {
@@ -74,31 +56,103 @@ public:
     std::vector<Mesh> Meshes;
     // 模型目录位置
     std::string Directory;
-    // 保存加载过的纹理（提高性能）
+    // 保存加载过的纹理（提高性能），纹理对象本身由 TextureRegistry 在所有模型间共享
     std::vector<Texture> TexturesLoaded;
     bool GammaCorrection;
+    // 是否从二进制网格缓存加载（用于统计冷/热启动）
+    bool LoadedFromCache = false;
+    // 网格上传到 GPU 时使用的顶点布局
+    VertexLayout Layout;
+    // 导入时网格优化前后的顶点缓存统计（从缓存加载时为空，缓存中保存的已经是优化后的网格）
+    MeshOptimizeReport OptimizeReport;
+
+    // 缓存中记录的 Assimp 后处理标记，改了标记缓存自动失效
+    static const unsigned int ImportFlags = aiProcess_Triangulate | aiProcess_FlipUVs | aiProcess_GenSmoothNormals | aiProcess_CalcTangentSpace;
 
-    Model(std::string const& path, bool gamma = false)
+    // 传入 loader 时纹理异步解码，先使用占位纹理，需要在渲染循环中调用 loader->Update()
+    // layout 不是 Full 时着色器需要解码压缩的顶点属性（见 Mesh.h 中的 VertexLayout）
+    Model(std::string const& path, bool gamma = false, bool useCache = true, TextureLoader* loader = nullptr, VertexLayout layout = VertexLayout::Full)
         :
-        GammaCorrection(gamma)
+        GammaCorrection(gamma),
+        Layout(layout),
+        Loader(loader)
+    {
+        LoadMesh(path, useCache);
+    }
+
+    // 纹理由全局注册表引用计数，Model 不能拷贝
+    Model(const Model&) = delete;
+    Model& operator=(const Model&) = delete;
+
+    ~Model()
     {
-        LoadMesh(path);
+        for (const Texture& texture : TexturesLoaded)
+            TextureRegistry::Get().Release(texture.ID);
     }
 
-    // 绘制
+    // 绘制（按网格顺序立即绘制，model 矩阵由调用者设置）
     void Draw(Shader& shader)
     {
         for (unsigned int i = 0; i < Meshes.size(); i++)
             Meshes[i].Draw(shader); 
     }
 
+    // 只绘制位置（深度预处理 / 阴影 pass），压缩布局下只读取位置流
+    void DrawPositions(const Shader& shader) const
+    {
+        for (const Mesh& mesh : Meshes)
+            mesh.DrawPositions(shader);
+    }
+
+    // 把所有网格提交到渲染队列，queue.Flush() 时排序并绘制（model 矩阵由队列设置）
+    void Submit(RenderQueue& queue, Shader& shader, const glm::mat4& model, RenderPass pass = RenderPass::Opaque) const
+    {
+        for (const Mesh& mesh : Meshes)
+            queue.Submit(shader, mesh, model, pass);
+    }
+
+    // 所有网格顶点缓冲占用的显存，layout 指定时按该布局计算（用于比较不同布局）
+    size_t GetVertexMemory() const
+    {
+        return GetVertexMemory(Layout);
+    }
+
+    size_t GetVertexMemory(VertexLayout layout) const
+    {
+        size_t bytes = 0;
+        for (const Mesh& mesh : Meshes)
+            bytes += mesh.Vertices.size() * Mesh::GetVertexStride(layout);
+        return bytes;
+    }
+
+    // 只绘制位置时读取的顶点数据量
+    size_t GetPositionMemory() const
+    {
+        size_t bytes = 0;
+        for (const Mesh& mesh : Meshes)
+            bytes += mesh.Vertices.size() * Mesh::GetPositionStride(Layout);
+        return bytes;
+    }
+
 private:
-    void LoadMesh(std::string const& path)
+    // 异步纹理加载器（可以为空）
+    TextureLoader* Loader;
+    // 纹理路径 -> TexturesLoaded 下标
+    std::unordered_map<std::string, size_t> TextureIndex;
+
+    void LoadMesh(std::string const& path, bool useCache)
     {
+        Directory = path.substr(0, path.find_last_of('/'));
+
+        // 先尝试二进制缓存，命中则完全跳过 Assimp
+        std::string cachePath = path + MESH_CACHE_EXTENSION;
+        uint64_t sourceHash = useCache ? HashSourceAsset(path) : 0ull;
+        if (useCache && LoadFromCache(cachePath, sourceHash))
+            return;
+
         Assimp::Importer importer;
         // OpenGL中大部分的图像的 y轴 都是反的，aiProcess_FlipUVs 处理一下
-        const aiScene* scene = importer.ReadFile(path, 
-            aiProcess_Triangulate | aiProcess_FlipUVs | aiProcess_GenSmoothNormals | aiProcess_CalcTangentSpace);
+        const aiScene* scene = importer.ReadFile(path, ImportFlags);
         
         // 检查了它的一个标记(Flag)，来查看返回的数据是不是不完整的
         if (!scene || scene->mFlags & AI_SCENE_FLAGS_INCOMPLETE || !scene->mRootNode)
@@ -106,10 +160,39 @@ private:
             std::cout << "[ASSIMP ERROR]: " << importer.GetErrorString() << std::endl;
             return;
         }
-        Directory = path.substr(0, path.find_last_of('/'));
 
         // 处理节点
         ProcessNode(scene->mRootNode, scene);
+
+        if (useCache && !WriteMeshCache(cachePath, sourceHash, ImportFlags, Meshes))
+            std::cout << "[MESH CACHE ERROR]: Failed to write mesh cache at path: " << cachePath << std::endl;
+    }
+
+    // 从二进制缓存加载网格，纹理仍然走 LoadTexture 去重
+    bool LoadFromCache(const std::string& cachePath, uint64_t sourceHash)
+    {
+        MeshCacheView cache;
+        if (sourceHash == 0ull || !cache.Open(cachePath, sourceHash, ImportFlags))
+            return false;
+
+        for (uint32_t i = 0; i < cache.GetMeshCount(); i++)
+        {
+            const MeshCacheRange& range = cache.GetRange(i);
+            const Vertex* vertexData = cache.GetVertices(range);
+            const uint32_t* indexData = cache.GetIndices(range);
+            std::vector<Vertex> vertices(vertexData, vertexData + range.VertexCount);
+            std::vector<unsigned int> indices(indexData, indexData + range.IndexCount);
+            std::vector<Texture> textures;
+            for (uint32_t t = 0; t < range.TextureCount; t++)
+            {
+                const MeshCacheTextureRef& ref = cache.GetTextureRef(range, t);
+                std::string path = cache.GetString(ref.PathOffset, ref.PathLength);
+                textures.push_back(LoadTexture(path.c_str(), cache.GetString(ref.TypeOffset, ref.TypeLength)));
+            }
+            Meshes.push_back(Mesh(vertices, indices, textures, Layout));
+        }
+        LoadedFromCache = true;
+        return true;
     }
 
     // 处理节点
@@ -140,7 +223,7 @@ private:
         // 1. 顶点
         for (unsigned int i = 0; i < mesh->mNumVertices; i++)
         {
-            Vertex vertex;
+            Vertex vertex = {};
 
             // 1. 顶点位置
             glm::vec3 vector;
@@ -208,7 +291,10 @@ private:
         std::vector<Texture> heightMaps = LoadMaterialTexture(material, aiTextureType_AMBIENT, "TextureHeight");
         textures.insert(textures.end(), heightMaps.begin(), heightMaps.end());
 
-        return Mesh(vertices, indices, textures);
+        // 4. 合并重复顶点、按顶点缓存/overdraw 重排三角形、按读取顺序重排顶点（见 MeshOptimizer.h）
+        OptimizeReport.Add(OptimizeMesh(vertices, indices));
+
+        return Mesh(vertices, indices, textures, Layout);
     }
 
     // 加载材质纹理
@@ -219,28 +305,27 @@ private:
         {
             aiString str;
             mat->GetTexture(type, i, &str);
-            bool skip = false;
-            for (unsigned int j = 0; j < TexturesLoaded.size(); j++)
-            {
-                if (std::strcmp(TexturesLoaded[j].Path.data(), str.C_Str()) == 0)
-                {
-                    textures.push_back(TexturesLoaded[j]);
-                    skip = true;
-                    break;
-                }
-            }
-            if (!skip)
-            {
-                // 如果纹理还没有被加载，则加载它
-                Texture texture;
-                texture.ID = TextureFromFile(str.C_Str(), Directory);
-                texture.Type = typeName;
-                texture.Path = str.C_Str();
-                textures.push_back(texture);
-                // 添加到已加载的纹理中
-                TexturesLoaded.push_back(texture);
-            }
+            textures.push_back(LoadTexture(str.C_Str(), typeName));
         }
         return textures;
     }
+
+    // 加载单张纹理，已经加载过的直接复用
+    Texture LoadTexture(const char* path, const std::string& typeName)
+    {
+        auto it = TextureIndex.find(path);
+        if (it != TextureIndex.end())
+            return TexturesLoaded[it->second];
+        // 如果纹理还没有被加载，则从全局注册表获取（其他模型加载过的同一张图片不会再次解码）
+        // 法线贴图的占位颜色使用 (0, 0, 1)，避免异步加载完成前光照异常
+        glm::vec4 placeholder = typeName == "TextureNormal" ? glm::vec4(0.5f, 0.5f, 1.0f, 1.0f) : glm::vec4(0.5f, 0.5f, 0.5f, 1.0f);
+        Texture texture;
+        texture.ID = TextureRegistry::Get().Acquire(Directory + '/' + path, true, false, Loader, placeholder);
+        texture.Type = typeName;
+        texture.Path = path;
+        // 添加到已加载的纹理中
+        TextureIndex[texture.Path] = TexturesLoaded.size();
+        TexturesLoaded.push_back(texture);
+        return texture;
+    }
 };
\ No newline at end of file
@@ -0,0 +1,240 @@
+#pragma once
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <iostream>
+
+// 点光源的全向阴影（28-PointShadow），四种渲染方式可以在运行时切换：
+//
+// GeometryShader : 原来的做法，整张立方体贴图作为分层附件，几何着色器把每个三角形输出 6 次（max_vertices = 18），
+//                  每个面的三角形都要经过一次裁剪/光栅化，而且几何着色器放大在大多数驱动上都很慢
+// PerFace        : 每个面一个 FBO，CPU 先用物体的 AABB 和每个面的视锥体求交，只在能看到物体的面上绘制，
+//                  没有几何着色器，代价是 draw call 变多
+// VertexLayer    : 实例化分层渲染，顶点着色器直接写 gl_Layer（GL_ARB_shader_viewport_layer_array / GL_AMD_vertex_shader_layer），
+//                  每个物体一次 draw call，实例数 = 能看到它的面数，gl_InstanceID 通过 uniform 数组映射到面
+// DualParaboloid : 对偶抛物面，两张贴图（GL_TEXTURE_2D_ARRAY 的两层）各覆盖一个半球，每个物体最多画两次；
+//                  投影在顶点着色器中完成，三角形内部按线性插值光栅化，大三角形会有误差（需要足够细分的几何体）
+//
+// 所有方式写入的深度都是 length(FragPos - lightPos) / far_plane（point_shadow_depth.fs），采样方式只在查找纹理坐标时不同
+
+enum class OmniShadowMode
+{
+    GeometryShader = 0,
+    PerFace = 1,
+    VertexLayer = 2,
+    DualParaboloid = 3,
+    Count = 4
+};
+
+inline const char* GetOmniShadowModeName(OmniShadowMode mode)
+{
+    switch (mode)
+    {
+    case OmniShadowMode::GeometryShader: return "gs";
+    case OmniShadowMode::PerFace: return "face";
+    case OmniShadowMode::VertexLayer: return "layer";
+    case OmniShadowMode::DualParaboloid: return "paraboloid";
+    default: return "unknown";
+    }
+}
+
+// 顶点着色器能否写 gl_Layer（只检查扩展，着色器还需要能成功链接）
+inline bool IsVertexLayerExtensionSupported()
+{
+    return glfwExtensionSupported("GL_ARB_shader_viewport_layer_array") || glfwExtensionSupported("GL_AMD_vertex_shader_layer");
+}
+
+// 立方体贴图第 face 个面（+X, -X, +Y, -Y, +Z, -Z）的观察矩阵，up 方向按照立方体贴图的约定
+inline glm::mat4 GetCubeFaceViewMatrix(const glm::vec3& lightPos, unsigned int face)
+{
+    static const glm::vec3 directions[6] = {
+        glm::vec3( 1.0f,  0.0f,  0.0f), glm::vec3(-1.0f,  0.0f,  0.0f), glm::vec3( 0.0f,  1.0f,  0.0f),
+        glm::vec3( 0.0f, -1.0f,  0.0f), glm::vec3( 0.0f,  0.0f,  1.0f), glm::vec3( 0.0f,  0.0f, -1.0f)
+    };
+    static const glm::vec3 ups[6] = {
+        glm::vec3( 0.0f, -1.0f,  0.0f), glm::vec3( 0.0f, -1.0f,  0.0f), glm::vec3( 0.0f,  0.0f,  1.0f),
+        glm::vec3( 0.0f,  0.0f, -1.0f), glm::vec3( 0.0f, -1.0f,  0.0f), glm::vec3( 0.0f, -1.0f,  0.0f)
+    };
+    return glm::lookAt(lightPos, lightPos + directions[face], ups[face]);
+}
+
+inline glm::mat4 GetCubeFaceMatrix(const glm::vec3& lightPos, float nearPlane, float farPlane, unsigned int face)
+{
+    return glm::perspective(glm::radians(90.0f), 1.0f, nearPlane, farPlane) * GetCubeFaceViewMatrix(lightPos, face);
+}
+
+// AABB 到光源的最近距离超过 range 时不会投射阴影
+inline bool IsInLightRange(const glm::vec3& lightPos, float range, const glm::vec3& worldMin, const glm::vec3& worldMax)
+{
+    glm::vec3 offset = glm::clamp(lightPos, worldMin, worldMax) - lightPos;
+    return glm::dot(offset, offset) <= range * range;
+}
+
+// AABB 和立方体贴图每个面的视锥体求交，返回 6 位的掩码（第 i 位对应第 i 个面）
+// 第 face 个面的视锥体是以光源为顶点的四棱锥：s * p[axis] >= |p[other]|，拆成 4 个过光源的平面，
+// 每个平面取 AABB 上使 s * p[axis] ± p[other] 最大的角点测试
+inline unsigned int GetCubeFaceMask(const glm::vec3& lightPos, float range, const glm::vec3& worldMin, const glm::vec3& worldMax)
+{
+    if (!IsInLightRange(lightPos, range, worldMin, worldMax))
+        return 0u;
+    glm::vec3 lo = worldMin - lightPos;
+    glm::vec3 hi = worldMax - lightPos;
+    unsigned int mask = 0u;
+    for (unsigned int face = 0; face < 6; face++)
+    {
+        int axis = static_cast<int>(face / 2);
+        float major = (face & 1u) ? -lo[axis] : hi[axis];
+        bool bVisible = major >= 0.0f;
+        for (int other = 0; other < 3 && bVisible; other++)
+        {
+            if (other != axis)
+                bVisible = major + hi[other] >= 0.0f && major - lo[other] >= 0.0f;
+        }
+        if (bVisible)
+            mask |= 1u << face;
+    }
+    return mask;
+}
+
+// 对偶抛物面两个半球（0：+Z，1：-Z）的可见性掩码
+inline unsigned int GetHemisphereMask(const glm::vec3& lightPos, float range, const glm::vec3& worldMin, const glm::vec3& worldMax)
+{
+    if (!IsInLightRange(lightPos, range, worldMin, worldMax))
+        return 0u;
+    return (worldMax.z >= lightPos.z ? 1u : 0u) | (worldMin.z <= lightPos.z ? 2u : 0u);
+}
+
+class OmniShadowMap
+{
+public:
+    // 立方体贴图每个面 resolution²，对偶抛物面每个半球 paraboloidResolution²
+    OmniShadowMap(unsigned int resolution = 1024u, unsigned int paraboloidResolution = 1024u)
+        :
+        Resolution(resolution),
+        ParaboloidResolution(paraboloidResolution)
+    {
+        glGenTextures(1, &Cubemap);
+        glBindTexture(GL_TEXTURE_CUBE_MAP, Cubemap);
+        for (unsigned int i = 0; i < 6; ++i)
+            glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, 0, GL_DEPTH_COMPONENT, Resolution, Resolution, 0, GL_DEPTH_COMPONENT, GL_FLOAT, NULL);
+        glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+
+        // 整张立方体贴图作为分层附件（GeometryShader、VertexLayer 通过 gl_Layer 选择面）
+        glGenFramebuffers(1, &LayeredFBO);
+        glBindFramebuffer(GL_FRAMEBUFFER, LayeredFBO);
+        glFramebufferTexture(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, Cubemap, 0);
+        CheckFramebuffer("layered");
+
+        // 每个面单独一个 FBO（PerFace），切换面时不用重新挂载附件
+        glGenFramebuffers(6, FaceFBOs);
+        for (unsigned int i = 0; i < 6; ++i)
+        {
+            glBindFramebuffer(GL_FRAMEBUFFER, FaceFBOs[i]);
+            glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, Cubemap, 0);
+            CheckFramebuffer("face");
+        }
+
+        glGenTextures(1, &ParaboloidMap);
+        glBindTexture(GL_TEXTURE_2D_ARRAY, ParaboloidMap);
+        glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_DEPTH_COMPONENT, ParaboloidResolution, ParaboloidResolution, 2, 0, GL_DEPTH_COMPONENT, GL_FLOAT, NULL);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        glGenFramebuffers(2, HemisphereFBOs);
+        for (unsigned int i = 0; i < 2; ++i)
+        {
+            glBindFramebuffer(GL_FRAMEBUFFER, HemisphereFBOs[i]);
+            glFramebufferTextureLayer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, ParaboloidMap, 0, i);
+            CheckFramebuffer("paraboloid");
+        }
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    }
+
+    void Destroy()
+    {
+        glDeleteFramebuffers(1, &LayeredFBO);
+        glDeleteFramebuffers(6, FaceFBOs);
+        glDeleteFramebuffers(2, HemisphereFBOs);
+        glDeleteTextures(1, &Cubemap);
+        glDeleteTextures(1, &ParaboloidMap);
+        Cubemap = ParaboloidMap = LayeredFBO = 0;
+    }
+
+    // 绑定分层 FBO 并清空全部 6 个面
+    void BeginLayered()
+    {
+        glBindFramebuffer(GL_FRAMEBUFFER, LayeredFBO);
+        glViewport(0, 0, Resolution, Resolution);
+        glClear(GL_DEPTH_BUFFER_BIT);
+    }
+
+    void BeginFace(unsigned int face)
+    {
+        glBindFramebuffer(GL_FRAMEBUFFER, FaceFBOs[face]);
+        glViewport(0, 0, Resolution, Resolution);
+        glClear(GL_DEPTH_BUFFER_BIT);
+    }
+
+    // 半球 0 覆盖 +Z，半球 1 覆盖 -Z（把 z 取反后用同一个投影，图像是镜像的，所以不做背面剔除）
+    // 半球之外的顶点由 gl_ClipDistance[0] 裁掉
+    void BeginHemisphere(unsigned int hemisphere)
+    {
+        if (!bInHemisphere)
+        {
+            bCullFaceWasEnabled = glIsEnabled(GL_CULL_FACE) == GL_TRUE;
+            bInHemisphere = true;
+        }
+        glBindFramebuffer(GL_FRAMEBUFFER, HemisphereFBOs[hemisphere]);
+        glViewport(0, 0, ParaboloidResolution, ParaboloidResolution);
+        glClear(GL_DEPTH_BUFFER_BIT);
+        glEnable(GL_CLIP_DISTANCE0);
+        glDisable(GL_CULL_FACE);
+    }
+
+    void End()
+    {
+        if (bInHemisphere)
+        {
+            glDisable(GL_CLIP_DISTANCE0);
+            if (bCullFaceWasEnabled)
+                glEnable(GL_CULL_FACE);
+            bInHemisphere = false;
+        }
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    }
+
+    // 半球的符号，传给 point_shadow_paraboloid.vs 的 hemisphere
+    static float GetHemisphereSign(unsigned int hemisphere) { return hemisphere == 0u ? 1.0f : -1.0f; }
+
+    inline unsigned int GetCubemap() const { return Cubemap; }
+    inline unsigned int GetParaboloidMap() const { return ParaboloidMap; }
+    inline unsigned int GetResolution() const { return Resolution; }
+    inline unsigned int GetParaboloidResolution() const { return ParaboloidResolution; }
+
+private:
+    unsigned int Resolution;
+    unsigned int ParaboloidResolution;
+    unsigned int Cubemap = 0;
+    unsigned int ParaboloidMap = 0;
+    unsigned int LayeredFBO = 0;
+    unsigned int FaceFBOs[6] = {};
+    unsigned int HemisphereFBOs[2] = {};
+    bool bInHemisphere = false;
+    bool bCullFaceWasEnabled = false;
+
+    static void CheckFramebuffer(const char* name)
+    {
+        // 不需要渲染具体场景
+        glDrawBuffer(GL_NONE);
+        glReadBuffer(GL_NONE);
+        if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+            std::cout << "Omni shadow " << name << " framebuffer not complete!" << std::endl;
+    }
+};
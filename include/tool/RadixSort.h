@@ -0,0 +1,103 @@
+#pragma once
+#include <cstdint>
+#include <cstring>
+#include <vector>
+#include <type_traits>
+
+// 按无符号整数 key 升序排列的 LSD 基数排序（每趟 8 位，32 位 key 最多 4 趟，64 位 key 最多 8 趟），输出排好序的下标
+// 1. 第一遍扫描同时统计所有趟的直方图，某一趟所有 key 的这 8 位都相同时直接跳过（比如深度都落在很小的范围内，高位全部相同）
+// 2. 排序是稳定的，key 相同的元素保持输入顺序（用 std::map 按距离排序时距离相同的物体会被覆盖掉）
+// 3. 内部缓冲只增不减，每帧排序数量稳定时不会再分配内存
+
+// 把 float 映射成保持大小顺序的 uint32：正数翻转符号位，负数翻转所有位
+inline uint32_t FloatToSortableKey(float value)
+{
+    uint32_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    uint32_t mask = (bits & 0x80000000u) != 0u ? 0xFFFFFFFFu : 0x80000000u;
+    return bits ^ mask;
+}
+
+template <typename Key>
+class RadixSorter
+{
+    static_assert(std::is_unsigned<Key>::value, "RadixSorter needs an unsigned key type");
+
+public:
+    static const unsigned int PassCount = sizeof(Key);
+
+    // 返回的下标数组在下一次 Sort 之前有效
+    const uint32_t* Sort(const Key* keys, uint32_t count)
+    {
+        if (Indices[0].size() < count)
+        {
+            for (int i = 0; i < 2; i++)
+            {
+                Keys[i].resize(count);
+                Indices[i].resize(count);
+            }
+        }
+        PassesExecuted = 0u;
+        if (count == 0u)
+            return Indices[0].data();
+
+        uint32_t histograms[PassCount][256];
+        std::memset(histograms, 0, sizeof(histograms));
+        for (uint32_t i = 0; i < count; i++)
+        {
+            Key key = keys[i];
+            for (unsigned int pass = 0; pass < PassCount; pass++)
+                histograms[pass][(key >> (pass * 8u)) & 0xFFu]++;
+        }
+
+        // 第一趟直接读输入，下标为空表示 0, 1, 2...
+        const Key* sourceKeys = keys;
+        const uint32_t* sourceIndices = nullptr;
+        int target = 0;
+        for (unsigned int pass = 0; pass < PassCount; pass++)
+        {
+            unsigned int shift = pass * 8u;
+            uint32_t* histogram = histograms[pass];
+            if (histogram[(keys[0] >> shift) & 0xFFu] == count)
+                continue;
+
+            uint32_t offsets[256];
+            uint32_t sum = 0u;
+            for (unsigned int digit = 0; digit < 256u; digit++)
+            {
+                offsets[digit] = sum;
+                sum += histogram[digit];
+            }
+            Key* targetKeys = Keys[target].data();
+            uint32_t* targetIndices = Indices[target].data();
+            for (uint32_t i = 0; i < count; i++)
+            {
+                Key key = sourceKeys[i];
+                uint32_t position = offsets[(key >> shift) & 0xFFu]++;
+                targetKeys[position] = key;
+                targetIndices[position] = sourceIndices != nullptr ? sourceIndices[i] : i;
+            }
+            sourceKeys = targetKeys;
+            sourceIndices = targetIndices;
+            target ^= 1;
+            PassesExecuted++;
+        }
+
+        // 所有 key 都相同，保持原来的顺序
+        if (sourceIndices == nullptr)
+        {
+            for (uint32_t i = 0; i < count; i++)
+                Indices[0][i] = i;
+            sourceIndices = Indices[0].data();
+        }
+        return sourceIndices;
+    }
+
+    // 上一次 Sort 实际执行的趟数
+    inline unsigned int GetPassesExecuted() const { return PassesExecuted; }
+
+private:
+    std::vector<Key> Keys[2];
+    std::vector<uint32_t> Indices[2];
+    unsigned int PassesExecuted = 0u;
+};
@@ -0,0 +1,16 @@
+#pragma once
+
+// 整数哈希（PCG），同样的 index 和 stream 总是得到同样的随机数，和线程数、执行顺序无关
+// 场景生成和测试程序用它代替 rand()：并行生成时不需要共享状态，不同的 stream 得到互不相关的序列
+inline unsigned int HashRandom(unsigned int index, unsigned int stream)
+{
+    unsigned int state = index * 747796405u + stream * 2891336453u + 1u;
+    unsigned int word = ((state >> ((state >> 28u) + 4u)) ^ state) * 277803737u;
+    return (word >> 22u) ^ word;
+}
+
+// [low, high) 之间的随机数（精度 1 / 10000）
+inline float HashRandomRange(unsigned int index, unsigned int stream, float low, float high)
+{
+    return low + (high - low) * static_cast<float>(HashRandom(index, stream) % 10000u) / 10000.0f;
+}
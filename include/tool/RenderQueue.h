@@ -0,0 +1,231 @@
+#pragma once
+#include <glad/glad.h>
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <glm/glm.hpp>
+
+#include <tool/Shader.h>
+#include <tool/Mesh.h>
+#include <tool/RadixSort.h>
+
+// 渲染队列：先收集整帧的绘制包（着色器、网格、物体矩阵），按 64 位排序键基数排序后统一提交
+// Model::Draw 按场景顺序逐个调用 Mesh::Draw，每次都重新激活 / 绑定所有纹理、绑定再解绑 VAO，
+// 同一个模型画 N 次就是 N 倍的状态切换。排序之后状态相同的绘制排在一起，提交时只在状态真正改变时绑定：
+// 1. 排序键（高位优先）：pass | 着色器 | 材质 | VAO | 深度，不透明物体在状态相同时从前往后画（提前深度测试）
+//    透明 pass 必须从后往前混合，深度放在 pass 之后：pass | 反转的深度 | 着色器 | 材质 | VAO
+// 2. 提交时记录当前的 program、VAO、每个纹理单元绑定的纹理，相同的直接跳过（计入 DrawStats::Filtered）；
+//    uniform 的值由 Shader 的缓存过滤，物体矩阵用预先解析的句柄设置
+// 3. 着色器、材质、VAO 在键中只占 12 / 16 / 16 位，ID 超出范围时只会影响分组，过滤按真实的 ID 比较，结果仍然正确
+// 绘制包只保存 Shader 和 Mesh 的指针，它们在 Flush 之前必须有效
+
+enum class RenderPass : uint8_t
+{
+    Opaque = 0,
+    AlphaTested = 1,
+    Transparent = 2
+};
+
+// depth 为视线方向上的距离，只取 float 的高 16 位（符号 + 指数 + 7 位尾数，相对精度约 1%）
+inline uint64_t MakeSortKey(RenderPass pass, uint32_t shader, uint32_t material, uint32_t vao, float depth)
+{
+    uint64_t key = static_cast<uint64_t>(pass) << 60;
+    uint64_t depthBits = FloatToSortableKey(depth) >> 16;
+    uint64_t shaderBits = shader & 0xFFFu;
+    uint64_t materialBits = material & 0xFFFFu;
+    uint64_t vaoBits = vao & 0xFFFFu;
+    if (pass == RenderPass::Transparent)
+        return key | ((0xFFFFu - depthBits) << 44) | (shaderBits << 32) | (materialBits << 16) | vaoBits;
+    return key | (shaderBits << 48) | (materialBits << 32) | (vaoBits << 16) | depthBits;
+}
+
+struct DrawPacket
+{
+    Shader* Program;
+    const Mesh* Geometry;
+    glm::mat4 Model;
+};
+
+class RenderQueue
+{
+public:
+    // modelUniform 是物体矩阵的 uniform 名（章节中有 uModel 也有 model）
+    explicit RenderQueue(const std::string& modelUniform = "uModel")
+        :
+        ModelUniform(modelUniform)
+    {
+    }
+
+    // 每帧开始收集之前调用，viewDirection 需要归一化
+    void Begin(const glm::vec3& viewPosition, const glm::vec3& viewDirection)
+    {
+        ViewPosition = viewPosition;
+        ViewDirection = viewDirection;
+        Packets.clear();
+        Keys.clear();
+    }
+
+    void Submit(Shader& shader, const Mesh& mesh, const glm::mat4& model, RenderPass pass = RenderPass::Opaque)
+    {
+        glm::vec3 center = glm::vec3(model * glm::vec4(mesh.BoundsCenter, 1.0f));
+        float depth = glm::dot(center - ViewPosition, ViewDirection);
+        Keys.push_back(MakeSortKey(pass, shader.GetID(), mesh.MaterialID, mesh.VAO, depth));
+        Packets.push_back(DrawPacket{ &shader, &mesh, model });
+    }
+
+    // 排序并提交所有绘制包，结束时 VAO 恢复为 0，激活的纹理单元恢复为 0
+    void Flush()
+    {
+        uint32_t count = static_cast<uint32_t>(Packets.size());
+        const uint32_t* order = bSortEnabled ? Sorter.Sort(Keys.data(), count) : nullptr;
+        PacketCount = count;
+        SortPasses = bSortEnabled ? Sorter.GetPassesExecuted() : 0u;
+
+        // 队列外面的代码可能改过状态，每次 Flush 都从未知状态开始
+        CurrentShader = nullptr;
+        CurrentMaterial = INVALID_STATE;
+        CurrentVAO = INVALID_STATE;
+        CurrentLayout = VertexLayout::Full;
+        ActiveUnit = INVALID_STATE;
+        BoundTextures.assign(BoundTextures.size(), INVALID_STATE);
+
+        DrawStats& stats = Mesh::GetDrawStats();
+        for (uint32_t i = 0; i < count; i++)
+        {
+            const DrawPacket& packet = Packets[order != nullptr ? order[i] : i];
+            const Mesh& mesh = *packet.Geometry;
+            BindShader(*packet.Program, stats);
+            BindMaterial(mesh, stats);
+            BindVertexArray(mesh, stats);
+            CurrentShader->SetMat4f(ModelHandle, packet.Model);
+            glDrawElements(GL_TRIANGLES, static_cast<unsigned int>(mesh.Indices.size()), GL_UNSIGNED_INT, (void*)0);
+            stats.Draws++;
+        }
+
+        if (count > 0u)
+        {
+            ResetVertexLayout();
+            glBindVertexArray(0u);
+            glActiveTexture(GL_TEXTURE0);
+        }
+        Packets.clear();
+        Keys.clear();
+    }
+
+    // 关闭后按提交顺序绘制（仍然过滤重复状态），用于比较排序的效果
+    inline void SetSortEnabled(bool enabled) { bSortEnabled = enabled; }
+    // 关闭后每个绘制包都重新绑定所有状态，相当于 Mesh::Draw
+    inline void SetStateFilteringEnabled(bool enabled) { bFilterState = enabled; }
+
+    // 上一次 Flush 的绘制包数量和基数排序实际执行的趟数
+    inline uint32_t GetPacketCount() const { return PacketCount; }
+    inline unsigned int GetSortPasses() const { return SortPasses; }
+
+private:
+    static const uint32_t INVALID_STATE = 0xFFFFFFFFu;
+
+    std::string ModelUniform;
+    glm::vec3 ViewPosition = glm::vec3(0.0f);
+    glm::vec3 ViewDirection = glm::vec3(0.0f, 0.0f, -1.0f);
+
+    std::vector<DrawPacket> Packets;
+    std::vector<uint64_t> Keys;
+    RadixSorter<uint64_t> Sorter;
+    bool bSortEnabled = true;
+    bool bFilterState = true;
+    uint32_t PacketCount = 0u;
+    unsigned int SortPasses = 0u;
+
+    // 提交时的当前状态
+    Shader* CurrentShader = nullptr;
+    UniformHandle ModelHandle;
+    uint32_t CurrentMaterial = INVALID_STATE;
+    uint32_t CurrentVAO = INVALID_STATE;
+    VertexLayout CurrentLayout = VertexLayout::Full;
+    uint32_t ActiveUnit = INVALID_STATE;
+    std::vector<uint32_t> BoundTextures;
+
+    void BindShader(Shader& shader, DrawStats& stats)
+    {
+        if (bFilterState && CurrentShader != nullptr && CurrentShader->GetID() == shader.GetID())
+        {
+            stats.Filtered++;
+            return;
+        }
+        // uVertexLayout 是每个 program 自己的，切换之前恢复上一个 program 的，
+        // 压缩布局的网格需要重新绑定 VAO，给新的 program 设置解码参数
+        if (CurrentLayout != VertexLayout::Full)
+            CurrentVAO = INVALID_STATE;
+        ResetVertexLayout();
+        shader.Use();
+        stats.ProgramBinds++;
+        CurrentShader = &shader;
+        ModelHandle = shader.GetUniform(ModelUniform);
+        // 采样器 uniform 也是每个 program 自己的，纹理绑定不变
+        CurrentMaterial = INVALID_STATE;
+    }
+
+    void BindMaterial(const Mesh& mesh, DrawStats& stats)
+    {
+        if (bFilterState && mesh.MaterialID == CurrentMaterial)
+        {
+            stats.Filtered += static_cast<unsigned int>(mesh.Textures.size());
+            return;
+        }
+        CurrentMaterial = mesh.MaterialID;
+        if (BoundTextures.size() < mesh.Textures.size())
+            BoundTextures.resize(mesh.Textures.size(), INVALID_STATE);
+        for (uint32_t unit = 0; unit < mesh.Textures.size(); unit++)
+        {
+            // 材质切换时才按名字设置采样器，值没变的由 Shader 过滤
+            CurrentShader->SetInt(mesh.SamplerNames[unit].c_str(), static_cast<int>(unit));
+            unsigned int texture = mesh.Textures[unit].ID;
+            if (bFilterState && BoundTextures[unit] == texture)
+            {
+                stats.Filtered++;
+                continue;
+            }
+            if (ActiveUnit != unit)
+            {
+                glActiveTexture(GL_TEXTURE0 + unit);
+                ActiveUnit = unit;
+            }
+            glBindTexture(GL_TEXTURE_2D, texture);
+            BoundTextures[unit] = texture;
+            stats.TextureBinds++;
+        }
+    }
+
+    void BindVertexArray(const Mesh& mesh, DrawStats& stats)
+    {
+        if (bFilterState && mesh.VAO == CurrentVAO)
+        {
+            stats.Filtered++;
+            return;
+        }
+        glBindVertexArray(mesh.VAO);
+        CurrentVAO = mesh.VAO;
+        stats.VAOBinds++;
+
+        // 压缩布局需要着色器解码，切回完整布局时恢复 uVertexLayout
+        if (mesh.Layout != VertexLayout::Full)
+        {
+            CurrentShader->SetInt("uVertexLayout", static_cast<int>(mesh.Layout));
+            CurrentShader->SetVec3f("uPositionScale", mesh.PositionScale);
+            CurrentShader->SetVec3f("uPositionBias", mesh.PositionBias);
+        }
+        else
+        {
+            ResetVertexLayout();
+        }
+        CurrentLayout = mesh.Layout;
+    }
+
+    void ResetVertexLayout()
+    {
+        if (CurrentShader != nullptr && CurrentLayout != VertexLayout::Full)
+            CurrentShader->SetInt("uVertexLayout", 0);
+        CurrentLayout = VertexLayout::Full;
+    }
+};
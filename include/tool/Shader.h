@@ -3,8 +3,31 @@
 #include <iostream>
 #include <fstream>
 #include <sstream>
+#include <string>
+#include <vector>
+#include <memory>
+#include <cstring>
+#include <unordered_map>
 #include <glm/glm.hpp>
 
+// 预先解析好的 uniform 句柄，用于每帧重复设置的 uniform（避免每次用字符串查找）
+struct UniformHandle
+{
+    int Index = -1;
+
+    inline bool IsValid() const { return Index >= 0; }
+};
+
+// uniform 调用统计（所有 Shader 共享），用于比较缓存前后每帧的调用次数
+struct UniformStats
+{
+    unsigned int Calls = 0;         // 实际发出的 glUniform* 调用
+    unsigned int Redundant = 0;     // 值没有变化被过滤掉的调用
+    unsigned int NameLookups = 0;   // 通过字符串查找 uniform 的次数（原来每次都是一次 glGetUniformLocation）
+
+    void Reset() { Calls = 0; Redundant = 0; NameLookups = 0; }
+};
+
 class Shader
 {
 public:
@@ -73,6 +96,7 @@ public:
             glAttachShader(ID, geometryShader);
         glLinkProgram(ID);
         CheckCompileErrors(ID, "PROGRAM");
+        ReflectUniforms();
         glDeleteShader(vertexShader);
         glDeleteShader(fragmentShader);
         if (GeometryShaderPath != nullptr)
@@ -89,39 +113,142 @@ public:
         glDeleteProgram(ID);
     }
 
+    // 查找 uniform 句柄，在初始化时调用一次，渲染循环中使用句柄设置
+    UniformHandle GetUniform(const std::string& name) const
+    {
+        auto it = Uniforms->Names.find(name);
+        if (it != Uniforms->Names.end())
+            return UniformHandle{ it->second };
+        // 没有被反射到的名字（未激活的 uniform）也缓存起来，location 为 -1，glUniform 会忽略
+        return UniformHandle{ AddUniformSlot(name, glGetUniformLocation(ID, name.c_str())) };
+    }
+
     void SetInt(const char* name, const int value) const
     {
-        glUniform1i(glGetUniformLocation(ID, name), value);
+        if (LegacyUniformsEnabled())
+            glUniform1i(LegacyUniformLocation(name), value);
+        else
+            SetInt(LookupUniform(name), value);
     }
 
     void SetFloat(const char* name, const float value) const
     {
-        glUniform1f(glGetUniformLocation(ID, name), value);
+        if (LegacyUniformsEnabled())
+            glUniform1f(LegacyUniformLocation(name), value);
+        else
+            SetFloat(LookupUniform(name), value);
     }
 
     void SetFloat(const std::string& name, const float value) const
     {
-        glUniform1f(glGetUniformLocation(ID, name.c_str()), value);
+        if (LegacyUniformsEnabled())
+            glUniform1f(LegacyUniformLocation(name.c_str()), value);
+        else
+            SetFloat(LookupUniform(name), value);
     }
 
     void SetMat4f(const std::string& name, const glm::mat4& value) const
     {
-        glUniformMatrix4fv(glGetUniformLocation(ID, name.c_str()), 1, false, &value[0][0]);
+        if (LegacyUniformsEnabled())
+            glUniformMatrix4fv(LegacyUniformLocation(name.c_str()), 1, false, &value[0][0]);
+        else
+            SetMat4f(LookupUniform(name), value);
     }
 
     void SetMat3f(const std::string& name, const glm::mat3& value) const
     {
-        glUniformMatrix3fv(glGetUniformLocation(ID, name.c_str()), 1, false, &value[0][0]);
+        if (LegacyUniformsEnabled())
+            glUniformMatrix3fv(LegacyUniformLocation(name.c_str()), 1, false, &value[0][0]);
+        else
+            SetMat3f(LookupUniform(name), value);
+    }
+
+    void SetVec2f(const std::string& name, const glm::vec2& value) const
+    {
+        if (LegacyUniformsEnabled())
+            glUniform2fv(LegacyUniformLocation(name.c_str()), 1, &value[0]);
+        else
+            SetVec2f(LookupUniform(name), value);
     }
 
     void SetVec3f(const std::string& name, const glm::vec3& value) const
     {
-        glUniform3fv(glGetUniformLocation(ID, name.c_str()), 1, &value[0]);
+        if (LegacyUniformsEnabled())
+            glUniform3fv(LegacyUniformLocation(name.c_str()), 1, &value[0]);
+        else
+            SetVec3f(LookupUniform(name), value);
     }
 
     void SetVec3f(const std::string& name, const float x, const float y, const float z) const
     {
-        glUniform3f(glGetUniformLocation(ID, name.c_str()), x, y, z);
+        if (LegacyUniformsEnabled())
+            glUniform3f(LegacyUniformLocation(name.c_str()), x, y, z);
+        else
+            SetVec3f(LookupUniform(name), glm::vec3(x, y, z));
+    }
+
+    // 句柄版本，值和上一次相同时不会调用 glUniform*（需要先 Use()）
+    void SetInt(UniformHandle handle, const int value) const
+    {
+        int location = UpdateUniformValue(handle, &value, sizeof(value));
+        if (location >= 0)
+            glUniform1i(location, value);
+    }
+
+    void SetFloat(UniformHandle handle, const float value) const
+    {
+        int location = UpdateUniformValue(handle, &value, sizeof(value));
+        if (location >= 0)
+            glUniform1f(location, value);
+    }
+
+    void SetMat4f(UniformHandle handle, const glm::mat4& value) const
+    {
+        int location = UpdateUniformValue(handle, &value[0][0], sizeof(value));
+        if (location >= 0)
+            glUniformMatrix4fv(location, 1, false, &value[0][0]);
+    }
+
+    void SetMat3f(UniformHandle handle, const glm::mat3& value) const
+    {
+        int location = UpdateUniformValue(handle, &value[0][0], sizeof(value));
+        if (location >= 0)
+            glUniformMatrix3fv(location, 1, false, &value[0][0]);
+    }
+
+    void SetVec2f(UniformHandle handle, const glm::vec2& value) const
+    {
+        int location = UpdateUniformValue(handle, &value[0], sizeof(value));
+        if (location >= 0)
+            glUniform2fv(location, 1, &value[0]);
+    }
+
+    void SetVec3f(UniformHandle handle, const glm::vec3& value) const
+    {
+        int location = UpdateUniformValue(handle, &value[0], sizeof(value));
+        if (location >= 0)
+            glUniform3fv(location, 1, &value[0]);
+    }
+
+    // 绕过 Shader 直接调用 glUniform* 修改过 uniform 之后需要清空值缓存
+    void InvalidateUniformCache() const
+    {
+        for (UniformSlot& slot : Uniforms->Slots)
+            slot.bHasValue = false;
+    }
+
+    static UniformStats& GetUniformStats()
+    {
+        static UniformStats stats;
+        return stats;
+    }
+
+    // 加缓存之前的做法：每次设置都调用 glGetUniformLocation 和 glUniform*，不过滤重复的值，只用于对比测试
+    // 关闭之后需要对用到的 Shader 调用 InvalidateUniformCache
+    static bool& LegacyUniformsEnabled()
+    {
+        static bool enabled = false;
+        return enabled;
     }
 
     // inline functions
@@ -131,6 +258,104 @@ private:
     // shader program
     unsigned int ID;
 
+    // 一个 uniform（数组的每个元素单独占一个）的 location 和上一次设置的值
+    struct UniformSlot
+    {
+        int Location = -1;
+        // 旧路径按名字重新查找 location
+        std::string Name;
+        unsigned int Size = 0;
+        unsigned char Value[sizeof(glm::mat4)];
+        bool bHasValue = false;
+    };
+
+    struct UniformTable
+    {
+        std::unordered_map<std::string, int> Names;
+        std::vector<UniformSlot> Slots;
+    };
+
+    // Shader 可能被按值传递，拷贝之间共享同一份缓存，否则缓存的值会和 OpenGL 中的不一致
+    std::shared_ptr<UniformTable> Uniforms = std::make_shared<UniformTable>();
+
+    // 链接之后反射所有激活的 uniform，数组展开成 name[i]
+    void ReflectUniforms()
+    {
+        int count = 0;
+        glGetProgramiv(ID, GL_ACTIVE_UNIFORMS, &count);
+        char name[256];
+        for (int i = 0; i < count; i++)
+        {
+            int length = 0;
+            int size = 0;
+            unsigned int type = 0;
+            glGetActiveUniform(ID, static_cast<unsigned int>(i), sizeof(name), &length, &size, &type, name);
+            std::string uniformName(name, length);
+            // uniform block 中的成员没有 location
+            int location = glGetUniformLocation(ID, uniformName.c_str());
+            if (location < 0)
+                continue;
+            AddUniformSlot(uniformName, location);
+            std::string::size_type bracket = uniformName.rfind("[0]");
+            if (bracket != std::string::npos && bracket + 3 == uniformName.size())
+            {
+                std::string baseName = uniformName.substr(0, bracket);
+                Uniforms->Names[baseName] = Uniforms->Names[uniformName];
+                for (int element = 1; element < size; element++)
+                {
+                    std::string elementName = baseName + "[" + std::to_string(element) + "]";
+                    AddUniformSlot(elementName, glGetUniformLocation(ID, elementName.c_str()));
+                }
+            }
+        }
+    }
+
+    int AddUniformSlot(const std::string& name, int location) const
+    {
+        int index = static_cast<int>(Uniforms->Slots.size());
+        UniformSlot slot;
+        slot.Location = location;
+        slot.Name = name;
+        Uniforms->Slots.push_back(slot);
+        Uniforms->Names[name] = index;
+        return index;
+    }
+
+    UniformHandle LookupUniform(const std::string& name) const
+    {
+        GetUniformStats().NameLookups++;
+        return GetUniform(name);
+    }
+
+    int LegacyUniformLocation(const char* name) const
+    {
+        GetUniformStats().NameLookups++;
+        GetUniformStats().Calls++;
+        return glGetUniformLocation(ID, name);
+    }
+
+    // 记录新值，返回需要设置的 location，值没变化时返回 -1
+    int UpdateUniformValue(UniformHandle handle, const void* value, unsigned int size) const
+    {
+        if (!handle.IsValid())
+            return -1;
+        UniformSlot& slot = Uniforms->Slots[handle.Index];
+        if (LegacyUniformsEnabled())
+            return LegacyUniformLocation(slot.Name.c_str());
+        if (slot.Location < 0)
+            return -1;
+        if (slot.bHasValue && slot.Size == size && std::memcmp(slot.Value, value, size) == 0)
+        {
+            GetUniformStats().Redundant++;
+            return -1;
+        }
+        std::memcpy(slot.Value, value, size);
+        slot.Size = size;
+        slot.bHasValue = true;
+        GetUniformStats().Calls++;
+        return slot.Location;
+    }
+
     void CheckCompileErrors(unsigned int shader, std::string type)
     {
         int success;
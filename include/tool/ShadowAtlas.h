@@ -0,0 +1,388 @@
+#pragma once
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include <tool/OmniShadowMap.h>
+
+#include <iostream>
+#include <vector>
+#include <algorithm>
+#include <cmath>
+
+// 多个点光源共享的阴影图集（28-PointShadow 的 --shadow-atlas）
+//
+// 1. 每个光源的 6 个面各占图集中的一块正方形，大小按光源在屏幕上的重要性（影响范围投影到屏幕上的像素数）选择 2 的幂，
+//    由四叉树伙伴分配器分配；总面积超过图集时从最不重要的光源开始降低分辨率，连最小的 tile 都放不下的光源没有阴影
+// 2. 两张同样大小的深度图集：缓存图集只有静态投射体，最终图集 = 静态内容 + 这一帧的动态投射体，着色器只读最终图集
+// 3. 脏标记以面为单位：光源移动、tile 重新分配、静态投射体变化（InvalidateRegion）时才重画缓存图集中对应的面；
+//    每帧只把有动态投射体（或上一帧有动态投射体）的面从缓存图集复制到最终图集，再在上面画动态投射体
+// 每个面的投影矩阵和立方体贴图相同（GetCubeFaceMatrix），着色器按立方体贴图的规则选择面和面内坐标，再映射到图集中的矩形
+
+// 四叉树伙伴分配器：块的大小是 AtlasSize >> level，释放时 4 个兄弟块都空闲就合并回父块
+class ShadowAtlasAllocator
+{
+public:
+    ShadowAtlasAllocator(unsigned int atlasSize, unsigned int minSize)
+        :
+        AtlasSize(atlasSize),
+        MinSize(minSize)
+    {
+        LevelCount = 1u;
+        while ((AtlasSize >> (LevelCount - 1u)) > MinSize)
+            LevelCount++;
+        Reset();
+    }
+
+    void Reset()
+    {
+        FreeBlocks.assign(LevelCount, std::vector<glm::ivec2>());
+        FreeBlocks[0].push_back(glm::ivec2(0));
+    }
+
+    // size 必须是 MinSize 到 AtlasSize 之间的 2 的幂
+    bool Allocate(unsigned int size, glm::ivec2& offset)
+    {
+        unsigned int level = GetLevel(size);
+        int source = static_cast<int>(level);
+        while (source >= 0 && FreeBlocks[source].empty())
+            source--;
+        if (source < 0)
+            return false;
+        offset = FreeBlocks[source].back();
+        FreeBlocks[source].pop_back();
+        // 逐级拆分，保留左下角的子块，另外 3 个放回空闲列表
+        for (unsigned int l = static_cast<unsigned int>(source) + 1u; l <= level; l++)
+        {
+            int half = static_cast<int>(AtlasSize >> l);
+            FreeBlocks[l].push_back(offset + glm::ivec2(half, 0));
+            FreeBlocks[l].push_back(offset + glm::ivec2(0, half));
+            FreeBlocks[l].push_back(offset + glm::ivec2(half, half));
+        }
+        return true;
+    }
+
+    void Free(glm::ivec2 offset, unsigned int size)
+    {
+        unsigned int level = GetLevel(size);
+        while (level > 0u)
+        {
+            int parentSize = static_cast<int>(AtlasSize >> (level - 1u));
+            glm::ivec2 parent(offset.x / parentSize * parentSize, offset.y / parentSize * parentSize);
+            int half = parentSize / 2;
+            std::vector<glm::ivec2>& blocks = FreeBlocks[level];
+            // 其余 3 个兄弟块都空闲时才能合并
+            size_t siblings[3];
+            unsigned int found = 0u;
+            for (int i = 0; i < 4; i++)
+            {
+                glm::ivec2 sibling = parent + glm::ivec2((i & 1) * half, (i >> 1) * half);
+                if (sibling == offset)
+                    continue;
+                auto it = std::find(blocks.begin(), blocks.end(), sibling);
+                if (it == blocks.end())
+                    break;
+                siblings[found++] = static_cast<size_t>(it - blocks.begin());
+            }
+            if (found < 3u)
+                break;
+            std::sort(siblings, siblings + 3);
+            for (int i = 2; i >= 0; i--)
+                blocks.erase(blocks.begin() + siblings[i]);
+            offset = parent;
+            level--;
+        }
+        FreeBlocks[level].push_back(offset);
+    }
+
+    inline unsigned int GetAtlasSize() const { return AtlasSize; }
+    inline unsigned int GetMinSize() const { return MinSize; }
+
+private:
+    unsigned int AtlasSize;
+    unsigned int MinSize;
+    unsigned int LevelCount;
+    std::vector<std::vector<glm::ivec2>> FreeBlocks;
+
+    unsigned int GetLevel(unsigned int size) const
+    {
+        unsigned int level = 0u;
+        while ((AtlasSize >> level) > size && level + 1u < LevelCount)
+            level++;
+        return level;
+    }
+};
+
+struct ShadowAtlasLight
+{
+    glm::vec3 Position;
+    float Range;                        // 同时是深度的 far_plane
+    unsigned int FaceSize = 0u;         // 0：没有分配到空间（没有阴影）
+    glm::ivec2 FaceOffsets[6];
+    unsigned int DesiredFaceSize = 0u;  // 按屏幕重要性计算的大小
+    float Importance = 0.0f;            // 影响范围投影到屏幕上的直径（像素）
+    unsigned int StaticDirtyFaces = 0u; // 缓存图集中需要重画的面
+    unsigned int DynamicFaces = 0u;     // 上一帧画过动态投射体的面（这一帧要先恢复静态内容）
+};
+
+class ShadowAtlas
+{
+public:
+    static const unsigned int AllFaces = 0x3Fu;
+
+    ShadowAtlas(unsigned int atlasSize = 4096u, unsigned int minFaceSize = 64u, unsigned int maxFaceSize = 512u)
+        :
+        Allocator(atlasSize, minFaceSize),
+        AtlasSize(atlasSize),
+        MinFaceSize(minFaceSize),
+        MaxFaceSize(std::min(maxFaceSize, atlasSize / 4u))
+    {
+        StaticTexture = CreateAtlasTexture(StaticFBO);
+        Texture = CreateAtlasTexture(FBO);
+    }
+
+    void Destroy()
+    {
+        unsigned int textures[2] = { StaticTexture, Texture };
+        unsigned int framebuffers[2] = { StaticFBO, FBO };
+        glDeleteTextures(2, textures);
+        glDeleteFramebuffers(2, framebuffers);
+        StaticTexture = Texture = StaticFBO = FBO = 0;
+    }
+
+    unsigned int AddLight(const glm::vec3& position, float range)
+    {
+        ShadowAtlasLight light;
+        light.Position = position;
+        light.Range = range;
+        Lights.push_back(light);
+        return static_cast<unsigned int>(Lights.size() - 1);
+    }
+
+    // 光源移动后缓存的 6 个面全部失效
+    void SetLightPosition(unsigned int index, const glm::vec3& position)
+    {
+        ShadowAtlasLight& light = Lights[index];
+        if (light.Position == position)
+            return;
+        light.Position = position;
+        light.StaticDirtyFaces = AllFaces;
+    }
+
+    // 静态投射体移动/出现/消失时，用它变化前后的 AABB 各调用一次，只有能看到这个区域的面会被重画
+    void InvalidateRegion(const glm::vec3& worldMin, const glm::vec3& worldMax)
+    {
+        for (ShadowAtlasLight& light : Lights)
+            light.StaticDirtyFaces |= GetCubeFaceMask(light.Position, light.Range, worldMin, worldMax);
+    }
+
+    void InvalidateAll()
+    {
+        for (ShadowAtlasLight& light : Lights)
+            light.StaticDirtyFaces = AllFaces;
+    }
+
+    // 按光源在屏幕上的大小重新选择每个面的分辨率，只重新分配大小需要变化的光源，其余光源的 tile 和缓存保持不动
+    // 每个面覆盖 90°，面的分辨率取投影直径的一半（向上取 2 的幂）；变大立即尝试，变小到 1/4 以下才重新分配，避免来回抖动
+    void UpdateTileSizes(const glm::vec3& cameraPos, float fovYDegrees, unsigned int screenHeight)
+    {
+        float pixelsPerUnit = static_cast<float>(screenHeight) * 0.5f / std::tan(glm::radians(fovYDegrees) * 0.5f);
+        std::vector<unsigned int> order;
+        for (unsigned int i = 0; i < Lights.size(); i++)
+        {
+            ShadowAtlasLight& light = Lights[i];
+            float distance = glm::length(light.Position - cameraPos);
+            light.Importance = 2.0f * light.Range * pixelsPerUnit / std::max(distance, 0.1f);
+            light.DesiredFaceSize = MinFaceSize;
+            while (light.DesiredFaceSize < MaxFaceSize && static_cast<float>(light.DesiredFaceSize) < light.Importance * 0.5f)
+                light.DesiredFaceSize *= 2u;
+            order.push_back(i);
+        }
+        std::stable_sort(order.begin(), order.end(), [this](unsigned int a, unsigned int b) { return Lights[a].Importance > Lights[b].Importance; });
+
+        // 总面积超过图集时，从最不重要的光源开始逐个减半，直到放得下（全部减到最小仍然放不下时，最不重要的光源没有阴影）
+        double capacity = static_cast<double>(AtlasSize) * AtlasSize;
+        double total = 0.0;
+        for (const ShadowAtlasLight& light : Lights)
+            total += 6.0 * light.DesiredFaceSize * light.DesiredFaceSize;
+        bool bReduced = true;
+        while (total > capacity && bReduced)
+        {
+            bReduced = false;
+            for (auto it = order.rbegin(); it != order.rend() && total > capacity; ++it)
+            {
+                ShadowAtlasLight& light = Lights[*it];
+                if (light.DesiredFaceSize <= MinFaceSize)
+                    continue;
+                total -= 6.0 * 0.75 * light.DesiredFaceSize * light.DesiredFaceSize;
+                light.DesiredFaceSize /= 2u;
+                bReduced = true;
+            }
+        }
+
+        std::vector<unsigned int> shrink;
+        std::vector<unsigned int> grow;
+        for (unsigned int i : order)
+        {
+            const ShadowAtlasLight& light = Lights[i];
+            if (light.FaceSize != 0u && light.DesiredFaceSize * 4u <= light.FaceSize)
+                shrink.push_back(i);
+            else if (light.DesiredFaceSize > light.FaceSize)
+                grow.push_back(i);
+        }
+
+        // 先缩小：释放旧 tile 之后同一块区域一定放得下更小的 tile
+        for (unsigned int index : shrink)
+        {
+            ShadowAtlasLight& light = Lights[index];
+            FreeFaces(light.FaceOffsets, light.FaceSize);
+            light.FaceSize = AllocateFaces(light.DesiredFaceSize, light.DesiredFaceSize, light.FaceOffsets);
+            light.StaticDirtyFaces = AllFaces;
+            light.DynamicFaces = 0u;
+            Reallocations++;
+        }
+
+        // 再按重要性从高到低放大：先在空闲空间中分配新的 tile，成功之后才释放旧的，放不下时保持原来的大小
+        for (unsigned int index : grow)
+        {
+            ShadowAtlasLight& light = Lights[index];
+            glm::ivec2 offsets[6];
+            unsigned int size = AllocateFaces(light.DesiredFaceSize, std::max(light.FaceSize * 2u, MinFaceSize), offsets);
+            if (size == 0u)
+                continue;
+            if (light.FaceSize != 0u)
+                FreeFaces(light.FaceOffsets, light.FaceSize);
+            std::copy(offsets, offsets + 6, light.FaceOffsets);
+            light.FaceSize = size;
+            light.StaticDirtyFaces = AllFaces;
+            light.DynamicFaces = 0u;
+            Reallocations++;
+        }
+    }
+
+    // 绑定缓存图集并清空 tile 中的一个面，然后画静态投射体
+    void BeginStaticFace(unsigned int index, unsigned int face)
+    {
+        BeginFace(StaticFBO, index, face, true);
+    }
+
+    // 把缓存图集中的一个面复制到最终图集（恢复成只有静态投射体的状态）
+    void CopyStaticFace(unsigned int index, unsigned int face)
+    {
+        glDisable(GL_SCISSOR_TEST);
+        const ShadowAtlasLight& light = Lights[index];
+        glm::ivec2 offset = light.FaceOffsets[face];
+        int size = static_cast<int>(light.FaceSize);
+        glBindFramebuffer(GL_READ_FRAMEBUFFER, StaticFBO);
+        glBindFramebuffer(GL_DRAW_FRAMEBUFFER, FBO);
+        glBlitFramebuffer(offset.x, offset.y, offset.x + size, offset.y + size, offset.x, offset.y, offset.x + size, offset.y + size,
+                          GL_DEPTH_BUFFER_BIT, GL_NEAREST);
+    }
+
+    // 在最终图集的一个面上叠加动态投射体（需要先 CopyStaticFace）
+    void BeginDynamicFace(unsigned int index, unsigned int face)
+    {
+        BeginFace(FBO, index, face, false);
+    }
+
+    void End()
+    {
+        glDisable(GL_SCISSOR_TEST);
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    }
+
+    // 一个面在图集中的范围（归一化纹理坐标）：xy 偏移，z 大小，w = 1 表示有阴影
+    glm::vec4 GetFaceRect(unsigned int index, unsigned int face) const
+    {
+        const ShadowAtlasLight& light = Lights[index];
+        if (light.FaceSize == 0u)
+            return glm::vec4(0.0f);
+        float scale = 1.0f / static_cast<float>(AtlasSize);
+        return glm::vec4(glm::vec2(light.FaceOffsets[face]) * scale, light.FaceSize * scale, 1.0f);
+    }
+
+    // 图集中已经分配出去的纹素比例
+    float GetOccupancy() const
+    {
+        double used = 0.0;
+        for (const ShadowAtlasLight& light : Lights)
+            used += 6.0 * light.FaceSize * light.FaceSize;
+        return static_cast<float>(used / (static_cast<double>(AtlasSize) * AtlasSize));
+    }
+
+    inline ShadowAtlasLight& GetLight(unsigned int index) { return Lights[index]; }
+    inline const ShadowAtlasLight& GetLight(unsigned int index) const { return Lights[index]; }
+    inline unsigned int GetLightCount() const { return static_cast<unsigned int>(Lights.size()); }
+    inline unsigned int GetTexture() const { return Texture; }
+    inline unsigned int GetAtlasSize() const { return AtlasSize; }
+    inline unsigned int GetReallocations() const { return Reallocations; }
+
+private:
+    ShadowAtlasAllocator Allocator;
+    unsigned int AtlasSize;
+    unsigned int MinFaceSize;
+    unsigned int MaxFaceSize;
+    std::vector<ShadowAtlasLight> Lights;
+    unsigned int StaticTexture = 0;
+    unsigned int StaticFBO = 0;
+    unsigned int Texture = 0;
+    unsigned int FBO = 0;
+    unsigned int Reallocations = 0;
+
+    unsigned int CreateAtlasTexture(unsigned int& framebuffer)
+    {
+        unsigned int texture;
+        glGenTextures(1, &texture);
+        glBindTexture(GL_TEXTURE_2D, texture);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH_COMPONENT24, AtlasSize, AtlasSize, 0, GL_DEPTH_COMPONENT, GL_FLOAT, NULL);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        glGenFramebuffers(1, &framebuffer);
+        glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, texture, 0);
+        glDrawBuffer(GL_NONE);
+        glReadBuffer(GL_NONE);
+        if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+            std::cout << "Shadow atlas framebuffer not complete!" << std::endl;
+        // 没有分配出去的区域保持最远深度（不产生阴影）
+        glClear(GL_DEPTH_BUFFER_BIT);
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        return texture;
+    }
+
+    // 分配 6 个同样大小的面，从 maxSize 开始逐级减半直到 minSize，返回分配到的大小（失败返回 0）
+    unsigned int AllocateFaces(unsigned int maxSize, unsigned int minSize, glm::ivec2 offsets[6])
+    {
+        for (unsigned int size = maxSize; size >= minSize && size >= MinFaceSize; size /= 2u)
+        {
+            unsigned int allocated = 0u;
+            while (allocated < 6u && Allocator.Allocate(size, offsets[allocated]))
+                allocated++;
+            if (allocated == 6u)
+                return size;
+            FreeFaces(offsets, size, allocated);
+        }
+        return 0u;
+    }
+
+    void FreeFaces(const glm::ivec2 offsets[6], unsigned int size, unsigned int count = 6u)
+    {
+        for (unsigned int i = 0; i < count; i++)
+            Allocator.Free(offsets[i], size);
+    }
+
+    void BeginFace(unsigned int framebuffer, unsigned int index, unsigned int face, bool bClear)
+    {
+        const ShadowAtlasLight& light = Lights[index];
+        glm::ivec2 offset = light.FaceOffsets[face];
+        int size = static_cast<int>(light.FaceSize);
+        glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+        glViewport(offset.x, offset.y, size, size);
+        // 裁剪测试把清空和光栅化限制在这个面的 tile 内
+        glEnable(GL_SCISSOR_TEST);
+        glScissor(offset.x, offset.y, size, size);
+        if (bClear)
+            glClear(GL_DEPTH_BUFFER_BIT);
+    }
+};
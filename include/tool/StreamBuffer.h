@@ -0,0 +1,160 @@
+#pragma once
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+
+#include <iostream>
+#include <cstdint>
+
+// 每帧 CPU 写、GPU 读的流式缓冲（实例矩阵、每帧的 uniform 数据等）
+// 缓冲分成 RegionCount 段（默认 3 段，三重缓冲），每帧写下一段，用 glFenceSync 保证 GPU 读完之后才会再次写同一段，
+// 正常情况下 CPU 永远不会等待 GPU。
+//
+// 1. 驱动支持 GL_ARB_buffer_storage（或 GL 4.4）时使用持久映射（GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT），
+//    只映射一次，之后每帧直接写指针
+// 2. 否则退回到 glMapBufferRange + GL_MAP_UNSYNCHRONIZED_BIT，每帧映射/解除映射当前段
+//    （同步仍然由 fence 保证，驱动不会在映射时隐式等待）
+// glad 只生成了 3.3 core，所以 glBufferStorage 通过 glfwGetProcAddress 手动加载
+
+#ifndef GL_MAP_PERSISTENT_BIT
+#define GL_MAP_PERSISTENT_BIT 0x0040
+#endif
+#ifndef GL_MAP_COHERENT_BIT
+#define GL_MAP_COHERENT_BIT 0x0080
+#endif
+
+class StreamBuffer
+{
+public:
+    // regionSize 会按 alignment 向上对齐（glBindBufferRange 绑定 uniform buffer 时偏移量必须满足 GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT）
+    StreamBuffer(GLenum target, size_t regionSize, unsigned int regionCount = 3u, size_t alignment = 256u, bool allowPersistent = true)
+        :
+        Target(target),
+        RegionCount(regionCount)
+    {
+        RegionSize = (regionSize + alignment - 1) / alignment * alignment;
+        Fences = new GLsync[RegionCount]();
+
+        glGenBuffers(1, &ID);
+        glBindBuffer(Target, ID);
+        GLsizeiptr totalSize = static_cast<GLsizeiptr>(RegionSize * RegionCount);
+        BufferStorageProc bufferStorage = allowPersistent ? LoadBufferStorage() : nullptr;
+        if (bufferStorage != nullptr)
+        {
+            GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+            bufferStorage(Target, totalSize, nullptr, flags);
+            PersistentData = static_cast<unsigned char*>(glMapBufferRange(Target, 0, totalSize, flags));
+        }
+        if (PersistentData == nullptr)
+            glBufferData(Target, totalSize, nullptr, GL_STREAM_DRAW);
+        glBindBuffer(Target, 0);
+    }
+
+    ~StreamBuffer()
+    {
+        // 和 Model 一样不在析构函数里调用 OpenGL（很多章节在 glfwTerminate 之后才析构），需要时显式调用 Destroy
+        delete[] Fences;
+    }
+
+    StreamBuffer(const StreamBuffer&) = delete;
+    StreamBuffer& operator=(const StreamBuffer&) = delete;
+
+    void Destroy()
+    {
+        for (unsigned int i = 0; i < RegionCount; i++)
+        {
+            if (Fences[i] != nullptr)
+                glDeleteSync(Fences[i]);
+            Fences[i] = nullptr;
+        }
+        if (PersistentData != nullptr)
+        {
+            glBindBuffer(Target, ID);
+            glUnmapBuffer(Target);
+            glBindBuffer(Target, 0);
+            PersistentData = nullptr;
+        }
+        glDeleteBuffers(1, &ID);
+        ID = 0u;
+    }
+
+    // 获取当前段的写指针（只写），写完后调用 Unmap，发出使用这段数据的绘制命令后调用 Fence
+    void* Map()
+    {
+        WaitRegion(Region);
+        if (PersistentData != nullptr)
+            return PersistentData + GetOffset();
+        glBindBuffer(Target, ID);
+        return glMapBufferRange(Target, static_cast<GLintptr>(GetOffset()), static_cast<GLsizeiptr>(RegionSize),
+            GL_MAP_WRITE_BIT | GL_MAP_UNSYNCHRONIZED_BIT | GL_MAP_INVALIDATE_RANGE_BIT);
+    }
+
+    void Unmap()
+    {
+        if (PersistentData != nullptr)
+            return;
+        glBindBuffer(Target, ID);
+        glUnmapBuffer(Target);
+    }
+
+    // 当前段已经提交给 GPU，插入 fence 并切换到下一段
+    void Fence()
+    {
+        if (Fences[Region] != nullptr)
+            glDeleteSync(Fences[Region]);
+        Fences[Region] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        Region = (Region + 1) % RegionCount;
+    }
+
+    inline unsigned int GetID() const { return ID; }
+    // 当前段在缓冲中的字节偏移
+    inline size_t GetOffset() const { return Region * RegionSize; }
+    inline size_t GetRegionSize() const { return RegionSize; }
+    inline bool IsPersistent() const { return PersistentData != nullptr; }
+    // 因为 GPU 还没读完而等待 fence 的次数，正常情况下应该一直是 0
+    inline unsigned int GetStallCount() const { return Stalls; }
+
+private:
+    typedef void (APIENTRYP BufferStorageProc)(GLenum target, GLsizeiptr size, const void* data, GLbitfield flags);
+
+    static BufferStorageProc LoadBufferStorage()
+    {
+        GLint major = 0, minor = 0;
+        glGetIntegerv(GL_MAJOR_VERSION, &major);
+        glGetIntegerv(GL_MINOR_VERSION, &minor);
+        bool bSupported = major > 4 || (major == 4 && minor >= 4) || glfwExtensionSupported("GL_ARB_buffer_storage");
+        if (!bSupported)
+            return nullptr;
+        BufferStorageProc proc = reinterpret_cast<BufferStorageProc>(glfwGetProcAddress("glBufferStorage"));
+        if (proc == nullptr)
+            proc = reinterpret_cast<BufferStorageProc>(glfwGetProcAddress("glBufferStorageARB"));
+        return proc;
+    }
+
+    void WaitRegion(unsigned int region)
+    {
+        if (Fences[region] == nullptr)
+            return;
+        GLenum result = glClientWaitSync(Fences[region], 0, 0);
+        if (result == GL_TIMEOUT_EXPIRED)
+        {
+            Stalls++;
+            do
+            {
+                result = glClientWaitSync(Fences[region], GL_SYNC_FLUSH_COMMANDS_BIT, 1000000ull);
+            } while (result == GL_TIMEOUT_EXPIRED);
+        }
+        if (result == GL_WAIT_FAILED)
+            std::cout << "[STREAM BUFFER ERROR]: glClientWaitSync failed" << std::endl;
+        glDeleteSync(Fences[region]);
+        Fences[region] = nullptr;
+    }
+
+    GLenum Target;
+    unsigned int ID = 0u;
+    unsigned int RegionCount;
+    unsigned int Region = 0u;
+    size_t RegionSize;
+    unsigned char* PersistentData = nullptr;
+    GLsync* Fences = nullptr;
+    unsigned int Stalls = 0u;
+};
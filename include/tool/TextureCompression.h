@@ -0,0 +1,893 @@
+#pragma once
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <cctype>
+#include <algorithm>
+#include <filesystem>
+
+#include <tool/JobSystem.h>
+#include <tool/MappedFile.h>
+#include <tool/MipGenerator.h>
+#include <tool/stb_image.h>
+
+// 纹理的离线块压缩（BC1/BC3/BC5/BC7）和 DDS 容器
+// 1. 原图用 stb_image 解码成 RGBA8，用 MipGenerator.h 生成完整的 mip 链（默认 Kaiser 滤波，颜色在线性空间滤波，
+//    法线重新归一化，草和窗户保持 alpha 测试的覆盖率）
+// 2. 每个 4x4 块独立编码，每一行块一个任务交给 JobSystem 并行：
+//    BC1（RGB，8 字节/块）：主成分方向上取端点，再用最小二乘优化两次端点
+//    BC3（RGBA，16 字节/块）：BC1 颜色块 + BC4 alpha 块，只用于真的有透明像素的图片
+//    BC5（RG，16 字节/块）：两个 BC4 块，用于模型的切线空间法线贴图（*_ddn）。采样结果的 B 通道为 0，
+//    目前没有着色器采样 TextureNormalN，以后使用时着色器必须自己重建 z：
+//    n.xy = texture(...).rg * 2.0 - 1.0; n.z = sqrt(max(1.0 - dot(n.xy, n.xy), 0.0));
+//    BC7（RGBA，16 字节/块）：只用模式 6（单分区、7 位端点 + p 位、4 位索引），--bc7 时代替 BC1/BC3
+// 3. 写成 DDS（DX10 扩展头），放在原图旁边（xxx.png.dds），dwReserved1 中记录原图的大小、修改时间和通道数，原图变化后缓存自动失效
+// 加载时映射文件，每级 mip 直接 glCompressedTexImage2D（见 TextureLoader.h 中的 TryLoadCompressedTexture）
+// 编码部分不调用 OpenGL，可以在没有 GPU 的机器上运行（Benchmark-TextureCompression）
+
+// 修改编码方法或文件布局时都要增加版本号
+const uint32_t COMPRESSED_TEXTURE_VERSION = 2u;
+const uint32_t COMPRESSED_TEXTURE_TAG = 0x4C474F4Cu;    // "LOGL"
+const char* const COMPRESSED_TEXTURE_EXTENSION = ".dds";
+
+enum class TextureBlockFormat
+{
+    BC1,
+    BC3,
+    BC5,
+    BC7,
+    Count
+};
+
+inline const char* GetTextureBlockFormatName(TextureBlockFormat format)
+{
+    switch (format)
+    {
+    case TextureBlockFormat::BC1: return "bc1";
+    case TextureBlockFormat::BC3: return "bc3";
+    case TextureBlockFormat::BC5: return "bc5";
+    case TextureBlockFormat::BC7: return "bc7";
+    default: return "unknown";
+    }
+}
+
+inline unsigned int GetTextureBlockBytes(TextureBlockFormat format)
+{
+    return format == TextureBlockFormat::BC1 ? 8u : 16u;
+}
+
+inline size_t GetCompressedLevelSize(TextureBlockFormat format, unsigned int width, unsigned int height)
+{
+    return static_cast<size_t>((width + 3u) / 4u) * ((height + 3u) / 4u) * GetTextureBlockBytes(format);
+}
+
+inline unsigned int GetMipCount(unsigned int width, unsigned int height)
+{
+    unsigned int count = 1u;
+    while (width > 1u || height > 1u)
+    {
+        width = std::max(1u, width >> 1);
+        height = std::max(1u, height >> 1);
+        count++;
+    }
+    return count;
+}
+
+// 原图的大小和修改时间，比哈希整个文件快得多（加载时每张纹理都要检查一次）
+struct TextureSourceStamp
+{
+    uint64_t Size = 0ull;
+    int64_t Time = 0;
+};
+
+inline bool GetTextureSourceStamp(const std::string& path, TextureSourceStamp& stamp)
+{
+    std::error_code error;
+    uint64_t size = std::filesystem::file_size(path, error);
+    if (error)
+        return false;
+    auto time = std::filesystem::last_write_time(path, error);
+    if (error)
+        return false;
+    stamp.Size = size;
+    stamp.Time = static_cast<int64_t>(time.time_since_epoch().count());
+    return true;
+}
+
+// 文件名（不含扩展名）以 _ddn 结尾的是模型的切线空间法线贴图
+inline bool IsTangentNormalMap(const std::string& path)
+{
+    std::string stem = std::filesystem::path(path).stem().string();
+    return stem.size() >= 4u && stem.compare(stem.size() - 4u, 4u, "_ddn") == 0;
+}
+
+// ----------------------------------------------------------------------------
+// 块编码
+// ----------------------------------------------------------------------------
+
+// 取出 (blockX, blockY) 处的 4x4 块，超出图像的部分重复边缘像素
+inline void FetchBlock(const unsigned char* rgba, unsigned int width, unsigned int height, unsigned int blockX, unsigned int blockY, unsigned char block[64])
+{
+    for (unsigned int y = 0; y < 4u; y++)
+    {
+        unsigned int sy = std::min(blockY * 4u + y, height - 1u);
+        for (unsigned int x = 0; x < 4u; x++)
+        {
+            unsigned int sx = std::min(blockX * 4u + x, width - 1u);
+            std::memcpy(block + (y * 4u + x) * 4u, rgba + (static_cast<size_t>(sy) * width + sx) * 4u, 4u);
+        }
+    }
+}
+
+// 求协方差矩阵的主特征向量（幂迭代），channels 为 3 或 4，matrix 按行存储
+inline void GetPrincipalAxis(const float* matrix, unsigned int channels, float* axis)
+{
+    for (unsigned int c = 0; c < channels; c++)
+        axis[c] = 1.0f;
+    for (int iteration = 0; iteration < 8; iteration++)
+    {
+        float next[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+        float length = 0.0f;
+        for (unsigned int r = 0; r < channels; r++)
+        {
+            for (unsigned int c = 0; c < channels; c++)
+                next[r] += matrix[r * channels + c] * axis[c];
+            length = std::max(length, std::fabs(next[r]));
+        }
+        if (length < 1e-8f)
+            return;
+        for (unsigned int c = 0; c < channels; c++)
+            axis[c] = next[c] / length;
+    }
+}
+
+// 沿主成分方向的两个端点（浮点，0~255），returns false 表示块内所有像素相同
+inline bool GetBoundingEndpoints(const float* pixels, unsigned int channels, float* endpoint0, float* endpoint1)
+{
+    float mean[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+    for (unsigned int i = 0; i < 16u; i++)
+        for (unsigned int c = 0; c < channels; c++)
+            mean[c] += pixels[i * 4u + c];
+    for (unsigned int c = 0; c < channels; c++)
+        mean[c] /= 16.0f;
+
+    float covariance[16] = {};
+    for (unsigned int i = 0; i < 16u; i++)
+    {
+        for (unsigned int r = 0; r < channels; r++)
+        {
+            float dr = pixels[i * 4u + r] - mean[r];
+            for (unsigned int c = 0; c < channels; c++)
+                covariance[r * channels + c] += dr * (pixels[i * 4u + c] - mean[c]);
+        }
+    }
+    float axis[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+    GetPrincipalAxis(covariance, channels, axis);
+
+    float minT = 0.0f;
+    float maxT = 0.0f;
+    for (unsigned int i = 0; i < 16u; i++)
+    {
+        float t = 0.0f;
+        for (unsigned int c = 0; c < channels; c++)
+            t += (pixels[i * 4u + c] - mean[c]) * axis[c];
+        minT = std::min(minT, t);
+        maxT = std::max(maxT, t);
+    }
+    float axisLength2 = 0.0f;
+    for (unsigned int c = 0; c < channels; c++)
+        axisLength2 += axis[c] * axis[c];
+    if (maxT - minT < 1e-4f || axisLength2 < 1e-12f)
+    {
+        for (unsigned int c = 0; c < channels; c++)
+            endpoint0[c] = endpoint1[c] = mean[c];
+        return false;
+    }
+    for (unsigned int c = 0; c < channels; c++)
+    {
+        endpoint0[c] = std::min(255.0f, std::max(0.0f, mean[c] + axis[c] * maxT / axisLength2));
+        endpoint1[c] = std::min(255.0f, std::max(0.0f, mean[c] + axis[c] * minT / axisLength2));
+    }
+    return true;
+}
+
+// 已知每个像素的插值权重 t（端点 1 的比例），最小二乘求两个端点
+inline bool SolveEndpoints(const float* pixels, unsigned int channels, const float weights[16], float* endpoint0, float* endpoint1)
+{
+    float a = 0.0f, b = 0.0f, c = 0.0f;
+    float x0[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+    float x1[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+    for (unsigned int i = 0; i < 16u; i++)
+    {
+        float t = weights[i];
+        float s = 1.0f - t;
+        a += s * s;
+        b += s * t;
+        c += t * t;
+        for (unsigned int ch = 0; ch < channels; ch++)
+        {
+            x0[ch] += s * pixels[i * 4u + ch];
+            x1[ch] += t * pixels[i * 4u + ch];
+        }
+    }
+    float determinant = a * c - b * b;
+    if (std::fabs(determinant) < 1e-6f)
+        return false;
+    for (unsigned int ch = 0; ch < channels; ch++)
+    {
+        endpoint0[ch] = std::min(255.0f, std::max(0.0f, (c * x0[ch] - b * x1[ch]) / determinant));
+        endpoint1[ch] = std::min(255.0f, std::max(0.0f, (a * x1[ch] - b * x0[ch]) / determinant));
+    }
+    return true;
+}
+
+inline uint16_t PackRGB565(const float* color)
+{
+    unsigned int r = static_cast<unsigned int>(std::min(31.0f, std::max(0.0f, color[0] * 31.0f / 255.0f + 0.5f)));
+    unsigned int g = static_cast<unsigned int>(std::min(63.0f, std::max(0.0f, color[1] * 63.0f / 255.0f + 0.5f)));
+    unsigned int b = static_cast<unsigned int>(std::min(31.0f, std::max(0.0f, color[2] * 31.0f / 255.0f + 0.5f)));
+    return static_cast<uint16_t>((r << 11) | (g << 5) | b);
+}
+
+inline void UnpackRGB565(uint16_t value, float* color)
+{
+    unsigned int r = (value >> 11) & 31u;
+    unsigned int g = (value >> 5) & 63u;
+    unsigned int b = value & 31u;
+    color[0] = static_cast<float>((r << 3) | (r >> 2));
+    color[1] = static_cast<float>((g << 2) | (g >> 4));
+    color[2] = static_cast<float>((b << 3) | (b >> 2));
+}
+
+// 四色模式：索引 0、1 是端点，2、3 是 1/3 和 2/3 处的插值，返回平方误差
+inline float FitColorIndices(const float* pixels, uint16_t color0, uint16_t color1, unsigned char indices[16])
+{
+    float palette[4][3];
+    UnpackRGB565(color0, palette[0]);
+    UnpackRGB565(color1, palette[1]);
+    for (unsigned int c = 0; c < 3u; c++)
+    {
+        palette[2][c] = (2.0f * palette[0][c] + palette[1][c]) / 3.0f;
+        palette[3][c] = (palette[0][c] + 2.0f * palette[1][c]) / 3.0f;
+    }
+    float error = 0.0f;
+    for (unsigned int i = 0; i < 16u; i++)
+    {
+        float best = 1e30f;
+        for (unsigned int p = 0; p < 4u; p++)
+        {
+            float d = 0.0f;
+            for (unsigned int c = 0; c < 3u; c++)
+            {
+                float diff = pixels[i * 4u + c] - palette[p][c];
+                d += diff * diff;
+            }
+            if (d < best)
+            {
+                best = d;
+                indices[i] = static_cast<unsigned char>(p);
+            }
+        }
+        error += best;
+    }
+    return error;
+}
+
+// BC1 颜色块（BC3 中的颜色部分也用这个，总是四色模式）
+inline void EncodeColorBlock(const unsigned char block[64], unsigned char* output)
+{
+    float pixels[64];
+    for (unsigned int i = 0; i < 64u; i++)
+        pixels[i] = block[i];
+
+    float endpoint0[4], endpoint1[4];
+    GetBoundingEndpoints(pixels, 3u, endpoint0, endpoint1);
+    uint16_t bestColor0 = PackRGB565(endpoint0);
+    uint16_t bestColor1 = PackRGB565(endpoint1);
+    unsigned char bestIndices[16];
+    float bestError = FitColorIndices(pixels, bestColor0, bestColor1, bestIndices);
+
+    // 按当前索引最小二乘求端点，误差变小才采用
+    const float indexWeights[4] = { 0.0f, 1.0f, 1.0f / 3.0f, 2.0f / 3.0f };
+    for (int iteration = 0; iteration < 2 && bestColor0 != bestColor1; iteration++)
+    {
+        float weights[16];
+        for (unsigned int i = 0; i < 16u; i++)
+            weights[i] = indexWeights[bestIndices[i]];
+        if (!SolveEndpoints(pixels, 3u, weights, endpoint0, endpoint1))
+            break;
+        uint16_t color0 = PackRGB565(endpoint0);
+        uint16_t color1 = PackRGB565(endpoint1);
+        unsigned char indices[16];
+        float error = FitColorIndices(pixels, color0, color1, indices);
+        if (error >= bestError)
+            break;
+        bestError = error;
+        bestColor0 = color0;
+        bestColor1 = color1;
+        std::memcpy(bestIndices, indices, sizeof(indices));
+    }
+
+    // color0 > color1 才是四色模式，相等时所有像素都取 color0
+    if (bestColor0 < bestColor1)
+    {
+        std::swap(bestColor0, bestColor1);
+        const unsigned char swapped[4] = { 1u, 0u, 3u, 2u };
+        for (unsigned int i = 0; i < 16u; i++)
+            bestIndices[i] = swapped[bestIndices[i]];
+    }
+    else if (bestColor0 == bestColor1)
+    {
+        std::memset(bestIndices, 0, sizeof(bestIndices));
+    }
+
+    uint32_t packedIndices = 0u;
+    for (unsigned int i = 0; i < 16u; i++)
+        packedIndices |= static_cast<uint32_t>(bestIndices[i]) << (i * 2u);
+    output[0] = static_cast<unsigned char>(bestColor0 & 0xFFu);
+    output[1] = static_cast<unsigned char>(bestColor0 >> 8);
+    output[2] = static_cast<unsigned char>(bestColor1 & 0xFFu);
+    output[3] = static_cast<unsigned char>(bestColor1 >> 8);
+    for (unsigned int i = 0; i < 4u; i++)
+        output[4u + i] = static_cast<unsigned char>((packedIndices >> (i * 8u)) & 0xFFu);
+}
+
+// BC4 单通道块（BC3 的 alpha、BC5 的两个通道）：8 值模式，端点取块内的最大、最小值
+inline void EncodeSingleChannelBlock(const unsigned char values[16], unsigned char* output)
+{
+    unsigned char minValue = 255u;
+    unsigned char maxValue = 0u;
+    for (unsigned int i = 0; i < 16u; i++)
+    {
+        minValue = std::min(minValue, values[i]);
+        maxValue = std::max(maxValue, values[i]);
+    }
+    output[0] = maxValue;
+    output[1] = minValue;
+    uint64_t packedIndices = 0ull;
+    if (maxValue != minValue)
+    {
+        float palette[8];
+        palette[0] = maxValue;
+        palette[1] = minValue;
+        for (unsigned int i = 2u; i < 8u; i++)
+            palette[i] = ((8.0f - i) * maxValue + (i - 1.0f) * minValue) / 7.0f;
+        for (unsigned int i = 0; i < 16u; i++)
+        {
+            unsigned int bestIndex = 0u;
+            float best = 1e30f;
+            for (unsigned int p = 0; p < 8u; p++)
+            {
+                float d = std::fabs(values[i] - palette[p]);
+                if (d < best)
+                {
+                    best = d;
+                    bestIndex = p;
+                }
+            }
+            packedIndices |= static_cast<uint64_t>(bestIndex) << (i * 3u);
+        }
+    }
+    for (unsigned int i = 0; i < 6u; i++)
+        output[2u + i] = static_cast<unsigned char>((packedIndices >> (i * 8u)) & 0xFFu);
+}
+
+inline void EncodeBC1Block(const unsigned char block[64], unsigned char* output)
+{
+    EncodeColorBlock(block, output);
+}
+
+inline void EncodeBC3Block(const unsigned char block[64], unsigned char* output)
+{
+    unsigned char alpha[16];
+    for (unsigned int i = 0; i < 16u; i++)
+        alpha[i] = block[i * 4u + 3u];
+    EncodeSingleChannelBlock(alpha, output);
+    EncodeColorBlock(block, output + 8);
+}
+
+inline void EncodeBC5Block(const unsigned char block[64], unsigned char* output)
+{
+    unsigned char channel[16];
+    for (unsigned int c = 0; c < 2u; c++)
+    {
+        for (unsigned int i = 0; i < 16u; i++)
+            channel[i] = block[i * 4u + c];
+        EncodeSingleChannelBlock(channel, output + c * 8u);
+    }
+}
+
+// BC7 模式 6 的 4 位插值权重（/64）
+const unsigned int BC7_WEIGHTS4[16] = { 0u, 4u, 9u, 13u, 17u, 21u, 26u, 30u, 34u, 38u, 43u, 47u, 51u, 55u, 60u, 64u };
+
+// 7 位端点 + 1 个 p 位（每个端点所有通道共用），选误差小的 p
+inline void QuantizeBC7Endpoint(const float* endpoint, unsigned int quantized[4], unsigned int& pBit)
+{
+    float bestError = 1e30f;
+    for (unsigned int p = 0; p < 2u; p++)
+    {
+        unsigned int candidate[4];
+        float error = 0.0f;
+        for (unsigned int c = 0; c < 4u; c++)
+        {
+            float q = std::floor((endpoint[c] - p) / 2.0f + 0.5f);
+            candidate[c] = static_cast<unsigned int>(std::min(127.0f, std::max(0.0f, q)));
+            float diff = static_cast<float>(candidate[c] * 2u + p) - endpoint[c];
+            error += diff * diff;
+        }
+        if (error < bestError)
+        {
+            bestError = error;
+            pBit = p;
+            std::memcpy(quantized, candidate, sizeof(candidate));
+        }
+    }
+}
+
+inline float FitBC7Indices(const float* pixels, const unsigned int endpoint0[4], unsigned int p0, const unsigned int endpoint1[4], unsigned int p1,
+    unsigned char indices[16])
+{
+    float palette[16][4];
+    for (unsigned int i = 0; i < 16u; i++)
+    {
+        for (unsigned int c = 0; c < 4u; c++)
+        {
+            unsigned int e0 = endpoint0[c] * 2u + p0;
+            unsigned int e1 = endpoint1[c] * 2u + p1;
+            palette[i][c] = static_cast<float>(((64u - BC7_WEIGHTS4[i]) * e0 + BC7_WEIGHTS4[i] * e1 + 32u) >> 6);
+        }
+    }
+    float error = 0.0f;
+    for (unsigned int i = 0; i < 16u; i++)
+    {
+        float best = 1e30f;
+        for (unsigned int p = 0; p < 16u; p++)
+        {
+            float d = 0.0f;
+            for (unsigned int c = 0; c < 4u; c++)
+            {
+                float diff = pixels[i * 4u + c] - palette[p][c];
+                d += diff * diff;
+            }
+            if (d < best)
+            {
+                best = d;
+                indices[i] = static_cast<unsigned char>(p);
+            }
+        }
+        error += best;
+    }
+    return error;
+}
+
+inline void WriteBits(unsigned char* output, unsigned int& position, uint32_t value, unsigned int count)
+{
+    for (unsigned int i = 0; i < count; i++, position++)
+    {
+        if ((value >> i) & 1u)
+            output[position >> 3] |= static_cast<unsigned char>(1u << (position & 7u));
+    }
+}
+
+inline void EncodeBC7Block(const unsigned char block[64], unsigned char* output)
+{
+    float pixels[64];
+    for (unsigned int i = 0; i < 64u; i++)
+        pixels[i] = block[i];
+
+    float endpoint0[4], endpoint1[4];
+    GetBoundingEndpoints(pixels, 4u, endpoint0, endpoint1);
+    unsigned int best0[4], best1[4], bestP0 = 0u, bestP1 = 0u;
+    QuantizeBC7Endpoint(endpoint0, best0, bestP0);
+    QuantizeBC7Endpoint(endpoint1, best1, bestP1);
+    unsigned char bestIndices[16];
+    float bestError = FitBC7Indices(pixels, best0, bestP0, best1, bestP1, bestIndices);
+
+    for (int iteration = 0; iteration < 2; iteration++)
+    {
+        float weights[16];
+        for (unsigned int i = 0; i < 16u; i++)
+            weights[i] = BC7_WEIGHTS4[bestIndices[i]] / 64.0f;
+        if (!SolveEndpoints(pixels, 4u, weights, endpoint0, endpoint1))
+            break;
+        unsigned int q0[4], q1[4], p0 = 0u, p1 = 0u;
+        QuantizeBC7Endpoint(endpoint0, q0, p0);
+        QuantizeBC7Endpoint(endpoint1, q1, p1);
+        unsigned char indices[16];
+        float error = FitBC7Indices(pixels, q0, p0, q1, p1, indices);
+        if (error >= bestError)
+            break;
+        bestError = error;
+        std::memcpy(best0, q0, sizeof(q0));
+        std::memcpy(best1, q1, sizeof(q1));
+        bestP0 = p0;
+        bestP1 = p1;
+        std::memcpy(bestIndices, indices, sizeof(indices));
+    }
+
+    // 第一个像素的索引最高位隐含为 0（anchor），否则交换端点
+    if (bestIndices[0] >= 8u)
+    {
+        std::swap(best0, best1);
+        std::swap(bestP0, bestP1);
+        for (unsigned int i = 0; i < 16u; i++)
+            bestIndices[i] = static_cast<unsigned char>(15u - bestIndices[i]);
+    }
+
+    std::memset(output, 0, 16);
+    unsigned int position = 0u;
+    WriteBits(output, position, 1u << 6, 7u);
+    for (unsigned int c = 0; c < 4u; c++)
+    {
+        WriteBits(output, position, best0[c], 7u);
+        WriteBits(output, position, best1[c], 7u);
+    }
+    WriteBits(output, position, bestP0, 1u);
+    WriteBits(output, position, bestP1, 1u);
+    WriteBits(output, position, bestIndices[0], 3u);
+    for (unsigned int i = 1; i < 16u; i++)
+        WriteBits(output, position, bestIndices[i], 4u);
+}
+
+inline void EncodeTextureBlock(TextureBlockFormat format, const unsigned char block[64], unsigned char* output)
+{
+    switch (format)
+    {
+    case TextureBlockFormat::BC1: EncodeBC1Block(block, output); break;
+    case TextureBlockFormat::BC3: EncodeBC3Block(block, output); break;
+    case TextureBlockFormat::BC5: EncodeBC5Block(block, output); break;
+    case TextureBlockFormat::BC7: EncodeBC7Block(block, output); break;
+    default: break;
+    }
+}
+
+// 压缩一级 RGBA8 图像，每一行块一个任务
+inline void CompressTextureLevel(TextureBlockFormat format, const unsigned char* rgba, unsigned int width, unsigned int height,
+    unsigned char* output, JobSystem* jobs = nullptr)
+{
+    unsigned int blocksX = (width + 3u) / 4u;
+    unsigned int blocksY = (height + 3u) / 4u;
+    unsigned int blockBytes = GetTextureBlockBytes(format);
+    auto encodeRows = [&](unsigned int first, unsigned int last)
+    {
+        unsigned char block[64];
+        for (unsigned int by = first; by < last; by++)
+        {
+            for (unsigned int bx = 0; bx < blocksX; bx++)
+            {
+                FetchBlock(rgba, width, height, bx, by, block);
+                EncodeTextureBlock(format, block, output + (static_cast<size_t>(by) * blocksX + bx) * blockBytes);
+            }
+        }
+    };
+    if (jobs != nullptr)
+        jobs->ParallelFor(0u, blocksY, 4u, encodeRows);
+    else
+        encodeRows(0u, blocksY);
+}
+
+// ----------------------------------------------------------------------------
+// DDS 容器
+// ----------------------------------------------------------------------------
+
+struct DDSPixelFormat
+{
+    uint32_t Size;
+    uint32_t Flags;
+    uint32_t FourCC;
+    uint32_t RGBBitCount;
+    uint32_t RBitMask;
+    uint32_t GBitMask;
+    uint32_t BBitMask;
+    uint32_t ABitMask;
+};
+
+struct DDSHeader
+{
+    uint32_t Magic;             // "DDS "
+    uint32_t Size;              // 124
+    uint32_t Flags;
+    uint32_t Height;
+    uint32_t Width;
+    uint32_t PitchOrLinearSize;
+    uint32_t Depth;
+    uint32_t MipMapCount;
+    // 0: COMPRESSED_TEXTURE_TAG，1: 版本，2-3: 原图大小，4-5: 原图修改时间，6: 原图通道数
+    uint32_t Reserved1[11];
+    DDSPixelFormat PixelFormat;
+    uint32_t Caps;
+    uint32_t Caps2;
+    uint32_t Caps3;
+    uint32_t Caps4;
+    uint32_t Reserved2;
+    // DX10 扩展头
+    uint32_t DXGIFormat;
+    uint32_t ResourceDimension;
+    uint32_t MiscFlag;
+    uint32_t ArraySize;
+    uint32_t MiscFlags2;
+};
+static_assert(sizeof(DDSHeader) == 148, "DDSHeader must match the DDS file layout");
+
+const uint32_t DDS_MAGIC = 0x20534444u;             // "DDS "
+const uint32_t DDS_FOURCC_DX10 = 0x30315844u;       // "DX10"
+
+inline uint32_t GetDXGIFormat(TextureBlockFormat format)
+{
+    switch (format)
+    {
+    case TextureBlockFormat::BC1: return 71u;       // DXGI_FORMAT_BC1_UNORM
+    case TextureBlockFormat::BC3: return 77u;       // DXGI_FORMAT_BC3_UNORM
+    case TextureBlockFormat::BC5: return 83u;       // DXGI_FORMAT_BC5_UNORM
+    case TextureBlockFormat::BC7: return 98u;       // DXGI_FORMAT_BC7_UNORM
+    default: return 0u;
+    }
+}
+
+inline bool GetTextureBlockFormatFromDXGI(uint32_t dxgiFormat, TextureBlockFormat& format)
+{
+    for (int i = 0; i < static_cast<int>(TextureBlockFormat::Count); i++)
+    {
+        if (GetDXGIFormat(static_cast<TextureBlockFormat>(i)) == dxgiFormat)
+        {
+            format = static_cast<TextureBlockFormat>(i);
+            return true;
+        }
+    }
+    return false;
+}
+
+// 映射 .dds 文件，校验文件头和原图的时间戳，之后直接读取每级 mip 的压缩数据
+class CompressedTextureView
+{
+public:
+    bool Open(const std::string& path, const TextureSourceStamp* source = nullptr)
+    {
+        LevelOffsets.clear();
+        if (!File.Open(path) || File.GetSize() < sizeof(DDSHeader))
+            return false;
+        DDSHeader header;
+        std::memcpy(&header, File.GetData(), sizeof(header));
+        if (header.Magic != DDS_MAGIC || header.Size != 124u || header.PixelFormat.FourCC != DDS_FOURCC_DX10
+            || header.Reserved1[0] != COMPRESSED_TEXTURE_TAG || header.Reserved1[1] != COMPRESSED_TEXTURE_VERSION
+            || header.ArraySize != 1u || header.Width == 0u || header.Height == 0u || header.MipMapCount == 0u
+            || !GetTextureBlockFormatFromDXGI(header.DXGIFormat, Format))
+        {
+            File.Close();
+            return false;
+        }
+        if (source != nullptr)
+        {
+            uint64_t size = header.Reserved1[2] | (static_cast<uint64_t>(header.Reserved1[3]) << 32);
+            int64_t time = static_cast<int64_t>(header.Reserved1[4] | (static_cast<uint64_t>(header.Reserved1[5]) << 32));
+            if (size != source->Size || time != source->Time)
+            {
+                File.Close();
+                return false;
+            }
+        }
+        Width = header.Width;
+        Height = header.Height;
+        SourceChannels = header.Reserved1[6];
+        size_t offset = sizeof(DDSHeader);
+        for (unsigned int mip = 0; mip < header.MipMapCount; mip++)
+        {
+            LevelOffsets.push_back(offset);
+            offset += GetCompressedLevelSize(Format, GetLevelWidth(mip), GetLevelHeight(mip));
+        }
+        if (offset > File.GetSize())
+        {
+            LevelOffsets.clear();
+            File.Close();
+            return false;
+        }
+        return true;
+    }
+
+    inline TextureBlockFormat GetFormat() const { return Format; }
+    inline unsigned int GetWidth() const { return Width; }
+    inline unsigned int GetHeight() const { return Height; }
+    inline unsigned int GetMipCount() const { return static_cast<unsigned int>(LevelOffsets.size()); }
+    inline unsigned int GetSourceChannels() const { return SourceChannels; }
+    inline size_t GetFileSize() const { return File.GetSize(); }
+    inline unsigned int GetLevelWidth(unsigned int mip) const { return std::max(1u, Width >> mip); }
+    inline unsigned int GetLevelHeight(unsigned int mip) const { return std::max(1u, Height >> mip); }
+    inline const unsigned char* GetLevel(unsigned int mip) const { return File.GetData() + LevelOffsets[mip]; }
+    inline size_t GetLevelSize(unsigned int mip) const { return GetCompressedLevelSize(Format, GetLevelWidth(mip), GetLevelHeight(mip)); }
+
+private:
+    MappedFile File;
+    std::vector<size_t> LevelOffsets;
+    TextureBlockFormat Format = TextureBlockFormat::BC1;
+    unsigned int Width = 0u;
+    unsigned int Height = 0u;
+    unsigned int SourceChannels = 0u;
+};
+
+// ----------------------------------------------------------------------------
+// 整张图片的压缩
+// ----------------------------------------------------------------------------
+
+struct TextureCompressionSettings
+{
+    // 颜色贴图用 BC7 代替 BC1/BC3（需要 GL 4.2 或 GL_ARB_texture_compression_bptc）
+    bool bUseBC7 = false;
+    MipFilter Filter = MipFilter::Kaiser;
+    // 这些图片（按文件名匹配）用于 alpha 测试，mip 保持 alpha >= AlphaTestReference 的覆盖率
+    std::vector<std::string> AlphaTestedTextures = { "grass.png", "blending_transparent_window.png" };
+    // 草叶和窗框（alpha 接近 1）算作覆盖，窗户的玻璃部分 alpha 约 0.3，不计入
+    float AlphaTestReference = 0.5f;
+};
+
+struct TextureCompressionResult
+{
+    TextureBlockFormat Format = TextureBlockFormat::BC1;
+    unsigned int Width = 0u;
+    unsigned int Height = 0u;
+    unsigned int MipCount = 0u;
+    // 原来的 glTexImage2D + glGenerateMipmap 占用的显存（按每个 texel 4 字节，驱动会把 RGB8 补齐成 RGBA8）
+    uint64_t UncompressedBytes = 0ull;
+    uint64_t CompressedBytes = 0ull;
+    double DecodeMs = 0.0;
+    double MipMs = 0.0;
+    double EncodeMs = 0.0;
+};
+
+inline double TextureCompressionElapsedMs(std::chrono::high_resolution_clock::time_point start)
+{
+    return std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+}
+
+// _ddn 法线贴图用 BC5，有透明像素的用 BC3，其余用 BC1（或者全部颜色贴图用 BC7）
+inline TextureBlockFormat ChooseTextureBlockFormat(const std::string& path, const unsigned char* rgba, size_t pixelCount, int channels,
+    const TextureCompressionSettings& settings)
+{
+    if (IsTangentNormalMap(path))
+        return TextureBlockFormat::BC5;
+    if (settings.bUseBC7)
+        return TextureBlockFormat::BC7;
+    if (channels == 2 || channels == 4)
+    {
+        for (size_t i = 0; i < pixelCount; i++)
+        {
+            if (rgba[i * 4u + 3u] != 255u)
+                return TextureBlockFormat::BC3;
+        }
+    }
+    return TextureBlockFormat::BC1;
+}
+
+// 文件名（不含扩展名）以这些结尾的是线性数据（法线、位移、高光、PBR 参数），不做 sRGB 转换
+inline bool IsLinearTexture(const std::string& path)
+{
+    std::string stem = std::filesystem::path(path).stem().string();
+    std::transform(stem.begin(), stem.end(), stem.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+    const char* suffixes[] = { "_ddn", "normal", "disp", "_spec", "specular", "ao", "metallic", "roughness" };
+    for (const char* suffix : suffixes)
+    {
+        size_t length = std::strlen(suffix);
+        if (stem.size() >= length && stem.compare(stem.size() - length, length, suffix) == 0)
+            return true;
+    }
+    return false;
+}
+
+inline bool IsNormalMap(const std::string& path)
+{
+    std::string stem = std::filesystem::path(path).stem().string();
+    std::transform(stem.begin(), stem.end(), stem.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+    return IsTangentNormalMap(path) || (stem.size() >= 6u && stem.compare(stem.size() - 6u, 6u, "normal") == 0);
+}
+
+// 按文件名选择 mip 的生成方式，环绕方式和 UploadCompressedTexture 中的规则一致（模型目录下的都是 GL_REPEAT）
+inline MipSettings GetTextureMipSettings(const std::string& path, int channels, const TextureCompressionSettings& settings)
+{
+    MipSettings mipSettings;
+    mipSettings.Filter = settings.Filter;
+    mipSettings.bNormalMap = IsNormalMap(path);
+    mipSettings.bSRGB = !IsLinearTexture(path);
+    std::string generic = std::filesystem::path(path).generic_string();
+    mipSettings.bWrap = channels != 4 || generic.find("/models/") != std::string::npos;
+    std::string filename = std::filesystem::path(path).filename().string();
+    for (const std::string& alphaTested : settings.AlphaTestedTextures)
+    {
+        if (filename == alphaTested)
+            mipSettings.AlphaCoverageReference = settings.AlphaTestReference;
+    }
+    return mipSettings;
+}
+
+// 压缩 path 指向的图片，写到 path + ".dds"
+inline bool CompressTextureFile(const std::string& path, const TextureCompressionSettings& settings, JobSystem* jobs, TextureCompressionResult& result)
+{
+    TextureSourceStamp stamp;
+    if (!GetTextureSourceStamp(path, stamp))
+        return false;
+
+    auto start = std::chrono::high_resolution_clock::now();
+    int width, height, channels;
+    unsigned char* data = stbi_load(path.c_str(), &width, &height, &channels, 4);
+    if (data == nullptr)
+    {
+        std::cout << "[TEXTURE COMPRESSION ERROR]: Failed to load texture at path: " << path << std::endl;
+        return false;
+    }
+    result.DecodeMs = TextureCompressionElapsedMs(start);
+    result.Width = static_cast<unsigned int>(width);
+    result.Height = static_cast<unsigned int>(height);
+    result.MipCount = GetMipCount(result.Width, result.Height);
+    result.Format = ChooseTextureBlockFormat(path, data, static_cast<size_t>(width) * height, channels, settings);
+
+    start = std::chrono::high_resolution_clock::now();
+    std::vector<std::vector<unsigned char>> levels;
+    GenerateMipChain(data, result.Width, result.Height, GetTextureMipSettings(path, channels, settings), levels, jobs);
+    stbi_image_free(data);
+    result.MipMs = TextureCompressionElapsedMs(start);
+
+    start = std::chrono::high_resolution_clock::now();
+    std::vector<unsigned char> compressed;
+    std::vector<size_t> levelOffsets;
+    result.UncompressedBytes = 0ull;
+    for (unsigned int mip = 0; mip < result.MipCount; mip++)
+    {
+        unsigned int levelWidth = std::max(1u, result.Width >> mip);
+        unsigned int levelHeight = std::max(1u, result.Height >> mip);
+        levelOffsets.push_back(compressed.size());
+        compressed.resize(compressed.size() + GetCompressedLevelSize(result.Format, levelWidth, levelHeight));
+        CompressTextureLevel(result.Format, levels[mip].data(), levelWidth, levelHeight, compressed.data() + levelOffsets[mip], jobs);
+        result.UncompressedBytes += static_cast<uint64_t>(levelWidth) * levelHeight * 4u;
+    }
+    result.CompressedBytes = compressed.size();
+    result.EncodeMs = TextureCompressionElapsedMs(start);
+
+    DDSHeader header = {};
+    header.Magic = DDS_MAGIC;
+    header.Size = 124u;
+    // CAPS | HEIGHT | WIDTH | PIXELFORMAT | MIPMAPCOUNT | LINEARSIZE
+    header.Flags = 0x1u | 0x2u | 0x4u | 0x1000u | 0x20000u | 0x80000u;
+    header.Height = result.Height;
+    header.Width = result.Width;
+    header.PitchOrLinearSize = static_cast<uint32_t>(GetCompressedLevelSize(result.Format, result.Width, result.Height));
+    header.MipMapCount = result.MipCount;
+    header.Reserved1[0] = COMPRESSED_TEXTURE_TAG;
+    header.Reserved1[1] = COMPRESSED_TEXTURE_VERSION;
+    header.Reserved1[2] = static_cast<uint32_t>(stamp.Size & 0xFFFFFFFFull);
+    header.Reserved1[3] = static_cast<uint32_t>(stamp.Size >> 32);
+    header.Reserved1[4] = static_cast<uint32_t>(static_cast<uint64_t>(stamp.Time) & 0xFFFFFFFFull);
+    header.Reserved1[5] = static_cast<uint32_t>(static_cast<uint64_t>(stamp.Time) >> 32);
+    header.Reserved1[6] = static_cast<uint32_t>(channels);
+    header.PixelFormat.Size = 32u;
+    header.PixelFormat.Flags = 0x4u;    // DDPF_FOURCC
+    header.PixelFormat.FourCC = DDS_FOURCC_DX10;
+    // TEXTURE | COMPLEX | MIPMAP
+    header.Caps = 0x1000u | 0x8u | 0x400000u;
+    header.DXGIFormat = GetDXGIFormat(result.Format);
+    header.ResourceDimension = 3u;      // D3D10_RESOURCE_DIMENSION_TEXTURE2D
+    header.ArraySize = 1u;
+
+    // 先写临时文件再改名，写到一半失败时不会留下损坏的缓存
+    std::string outputPath = path + COMPRESSED_TEXTURE_EXTENSION;
+    std::string temporaryPath = outputPath + ".tmp";
+    {
+        std::ofstream file(temporaryPath, std::ios::binary | std::ios::trunc);
+        if (!file)
+            return false;
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        file.write(reinterpret_cast<const char*>(compressed.data()), static_cast<std::streamsize>(compressed.size()));
+        if (!file)
+            return false;
+    }
+    std::error_code error;
+    std::filesystem::rename(temporaryPath, outputPath, error);
+    if (error)
+    {
+        std::filesystem::remove(temporaryPath, error);
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,466 @@
+#pragma once
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+#include <glm/glm.hpp>
+
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+
+#include <tool/stb_image.h>
+#include <tool/TextureCompression.h>
+
+// 把解码好的像素上传到已有的纹理对象（TextureFromFile 和异步加载共用）
+void UploadTextureData(unsigned int textureID, const unsigned char* data, int width, int height, int nrChannels, bool isModel, bool gamma)
+{
+    unsigned int internalFormat = GL_RGB;
+    unsigned int dataFormat = GL_RGB;
+    if (nrChannels == 1)
+    {
+        internalFormat = GL_RED;
+        dataFormat = GL_RED;
+    }
+    else if (nrChannels == 3)
+    {
+        internalFormat = gamma ? GL_SRGB : GL_RGB;
+        dataFormat = GL_RGB;
+    }
+    else if (nrChannels == 4)
+    {
+        internalFormat = gamma ? GL_SRGB_ALPHA : GL_RGBA;
+        dataFormat = GL_RGBA;
+    }
+
+    glBindTexture(GL_TEXTURE_2D, textureID);
+    // 如果是 rgba 设置过滤 gl_clamp_to_edge，不然会边缘插值，边缘会达不到效果
+    // 这里我在main函数中加载纹理和加载模型中使用的函数都是这一个，需要处理一下，模型必须是 GL_REPEAT 否则可能只绘制半边纹理
+    // 然后为了实现正确的混合效果，需要做 else 中的判断
+    if (isModel)
+    {
+        glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+        glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+    }
+    else
+    {
+        glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, dataFormat == GL_RGBA ? GL_CLAMP_TO_EDGE : GL_REPEAT);
+        glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, dataFormat == GL_RGBA ? GL_CLAMP_TO_EDGE : GL_REPEAT);
+    }
+    glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+    glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+    glTexImage2D(GL_TEXTURE_2D, 0, internalFormat, width, height, 0, dataFormat, GL_UNSIGNED_BYTE, data);
+    glGenerateMipmap(GL_TEXTURE_2D);
+}
+
+// 离线压缩的纹理（TextureCompression.h）
+// BC4/BC5（RGTC）是 GL 3.0 核心；BC1/BC3 需要 GL_EXT_texture_compression_s3tc，BC7 需要 GL 4.2 或 GL_ARB_texture_compression_bptc
+#ifndef GL_COMPRESSED_RGB_S3TC_DXT1_EXT
+#define GL_COMPRESSED_RGB_S3TC_DXT1_EXT 0x83F0
+#endif
+#ifndef GL_COMPRESSED_RGBA_S3TC_DXT5_EXT
+#define GL_COMPRESSED_RGBA_S3TC_DXT5_EXT 0x83F3
+#endif
+#ifndef GL_COMPRESSED_SRGB_S3TC_DXT1_EXT
+#define GL_COMPRESSED_SRGB_S3TC_DXT1_EXT 0x8C4C
+#endif
+#ifndef GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT
+#define GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT 0x8C4F
+#endif
+#ifndef GL_COMPRESSED_RGBA_BPTC_UNORM
+#define GL_COMPRESSED_RGBA_BPTC_UNORM 0x8E8C
+#endif
+#ifndef GL_COMPRESSED_SRGB_ALPHA_BPTC_UNORM
+#define GL_COMPRESSED_SRGB_ALPHA_BPTC_UNORM 0x8E8D
+#endif
+
+// 是否优先加载原图旁边的 .dds（默认开启，章节可以用 --textures=uncompressed 关闭）
+inline bool& CompressedTexturesEnabled()
+{
+    static bool enabled = true;
+    return enabled;
+}
+
+// 加载图片时是否上下翻转。stb_image 的翻转状态是内部变量（定义了 STBI_THREAD_LOCAL 时每个线程一份），不能直接读取，
+// 所以章节通过 SetTextureFlip 设置，这里记录一份（.dds 中是不翻转的数据，翻转时需要解码原图）
+inline bool& TextureFlipEnabled()
+{
+    static bool enabled = false;
+    return enabled;
+}
+
+inline void SetTextureFlip(bool flip)
+{
+    TextureFlipEnabled() = flip;
+    stbi_set_flip_vertically_on_load(flip);
+}
+
+inline bool IsTextureBlockFormatSupported(TextureBlockFormat format)
+{
+    switch (format)
+    {
+    case TextureBlockFormat::BC1:
+    case TextureBlockFormat::BC3:
+        return glfwExtensionSupported("GL_EXT_texture_compression_s3tc") == GLFW_TRUE;
+    case TextureBlockFormat::BC5:
+        return true;
+    case TextureBlockFormat::BC7:
+        return GLVersion.major > 4 || (GLVersion.major == 4 && GLVersion.minor >= 2)
+            || glfwExtensionSupported("GL_ARB_texture_compression_bptc") == GLFW_TRUE;
+    default:
+        return false;
+    }
+}
+
+// gamma 为 true 时颜色贴图使用 sRGB 格式（和 UploadTextureData 的 GL_SRGB/GL_SRGB_ALPHA 对应），法线贴图不受影响
+inline GLenum GetCompressedInternalFormat(TextureBlockFormat format, bool gamma)
+{
+    switch (format)
+    {
+    case TextureBlockFormat::BC1: return gamma ? GL_COMPRESSED_SRGB_S3TC_DXT1_EXT : GL_COMPRESSED_RGB_S3TC_DXT1_EXT;
+    case TextureBlockFormat::BC3: return gamma ? GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT : GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+    case TextureBlockFormat::BC5: return GL_COMPRESSED_RG_RGTC2;
+    case TextureBlockFormat::BC7: return gamma ? GL_COMPRESSED_SRGB_ALPHA_BPTC_UNORM : GL_COMPRESSED_RGBA_BPTC_UNORM;
+    default: return GL_NONE;
+    }
+}
+
+// 打开 filename 对应的 .dds，不存在、原图已经修改或者驱动不支持该格式时返回 false
+inline bool OpenCompressedTexture(const std::string& filename, CompressedTextureView& view)
+{
+    if (!CompressedTexturesEnabled())
+        return false;
+    TextureSourceStamp stamp;
+    if (!GetTextureSourceStamp(filename, stamp) || !view.Open(filename + COMPRESSED_TEXTURE_EXTENSION, &stamp))
+        return false;
+    return IsTextureBlockFormatSupported(view.GetFormat());
+}
+
+// 把 .dds 中的全部 mip 直接上传（不需要 glGenerateMipmap），采样参数和 UploadTextureData 相同
+inline void UploadCompressedTexture(unsigned int textureID, const CompressedTextureView& view, bool isModel, bool gamma)
+{
+    glBindTexture(GL_TEXTURE_2D, textureID);
+    GLint wrap = (isModel || view.GetSourceChannels() != 4u) ? GL_REPEAT : GL_CLAMP_TO_EDGE;
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, wrap);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, wrap);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, static_cast<GLint>(view.GetMipCount()) - 1);
+
+    GLenum internalFormat = GetCompressedInternalFormat(view.GetFormat(), gamma);
+    for (unsigned int mip = 0; mip < view.GetMipCount(); mip++)
+    {
+        glCompressedTexImage2D(GL_TEXTURE_2D, static_cast<GLint>(mip), internalFormat, view.GetLevelWidth(mip), view.GetLevelHeight(mip), 0,
+            static_cast<GLsizei>(view.GetLevelSize(mip)), view.GetLevel(mip));
+    }
+}
+
+// 材质直接引用 .dds 文件（stb_image 不能解码 .dds）
+inline bool IsCompressedTexturePath(const std::string& filename)
+{
+    size_t extensionLength = std::char_traits<char>::length(COMPRESSED_TEXTURE_EXTENSION);
+    return filename.size() >= extensionLength
+        && filename.compare(filename.size() - extensionLength, extensionLength, COMPRESSED_TEXTURE_EXTENSION) == 0;
+}
+
+// 打开直接引用的 .dds，没有原图可以比对，只检查文件头、mip 大小和驱动是否支持该格式
+inline bool OpenCompressedTextureFile(const std::string& path, CompressedTextureView& view)
+{
+    return view.Open(path) && IsTextureBlockFormatSupported(view.GetFormat());
+}
+
+inline bool TryLoadCompressedTexture(unsigned int textureID, const std::string& filename, bool isModel, bool gamma)
+{
+    CompressedTextureView view;
+    if (IsCompressedTexturePath(filename) ? !OpenCompressedTextureFile(filename, view) : !OpenCompressedTexture(filename, view))
+        return false;
+    UploadCompressedTexture(textureID, view, isModel, gamma);
+    return true;
+}
+
+// 纹理所有 mip 占用的显存（压缩纹理按驱动报告的大小，未压缩的 RGB8 按驱动实际分配的 4 字节/texel）
+inline size_t GetTextureMemorySize(unsigned int textureID)
+{
+    glBindTexture(GL_TEXTURE_2D, textureID);
+    size_t total = 0u;
+    for (GLint level = 0; level < 16; level++)
+    {
+        GLint width = 0, height = 0;
+        glGetTexLevelParameteriv(GL_TEXTURE_2D, level, GL_TEXTURE_WIDTH, &width);
+        glGetTexLevelParameteriv(GL_TEXTURE_2D, level, GL_TEXTURE_HEIGHT, &height);
+        if (width == 0 || height == 0)
+            break;
+        GLint compressed = GL_FALSE;
+        glGetTexLevelParameteriv(GL_TEXTURE_2D, level, GL_TEXTURE_COMPRESSED, &compressed);
+        if (compressed == GL_TRUE)
+        {
+            GLint size = 0;
+            glGetTexLevelParameteriv(GL_TEXTURE_2D, level, GL_TEXTURE_COMPRESSED_IMAGE_SIZE, &size);
+            total += static_cast<size_t>(size);
+            continue;
+        }
+        GLint bits[4] = { 0, 0, 0, 0 };
+        glGetTexLevelParameteriv(GL_TEXTURE_2D, level, GL_TEXTURE_RED_SIZE, &bits[0]);
+        glGetTexLevelParameteriv(GL_TEXTURE_2D, level, GL_TEXTURE_GREEN_SIZE, &bits[1]);
+        glGetTexLevelParameteriv(GL_TEXTURE_2D, level, GL_TEXTURE_BLUE_SIZE, &bits[2]);
+        glGetTexLevelParameteriv(GL_TEXTURE_2D, level, GL_TEXTURE_ALPHA_SIZE, &bits[3]);
+        GLint texelBits = bits[0] + bits[1] + bits[2] + bits[3];
+        if (texelBits == 24)
+            texelBits = 32;
+        total += static_cast<size_t>(width) * height * static_cast<size_t>(texelBits) / 8u;
+    }
+    return total;
+}
+
+// 异步纹理加载器
+// 1. Request 立即返回一个 1x1 占位纹理的 ID，解码任务交给线程池（stbi_load 可以多线程调用）
+//    .dds（直接引用的或者原图旁边的）不需要解码，在 Request 中直接上传，不进入解码队列
+// 2. 解码完成的图像放进有界队列，队列满时工作线程等待，避免一次解码太多图片占用内存
+// 3. 渲染线程每帧调用 Update，把队列中的图像上传到原来的纹理对象上，
+//    纹理 ID 不变，所以 Mesh 中保存的 Texture 不需要替换
+class TextureLoader
+{
+public:
+    // 每张纹理的耗时统计
+    struct TextureStats
+    {
+        std::string Path;
+        double DecodeMs;
+        double UploadMs;
+        int Width;
+        int Height;
+    };
+
+    TextureLoader(unsigned int threadCount = 0u, size_t maxPendingUploads = 8u)
+        :
+        MaxPendingUploads(maxPendingUploads > 0u ? maxPendingUploads : 1u)
+    {
+        if (threadCount == 0u)
+        {
+            unsigned int cores = std::thread::hardware_concurrency();
+            threadCount = cores > 1u ? cores - 1u : 1u;
+        }
+        for (unsigned int i = 0; i < threadCount; i++)
+            Workers.emplace_back(&TextureLoader::WorkerLoop, this);
+    }
+
+    TextureLoader(const TextureLoader&) = delete;
+    TextureLoader& operator=(const TextureLoader&) = delete;
+
+    ~TextureLoader()
+    {
+        {
+            std::lock_guard<std::mutex> lock(Mutex);
+            bStop = true;
+        }
+        JobAvailable.notify_all();
+        UploadSlotFree.notify_all();
+        for (std::thread& worker : Workers)
+            worker.join();
+        for (DecodedImage& image : Decoded)
+            stbi_image_free(image.Data);
+    }
+
+    // 申请加载纹理，返回的 ID 立即可用（先显示占位颜色）
+    unsigned int Request(const std::string& filename, bool isModel = true, bool gamma = false, const glm::vec4& placeholder = glm::vec4(0.5f, 0.5f, 0.5f, 1.0f))
+    {
+        unsigned int textureID;
+        glGenTextures(1, &textureID);
+        glBindTexture(GL_TEXTURE_2D, textureID);
+        unsigned char texel[4] =
+        {
+            static_cast<unsigned char>(glm::clamp(placeholder.r, 0.0f, 1.0f) * 255.0f),
+            static_cast<unsigned char>(glm::clamp(placeholder.g, 0.0f, 1.0f) * 255.0f),
+            static_cast<unsigned char>(glm::clamp(placeholder.b, 0.0f, 1.0f) * 255.0f),
+            static_cast<unsigned char>(glm::clamp(placeholder.a, 0.0f, 1.0f) * 255.0f)
+        };
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, 1, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, texel);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+
+        // .dds 中是不翻转的数据，翻转时原图还是交给 stbi 解码；直接引用的 .dds 没有原图，加载失败时保留占位纹理
+        bool isCompressedFile = IsCompressedTexturePath(filename);
+        if (isCompressedFile || !TextureFlipEnabled())
+        {
+            auto start = std::chrono::high_resolution_clock::now();
+            CompressedTextureView view;
+            if (isCompressedFile ? OpenCompressedTextureFile(filename, view) : OpenCompressedTexture(filename, view))
+            {
+                UploadCompressedTexture(textureID, view, isModel, gamma);
+                double uploadMs = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+                Stats.push_back({ filename, 0.0, uploadMs, static_cast<int>(view.GetWidth()), static_cast<int>(view.GetHeight()) });
+                return textureID;
+            }
+            if (isCompressedFile)
+            {
+                std::cout << "[TEXTURE LOAD ERROR]: Invalid or unsupported DDS texture at path: " << filename << std::endl;
+                return textureID;
+            }
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(Mutex);
+            Jobs.push_back({ filename, textureID, isModel, gamma });
+            PendingCount++;
+        }
+        JobAvailable.notify_one();
+        return textureID;
+    }
+
+    // 在 OpenGL 上下文线程调用，最多上传 maxUploads 张纹理，返回本次上传的数量
+    unsigned int Update(unsigned int maxUploads = 2u)
+    {
+        unsigned int uploaded = 0;
+        while (uploaded < maxUploads)
+        {
+            DecodedImage image;
+            {
+                std::lock_guard<std::mutex> lock(Mutex);
+                if (Decoded.empty())
+                    break;
+                image = Decoded.front();
+                Decoded.pop_front();
+            }
+            UploadSlotFree.notify_one();
+            Upload(image);
+            uploaded++;
+        }
+        return uploaded;
+    }
+
+    // 阻塞直到所有纹理都上传完成（同步加载时使用）
+    void Finish()
+    {
+        while (true)
+        {
+            DecodedImage image;
+            {
+                std::unique_lock<std::mutex> lock(Mutex);
+                ImageDecoded.wait(lock, [this] { return !Decoded.empty() || PendingCount == 0; });
+                if (Decoded.empty())
+                    return;
+                image = Decoded.front();
+                Decoded.pop_front();
+            }
+            UploadSlotFree.notify_one();
+            Upload(image);
+        }
+    }
+
+    // 还没有上传完成的纹理数量
+    inline size_t GetPendingCount()
+    {
+        std::lock_guard<std::mutex> lock(Mutex);
+        return PendingCount;
+    }
+
+    inline const std::vector<TextureStats>& GetStats() const { return Stats; }
+
+    void PrintStats() const
+    {
+        double totalDecode = 0.0;
+        double totalUpload = 0.0;
+        for (const TextureStats& stats : Stats)
+        {
+            std::cout << "[TEXTURE] " << std::left << std::setw(48) << stats.Path << std::right
+                      << std::setw(5) << stats.Width << "x" << std::setw(5) << std::left << stats.Height << std::right
+                      << " decode: " << std::fixed << std::setprecision(2) << std::setw(8) << stats.DecodeMs << " ms"
+                      << " upload: " << std::setw(8) << stats.UploadMs << " ms" << std::endl;
+            totalDecode += stats.DecodeMs;
+            totalUpload += stats.UploadMs;
+        }
+        std::cout << "[TEXTURE] " << Stats.size() << " textures on " << Workers.size() << " threads, decode total: "
+                  << totalDecode << " ms, upload total: " << totalUpload << " ms" << std::endl;
+    }
+
+private:
+    struct DecodeJob
+    {
+        std::string Filename;
+        unsigned int TextureID;
+        bool IsModel;
+        bool Gamma;
+    };
+
+    struct DecodedImage
+    {
+        DecodeJob Job;
+        unsigned char* Data = nullptr;
+        int Width = 0;
+        int Height = 0;
+        int Channels = 0;
+        double DecodeMs = 0.0;
+    };
+
+    void WorkerLoop()
+    {
+        while (true)
+        {
+            DecodeJob job;
+            {
+                std::unique_lock<std::mutex> lock(Mutex);
+                JobAvailable.wait(lock, [this] { return bStop || !Jobs.empty(); });
+                if (bStop)
+                    return;
+                job = Jobs.front();
+                Jobs.pop_front();
+            }
+
+            DecodedImage image;
+            image.Job = job;
+            auto start = std::chrono::high_resolution_clock::now();
+            image.Data = stbi_load(job.Filename.c_str(), &image.Width, &image.Height, &image.Channels, 0);
+            image.DecodeMs = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+
+            {
+                // 有界队列：上传跟不上时等待
+                std::unique_lock<std::mutex> lock(Mutex);
+                UploadSlotFree.wait(lock, [this] { return bStop || Decoded.size() < MaxPendingUploads; });
+                if (bStop)
+                {
+                    stbi_image_free(image.Data);
+                    return;
+                }
+                Decoded.push_back(image);
+            }
+            ImageDecoded.notify_one();
+        }
+    }
+
+    void Upload(DecodedImage& image)
+    {
+        auto start = std::chrono::high_resolution_clock::now();
+        if (image.Data != nullptr)
+            UploadTextureData(image.Job.TextureID, image.Data, image.Width, image.Height, image.Channels, image.Job.IsModel, image.Job.Gamma);
+        else
+            std::cout << "[TEXTURE LOAD ERROR]: Failed to load texture at path: " << image.Job.Filename << std::endl;
+        double uploadMs = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+        stbi_image_free(image.Data);
+        image.Data = nullptr;
+
+        Stats.push_back({ image.Job.Filename, image.DecodeMs, uploadMs, image.Width, image.Height });
+        {
+            std::lock_guard<std::mutex> lock(Mutex);
+            PendingCount--;
+        }
+        ImageDecoded.notify_all();
+    }
+
+    std::vector<std::thread> Workers;
+    std::deque<DecodeJob> Jobs;
+    std::deque<DecodedImage> Decoded;
+    std::vector<TextureStats> Stats;
+    size_t MaxPendingUploads;
+    size_t PendingCount = 0;
+    bool bStop = false;
+
+    std::mutex Mutex;
+    std::condition_variable JobAvailable;
+    std::condition_variable ImageDecoded;
+    std::condition_variable UploadSlotFree;
+};
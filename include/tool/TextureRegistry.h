@@ -0,0 +1,185 @@
+#pragma once
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <filesystem>
+
+#include <tool/MappedFile.h>
+#include <tool/TextureLoader.h>
+
+unsigned int TextureFromFile(const char* path, const std::string& directory, bool isModel, bool gamma);
+
+// 进程内全局纹理注册表
+// 1. 先按规范化路径查找（哈希表，O(1)）
+// 2. 路径没命中时按文件内容哈希查找，不同目录下内容相同的图片（比如 nanosuit 和 nanosuit_reflection）共用一个纹理对象
+// 3. 引用计数：Model 析构时 Release，计数归零的纹理只有在显式调用 EvictUnused 时才会删除
+//    （很多章节在 glfwTerminate 之后才析构 Model，那时已经没有 OpenGL 上下文了）
+class TextureRegistry
+{
+public:
+    struct Statistics
+    {
+        unsigned int PathHits = 0;
+        unsigned int ContentHits = 0;
+        unsigned int Decodes = 0;
+        unsigned int Evictions = 0;
+    };
+
+    static TextureRegistry& Get()
+    {
+        static TextureRegistry registry;
+        return registry;
+    }
+
+    TextureRegistry(const TextureRegistry&) = delete;
+    TextureRegistry& operator=(const TextureRegistry&) = delete;
+
+    // 获取纹理并增加引用计数，loader 不为空时异步解码
+    unsigned int Acquire(const std::string& filename, bool isModel = true, bool gamma = false, TextureLoader* loader = nullptr,
+        const glm::vec4& placeholder = glm::vec4(0.5f, 0.5f, 0.5f, 1.0f))
+    {
+        std::string pathKey = MakeKey(CanonicalPath(filename), isModel, gamma);
+        auto pathIt = PathToTexture.find(pathKey);
+        if (pathIt != PathToTexture.end())
+        {
+            Stats.PathHits++;
+            Entries[pathIt->second].RefCount++;
+            return pathIt->second;
+        }
+
+        // 路径第一次出现，按内容查找
+        uint64_t contentHash = HashFileContent(filename);
+        std::string contentKey = MakeKey(std::to_string(contentHash), isModel, gamma);
+        if (contentHash != 0ull)
+        {
+            auto contentIt = ContentToTexture.find(contentKey);
+            if (contentIt != ContentToTexture.end())
+            {
+                Stats.ContentHits++;
+                Entry& entry = Entries[contentIt->second];
+                entry.RefCount++;
+                entry.PathKeys.push_back(pathKey);
+                PathToTexture[pathKey] = contentIt->second;
+                return contentIt->second;
+            }
+        }
+
+        Stats.Decodes++;
+        unsigned int textureID;
+        // 有压缩好的 .dds 时不需要异步解码，直接同步上传
+        CompressedTextureView compressed;
+        if (loader != nullptr && !OpenCompressedTexture(filename, compressed))
+        {
+            textureID = loader->Request(filename, isModel, gamma, placeholder);
+        }
+        else
+        {
+            size_t slash = filename.find_last_of('/');
+            std::string directory = slash == std::string::npos ? std::string(".") : filename.substr(0, slash);
+            std::string name = slash == std::string::npos ? filename : filename.substr(slash + 1);
+            textureID = TextureFromFile(name.c_str(), directory, isModel, gamma);
+        }
+
+        Entry& entry = Entries[textureID];
+        entry.RefCount = 1u;
+        entry.PathKeys.push_back(pathKey);
+        PathToTexture[pathKey] = textureID;
+        if (contentHash != 0ull)
+        {
+            entry.ContentKey = contentKey;
+            ContentToTexture[contentKey] = textureID;
+        }
+        return textureID;
+    }
+
+    // 减少引用计数，不会立即删除纹理
+    void Release(unsigned int textureID)
+    {
+        auto it = Entries.find(textureID);
+        if (it != Entries.end() && it->second.RefCount > 0u)
+            it->second.RefCount--;
+    }
+
+    // 删除所有引用计数为 0 的纹理（需要在 OpenGL 上下文中调用），返回删除数量
+    unsigned int EvictUnused()
+    {
+        unsigned int evicted = 0;
+        for (auto it = Entries.begin(); it != Entries.end();)
+        {
+            if (it->second.RefCount > 0u)
+            {
+                ++it;
+                continue;
+            }
+            for (const std::string& pathKey : it->second.PathKeys)
+                PathToTexture.erase(pathKey);
+            if (!it->second.ContentKey.empty())
+                ContentToTexture.erase(it->second.ContentKey);
+            glDeleteTextures(1, &it->first);
+            it = Entries.erase(it);
+            evicted++;
+        }
+        Stats.Evictions += evicted;
+        return evicted;
+    }
+
+    inline unsigned int GetRefCount(unsigned int textureID) const
+    {
+        auto it = Entries.find(textureID);
+        return it != Entries.end() ? it->second.RefCount : 0u;
+    }
+
+    inline size_t GetTextureCount() const { return Entries.size(); }
+    inline const Statistics& GetStatistics() const { return Stats; }
+
+    void PrintStatistics() const
+    {
+        std::cout << "[TEXTURE REGISTRY] textures: " << Entries.size()
+                  << ", decodes: " << Stats.Decodes
+                  << ", path hits: " << Stats.PathHits
+                  << ", content hits: " << Stats.ContentHits
+                  << ", evictions: " << Stats.Evictions << std::endl;
+    }
+
+private:
+    TextureRegistry() = default;
+
+    struct Entry
+    {
+        unsigned int RefCount = 0u;
+        std::string ContentKey;
+        std::vector<std::string> PathKeys;
+    };
+
+    static std::string CanonicalPath(const std::string& filename)
+    {
+        std::error_code error;
+        std::filesystem::path path = std::filesystem::weakly_canonical(std::filesystem::path(filename), error);
+        if (error)
+            return std::filesystem::path(filename).lexically_normal().generic_string();
+        return path.generic_string();
+    }
+
+    // 同一张图片用不同的 gamma / 环绕方式加载时是不同的纹理对象
+    static std::string MakeKey(const std::string& base, bool isModel, bool gamma)
+    {
+        return base + (isModel ? "|m" : "|t") + (gamma ? "|srgb" : "|linear");
+    }
+
+    static uint64_t HashFileContent(const std::string& filename)
+    {
+        MappedFile file;
+        if (!file.Open(filename))
+            return 0ull;
+        return HashBytes(file.GetData(), file.GetSize());
+    }
+
+    std::unordered_map<std::string, unsigned int> PathToTexture;
+    std::unordered_map<std::string, unsigned int> ContentToTexture;
+    std::unordered_map<unsigned int, Entry> Entries;
+    Statistics Stats;
+};
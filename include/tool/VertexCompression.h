@@ -0,0 +1,117 @@
+#pragma once
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <cstring>
+#include <cmath>
+#include <algorithm>
+
+// 顶点属性压缩的编码函数（加载时在 CPU 上调用，着色器中对应的解码见 33-DeferredShading/Shaders/g_buffer.vs）
+//
+// 八面体编码（octahedral）：把单位向量投影到八面体 |x| + |y| + |z| = 1 上再展开成 [-1, 1]^2 的正方形，
+// 两个分量就能表示方向，16 位精度的最大角度误差约 0.05 度，8 位约 1 度
+
+inline glm::vec2 OctahedralEncode(glm::vec3 n)
+{
+    float length = std::fabs(n.x) + std::fabs(n.y) + std::fabs(n.z);
+    if (length < 1e-12f)
+        return glm::vec2(0.0f);
+    n /= length;
+    glm::vec2 p(n.x, n.y);
+    if (n.z < 0.0f)
+    {
+        // 下半球折叠到正方形的四个角
+        p.x = (1.0f - std::fabs(n.y)) * (n.x >= 0.0f ? 1.0f : -1.0f);
+        p.y = (1.0f - std::fabs(n.x)) * (n.y >= 0.0f ? 1.0f : -1.0f);
+    }
+    return p;
+}
+
+inline glm::vec3 OctahedralDecode(glm::vec2 e)
+{
+    glm::vec3 v(e.x, e.y, 1.0f - std::fabs(e.x) - std::fabs(e.y));
+    float t = std::max(-v.z, 0.0f);
+    v.x += v.x >= 0.0f ? -t : t;
+    v.y += v.y >= 0.0f ? -t : t;
+    return glm::normalize(v);
+}
+
+// [-1, 1] -> 有符号归一化整数（GL_SHORT / GL_BYTE + normalized = GL_TRUE）
+inline int16_t PackSnorm16(float value)
+{
+    return static_cast<int16_t>(std::lround(std::clamp(value, -1.0f, 1.0f) * 32767.0f));
+}
+
+inline int8_t PackSnorm8(float value)
+{
+    return static_cast<int8_t>(std::lround(std::clamp(value, -1.0f, 1.0f) * 127.0f));
+}
+
+// [0, 1] -> 无符号归一化整数（GL_UNSIGNED_SHORT + normalized = GL_TRUE）
+inline uint16_t PackUnorm16(float value)
+{
+    return static_cast<uint16_t>(std::lround(std::clamp(value, 0.0f, 1.0f) * 65535.0f));
+}
+
+// 32 位浮点 -> 16 位半精度（GL_HALF_FLOAT），就近舍入，太小的值变成 0，太大的值变成无穷
+inline uint16_t FloatToHalf(float value)
+{
+    uint32_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    uint16_t sign = static_cast<uint16_t>((bits >> 16) & 0x8000u);
+    int32_t exponent = static_cast<int32_t>((bits >> 23) & 0xFFu) - 127 + 15;
+    uint32_t mantissa = bits & 0x7FFFFFu;
+
+    if (((bits >> 23) & 0xFFu) == 0xFFu)
+        return static_cast<uint16_t>(sign | 0x7C00u | (mantissa != 0u ? 0x200u : 0u));
+    if (exponent >= 31)
+        return static_cast<uint16_t>(sign | 0x7C00u);
+    if (exponent <= 0)
+    {
+        if (exponent < -10)
+            return sign;
+        // 非规格化数
+        mantissa |= 0x800000u;
+        uint32_t shift = static_cast<uint32_t>(14 - exponent);
+        uint32_t half = mantissa >> shift;
+        if ((mantissa >> (shift - 1)) & 1u)
+            half++;
+        return static_cast<uint16_t>(sign | half);
+    }
+    uint32_t half = (static_cast<uint32_t>(exponent) << 10) | (mantissa >> 13);
+    // 舍入（进位可能进到指数，结果仍然正确）
+    if (mantissa & 0x1000u)
+        half++;
+    return static_cast<uint16_t>(sign | half);
+}
+
+inline float HalfToFloat(uint16_t half)
+{
+    uint32_t sign = static_cast<uint32_t>(half & 0x8000u) << 16;
+    uint32_t exponent = (half >> 10) & 0x1Fu;
+    uint32_t mantissa = half & 0x3FFu;
+    uint32_t bits;
+    if (exponent == 0u)
+    {
+        if (mantissa == 0u)
+            bits = sign;
+        else
+        {
+            // 非规格化数，规格化之后再转换
+            exponent = 127 - 15 + 1;
+            while ((mantissa & 0x400u) == 0u)
+            {
+                mantissa <<= 1;
+                exponent--;
+            }
+            bits = sign | (exponent << 23) | ((mantissa & 0x3FFu) << 13);
+        }
+    }
+    else if (exponent == 31u)
+        bits = sign | 0x7F800000u | (mantissa << 13);
+    else
+        bits = sign | ((exponent + 127 - 15) << 23) | (mantissa << 13);
+    float value;
+    std::memcpy(&value, &bits, sizeof(value));
+    return value;
+}
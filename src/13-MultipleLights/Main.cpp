@@ -1,4 +1,12 @@
 #include <iostream>
+#include <iomanip>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <algorithm>
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
 #include <tool/Shader.h>
@@ -9,6 +17,10 @@
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 
+#include <tool/FrameConstants.h>
+#include <tool/GpuProfiler.h>
+#include <tool/Random.h>
+
 const int SCREEN_WIDTH = 800;
 const int SCREEN_HEIGHT = 600;
 
@@ -25,6 +37,83 @@ float LastFrame{};
 // Light
 glm::vec3 LightPos{1.2f, 1.0f, 2.0f};
 
+// 相机、光源、材质和每个物体的矩阵怎样传给着色器（U 键切换）
+// ring   : FrameConstantAllocator，每帧从持久映射的三重缓冲 UBO 中分配，glBindBufferRange 切换每个物体的数据
+// subdata: 21-UniformBufferObject 的做法，每个块一个 UBO，每次更新（包括每个物体）调用 glBufferSubData
+// legacy : 原来的做法，逐个 glUniform*（通过名字查找）
+enum class UniformMode
+{
+    Ring,
+    SubData,
+    Legacy,
+    Count
+};
+
+const char* GetUniformModeName(UniformMode mode)
+{
+    switch (mode)
+    {
+    case UniformMode::Ring: return "ring";
+    case UniformMode::SubData: return "subdata";
+    case UniformMode::Legacy: return "legacy";
+    default: return "unknown";
+    }
+}
+
+UniformMode Mode = UniformMode::Ring;
+bool uKeyPressed = false;
+
+float LastTitleTime{};
+int nbFrames{};
+
+// uniform 块的绑定点
+const unsigned int CAMERA_BINDING = 0u;
+const unsigned int OBJECT_BINDING = 1u;
+const unsigned int LIGHTS_BINDING = 2u;
+const unsigned int MATERIAL_BINDING = 3u;
+
+// 和 UniformBlockFragmentShader.glsl 中的 std140 块一一对应，都是 vec4，标量放在 x/y/z 里
+struct DirLightData
+{
+    glm::vec4 Direction;
+    glm::vec4 Ambient;
+    glm::vec4 Diffuse;
+    glm::vec4 Specular;
+};
+
+struct PointLightData
+{
+    glm::vec4 Position;
+    glm::vec4 Attenuation;
+    glm::vec4 Ambient;
+    glm::vec4 Diffuse;
+    glm::vec4 Specular;
+};
+
+struct SpotLightData
+{
+    glm::vec4 Position;
+    glm::vec4 Direction;
+    glm::vec4 Attenuation;
+    glm::vec4 CutOff;
+    glm::vec4 Ambient;
+    glm::vec4 Diffuse;
+    glm::vec4 Specular;
+};
+
+struct LightConstants
+{
+    DirLightData DirLight;
+    PointLightData PointLights[4];
+    SpotLightData SpotLight;
+};
+
+struct MaterialConstants
+{
+    // x: shininess
+    glm::vec4 Params;
+};
+
 void FramebufferSizeCallback(GLFWwindow* window, int width, int height)
 {
     glViewport(0u, 0u, width, height);
@@ -46,6 +135,14 @@ void ProcessInput(GLFWwindow* window)
         camera.ProcessKeyboard(UP, DeltaTime);
     if (glfwGetKey(window, GLFW_KEY_Q) == GLFW_PRESS)
         camera.ProcessKeyboard(DOWN, DeltaTime);
+
+    if (glfwGetKey(window, GLFW_KEY_U) == GLFW_PRESS && !uKeyPressed)
+    {
+        Mode = static_cast<UniformMode>((static_cast<int>(Mode) + 1) % static_cast<int>(UniformMode::Count));
+        uKeyPressed = true;
+    }
+    if (glfwGetKey(window, GLFW_KEY_U) == GLFW_RELEASE)
+        uKeyPressed = false;
 }
 
 void CursorPosCallback(GLFWwindow* window, double xpos, double ypos)
@@ -106,8 +203,398 @@ unsigned int LoadTexture(const char* path)
     return textureID;
 }
 
+// 场景是静态的，每个物体的矩阵提前算好，每帧只比较把它们交给着色器的开销
+struct LightingScene
+{
+    std::vector<ObjectConstants> Cubes;
+    ObjectConstants LightCubes[4];
+    glm::vec3 PointLightPositions[4];
+    unsigned int CubeVAO = 0u;
+    unsigned int LightCubeVAO = 0u;
+    unsigned int DiffuseMap = 0u;
+    unsigned int SpecularMap = 0u;
+};
+
+ObjectConstants MakeObjectConstants(const glm::mat4& model)
+{
+    ObjectConstants object;
+    object.Model = model;
+    object.NormalMatrix = glm::mat4(glm::transpose(glm::inverse(glm::mat3(model))));
+    return object;
+}
+
+// 前 10 个是原来的箱子，--cubes=N 时在周围散布更多箱子
+void BuildCubes(LightingScene& scene, unsigned int count)
+{
+    const glm::vec3 cubePositions[10] =
+    {
+        glm::vec3( 0.0f,  0.0f,  0.0f),
+        glm::vec3( 2.0f,  5.0f, -15.0f),
+        glm::vec3(-1.5f, -2.2f, -2.5f),
+        glm::vec3(-3.8f, -2.0f, -12.3f),
+        glm::vec3( 2.4f, -0.4f, -3.5f),
+        glm::vec3(-1.7f,  3.0f, -7.5f),
+        glm::vec3( 1.3f, -2.0f, -2.5f),
+        glm::vec3( 1.5f,  2.0f, -2.5f),
+        glm::vec3( 1.5f,  0.2f, -1.5f),
+        glm::vec3(-1.3f,  1.0f, -1.5f)
+    };
+    scene.Cubes.clear();
+    scene.Cubes.reserve(count);
+    float extent = std::max(8.0f, std::cbrt(static_cast<float>(count)));
+    for (unsigned int i = 0; i < count; i++)
+    {
+        glm::vec3 position;
+        if (i < 10u)
+        {
+            position = cubePositions[i];
+        }
+        else
+        {
+            position.x = (static_cast<float>(HashRandom(i, 0u) % 10000u) / 5000.0f - 1.0f) * extent;
+            position.y = (static_cast<float>(HashRandom(i, 1u) % 10000u) / 5000.0f - 1.0f) * extent;
+            position.z = -static_cast<float>(HashRandom(i, 2u) % 10000u) / 10000.0f * extent * 2.0f;
+        }
+        glm::mat4 model = glm::translate(glm::mat4(1.0f), position);
+        model = glm::rotate(model, glm::radians(20.0f * (i % 18u)), glm::vec3(1.0f, 0.3f, 0.5f));
+        scene.Cubes.push_back(MakeObjectConstants(model));
+    }
+}
+
+LightConstants BuildLightConstants(const LightingScene& scene)
+{
+    LightConstants lights;
+    // directional light
+    lights.DirLight.Direction = glm::vec4(-0.2f, -1.0f, -0.3f, 0.0f);
+    lights.DirLight.Ambient = glm::vec4(0.05f, 0.05f, 0.05f, 0.0f);
+    lights.DirLight.Diffuse = glm::vec4(0.4f, 0.4f, 0.4f, 0.0f);
+    lights.DirLight.Specular = glm::vec4(0.5f, 0.5f, 0.5f, 0.0f);
+    // point lights
+    for (unsigned int i = 0; i < 4; i++)
+    {
+        lights.PointLights[i].Position = glm::vec4(scene.PointLightPositions[i], 1.0f);
+        lights.PointLights[i].Attenuation = glm::vec4(1.0f, 0.09f, 0.032f, 0.0f);
+        lights.PointLights[i].Ambient = glm::vec4(0.05f, 0.05f, 0.05f, 0.0f);
+        lights.PointLights[i].Diffuse = glm::vec4(0.8f, 0.8f, 0.8f, 0.0f);
+        lights.PointLights[i].Specular = glm::vec4(1.0f, 1.0f, 1.0f, 0.0f);
+    }
+    // spotLight
+    lights.SpotLight.Position = glm::vec4(camera.Position, 1.0f);
+    lights.SpotLight.Direction = glm::vec4(camera.Front, 0.0f);
+    lights.SpotLight.Attenuation = glm::vec4(1.0f, 0.09f, 0.032f, 0.0f);
+    lights.SpotLight.CutOff = glm::vec4(glm::cos(glm::radians(12.5f)), glm::cos(glm::radians(15.0f)), 0.0f, 0.0f);
+    lights.SpotLight.Ambient = glm::vec4(0.0f, 0.0f, 0.0f, 0.0f);
+    lights.SpotLight.Diffuse = glm::vec4(1.0f, 1.0f, 1.0f, 0.0f);
+    lights.SpotLight.Specular = glm::vec4(1.0f, 1.0f, 1.0f, 0.0f);
+    return lights;
+}
+
+// subdata 模式每个块一个固定的 UBO
+struct UniformBlockBuffers
+{
+    unsigned int Camera = 0u;
+    unsigned int Lights = 0u;
+    unsigned int Material = 0u;
+    unsigned int Object = 0u;
+};
+
+UniformBlockBuffers CreateUniformBlockBuffers()
+{
+    UniformBlockBuffers buffers;
+    const size_t sizes[4] = { sizeof(CameraConstants), sizeof(LightConstants), sizeof(MaterialConstants), sizeof(ObjectConstants) };
+    unsigned int* ids[4] = { &buffers.Camera, &buffers.Lights, &buffers.Material, &buffers.Object };
+    for (int i = 0; i < 4; i++)
+    {
+        glGenBuffers(1, ids[i]);
+        glBindBuffer(GL_UNIFORM_BUFFER, *ids[i]);
+        glBufferData(GL_UNIFORM_BUFFER, sizes[i], nullptr, GL_DYNAMIC_DRAW);
+    }
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+    return buffers;
+}
+
+void DestroyUniformBlockBuffers(UniformBlockBuffers& buffers)
+{
+    unsigned int ids[4] = { buffers.Camera, buffers.Lights, buffers.Material, buffers.Object };
+    glDeleteBuffers(4, ids);
+    buffers = UniformBlockBuffers();
+}
+
+// 三种模式共用的着色器和缓冲，Uploads / Binds 是上一帧的缓冲上传（glBufferSubData）和绑定（glBindBufferBase/Range）次数
+struct LightingRenderer
+{
+    Shader* LegacyShader = nullptr;
+    Shader* LegacyLightCubeShader = nullptr;
+    Shader* BlockShader = nullptr;
+    Shader* BlockLightCubeShader = nullptr;
+    FrameConstantAllocator* Allocator = nullptr;
+    UniformBlockBuffers Buffers;
+    std::vector<FrameConstantSlice> ObjectSlices;
+    unsigned int Uploads = 0u;
+    unsigned int Binds = 0u;
+};
+
+size_t GetFrameConstantCapacity(unsigned int cubeCount)
+{
+    return GetUniformAllocationSize(sizeof(CameraConstants)) + GetUniformAllocationSize(sizeof(LightConstants))
+        + GetUniformAllocationSize(sizeof(MaterialConstants)) + GetUniformAllocationSize(sizeof(ObjectConstants), cubeCount + 4u);
+}
+
+void BindMaterialTextures(const LightingScene& scene)
+{
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, scene.DiffuseMap);
+    glActiveTexture(GL_TEXTURE1);
+    glBindTexture(GL_TEXTURE_2D, scene.SpecularMap);
+}
+
+// 原来的做法：每个光源的每个成员一次 glUniform*，每个箱子一次 uModel
+void RenderLegacy(LightingRenderer& renderer, const LightingScene& scene, const CameraConstants& cameraConstants, const LightConstants& lights,
+    const MaterialConstants& material)
+{
+    Shader& lightingShader = *renderer.LegacyShader;
+    lightingShader.Use();
+    BindMaterialTextures(scene);
+    lightingShader.SetInt("uMaterial.diffuse", 0);
+    lightingShader.SetInt("uMaterial.specular", 1);
+    lightingShader.SetFloat("uMaterial.shininess", material.Params.x);
+    lightingShader.SetVec3f("uViewPos", glm::vec3(cameraConstants.ViewPosition));
+
+    // directional light
+    lightingShader.SetVec3f("uDirLight.direction", glm::vec3(lights.DirLight.Direction));
+    lightingShader.SetVec3f("uDirLight.ambient", glm::vec3(lights.DirLight.Ambient));
+    lightingShader.SetVec3f("uDirLight.diffuse", glm::vec3(lights.DirLight.Diffuse));
+    lightingShader.SetVec3f("uDirLight.specular", glm::vec3(lights.DirLight.Specular));
+    // point lights
+    for (unsigned int i = 0; i < 4; i++)
+    {
+        std::string name = "uPointLights[" + std::to_string(i) + "].";
+        const PointLightData& light = lights.PointLights[i];
+        lightingShader.SetVec3f(name + "position", glm::vec3(light.Position));
+        lightingShader.SetVec3f(name + "ambient", glm::vec3(light.Ambient));
+        lightingShader.SetVec3f(name + "diffuse", glm::vec3(light.Diffuse));
+        lightingShader.SetVec3f(name + "specular", glm::vec3(light.Specular));
+        lightingShader.SetFloat(name + "constant", light.Attenuation.x);
+        lightingShader.SetFloat(name + "linear", light.Attenuation.y);
+        lightingShader.SetFloat(name + "quadratic", light.Attenuation.z);
+    }
+    // spotLight
+    lightingShader.SetVec3f("uSpotLight.position", glm::vec3(lights.SpotLight.Position));
+    lightingShader.SetVec3f("uSpotLight.direction", glm::vec3(lights.SpotLight.Direction));
+    lightingShader.SetVec3f("uSpotLight.ambient", glm::vec3(lights.SpotLight.Ambient));
+    lightingShader.SetVec3f("uSpotLight.diffuse", glm::vec3(lights.SpotLight.Diffuse));
+    lightingShader.SetVec3f("uSpotLight.specular", glm::vec3(lights.SpotLight.Specular));
+    lightingShader.SetFloat("uSpotLight.constant", lights.SpotLight.Attenuation.x);
+    lightingShader.SetFloat("uSpotLight.linear", lights.SpotLight.Attenuation.y);
+    lightingShader.SetFloat("uSpotLight.quadratic", lights.SpotLight.Attenuation.z);
+    lightingShader.SetFloat("uSpotLight.cutOff", lights.SpotLight.CutOff.x);
+    lightingShader.SetFloat("uSpotLight.outerCutOff", lights.SpotLight.CutOff.y);
+
+    // MVP
+    lightingShader.SetMat4f("uView", cameraConstants.View);
+    lightingShader.SetMat4f("uProjection", cameraConstants.Projection);
+    glBindVertexArray(scene.CubeVAO);
+    for (const ObjectConstants& cube : scene.Cubes)
+    {
+        lightingShader.SetMat4f("uModel", cube.Model);
+        glDrawArrays(GL_TRIANGLES, 0, 36);
+    }
+
+    // draw light
+    Shader& lightCubeShader = *renderer.LegacyLightCubeShader;
+    lightCubeShader.Use();
+    lightCubeShader.SetMat4f("uView", cameraConstants.View);
+    lightCubeShader.SetMat4f("uProjection", cameraConstants.Projection);
+    glBindVertexArray(scene.LightCubeVAO);
+    for (const ObjectConstants& lightCube : scene.LightCubes)
+    {
+        lightCubeShader.SetMat4f("uModel", lightCube.Model);
+        glDrawArrays(GL_TRIANGLES, 0, 36);
+    }
+}
+
+void UploadUniformBlock(unsigned int buffer, const void* data, size_t size)
+{
+    glBindBuffer(GL_UNIFORM_BUFFER, buffer);
+    glBufferSubData(GL_UNIFORM_BUFFER, 0, static_cast<GLsizeiptr>(size), data);
+}
+
+// 21-UniformBufferObject 的做法：每个块一个 UBO，每个箱子绘制之前 glBufferSubData 更新 Object 块
+// （上一个箱子的绘制还在使用这块内存，驱动每次都要复制一份或者等待）
+void RenderSubData(LightingRenderer& renderer, const LightingScene& scene, const CameraConstants& cameraConstants, const LightConstants& lights,
+    const MaterialConstants& material)
+{
+    const UniformBlockBuffers& buffers = renderer.Buffers;
+    UploadUniformBlock(buffers.Camera, &cameraConstants, sizeof(cameraConstants));
+    UploadUniformBlock(buffers.Lights, &lights, sizeof(lights));
+    UploadUniformBlock(buffers.Material, &material, sizeof(material));
+    renderer.Uploads += 3u;
+    glBindBufferBase(GL_UNIFORM_BUFFER, CAMERA_BINDING, buffers.Camera);
+    glBindBufferBase(GL_UNIFORM_BUFFER, LIGHTS_BINDING, buffers.Lights);
+    glBindBufferBase(GL_UNIFORM_BUFFER, MATERIAL_BINDING, buffers.Material);
+    glBindBufferBase(GL_UNIFORM_BUFFER, OBJECT_BINDING, buffers.Object);
+    renderer.Binds += 4u;
+
+    renderer.BlockShader->Use();
+    BindMaterialTextures(scene);
+    glBindVertexArray(scene.CubeVAO);
+    for (const ObjectConstants& cube : scene.Cubes)
+    {
+        UploadUniformBlock(buffers.Object, &cube, sizeof(cube));
+        glDrawArrays(GL_TRIANGLES, 0, 36);
+    }
+
+    renderer.BlockLightCubeShader->Use();
+    glBindVertexArray(scene.LightCubeVAO);
+    for (const ObjectConstants& lightCube : scene.LightCubes)
+    {
+        UploadUniformBlock(buffers.Object, &lightCube, sizeof(lightCube));
+        glDrawArrays(GL_TRIANGLES, 0, 36);
+    }
+    renderer.Uploads += static_cast<unsigned int>(scene.Cubes.size()) + 4u;
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+}
+
+// 先把这一帧所有的常量写进环形缓冲，再逐个绘制，每个箱子只需要一次 glBindBufferRange
+void RenderRing(LightingRenderer& renderer, const LightingScene& scene, const CameraConstants& cameraConstants, const LightConstants& lights,
+    const MaterialConstants& material)
+{
+    FrameConstantAllocator& allocator = *renderer.Allocator;
+    allocator.BeginFrame();
+    FrameConstantSlice cameraSlice = allocator.Push(cameraConstants);
+    FrameConstantSlice lightsSlice = allocator.Push(lights);
+    FrameConstantSlice materialSlice = allocator.Push(material);
+    std::vector<FrameConstantSlice>& objectSlices = renderer.ObjectSlices;
+    objectSlices.resize(scene.Cubes.size() + 4u);
+    for (size_t i = 0; i < scene.Cubes.size(); i++)
+        objectSlices[i] = allocator.Push(scene.Cubes[i]);
+    for (size_t i = 0; i < 4u; i++)
+        objectSlices[scene.Cubes.size() + i] = allocator.Push(scene.LightCubes[i]);
+    allocator.Submit();
+
+    allocator.Bind(CAMERA_BINDING, cameraSlice);
+    allocator.Bind(LIGHTS_BINDING, lightsSlice);
+    allocator.Bind(MATERIAL_BINDING, materialSlice);
+    renderer.BlockShader->Use();
+    BindMaterialTextures(scene);
+    glBindVertexArray(scene.CubeVAO);
+    for (size_t i = 0; i < scene.Cubes.size(); i++)
+    {
+        allocator.Bind(OBJECT_BINDING, objectSlices[i]);
+        glDrawArrays(GL_TRIANGLES, 0, 36);
+    }
+
+    renderer.BlockLightCubeShader->Use();
+    glBindVertexArray(scene.LightCubeVAO);
+    for (size_t i = 0; i < 4u; i++)
+    {
+        allocator.Bind(OBJECT_BINDING, objectSlices[scene.Cubes.size() + i]);
+        glDrawArrays(GL_TRIANGLES, 0, 36);
+    }
+    allocator.EndFrame();
+    renderer.Binds += allocator.GetBindCount();
+}
+
+void RenderScene(LightingRenderer& renderer, const LightingScene& scene, UniformMode mode)
+{
+    CameraConstants cameraConstants;
+    cameraConstants.View = camera.GetViewMatrix();
+    cameraConstants.Projection = glm::perspective(glm::radians(camera.Fov), static_cast<float>(SCREEN_WIDTH)/SCREEN_HEIGHT, 0.1f, 100.0f);
+    cameraConstants.ViewPosition = glm::vec4(camera.Position, 1.0f);
+    LightConstants lights = BuildLightConstants(scene);
+    MaterialConstants material;
+    material.Params = glm::vec4(32.0f, 0.0f, 0.0f, 0.0f);
+
+    renderer.Uploads = 0u;
+    renderer.Binds = 0u;
+    if (mode == UniformMode::Ring)
+        RenderRing(renderer, scene, cameraConstants, lights, material);
+    else if (mode == UniformMode::SubData)
+        RenderSubData(renderer, scene, cameraConstants, lights, material);
+    else
+        RenderLegacy(renderer, scene, cameraConstants, lights, material);
+}
+
+// 10、1000、10000 个箱子时三种模式每帧提交的 CPU 时间（不等待 GPU，主要是驱动的开销）、GPU 时间和 API 调用次数
+void RunUniformBenchmark(LightingRenderer& renderer, LightingScene& scene)
+{
+    const unsigned int cubeCounts[3] = { 10u, 1000u, 10000u };
+    const int ITERATIONS = 50;
+    const int WARMUP = 5;
+    std::cout << "uniform benchmark: " << ITERATIONS << " frames per row, frame constants "
+              << (renderer.Allocator->IsPersistent() ? "persistent mapped" : "unsynchronized map") << std::endl;
+    std::cout << std::setw(8) << "cubes" << std::setw(9) << "mode" << std::setw(10) << "CPU(ms)" << std::setw(10) << "GPU(ms)"
+              << std::setw(11) << "glUniform" << std::setw(9) << "uploads" << std::setw(8) << "binds" << std::endl;
+    // 每个箱子数量使用单独的分配器，等待 fence 的次数在销毁之前累加
+    unsigned int stallCount = 0u;
+    for (unsigned int cubeCount : cubeCounts)
+    {
+        BuildCubes(scene, cubeCount);
+        FrameConstantAllocator allocator(GetFrameConstantCapacity(cubeCount));
+        FrameConstantAllocator* defaultAllocator = renderer.Allocator;
+        renderer.Allocator = &allocator;
+        for (int mode = 0; mode < static_cast<int>(UniformMode::Count); mode++)
+        {
+            GpuProfiler profiler;
+            double cpuMs = 0.0;
+            unsigned int uniformCalls = 0u;
+            for (int iteration = 0; iteration < ITERATIONS + WARMUP; iteration++)
+            {
+                glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+                profiler.BeginFrame();
+                profiler.PushScope("scene");
+                Shader::GetUniformStats().Reset();
+                auto start = std::chrono::high_resolution_clock::now();
+                RenderScene(renderer, scene, static_cast<UniformMode>(mode));
+                if (iteration >= WARMUP)
+                    cpuMs += std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+                uniformCalls = Shader::GetUniformStats().Calls;
+                profiler.PopScope();
+                profiler.EndFrame();
+                profiler.Flush();
+            }
+            double gpuMs = 0.0;
+            int frames = 0;
+            for (const GpuProfiler::FrameResult &frame : profiler.GetHistory())
+            {
+                if (frame.Frame < static_cast<unsigned int>(WARMUP))
+                    continue;
+                for (const GpuProfiler::ScopeResult &scope : frame.Scopes)
+                    gpuMs += scope.TotalMs;
+                frames++;
+            }
+            frames = std::max(frames, 1);
+            std::cout << std::setw(8) << cubeCount << std::setw(9) << GetUniformModeName(static_cast<UniformMode>(mode)) << std::fixed << std::setprecision(3)
+                      << std::setw(10) << cpuMs / ITERATIONS << std::setw(10) << gpuMs / frames << std::setw(11) << uniformCalls
+                      << std::setw(9) << renderer.Uploads << std::setw(8) << renderer.Binds << std::endl;
+        }
+        renderer.Allocator = defaultAllocator;
+        stallCount += allocator.GetStallCount();
+        allocator.Destroy();
+    }
+    std::cout << "frame constant stalls: " << stallCount << std::endl;
+}
+
 int main(int argc, char** argv)
 {
+    // --uniforms=ring|subdata|legacy（U 键切换），--cubes=N（箱子数量，默认是原来的 10 个），--uniform-benchmark（输出对比结果后退出）
+    unsigned int cubeCount = 10u;
+    bool bUniformBenchmark = false;
+    for (int i = 1; i < argc; i++)
+    {
+        std::string arg = argv[i];
+        if (arg == "--uniforms=ring")
+            Mode = UniformMode::Ring;
+        else if (arg == "--uniforms=subdata")
+            Mode = UniformMode::SubData;
+        else if (arg == "--uniforms=legacy")
+            Mode = UniformMode::Legacy;
+        else if (arg.rfind("--cubes=", 0) == 0)
+            cubeCount = static_cast<unsigned int>(std::max(1, std::atoi(arg.c_str() + 8)));
+        else if (arg == "--uniform-benchmark")
+            bUniformBenchmark = true;
+    }
+
     // glfw and glad initialize
     if (!glfwInit())
         return -1;
@@ -146,6 +633,20 @@ int main(int argc, char** argv)
     // 1. shader
     Shader lightingShader("./src/13-MultipleLights/Shaders/VertexShader.glsl", "./src/13-MultipleLights/Shaders/FragmentShader.glsl");
     Shader lightCubeShader("./src/13-MultipleLights/Shaders/LightCubeVertexShader.glsl", "./src/13-MultipleLights/Shaders/LightCubeFragmentShader.glsl");
+    // 相机、光源、材质和物体矩阵都在 uniform 块里
+    Shader blockShader("./src/13-MultipleLights/Shaders/UniformBlockVertexShader.glsl", "./src/13-MultipleLights/Shaders/UniformBlockFragmentShader.glsl");
+    Shader blockLightCubeShader("./src/13-MultipleLights/Shaders/LightCubeUniformBlockVertexShader.glsl", "./src/13-MultipleLights/Shaders/LightCubeFragmentShader.glsl");
+    for (Shader* shader : { &blockShader, &blockLightCubeShader })
+    {
+        BindUniformBlock(shader->GetID(), "Camera", CAMERA_BINDING);
+        BindUniformBlock(shader->GetID(), "Object", OBJECT_BINDING);
+        BindUniformBlock(shader->GetID(), "Lights", LIGHTS_BINDING);
+        BindUniformBlock(shader->GetID(), "Material", MATERIAL_BINDING);
+    }
+    // 采样器不能放在 uniform 块里，只需要设置一次
+    blockShader.Use();
+    blockShader.SetInt("uDiffuseMap", 0);
+    blockShader.SetInt("uSpecularMap", 1);
 
     // 2. vertices data
     float vertices[] =
@@ -194,28 +695,18 @@ int main(int argc, char** argv)
         -0.5f,  0.5f, -0.5f,  0.0f,  1.0f,  0.0f,  0.0f, 1.0f
     };
 
-    glm::vec3 cubePositions[] =
-    {
-        glm::vec3( 0.0f,  0.0f,  0.0f),
-        glm::vec3( 2.0f,  5.0f, -15.0f),
-        glm::vec3(-1.5f, -2.2f, -2.5f),
-        glm::vec3(-3.8f, -2.0f, -12.3f),
-        glm::vec3( 2.4f, -0.4f, -3.5f),
-        glm::vec3(-1.7f,  3.0f, -7.5f),
-        glm::vec3( 1.3f, -2.0f, -2.5f),
-        glm::vec3( 1.5f,  2.0f, -2.5f),
-        glm::vec3( 1.5f,  0.2f, -1.5f),
-        glm::vec3(-1.3f,  1.0f, -1.5f)
-    };
-
+    LightingScene scene;
     // positions of the point lights
-    glm::vec3 pointLightPositions[] =
+    scene.PointLightPositions[0] = glm::vec3( 0.7f,  0.2f,  2.0f);
+    scene.PointLightPositions[1] = glm::vec3( 2.3f, -3.3f, -4.0f);
+    scene.PointLightPositions[2] = glm::vec3(-4.0f,  2.0f, -12.0f);
+    scene.PointLightPositions[3] = glm::vec3( 0.0f,  0.0f, -3.0f);
+    for (unsigned int i = 0; i < 4; i++)
     {
-        glm::vec3( 0.7f,  0.2f,  2.0f),
-        glm::vec3( 2.3f, -3.3f, -4.0f),
-        glm::vec3(-4.0f,  2.0f, -12.0f),
-        glm::vec3( 0.0f,  0.0f, -3.0f)
-    };
+        glm::mat4 model = glm::translate(glm::mat4(1.0f), scene.PointLightPositions[i]);
+        scene.LightCubes[i] = MakeObjectConstants(glm::scale(model, glm::vec3(0.2f)));
+    }
+    BuildCubes(scene, cubeCount);
 
     unsigned int cubeVao, vbo;
     glGenVertexArrays(1, &cubeVao);
@@ -247,6 +738,33 @@ int main(int argc, char** argv)
     unsigned int specularMap;
     diffuseMap = LoadTexture("./res/textures/container2.png");
     specularMap = LoadTexture("./res/textures/container2_specular.png");
+    scene.CubeVAO = cubeVao;
+    scene.LightCubeVAO = lightCubeVao;
+    scene.DiffuseMap = diffuseMap;
+    scene.SpecularMap = specularMap;
+
+    LightingRenderer renderer;
+    renderer.LegacyShader = &lightingShader;
+    renderer.LegacyLightCubeShader = &lightCubeShader;
+    renderer.BlockShader = &blockShader;
+    renderer.BlockLightCubeShader = &blockLightCubeShader;
+    renderer.Buffers = CreateUniformBlockBuffers();
+    FrameConstantAllocator frameConstants(GetFrameConstantCapacity(cubeCount));
+    renderer.Allocator = &frameConstants;
+
+    if (bUniformBenchmark)
+    {
+        RunUniformBenchmark(renderer, scene);
+        frameConstants.Destroy();
+        DestroyUniformBlockBuffers(renderer.Buffers);
+        glfwTerminate();
+        return 0;
+    }
+
+    std::cout << "uniforms: " << GetUniformModeName(Mode) << " (U to switch), " << cubeCount << " cubes, frame constants: "
+              << (frameConstants.IsPersistent() ? "persistent mapped" : "unsynchronized map") << ", "
+              << frameConstants.GetCapacity() << " bytes per frame" << std::endl;
+    double submitMs = 0.0;
     
     // 4. render loop
     while (!glfwWindowShouldClose(window))
@@ -254,6 +772,16 @@ int main(int argc, char** argv)
         float CurrentTime = static_cast<float>(glfwGetTime());
         DeltaTime = CurrentTime - LastFrame;
         LastFrame = CurrentTime;
+        nbFrames++;
+        if (CurrentTime - LastTitleTime >= 1.0f)
+        {
+            std::stringstream ss;
+            ss << "LearnOpenGL ( FPS: " << nbFrames << " ) uniforms: " << GetUniformModeName(Mode) << ", " << cubeCount << " cubes, submit "
+               << std::fixed << std::setprecision(3) << submitMs << " ms";
+            glfwSetWindowTitle(window, ss.str().c_str());
+            nbFrames = 0;
+            LastTitleTime += 1.0f;
+        }
 
         ProcessInput(window);
 
@@ -261,109 +789,10 @@ int main(int argc, char** argv)
         glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
-        // draw cube object
-        lightingShader.Use();
-        // active texture unit & bind texture
-        glActiveTexture(GL_TEXTURE0);
-        glBindTexture(GL_TEXTURE_2D, diffuseMap);
-        glActiveTexture(GL_TEXTURE1);
-        glBindTexture(GL_TEXTURE_2D, specularMap);
-        // set object material
-        // 设置采样器对应哪个纹理单元（漫反射贴图 & 镜面反射贴图）
-        lightingShader.SetInt("uMaterial.diffuse", 0);
-        lightingShader.SetInt("uMaterial.specular", 1);
-        lightingShader.SetFloat("uMaterial.shininess", 32.0f);
-
-        /*
-           Here we set all the uniforms for the 5/6 types of lights we have. We have to set them manually and index 
-           the proper PointLight struct in the array to set each uniform variable. This can be done more code-friendly
-           by defining light types as classes and set their values in there, or by using a more efficient uniform approach
-           by using 'Uniform buffer objects', but that is something we'll discuss in the 'Advanced GLSL' tutorial.
-        */
-        // directional light
-        lightingShader.SetVec3f("uDirLight.direction", -0.2f, -1.0f, -0.3f);
-        lightingShader.SetVec3f("uDirLight.ambient", 0.05f, 0.05f, 0.05f);
-        lightingShader.SetVec3f("uDirLight.diffuse", 0.4f, 0.4f, 0.4f);
-        lightingShader.SetVec3f("uDirLight.specular", 0.5f, 0.5f, 0.5f);
-        // point light 1
-        lightingShader.SetVec3f("uPointLights[0].position", pointLightPositions[0]);
-        lightingShader.SetVec3f("uPointLights[0].ambient", 0.05f, 0.05f, 0.05f);
-        lightingShader.SetVec3f("uPointLights[0].diffuse", 0.8f, 0.8f, 0.8f);
-        lightingShader.SetVec3f("uPointLights[0].specular", 1.0f, 1.0f, 1.0f);
-        lightingShader.SetFloat("uPointLights[0].constant", 1.0f);
-        lightingShader.SetFloat("uPointLights[0].linear", 0.09f);
-        lightingShader.SetFloat("uPointLights[0].quadratic", 0.032f);
-        // point light 2
-        lightingShader.SetVec3f("uPointLights[1].position", pointLightPositions[1]);
-        lightingShader.SetVec3f("uPointLights[1].ambient", 0.05f, 0.05f, 0.05f);
-        lightingShader.SetVec3f("uPointLights[1].diffuse", 0.8f, 0.8f, 0.8f);
-        lightingShader.SetVec3f("uPointLights[1].specular", 1.0f, 1.0f, 1.0f);
-        lightingShader.SetFloat("uPointLights[1].constant", 1.0f);
-        lightingShader.SetFloat("uPointLights[1].linear", 0.09f);
-        lightingShader.SetFloat("uPointLights[1].quadratic", 0.032f);
-        // point light 3
-        lightingShader.SetVec3f("uPointLights[2].position", pointLightPositions[2]);
-        lightingShader.SetVec3f("uPointLights[2].ambient", 0.05f, 0.05f, 0.05f);
-        lightingShader.SetVec3f("uPointLights[2].diffuse", 0.8f, 0.8f, 0.8f);
-        lightingShader.SetVec3f("uPointLights[2].specular", 1.0f, 1.0f, 1.0f);
-        lightingShader.SetFloat("uPointLights[2].constant", 1.0f);
-        lightingShader.SetFloat("uPointLights[2].linear", 0.09f);
-        lightingShader.SetFloat("uPointLights[2].quadratic", 0.032f);
-        // point light 4
-        lightingShader.SetVec3f("uPointLights[3].position", pointLightPositions[3]);
-        lightingShader.SetVec3f("uPointLights[3].ambient", 0.05f, 0.05f, 0.05f);
-        lightingShader.SetVec3f("uPointLights[3].diffuse", 0.8f, 0.8f, 0.8f);
-        lightingShader.SetVec3f("uPointLights[3].specular", 1.0f, 1.0f, 1.0f);
-        lightingShader.SetFloat("uPointLights[3].constant", 1.0f);
-        lightingShader.SetFloat("uPointLights[3].linear", 0.09f);
-        lightingShader.SetFloat("uPointLights[3].quadratic", 0.032f);
-        // spotLight
-        lightingShader.SetVec3f("uSpotLight.position", camera.Position);
-        lightingShader.SetVec3f("uSpotLight.direction", camera.Front);
-        lightingShader.SetVec3f("uSpotLight.ambient", 0.0f, 0.0f, 0.0f);
-        lightingShader.SetVec3f("uSpotLight.diffuse", 1.0f, 1.0f, 1.0f);
-        lightingShader.SetVec3f("uSpotLight.specular", 1.0f, 1.0f, 1.0f);
-        lightingShader.SetFloat("uSpotLight.constant", 1.0f);
-        lightingShader.SetFloat("uSpotLight.linear", 0.09f);
-        lightingShader.SetFloat("uSpotLight.quadratic", 0.032f);
-        lightingShader.SetFloat("uSpotLight.cutOff", glm::cos(glm::radians(12.5f)));
-        lightingShader.SetFloat("uSpotLight.outerCutOff", glm::cos(glm::radians(15.0f)));
-        
-        // MVP
-        glm::mat4 Model(1.0f);
-        glm::mat4 View = camera.GetViewMatrix();
-        glm::mat4 Projection = glm::perspective(glm::radians(camera.Fov), static_cast<float>(SCREEN_WIDTH)/SCREEN_HEIGHT, 0.1f, 100.0f);
-        lightingShader.SetMat4f("uModel", Model);
-        lightingShader.SetMat4f("uView", View);
-        lightingShader.SetMat4f("uProjection", Projection);
-
-        glBindVertexArray(cubeVao);
-        for(unsigned int i = 0; i < 10; i++)
-        {
-            Model = glm::mat4(1.0f);
-            Model = glm::translate(Model, cubePositions[i]);
-            float angle = 20.0f * i;
-            Model = glm::rotate(Model, glm::radians(angle), glm::vec3(1.0f, 0.3f, 0.5f));
-            lightingShader.SetMat4f("uModel", Model);
-
-            glDrawArrays(GL_TRIANGLES, 0, 36);
-        }
-
-        // draw light
-        lightCubeShader.Use();
-        // MVP
-        lightCubeShader.SetMat4f("uView", View);
-        lightCubeShader.SetMat4f("uProjection", Projection);
-        glBindVertexArray(lightCubeVao);
-
-        for (unsigned int i = 0; i < 4; i++)
-        {
-            Model = glm::mat4(1.0f);
-            Model = glm::translate(Model, pointLightPositions[i]);
-            Model = glm::scale(Model, glm::vec3(0.2f));
-            lightCubeShader.SetMat4f("uModel", Model);
-            glDrawArrays(GL_TRIANGLES, 0, 36);
-        }
+        // 原来每帧逐个设置 5 种光源的每个成员（一共 40 多次 glUniform*），而且 uViewPos 从来没有设置过
+        auto start = std::chrono::high_resolution_clock::now();
+        RenderScene(renderer, scene, Mode);
+        submitMs = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
 
         glfwSwapBuffers(window);
         glfwPollEvents();
@@ -373,8 +802,12 @@ int main(int argc, char** argv)
     glDeleteBuffers(1, &vbo);
     glDeleteVertexArrays(1, &cubeVao);
     glDeleteVertexArrays(1, &lightCubeVao);
+    frameConstants.Destroy();
+    DestroyUniformBlockBuffers(renderer.Buffers);
     lightingShader.DeleteShaderProgram();
-    lightingShader.DeleteShaderProgram();
+    lightCubeShader.DeleteShaderProgram();
+    blockShader.DeleteShaderProgram();
+    blockLightCubeShader.DeleteShaderProgram();
 
     glfwTerminate();
     return 0;
@@ -0,0 +1,20 @@
+#version 330 core
+layout (location = 0) in vec3 aPos;
+
+layout (std140) uniform Camera
+{
+   mat4 uView;
+   mat4 uProjection;
+   vec4 uViewPos;
+};
+
+layout (std140) uniform Object
+{
+   mat4 uModel;
+   mat4 uNormalMatrix;
+};
+
+void main()
+{
+   gl_Position = uProjection * uView * uModel * vec4(aPos, 1.0f);
+}
@@ -0,0 +1,151 @@
+#version 330 core
+
+// 和 FragmentShader.glsl 的光照相同，光源和材质放在 std140 uniform 块里
+// 每个成员都是 vec4（std140 中 vec3 按 16 字节对齐），标量放在 w 分量里，对应 Main.cpp 中的 LightConstants
+
+// 1. 方向光
+struct DirLight
+{
+   vec4 direction;
+
+   vec4 ambient;
+   vec4 diffuse;
+   vec4 specular;
+};
+
+// 2. 点光源
+struct PointLight
+{
+   vec4 position;
+   // x: constant, y: linear, z: quadratic
+   vec4 attenuation;
+
+   vec4 ambient;
+   vec4 diffuse;
+   vec4 specular;
+};
+
+// 3. 聚光灯
+struct SpotLight
+{
+   vec4 position;
+   vec4 direction;
+   // x: constant, y: linear, z: quadratic
+   vec4 attenuation;
+   // x: cutOff, y: outerCutOff
+   vec4 cutOff;
+
+   vec4 ambient;
+   vec4 diffuse;
+   vec4 specular;
+};
+
+out vec4 FragColor;
+
+in vec3 varingNormal;
+// 片段在世界空间中的位置（进行所有的光照计算）
+in vec3 varingFragPos;
+in vec2 varingTexCoords;
+
+layout (std140) uniform Camera
+{
+   mat4 uView;
+   mat4 uProjection;
+   vec4 uViewPos;
+};
+
+layout (std140) uniform Lights
+{
+   DirLight uDirLight;
+   PointLight uPointLights[4];
+   SpotLight uSpotLight;
+};
+
+// 材质：采样器不能放在 uniform 块里，仍然是普通 uniform（只需要设置一次）
+layout (std140) uniform Material
+{
+   // x: shininess
+   vec4 uMaterialParams;
+};
+uniform sampler2D uDiffuseMap;
+uniform sampler2D uSpecularMap;
+
+// 1. 计算方向光
+vec3 CalcDirLight(DirLight light, vec3 normal, vec3 viewDir, vec3 diffuseColor, vec3 specularColor)
+{
+   vec3 lightDir = normalize(-light.direction.xyz);
+   // 漫反射着色
+   float diff = max(dot(normal, lightDir), 0.0f);
+   // 镜面光着色
+   vec3 reflectDir = reflect(-lightDir, normal);
+   float spec = pow(max(dot(viewDir, reflectDir), 0.0f), uMaterialParams.x);
+
+   // 合并结果
+   vec3 ambient = light.ambient.rgb * diffuseColor;
+   vec3 diffuse = light.diffuse.rgb * diff * diffuseColor;
+   vec3 specular = light.specular.rgb * spec * specularColor;
+
+   return ambient + diffuse + specular;
+}
+
+// 2. 计算点光源
+vec3 CalcPointLight(PointLight light, vec3 normal, vec3 fragPos, vec3 viewDir, vec3 diffuseColor, vec3 specularColor)
+{
+   vec3 lightDir = normalize(light.position.xyz - fragPos);
+   // 漫反射着色
+   float diff = max(dot(normal, lightDir), 0.0);
+   // 镜面光着色
+   vec3 reflectDir = reflect(-lightDir, normal);
+   float spec = pow(max(dot(viewDir, reflectDir), 0.0), uMaterialParams.x);
+   // 衰减
+   float distance = length(light.position.xyz - fragPos);
+   float attenuation = 1.0 / (light.attenuation.x + light.attenuation.y * distance + light.attenuation.z * (distance * distance));
+   // 合并结果
+   vec3 ambient  = light.ambient.rgb  * diffuseColor;
+   vec3 diffuse  = light.diffuse.rgb  * diff * diffuseColor;
+   vec3 specular = light.specular.rgb * spec * specularColor;
+   return (ambient + diffuse + specular) * attenuation;
+}
+
+// 3. 计算聚光灯
+vec3 CalcSpotLight(SpotLight light, vec3 normal, vec3 fragPos, vec3 viewDir, vec3 diffuseColor, vec3 specularColor)
+{
+   vec3 lightDir = normalize(light.position.xyz - fragPos);
+   // 漫反射着色
+   float diff = max(dot(normal, lightDir), 0.0);
+   // 镜面光着色
+   vec3 reflectDir = reflect(-lightDir, normal);
+   float spec = pow(max(dot(viewDir, reflectDir), 0.0), uMaterialParams.x);
+   // 衰减
+   float distance = length(light.position.xyz - fragPos);
+   float attenuation = 1.0 / (light.attenuation.x + light.attenuation.y * distance + light.attenuation.z * (distance * distance));
+   // 聚光灯强度
+   float theta = dot(lightDir, normalize(-light.direction.xyz));
+   float epsilon = light.cutOff.x - light.cutOff.y;
+   float intensity = clamp((theta - light.cutOff.y) / epsilon, 0.0, 1.0);
+   // 合并结果
+   vec3 ambient = light.ambient.rgb * diffuseColor;
+   vec3 diffuse = light.diffuse.rgb * diff * diffuseColor;
+   vec3 specular = light.specular.rgb * spec * specularColor;
+   return (ambient + diffuse + specular) * attenuation * intensity;
+}
+
+void main()
+{
+   vec3 norm = normalize(varingNormal);
+   vec3 viewDir = normalize(uViewPos.xyz - varingFragPos);
+   vec3 diffuseColor = texture(uDiffuseMap, varingTexCoords).rgb;
+   vec3 specularColor = texture(uSpecularMap, varingTexCoords).rgb;
+
+   // 1. 定向光照
+   vec3 result = CalcDirLight(uDirLight, norm, viewDir, diffuseColor, specularColor);
+   // 2. 点光源
+   for (int i = 0; i < 4; i++)
+   {
+      result += CalcPointLight(uPointLights[i], norm, varingFragPos, viewDir, diffuseColor, specularColor);
+   }
+   // 3. 聚光灯
+   result += CalcSpotLight(uSpotLight, norm, varingFragPos, viewDir, diffuseColor, specularColor);
+
+   FragColor = vec4(result, 1.0f);
+}
@@ -0,0 +1,35 @@
+#version 330 core
+layout (location = 0) in vec3 aPos;
+layout (location = 1) in vec3 aNormal;
+layout (location = 2) in vec2 aTexCoords;
+
+out vec3 varingNormal;
+out vec3 varingFragPos;
+out vec2 varingTexCoords;
+
+// 每帧一次（FrameConstants.h 中的 CameraConstants）
+layout (std140) uniform Camera
+{
+   mat4 uView;
+   mat4 uProjection;
+   vec4 uViewPos;
+};
+
+// 每个物体一段，绘制前用 glBindBufferRange 切换（ObjectConstants）
+layout (std140) uniform Object
+{
+   mat4 uModel;
+   // 在 CPU 上算好，不需要每个顶点 transpose(inverse(uModel))
+   mat4 uNormalMatrix;
+};
+
+void main()
+{
+   // 片段在世界空间中的位置（进行所有的光照计算）
+   varingFragPos = vec3(uModel * vec4(aPos, 1.0f));
+   varingNormal = mat3(uNormalMatrix) * aNormal;
+   varingTexCoords = aTexCoords;
+
+   // 顶点在经过 MVP 后的位置
+   gl_Position = uProjection * uView * uModel * vec4(aPos, 1.0f);
+}
@@ -1,4 +1,5 @@
 #include <iostream>
+#include <string>
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
 #include <tool/Shader.h>
@@ -71,6 +72,13 @@ void ScrollCallback(GLFWwindow* window, double xoffset, double yoffset)
 
 int main(int argc, char** argv)
 {
+    // --textures=uncompressed 不使用 Benchmark-TextureCompression 生成的 .dds，解码原图
+    for (int i = 1; i < argc; i++)
+    {
+        if (std::string(argv[i]) == "--textures=uncompressed")
+            CompressedTexturesEnabled() = false;
+    }
+
     // glfw and glad initialize
     if (!glfwInit())
         return -1;
@@ -113,7 +121,9 @@ int main(int argc, char** argv)
     Shader ModelShader("./src/14-Model/Shaders/ModelVertexShader.glsl", "./src/14-Model/Shaders/ModelFragmentShader.glsl");
 
     // 2. Model
-    Model ourModel("./res/models/nanosuit/nanosuit.obj");
+    // 纹理在线程池中解码，模型先用占位纹理显示，渲染循环中逐帧上传
+    TextureLoader textureLoader;
+    Model ourModel("./res/models/nanosuit/nanosuit.obj", false, true, &textureLoader);
 
     // 3. vertices data
     float vertices[] =
@@ -225,6 +235,10 @@ int main(int argc, char** argv)
 
         ProcessInput(window);
 
+        // upload decoded textures (bounded per frame)
+        if (textureLoader.GetPendingCount() > 0u && textureLoader.Update() > 0u && textureLoader.GetPendingCount() == 0u)
+            textureLoader.PrintStats();
+
         // render
         glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
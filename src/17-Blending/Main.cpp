@@ -1,5 +1,12 @@
 #include <iostream>
-#include <map>
+#include <iomanip>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <algorithm>
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
 #include <tool/Shader.h>
@@ -9,6 +16,10 @@
 #include <glm/gtc/matrix_transform.hpp>
 
 #include <tool/Model.h>
+#include <tool/StreamBuffer.h>
+#include <tool/RadixSort.h>
+#include <tool/GpuProfiler.h>
+#include <tool/Random.h>
 
 const int SCREEN_WIDTH = 1280;
 const int SCREEN_HEIGHT = 720;
@@ -22,10 +33,16 @@ bool bFirstMouse{true};
 // Delta Time
 float DeltaTime{};
 float LastFrame{};
+float LastTitleTime{};
+int nbFrames{};
 
 // Light
 glm::vec3 LightPos{1.2f, 1.0f, 2.0f};
 
+// 透明窗户的绘制方式，O 键切换：Weighted Blended OIT（不排序）或者 CPU 基数排序后从远到近绘制
+bool bWeightedOIT = true;
+bool oitKeyPressed = false;
+
 void FramebufferSizeCallback(GLFWwindow* window, int width, int height)
 {
     glViewport(0u, 0u, width, height);
@@ -47,6 +64,16 @@ void ProcessInput(GLFWwindow* window)
         camera.ProcessKeyboard(UP, DeltaTime);
     if (glfwGetKey(window, GLFW_KEY_Q) == GLFW_PRESS)
         camera.ProcessKeyboard(DOWN, DeltaTime);
+
+    if (glfwGetKey(window, GLFW_KEY_O) == GLFW_PRESS && !oitKeyPressed)
+    {
+        bWeightedOIT = !bWeightedOIT;
+        oitKeyPressed = true;
+    }
+    if (glfwGetKey(window, GLFW_KEY_O) == GLFW_RELEASE)
+    {
+        oitKeyPressed = false;
+    }
 }
 
 void CursorPosCallback(GLFWwindow* window, double xpos, double ypos)
@@ -70,8 +97,375 @@ void ScrollCallback(GLFWwindow* window, double xoffset, double yoffset)
     camera.ProcessMouseScroll(yoffset);
 }
 
+
+// 合成 OIT 结果用的全屏四边形
+unsigned int quadVAO = 0;
+unsigned int quadVBO;
+void RenderQuad()
+{
+    if (quadVAO == 0)
+    {
+        float quadVertices[] = {
+            // positions
+            -1.0f,  1.0f, 0.0f,
+            -1.0f, -1.0f, 0.0f,
+             1.0f,  1.0f, 0.0f,
+             1.0f, -1.0f, 0.0f,
+        };
+        glGenVertexArrays(1, &quadVAO);
+        glGenBuffers(1, &quadVBO);
+        glBindVertexArray(quadVAO);
+        glBindBuffer(GL_ARRAY_BUFFER, quadVBO);
+        glBufferData(GL_ARRAY_BUFFER, sizeof(quadVertices), &quadVertices, GL_STATIC_DRAW);
+        glEnableVertexAttribArray(0);
+        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
+    }
+    glBindVertexArray(quadVAO);
+    glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+    glBindVertexArray(0);
+}
+
+// 不透明物体：两个立方体和地面
+struct OpaqueScene
+{
+    unsigned int CubeVAO;
+    unsigned int PlaneVAO;
+    unsigned int CubeTexture;
+    unsigned int FloorTexture;
+};
+
+void RenderOpaque(Shader& shader, const OpaqueScene& scene, const glm::mat4& view, const glm::mat4& projection)
+{
+    shader.Use();
+    shader.SetMat4f("view", view);
+    shader.SetMat4f("projection", projection);
+
+    // cubes
+    glBindVertexArray(scene.CubeVAO);
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, scene.CubeTexture);
+    glm::mat4 model = glm::mat4(1.0f);
+    model = glm::translate(model, glm::vec3(-1.0f, 0.0f, -1.0f));
+    shader.SetMat4f("model", model);
+    glDrawArrays(GL_TRIANGLES, 0, 36);
+    model = glm::mat4(1.0f);
+    model = glm::translate(model, glm::vec3(2.0f, 0.0f, 0.0f));
+    shader.SetMat4f("model", model);
+    glDrawArrays(GL_TRIANGLES, 0, 36);
+    // floor
+    glBindVertexArray(scene.PlaneVAO);
+    glBindTexture(GL_TEXTURE_2D, scene.FloorTexture);
+    shader.SetMat4f("model", glm::mat4(1.0f));
+    glDrawArrays(GL_TRIANGLES, 0, 6);
+    glBindVertexArray(0);
+}
+
+// 所有窗户用一次实例化绘制，位置放在实例缓冲里（属性 2）
+struct WindowInstances
+{
+    std::vector<glm::vec3> Positions;
+    // OIT 不需要排序，位置只上传一次
+    unsigned int StaticBuffer = 0u;
+    // 排序后的位置，每帧写流式缓冲的一段
+    StreamBuffer* SortedBuffer = nullptr;
+    std::vector<uint32_t> Keys;
+    RadixSorter<uint32_t> Sorter;
+};
+
+// 原来的 5 个窗户，再在场景周围散布 count - 5 个（数量越多范围越大）
+void BuildWindows(WindowInstances& windows, unsigned int count)
+{
+    const glm::vec3 originalWindows[5] =
+    {
+        glm::vec3(-1.5f,  0.0f, -0.48f),
+        glm::vec3( 1.5f,  0.0f,  0.51f),
+        glm::vec3( 0.0f,  0.0f,  0.7f),
+        glm::vec3(-0.3f,  0.0f, -2.3f),
+        glm::vec3( 0.5f,  0.0f, -0.6f)
+    };
+    windows.Positions.clear();
+    windows.Positions.reserve(count);
+    float extent = std::max(5.0f, 0.5f * std::cbrt(static_cast<float>(count)));
+    for (unsigned int i = 0; i < count; i++)
+    {
+        if (i < 5u)
+        {
+            windows.Positions.push_back(originalWindows[i]);
+            continue;
+        }
+        float x = (static_cast<float>(HashRandom(i, 0u) % 10000u) / 5000.0f - 1.0f) * extent;
+        float y = static_cast<float>(HashRandom(i, 1u) % 10000u) / 10000.0f * extent * 0.4f;
+        float z = (static_cast<float>(HashRandom(i, 2u) % 10000u) / 5000.0f - 1.0f) * extent;
+        windows.Positions.push_back(glm::vec3(x, y, z));
+    }
+    windows.Keys.resize(count);
+
+    glGenBuffers(1, &windows.StaticBuffer);
+    glBindBuffer(GL_ARRAY_BUFFER, windows.StaticBuffer);
+    glBufferData(GL_ARRAY_BUFFER, count * sizeof(glm::vec3), windows.Positions.data(), GL_STATIC_DRAW);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    windows.SortedBuffer = new StreamBuffer(GL_ARRAY_BUFFER, count * sizeof(glm::vec3));
+}
+
+void DestroyWindows(WindowInstances& windows)
+{
+    glDeleteBuffers(1, &windows.StaticBuffer);
+    windows.StaticBuffer = 0u;
+    if (windows.SortedBuffer != nullptr)
+    {
+        windows.SortedBuffer->Destroy();
+        delete windows.SortedBuffer;
+        windows.SortedBuffer = nullptr;
+    }
+}
+
+void DrawWindowInstances(unsigned int VAO, unsigned int buffer, size_t offset, unsigned int count)
+{
+    glBindVertexArray(VAO);
+    glBindBuffer(GL_ARRAY_BUFFER, buffer);
+    glVertexAttribPointer(2, 3, GL_FLOAT, GL_FALSE, sizeof(glm::vec3), (void*)offset);
+    glDrawArraysInstanced(GL_TRIANGLES, 0, 6, static_cast<GLsizei>(count));
+    glBindVertexArray(0);
+}
+
+// 从远到近绘制（深度测试还是需要启用），返回 CPU 排序并写入实例缓冲的时间（毫秒）
+// 用距离的平方作为 key，按位取反后升序排列就是从远到近
+double RenderSortedWindows(WindowInstances& windows, unsigned int VAO, Shader& shader, unsigned int texture,
+    const glm::mat4& view, const glm::mat4& projection, const glm::vec3& cameraPos)
+{
+    auto start = std::chrono::high_resolution_clock::now();
+    unsigned int count = static_cast<unsigned int>(windows.Positions.size());
+    for (unsigned int i = 0; i < count; i++)
+    {
+        glm::vec3 offset = windows.Positions[i] - cameraPos;
+        windows.Keys[i] = ~FloatToSortableKey(glm::dot(offset, offset));
+    }
+    const uint32_t* order = windows.Sorter.Sort(windows.Keys.data(), count);
+    glm::vec3* instances = static_cast<glm::vec3*>(windows.SortedBuffer->Map());
+    for (unsigned int i = 0; i < count; i++)
+        instances[i] = windows.Positions[order[i]];
+    windows.SortedBuffer->Unmap();
+    double sortMs = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+
+    shader.Use();
+    shader.SetMat4f("view", view);
+    shader.SetMat4f("projection", projection);
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, texture);
+    DrawWindowInstances(VAO, windows.SortedBuffer->GetID(), windows.SortedBuffer->GetOffset(), count);
+    windows.SortedBuffer->Fence();
+    return sortMs;
+}
+
+// Weighted Blended OIT 的离屏目标：累积颜色 + revealage（RGBA16F）、权重和（R16F），深度从默认帧缓冲拷贝过来
+// 深度格式要和默认帧缓冲一致（GLFW 默认 24 位深度 + 8 位模板）才能 glBlitFramebuffer
+struct WeightedOITTarget
+{
+    unsigned int FBO = 0u;
+    unsigned int AccumulationTexture = 0u;
+    unsigned int WeightTexture = 0u;
+    unsigned int DepthRBO = 0u;
+};
+
+unsigned int CreateOITTexture(GLint internalFormat, GLenum format)
+{
+    unsigned int texture;
+    glGenTextures(1, &texture);
+    glBindTexture(GL_TEXTURE_2D, texture);
+    glTexImage2D(GL_TEXTURE_2D, 0, internalFormat, SCREEN_WIDTH, SCREEN_HEIGHT, 0, format, GL_HALF_FLOAT, NULL);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    return texture;
+}
+
+void CreateWeightedOITTarget(WeightedOITTarget& target)
+{
+    glGenFramebuffers(1, &target.FBO);
+    glBindFramebuffer(GL_FRAMEBUFFER, target.FBO);
+    target.AccumulationTexture = CreateOITTexture(GL_RGBA16F, GL_RGBA);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, target.AccumulationTexture, 0);
+    target.WeightTexture = CreateOITTexture(GL_R16F, GL_RED);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT1, GL_TEXTURE_2D, target.WeightTexture, 0);
+    unsigned int attachments[2] = { GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1 };
+    glDrawBuffers(2, attachments);
+    glGenRenderbuffers(1, &target.DepthRBO);
+    glBindRenderbuffer(GL_RENDERBUFFER, target.DepthRBO);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, SCREEN_WIDTH, SCREEN_HEIGHT);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, target.DepthRBO);
+    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+        std::cout << "OIT Framebuffer not complete!" << std::endl;
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+void DestroyWeightedOITTarget(WeightedOITTarget& target)
+{
+    glDeleteFramebuffers(1, &target.FBO);
+    glDeleteTextures(1, &target.AccumulationTexture);
+    glDeleteTextures(1, &target.WeightTexture);
+    glDeleteRenderbuffers(1, &target.DepthRBO);
+}
+
+// 1. 拷贝不透明物体的深度，被挡住的透明片段不参与累积
+// 2. 累积：所有窗户一次绘制，不排序，只做深度测试不写深度
+// 3. 全屏合成到默认帧缓冲
+void RenderWeightedOIT(WindowInstances& windows, const WeightedOITTarget& target, unsigned int VAO, Shader& oitShader,
+    Shader& compositeShader, unsigned int texture, const glm::mat4& view, const glm::mat4& projection)
+{
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, 0);
+    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, target.FBO);
+    glBlitFramebuffer(0, 0, SCREEN_WIDTH, SCREEN_HEIGHT, 0, 0, SCREEN_WIDTH, SCREEN_HEIGHT, GL_DEPTH_BUFFER_BIT, GL_NEAREST);
+    glBindFramebuffer(GL_FRAMEBUFFER, target.FBO);
+    // revealage 初始为 1（完全透出背景）
+    const float clearAccumulation[4] = { 0.0f, 0.0f, 0.0f, 1.0f };
+    const float clearWeight[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+    glClearBufferfv(GL_COLOR, 0, clearAccumulation);
+    glClearBufferfv(GL_COLOR, 1, clearWeight);
+
+    glDepthMask(GL_FALSE);
+    glBlendFuncSeparate(GL_ONE, GL_ONE, GL_ZERO, GL_ONE_MINUS_SRC_ALPHA);
+    oitShader.Use();
+    oitShader.SetMat4f("view", view);
+    oitShader.SetMat4f("projection", projection);
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, texture);
+    DrawWindowInstances(VAO, windows.StaticBuffer, 0u, static_cast<unsigned int>(windows.Positions.size()));
+
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    glDisable(GL_DEPTH_TEST);
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    compositeShader.Use();
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, target.AccumulationTexture);
+    glActiveTexture(GL_TEXTURE1);
+    glBindTexture(GL_TEXTURE_2D, target.WeightTexture);
+    RenderQuad();
+    glActiveTexture(GL_TEXTURE0);
+    glEnable(GL_DEPTH_TEST);
+    glDepthMask(GL_TRUE);
+}
+
+// 读回累积结果，按 OITComposite.fs 的方式解析，统计得到 NaN / inf 的像素（半精度累积溢出后是 inf / inf）
+unsigned int CountNonFiniteOITPixels(const WeightedOITTarget& target)
+{
+    std::vector<float> accumulation(SCREEN_WIDTH * SCREEN_HEIGHT * 4);
+    std::vector<float> weights(SCREEN_WIDTH * SCREEN_HEIGHT);
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, target.FBO);
+    glReadBuffer(GL_COLOR_ATTACHMENT0);
+    glReadPixels(0, 0, SCREEN_WIDTH, SCREEN_HEIGHT, GL_RGBA, GL_FLOAT, accumulation.data());
+    glReadBuffer(GL_COLOR_ATTACHMENT1);
+    glReadPixels(0, 0, SCREEN_WIDTH, SCREEN_HEIGHT, GL_RED, GL_FLOAT, weights.data());
+    glReadBuffer(GL_COLOR_ATTACHMENT0);
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, 0);
+
+    unsigned int count = 0u;
+    for (size_t i = 0; i < weights.size(); i++)
+    {
+        float weight = std::max(weights[i], 1e-5f);
+        for (int c = 0; c < 4; c++)
+        {
+            float value = c < 3 ? accumulation[i * 4 + c] / weight : accumulation[i * 4 + c];
+            if (!std::isfinite(value))
+            {
+                count++;
+                break;
+            }
+        }
+    }
+    return count;
+}
+
+// 10、1 万、50 万个窗户，对比排序和 OIT 透明部分的 CPU（排序、写实例缓冲、提交）和 GPU 时间
+void RunOITBenchmark(Shader& shader, const OpaqueScene& scene, const WeightedOITTarget& target, unsigned int VAO,
+    Shader& sortedShader, Shader& oitShader, Shader& compositeShader, unsigned int texture)
+{
+    const unsigned int windowCounts[3] = { 10u, 10000u, 500000u };
+    const int ITERATIONS = 50;
+    const int WARMUP = 5;
+    glm::mat4 view = camera.GetViewMatrix();
+    glm::mat4 projection = glm::perspective(glm::radians(camera.Fov), (float)SCREEN_WIDTH / (float)SCREEN_HEIGHT, 0.1f, 100.0f);
+    std::cout << "transparency benchmark: " << ITERATIONS << " frames per row" << std::endl;
+    std::cout << std::setw(8) << "windows" << std::setw(8) << "mode" << std::setw(10) << "sort(ms)"
+              << std::setw(10) << "CPU(ms)" << std::setw(10) << "GPU(ms)" << std::setw(10) << "NaN/inf" << std::endl;
+    // OIT 的合成结果必须是有限值，最后一帧的累积结果读回检查
+    unsigned int totalNonFinite = 0u;
+    for (unsigned int windowCount : windowCounts)
+    {
+        WindowInstances windows;
+        BuildWindows(windows, windowCount);
+        for (int oit = 0; oit < 2; oit++)
+        {
+            GpuProfiler profiler;
+            double sortMs = 0.0;
+            double cpuMs = 0.0;
+            for (int iteration = 0; iteration < ITERATIONS + WARMUP; iteration++)
+            {
+                glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+                RenderOpaque(shader, scene, view, projection);
+                profiler.BeginFrame();
+                profiler.PushScope("transparent");
+                auto start = std::chrono::high_resolution_clock::now();
+                double frameSortMs = 0.0;
+                if (oit)
+                    RenderWeightedOIT(windows, target, VAO, oitShader, compositeShader, texture, view, projection);
+                else
+                    frameSortMs = RenderSortedWindows(windows, VAO, sortedShader, texture, view, projection, camera.Position);
+                if (iteration >= WARMUP)
+                {
+                    cpuMs += std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+                    sortMs += frameSortMs;
+                }
+                profiler.PopScope();
+                profiler.EndFrame();
+                profiler.Flush();
+            }
+            double gpuMs = 0.0;
+            int frames = 0;
+            for (const GpuProfiler::FrameResult &frame : profiler.GetHistory())
+            {
+                if (frame.Frame < static_cast<unsigned int>(WARMUP))
+                    continue;
+                for (const GpuProfiler::ScopeResult &scope : frame.Scopes)
+                    gpuMs += scope.TotalMs;
+                frames++;
+            }
+            frames = std::max(frames, 1);
+            std::cout << std::setw(8) << windowCount << std::setw(8) << (oit ? "oit" : "sorted") << std::fixed << std::setprecision(3)
+                      << std::setw(10) << sortMs / ITERATIONS << std::setw(10) << cpuMs / ITERATIONS
+                      << std::setw(10) << gpuMs / frames;
+            if (oit)
+            {
+                unsigned int nonFinite = CountNonFiniteOITPixels(target);
+                totalNonFinite += nonFinite;
+                std::cout << std::setw(10) << nonFinite << std::endl;
+            }
+            else
+                std::cout << std::setw(10) << "-" << std::endl;
+        }
+        DestroyWindows(windows);
+    }
+    std::cout << "oit resolve: " << (totalNonFinite == 0u ? "finite" : "NaN/inf pixels found") << std::endl;
+}
+
 int main(int argc, char** argv)
 {
+    // --transparency=oit|sorted（O 键切换），--windows=N（窗户数量，默认是原来的 5 个），--oit-benchmark（输出对比结果后退出）
+    unsigned int windowCount = 5u;
+    bool bOITBenchmark = false;
+    for (int i = 1; i < argc; i++)
+    {
+        std::string arg = argv[i];
+        if (arg == "--transparency=sorted")
+            bWeightedOIT = false;
+        else if (arg == "--transparency=oit")
+            bWeightedOIT = true;
+        else if (arg.rfind("--windows=", 0) == 0)
+            windowCount = static_cast<unsigned int>(std::max(1, std::atoi(arg.c_str() + 10)));
+        else if (arg == "--oit-benchmark")
+            bOITBenchmark = true;
+    }
+
     // glfw and glad initialize
     if (!glfwInit())
         return -1;
@@ -114,6 +508,9 @@ int main(int argc, char** argv)
 
     // Shader
     Shader shader("./src/17-Blending/Shaders/Blending.vs", "./src/17-Blending/Shaders/Blending.fs");
+    Shader sortedShader("./src/17-Blending/Shaders/Transparent.vs", "./src/17-Blending/Shaders/Blending.fs");
+    Shader oitShader("./src/17-Blending/Shaders/Transparent.vs", "./src/17-Blending/Shaders/WeightedOIT.fs");
+    Shader compositeShader("./src/17-Blending/Shaders/OITComposite.vs", "./src/17-Blending/Shaders/OITComposite.fs");
 
     // 顶点数据
     float cubeVertices[] =
@@ -186,14 +583,6 @@ int main(int argc, char** argv)
         1.0f,  0.5f,  0.0f,  1.0f,  0.0f
     };
 
-    // 窗户的位置
-    std::vector<glm::vec3> windows;
-    windows.push_back(glm::vec3(-1.5f,  0.0f, -0.48f));
-    windows.push_back(glm::vec3( 1.5f,  0.0f,  0.51f));
-    windows.push_back(glm::vec3( 0.0f,  0.0f,  0.7f));
-    windows.push_back(glm::vec3(-0.3f,  0.0f, -2.3f));
-    windows.push_back(glm::vec3( 0.5f,  0.0f, -0.6f));
-
     // cube VAO
     unsigned int cubeVAO, cubeVBO;
     glGenVertexArrays(1, &cubeVAO);
@@ -229,6 +618,9 @@ int main(int argc, char** argv)
     glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 5 * sizeof(float), (void*)0);
     glEnableVertexAttribArray(1);
     glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 5 * sizeof(float), (void*)(3 * sizeof(float)));
+    // 实例位置，缓冲和偏移在绘制时设置（排序和 OIT 用不同的实例缓冲）
+    glEnableVertexAttribArray(2);
+    glVertexAttribDivisor(2, 1);
     glBindVertexArray(0);
 
     // load textures
@@ -241,6 +633,31 @@ int main(int argc, char** argv)
     // --------------------
     shader.Use();
     shader.SetInt("texture1", 0);
+    sortedShader.Use();
+    sortedShader.SetInt("texture1", 0);
+    oitShader.Use();
+    oitShader.SetInt("texture1", 0);
+    compositeShader.Use();
+    compositeShader.SetInt("accumulationTexture", 0);
+    compositeShader.SetInt("weightTexture", 1);
+
+    OpaqueScene opaqueScene = { cubeVAO, planeVAO, cubeTexture, floorTexture };
+    WeightedOITTarget oitTarget;
+    CreateWeightedOITTarget(oitTarget);
+
+    if (bOITBenchmark)
+    {
+        RunOITBenchmark(shader, opaqueScene, oitTarget, transparentVAO, sortedShader, oitShader, compositeShader, transparentTexture);
+        DestroyWeightedOITTarget(oitTarget);
+        glfwTerminate();
+        return 0;
+    }
+
+    WindowInstances windows;
+    BuildWindows(windows, windowCount);
+    std::cout << "transparency: " << (bWeightedOIT ? "oit" : "sorted") << " (O to switch), " << windowCount << " windows, instance buffer: "
+              << (windows.SortedBuffer->IsPersistent() ? "persistent mapped" : "unsynchronized map") << std::endl;
+    double sortMs = 0.0;
 
     // render loop
     while (!glfwWindowShouldClose(window))
@@ -248,6 +665,18 @@ int main(int argc, char** argv)
         float CurrentTime = static_cast<float>(glfwGetTime());
         DeltaTime = CurrentTime - LastFrame;
         LastFrame = CurrentTime;
+        nbFrames++;
+        if (CurrentTime - LastTitleTime >= 1.0f)
+        {
+            std::stringstream ss;
+            ss << "LearnOpenGL ( FPS: " << nbFrames << " ) transparency: " << (bWeightedOIT ? "oit" : "sorted") << ", "
+               << windowCount << " windows";
+            if (!bWeightedOIT)
+                ss << ", sort " << std::fixed << std::setprecision(2) << sortMs << " ms";
+            glfwSetWindowTitle(window, ss.str().c_str());
+            nbFrames = 0;
+            LastTitleTime += 1.0f;
+        }
 
         ProcessInput(window);
 
@@ -255,50 +684,16 @@ int main(int argc, char** argv)
         glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
-        shader.Use();
-        glm::mat4 model = glm::mat4(1.0f);
         glm::mat4 view = camera.GetViewMatrix();
         glm::mat4 projection = glm::perspective(glm::radians(camera.Fov), (float)SCREEN_WIDTH / (float)SCREEN_HEIGHT, 0.1f, 100.0f);
-        shader.SetMat4f("view", view);
-        shader.SetMat4f("projection", projection);
-
-        // cubes
-        glBindVertexArray(cubeVAO);
-        glActiveTexture(GL_TEXTURE0);
-        glBindTexture(GL_TEXTURE_2D, cubeTexture);
-        model = glm::translate(model, glm::vec3(-1.0f, 0.0f, -1.0f));
-        shader.SetMat4f("model", model);
-        glDrawArrays(GL_TRIANGLES, 0, 36);
-        model = glm::mat4(1.0f);
-        model = glm::translate(model, glm::vec3(2.0f, 0.0f, 0.0f));
-        shader.SetMat4f("model", model);
-        glDrawArrays(GL_TRIANGLES, 0, 36);
-        // floor
-        glBindVertexArray(planeVAO);
-        glBindTexture(GL_TEXTURE_2D, floorTexture);
-        shader.SetMat4f("model", glm::mat4(1.0f));
-        glDrawArrays(GL_TRIANGLES, 0, 6);
-        glBindVertexArray(0);
-        // windows
-        // 绘制透明物体时从远到近绘制（深度测试还是需要启用）
+        RenderOpaque(shader, opaqueScene, view, projection);
 
-        // 根据窗户位置从远到近排序（排序放在渲染循环里，因为相机会移动）
-        std::map<float, glm::vec3> sorted;
-        for (unsigned int i = 0; i < windows.size(); i++)
-        {
-            float distance = glm::length(camera.Position - windows[i]);
-            sorted[distance] = windows[i];
-        }
-
-        glBindVertexArray(transparentVAO);
-        glBindTexture(GL_TEXTURE_2D, transparentTexture);
-        for (auto it = sorted.rbegin(); it != sorted.rend(); it++)
-        {
-            model = glm::mat4(1.0f);
-            model = glm::translate(model, it->second);
-            shader.SetMat4f("model", model);
-            glDrawArrays(GL_TRIANGLES, 0, 6);
-        }
+        // windows
+        // 原来每帧用 std::map<float, glm::vec3> 按距离排序再逐个绘制（距离相同的窗户会被覆盖掉，而且每个窗户一次 draw call）
+        if (bWeightedOIT)
+            RenderWeightedOIT(windows, oitTarget, transparentVAO, oitShader, compositeShader, transparentTexture, view, projection);
+        else
+            sortMs = RenderSortedWindows(windows, transparentVAO, sortedShader, transparentTexture, view, projection, camera.Position);
 
         glfwSwapBuffers(window);
         glfwPollEvents();
@@ -309,7 +704,14 @@ int main(int argc, char** argv)
     glDeleteBuffers(1, &planeVBO);
     glDeleteVertexArrays(1, &cubeVAO);
     glDeleteVertexArrays(1, &planeVAO);
+    glDeleteBuffers(1, &transparentVBO);
+    glDeleteVertexArrays(1, &transparentVAO);
+    DestroyWindows(windows);
+    DestroyWeightedOITTarget(oitTarget);
     shader.DeleteShaderProgram();
+    sortedShader.DeleteShaderProgram();
+    oitShader.DeleteShaderProgram();
+    compositeShader.DeleteShaderProgram();
 
     glfwTerminate();
     return 0;
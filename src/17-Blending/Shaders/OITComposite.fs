@@ -0,0 +1,21 @@
+#version 330 core
+// 把累积的结果混合到不透明场景上：color = 加权平均颜色，alpha = 1 - revealage
+// 配合 glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA)：result = average * (1 - revealage) + background * revealage
+out vec4 FragColor;
+
+uniform sampler2D accumulationTexture;
+uniform sampler2D weightTexture;
+
+void main()
+{
+    ivec2 coord = ivec2(gl_FragCoord.xy);
+    vec4 accumulation = texelFetch(accumulationTexture, coord, 0);
+    float revealage = accumulation.a;
+    // 没有被透明物体覆盖
+    if (revealage >= 0.999)
+        discard;
+
+    float weight = texelFetch(weightTexture, coord, 0).r;
+    vec3 average = accumulation.rgb / max(weight, 1e-5);
+    FragColor = vec4(average, 1.0 - revealage);
+}
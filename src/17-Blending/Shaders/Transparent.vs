@@ -0,0 +1,20 @@
+#version 330 core
+layout (location = 0) in vec3 aPos;
+layout (location = 1) in vec2 aTexCoords;
+// 每个实例（窗户）的位置，来自实例缓冲
+layout (location = 2) in vec3 aOffset;
+
+out vec2 TexCoords;
+// 线性的视空间深度，OIT 的深度权重使用
+out float ViewDepth;
+
+uniform mat4 view;
+uniform mat4 projection;
+
+void main()
+{
+    TexCoords = aTexCoords;
+    vec4 viewPos = view * vec4(aPos + aOffset, 1.0);
+    ViewDepth = -viewPos.z;
+    gl_Position = projection * viewPos;
+}
@@ -0,0 +1,27 @@
+#version 330 core
+// Weighted Blended OIT 的累积阶段（McGuire & Bavoil 2013），不需要排序
+// GL 3.3 没有 glBlendFunci，两个颜色附件只能共用 glBlendFuncSeparate(ONE, ONE, ZERO, ONE_MINUS_SRC_ALPHA)：
+// Accumulation.rgb 累加 color * alpha * weight，Accumulation.a 累乘 (1 - alpha)（revealage）；
+// Weight.r 累加 alpha * weight
+layout (location = 0) out vec4 Accumulation;
+layout (location = 1) out vec4 Weight;
+
+in vec2 TexCoords;
+in float ViewDepth;
+
+uniform sampler2D texture1;
+
+void main()
+{
+    vec4 color = texture(texture1, TexCoords);
+    // 完全透明的部分对结果没有贡献
+    if (color.a < 0.004)
+        discard;
+
+    // 深度权重：越近的片段权重越大，让前面的窗户在重叠时占主导
+    // 用线性视空间深度（论文公式 9），gl_FragCoord.z 在 near = 0.1、far = 100 时几乎都接近 1，权重会一直被截到上限
+    // 累积目标是半精度（最大 65504），上限取 250，256 层都取到上限也不会溢出；z = 1 时约 20，z = 10 时约 0.2
+    float weight = color.a * clamp(0.8 / (1e-5 + pow(ViewDepth / 5.0, 2.0) + pow(ViewDepth / 200.0, 6.0)), 1e-2, 250.0);
+    Accumulation = vec4(color.rgb * color.a * weight, color.a);
+    Weight = vec4(color.a * weight);
+}
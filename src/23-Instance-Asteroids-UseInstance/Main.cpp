@@ -1,5 +1,8 @@
 #include <iostream>
 #include <map>
+#include <chrono>
+#include <iomanip>
+#include <limits>
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
 #include <tool/Shader.h>
@@ -9,6 +12,11 @@
 #include <glm/gtc/matrix_transform.hpp>
 
 #include <tool/Model.h>
+#include <tool/Headless.h>
+#include <tool/InstanceBVH.h>
+#include <tool/StreamBuffer.h>
+#include <tool/JobSystem.h>
+#include <tool/Random.h>
 
 const int SCREEN_WIDTH = 1280;
 const int SCREEN_HEIGHT = 720;
@@ -111,14 +119,65 @@ unsigned int LoadCubemap(std::vector<std::string> &faces)
     return textureID;
 }
 
+// 第 i 颗小行星的变换矩阵
+glm::mat4 GenerateAsteroidMatrix(unsigned int i, unsigned int amount)
+{
+    const float radius = 50.0;
+    const float offset = 2.5f;
+    glm::mat4 model = glm::mat4(1.0f);
+    // 1. translation: displace along circle with 'radius' in range [-offset, offset]，这里是 [-2.5, 2.5]
+    float angle = (float)i / (float)amount * 360.0f;
+    float displacement = (HashRandom(i, 0u) % (int)(2 * offset * 100)) / 100.0f - offset;
+    float x = sin(angle) * radius + displacement;
+    displacement = (HashRandom(i, 1u) % (int)(2 * offset * 100)) / 100.0f - offset;
+    float y = displacement * 0.4f; // keep height of asteroid field smaller compared to width of x and z
+    displacement = (HashRandom(i, 2u) % (int)(2 * offset * 100)) / 100.0f - offset;
+    float z = cos(angle) * radius + displacement;
+    model = glm::translate(model, glm::vec3(x, y, z));
+
+    // 2. scale: Scale between 0.05 and 0.25f
+    float scale = static_cast<float>((HashRandom(i, 3u) % 20) / 100.0 + 0.05);
+    model = glm::scale(model, glm::vec3(scale));
+
+    // 3. rotation: add random rotation around a (semi)randomly picked rotation axis vector
+    float rotAngle = static_cast<float>((HashRandom(i, 4u) % 360));
+    model = glm::rotate(model, rotAngle, glm::vec3(0.4f, 0.6f, 0.8f));
+    return model;
+}
+
+// 实例矩阵属性（location 3 ~ 6）指向 buffer 中 offset 开始的位置
+// GL 3.3 没有 glDrawElementsInstancedBaseInstance，所以每帧切换流式缓冲的段时重新设置属性指针
+void SetInstanceAttributes(unsigned int VAO, unsigned int buffer, size_t offset)
+{
+    glBindVertexArray(VAO);
+    glBindBuffer(GL_ARRAY_BUFFER, buffer);
+    GLsizei vec4Size = sizeof(glm::vec4);
+    for (unsigned int column = 0; column < 4; column++)
+        glVertexAttribPointer(3 + column, 4, GL_FLOAT, GL_FALSE, 4 * vec4Size, (void*)(offset + column * vec4Size));
+    glBindVertexArray(0);
+}
+
 int main(int argc, char **argv)
 {
+    // headless mode: --headless --frames=N --capture=F1,F2 --output=DIR
+    HeadlessOptions headlessOptions = ParseHeadlessOptions(argc, argv);
+    // 小行星数量：--asteroids=N（默认 20000，可以到 1000000）
+    unsigned int amount = 20000;
+    for (int i = 1; i < argc; i++)
+    {
+        std::string arg = argv[i];
+        if (arg.rfind("--asteroids=", 0) == 0)
+            amount = static_cast<unsigned int>(std::max(1, std::atoi(arg.c_str() + 12)));
+    }
+    ConfigureHeadlessPlatform(headlessOptions);
+
     // glfw and glad initialize
     if (!glfwInit())
         return -1;
     glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
     glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
     glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+    ConfigureHeadlessWindowHints(headlessOptions);
 
     GLFWwindow *window = glfwCreateWindow(SCREEN_WIDTH, SCREEN_HEIGHT, "LearnOpenGL", nullptr, nullptr);
     if (window == nullptr)
@@ -162,58 +221,52 @@ int main(int argc, char **argv)
 
     // generate a large list of semi-random model transformation matrices
     // ------------------------------------------------------------------
-    // 绘制小行星数量
-    unsigned int amount = 20000;
-    glm::mat4* modelMatrices;
-    modelMatrices = new glm::mat4[amount];
-    srand(static_cast<unsigned int>(glfwGetTime())); // initialize random seed
-    float radius = 50.0;
-    float offset = 2.5f;
-    for (unsigned int i = 0; i < amount; i++)
+    // 每个实例的随机数只由实例序号决定（rand() 不能多线程调用），分块交给任务系统并行生成
+    JobSystem jobs;
+    std::vector<glm::mat4> modelMatrices(amount);
+    auto generateStart = std::chrono::high_resolution_clock::now();
+    jobs.ParallelFor(0u, amount, 4096u, [&modelMatrices, amount](unsigned int first, unsigned int last)
     {
-        glm::mat4 model = glm::mat4(1.0f);
-        // 1. translation: displace along circle with 'radius' in range [-offset, offset]，这里是 [-2.5, 2.5]
-        float angle = (float)i / (float)amount * 360.0f;
-        float displacement = (rand() % (int)(2 * offset * 100)) / 100.0f - offset;
-        float x = sin(angle) * radius + displacement;
-        displacement = (rand() % (int)(2 * offset * 100)) / 100.0f - offset;
-        float y = displacement * 0.4f; // keep height of asteroid field smaller compared to width of x and z
-        displacement = (rand() % (int)(2 * offset * 100)) / 100.0f - offset;
-        float z = cos(angle) * radius + displacement;
-        model = glm::translate(model, glm::vec3(x, y, z));
-
-        // 2. scale: Scale between 0.05 and 0.25f
-        float scale = static_cast<float>((rand() % 20) / 100.0 + 0.05);
-        model = glm::scale(model, glm::vec3(scale));
-
-        // 3. rotation: add random rotation around a (semi)randomly picked rotation axis vector
-        float rotAngle = static_cast<float>((rand() % 360));
-        model = glm::rotate(model, rotAngle, glm::vec3(0.4f, 0.6f, 0.8f));
-
-        // 4. now add to list of matrices
-        modelMatrices[i] = model;
+        for (unsigned int i = first; i < last; i++)
+            modelMatrices[i] = GenerateAsteroidMatrix(i, amount);
+    });
+    std::cout << "generated " << amount << " asteroid matrices on " << jobs.GetThreadCount() << " threads in "
+              << std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - generateStart).count() << " ms" << std::endl;
+
+    // 岩石模型的包围球（所有网格顶点的包围盒中心 + 最远顶点距离）
+    glm::vec3 rockMin(std::numeric_limits<float>::max()), rockMax(-std::numeric_limits<float>::max());
+    for (const Mesh& mesh : rock.Meshes)
+    {
+        for (const Vertex& vertex : mesh.Vertices)
+        {
+            rockMin = glm::min(rockMin, vertex.Position);
+            rockMax = glm::max(rockMax, vertex.Position);
+        }
+    }
+    glm::vec3 rockCenter = (rockMin + rockMax) * 0.5f;
+    float rockRadius = 0.0f;
+    for (const Mesh& mesh : rock.Meshes)
+    {
+        for (const Vertex& vertex : mesh.Vertices)
+            rockRadius = std::max(rockRadius, glm::length(vertex.Position - rockCenter));
     }
 
-    // 顶点缓冲对象
-    unsigned int buffer;
-    glGenBuffers(1, &buffer);
-    glBindBuffer(GL_ARRAY_BUFFER, buffer);
-    glBufferData(GL_ARRAY_BUFFER, amount * sizeof(glm::mat4), &modelMatrices[0], GL_STATIC_DRAW);
+    // 实例 BVH，每帧在 CPU 上做视锥体剔除，只把可见实例的矩阵写进流式缓冲
+    InstanceBVH asteroidBVH;
+    asteroidBVH.Build(modelMatrices, rockCenter, rockRadius);
+    StreamBuffer instanceBuffer(GL_ARRAY_BUFFER, amount * sizeof(glm::mat4));
+    std::cout << "asteroids: " << amount << ", BVH nodes: " << asteroidBVH.GetNodeCount()
+              << ", instance buffer: " << (instanceBuffer.IsPersistent() ? "persistent mapped" : "unsynchronized map") << std::endl;
 
     for(unsigned int i = 0; i < rock.Meshes.size(); i++)
     {
         unsigned int VAO = rock.Meshes[i].VAO;
         glBindVertexArray(VAO);
         // 顶点属性
-        GLsizei vec4Size = sizeof(glm::vec4);
         glEnableVertexAttribArray(3);
-        glVertexAttribPointer(3, 4, GL_FLOAT, GL_FALSE, 4 * vec4Size, (void*)0);
         glEnableVertexAttribArray(4);
-        glVertexAttribPointer(4, 4, GL_FLOAT, GL_FALSE, 4 * vec4Size, (void*)(vec4Size));
         glEnableVertexAttribArray(5);
-        glVertexAttribPointer(5, 4, GL_FLOAT, GL_FALSE, 4 * vec4Size, (void*)(2 * vec4Size));
         glEnableVertexAttribArray(6);
-        glVertexAttribPointer(6, 4, GL_FLOAT, GL_FALSE, 4 * vec4Size, (void*)(3 * vec4Size));
 
         glVertexAttribDivisor(3, 1);
         glVertexAttribDivisor(4, 1);
@@ -295,8 +348,14 @@ int main(int argc, char **argv)
     skyboxShader.Use();
     skyboxShader.SetInt("skybox", 0);
 
+    // scripted camera path, timings and captures for headless runs
+    HeadlessRunner headlessRunner(headlessOptions, CameraPath::Orbit(glm::vec3(0.0f, 0.0f, 0.0f), 60.0f, 20.0f, 10.0f), SCREEN_WIDTH, SCREEN_HEIGHT);
+
+    InstanceBVH::CullStats cullStats;
+    float cullMs = 0.0f;
+
     // render loop
-    while (!glfwWindowShouldClose(window))
+    while (!glfwWindowShouldClose(window) && !headlessRunner.IsFinished())
     {
         float CurrentTime = static_cast<float>(glfwGetTime());
         DeltaTime = CurrentTime - LastTime;
@@ -307,6 +366,8 @@ int main(int argc, char **argv)
             std::stringstream ss;
             ss << "LearnOpenGL ( FPS: ";
             ss << nbFrames;
+            ss << " | visible: " << cullStats.Visible << " / " << amount;
+            ss << ", cull: " << std::fixed << std::setprecision(2) << cullMs << " ms";
             ss << " )";
             glfwSetWindowTitle(window, ss.str().c_str());
             nbFrames = 0;
@@ -314,6 +375,7 @@ int main(int argc, char **argv)
         }
 
         ProcessInput(window);
+        headlessRunner.BeginFrame(camera, DeltaTime);
 
         // render
         glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
@@ -336,6 +398,14 @@ int main(int argc, char **argv)
         planetShader.SetMat4f("model", model);
         planet.Draw(planetShader);
 
+        // cull asteroids against the camera frustum and stream the visible matrices
+        auto cullStart = std::chrono::high_resolution_clock::now();
+        Frustum frustum = Frustum::FromMatrix(projection * view);
+        glm::mat4* instanceData = static_cast<glm::mat4*>(instanceBuffer.Map());
+        size_t visibleCount = asteroidBVH.Cull(frustum, instanceData, &cullStats);
+        instanceBuffer.Unmap();
+        cullMs = std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - cullStart).count();
+
         // draw meteorites
         asteroidShader.Use();
         asteroidShader.SetInt("TextureDiffuse1", 0);
@@ -343,10 +413,12 @@ int main(int argc, char **argv)
         glBindTexture(GL_TEXTURE_2D, rock.TexturesLoaded[0].ID); // note: we also made the TexturesLoaded vector public (instead of private) from the model class.
         for (unsigned int i = 0; i < rock.Meshes.size(); i++)
         {
+            SetInstanceAttributes(rock.Meshes[i].VAO, instanceBuffer.GetID(), instanceBuffer.GetOffset());
             glBindVertexArray(rock.Meshes[i].VAO);
-            glDrawElementsInstanced(GL_TRIANGLES, static_cast<unsigned int>(rock.Meshes[i].Indices.size()), GL_UNSIGNED_INT, 0, amount);
+            glDrawElementsInstanced(GL_TRIANGLES, static_cast<unsigned int>(rock.Meshes[i].Indices.size()), GL_UNSIGNED_INT, 0, static_cast<GLsizei>(visibleCount));
             glBindVertexArray(0);
         }
+        instanceBuffer.Fence();
 
         // draw skybox
         // 深度缓冲的初始值为 1.0f，从两个方面可以验证：
@@ -367,6 +439,8 @@ int main(int argc, char **argv)
         glBindVertexArray(0);
         glDepthFunc(GL_LESS);
 
+        headlessRunner.EndFrame();
+
         // swap and poll events
         glfwSwapBuffers(window);
         glfwPollEvents();
@@ -375,6 +449,9 @@ int main(int argc, char **argv)
     // clear resources
     glDeleteBuffers(1, &skyboxVBO);
     glDeleteVertexArrays(1, &skyboxVAO);
+    if (instanceBuffer.GetStallCount() > 0)
+        std::cout << "instance buffer stalls: " << instanceBuffer.GetStallCount() << std::endl;
+    instanceBuffer.Destroy();
 
     glfwTerminate();
     return 0;
@@ -1,4 +1,5 @@
 #include <iostream>
+#include <string>
 #include <map>
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
@@ -26,6 +27,10 @@ float LastFrame{};
 // Calculate FPS (number)
 int nbFrames{};
 
+// 渲染队列（R 键切换）：关闭时按原来的方式逐个调用 Model::Draw
+bool bRenderQueue{true};
+bool bRenderQueueKeyPressed{false};
+
 // Light
 glm::vec3 LightPos{1.2f, 1.0f, 2.0f};
 
@@ -50,6 +55,9 @@ void ProcessInput(GLFWwindow *window)
         camera.ProcessKeyboard(UP, DeltaTime);
     if (glfwGetKey(window, GLFW_KEY_Q) == GLFW_PRESS)
         camera.ProcessKeyboard(DOWN, DeltaTime);
+    if (glfwGetKey(window, GLFW_KEY_R) == GLFW_PRESS && !bRenderQueueKeyPressed)
+        bRenderQueue = !bRenderQueue;
+    bRenderQueueKeyPressed = glfwGetKey(window, GLFW_KEY_R) == GLFW_PRESS;
 }
 
 void CursorPosCallback(GLFWwindow *window, double xpos, double ypos)
@@ -113,6 +121,13 @@ unsigned int LoadCubemap(std::vector<std::string> &faces)
 
 int main(int argc, char **argv)
 {
+    // --render-queue=off 按场景顺序逐个绘制（每块陨石都重新绑定纹理和 VAO）
+    for (int i = 1; i < argc; i++)
+    {
+        if (std::string(argv[i]) == "--render-queue=off")
+            bRenderQueue = false;
+    }
+
     // glfw and glad initialize
     if (!glfwInit())
         return -1;
@@ -265,6 +280,11 @@ int main(int argc, char **argv)
     skyboxShader.Use();
     skyboxShader.SetInt("skybox", 0);
 
+    // 着色器的物体矩阵叫 model
+    RenderQueue renderQueue("model");
+    // 上一帧的绘制统计，显示在标题栏
+    DrawStats frameStats;
+
     // render loop
     while (!glfwWindowShouldClose(window))
     {
@@ -277,7 +297,10 @@ int main(int argc, char **argv)
             std::stringstream ss;
             ss << "LearnOpenGL ( FPS: ";
             ss << nbFrames;
-            ss << " )";
+            ss << " ) " << (bRenderQueue ? "render queue" : "Model::Draw");
+            ss << " | draws " << frameStats.Draws << ", program binds " << frameStats.ProgramBinds;
+            ss << ", VAO binds " << frameStats.VAOBinds << ", texture binds " << frameStats.TextureBinds;
+            ss << ", filtered " << frameStats.Filtered;
             glfwSetWindowTitle(window, ss.str().c_str());
             nbFrames = 0;
             LastFrame += 1.0f;
@@ -292,6 +315,7 @@ int main(int argc, char **argv)
         // configure transformation matrices
         glm::mat4 projection = glm::perspective(glm::radians(45.0f), (float)SCREEN_WIDTH / (float)SCREEN_HEIGHT, 0.1f, 1000.0f);
         glm::mat4 view = camera.GetViewMatrix();;
+        Mesh::GetDrawStats().Reset();
         shader.Use();
         shader.SetMat4f("projection", projection);
         shader.SetMat4f("view", view);
@@ -300,15 +324,28 @@ int main(int argc, char **argv)
         glm::mat4 model = glm::mat4(1.0f);
         model = glm::translate(model, glm::vec3(0.0f, -3.0f, 0.0f));
         model = glm::scale(model, glm::vec3(4.0f, 4.0f, 4.0f));
-        shader.SetMat4f("model", model);
-        planet.Draw(shader);
-
-        // draw meteorites
-        for (unsigned int i = 0; i < amount; i++)
+        if (bRenderQueue)
         {
-            shader.SetMat4f("model", modelMatrices[i]);
-            rock.Draw(shader);
-        }     
+            // 收集行星和所有陨石，排序后同一个网格的绘制连在一起，纹理和 VAO 只绑定一次，相同状态下从近到远绘制
+            renderQueue.Begin(camera.Position, camera.Front);
+            planet.Submit(renderQueue, shader, model);
+            for (unsigned int i = 0; i < amount; i++)
+                rock.Submit(renderQueue, shader, modelMatrices[i]);
+            renderQueue.Flush();
+        }
+        else
+        {
+            shader.SetMat4f("model", model);
+            planet.Draw(shader);
+
+            // draw meteorites
+            for (unsigned int i = 0; i < amount; i++)
+            {
+                shader.SetMat4f("model", modelMatrices[i]);
+                rock.Draw(shader);
+            }
+        }
+        frameStats = Mesh::GetDrawStats();
 
         // draw skybox
         // 深度缓冲的初始值为 1.0f，从两个方面可以验证：
@@ -1,5 +1,9 @@
 #include <iostream>
 #include <map>
+#include <string>
+#include <sstream>
+#include <vector>
+#include <cstdlib>
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
 #include <tool/Shader.h>
@@ -9,6 +13,8 @@
 #include <glm/gtc/matrix_transform.hpp>
 
 #include <tool/Model.h>
+#include <tool/CascadedShadowMap.h>
+#include <tool/Random.h>
 
 const int SCREEN_WIDTH = 1280;
 const int SCREEN_HEIGHT = 720;
@@ -32,6 +38,12 @@ glm::vec3 LightPos{1.2f, 1.0f, 2.0f};
 bool gammaEnabled = false;
 bool gammaKeyPressed = false;
 
+// 阴影：级联阴影（默认）或者原来固定范围的单张阴影贴图，M 键切换；C 键显示每个像素所在的级联
+bool bCascaded = true;
+bool cascadedKeyPressed = false;
+bool showCascades = false;
+bool showCascadesKeyPressed = false;
+
 void FramebufferSizeCallback(GLFWwindow *window, int width, int height)
 {
     glViewport(0u, 0u, width, height);
@@ -64,6 +76,23 @@ void ProcessInput(GLFWwindow *window)
     {
         gammaKeyPressed = false;
     }
+
+    if (glfwGetKey(window, GLFW_KEY_M) == GLFW_PRESS && !cascadedKeyPressed)
+    {
+        bCascaded = !bCascaded;
+        cascadedKeyPressed = true;
+        std::cout << "shadow: " << (bCascaded ? "cascaded" : "single") << std::endl;
+    }
+    if (glfwGetKey(window, GLFW_KEY_M) == GLFW_RELEASE)
+        cascadedKeyPressed = false;
+
+    if (glfwGetKey(window, GLFW_KEY_C) == GLFW_PRESS && !showCascadesKeyPressed)
+    {
+        showCascades = !showCascades;
+        showCascadesKeyPressed = true;
+    }
+    if (glfwGetKey(window, GLFW_KEY_C) == GLFW_RELEASE)
+        showCascadesKeyPressed = false;
 }
 
 void CursorPosCallback(GLFWwindow *window, double xpos, double ypos)
@@ -235,34 +264,103 @@ void RenderQuad()
 // -------------------
 // meshes
 unsigned int planeVAO;
-void RenderScene(const Shader &shader)
+
+// 场景中的物体：模型矩阵和世界空间 AABB（每个级联剔除投射体时使用）
+struct SceneObject
+{
+    glm::mat4 Model;
+    glm::vec3 Min;
+    glm::vec3 Max;
+    bool bPlane;
+};
+std::vector<SceneObject> SceneObjects;
+
+void AddSceneObject(const glm::mat4& model, bool bPlane)
 {
-    // floor
+    // 地面是 y = -0.5 的 50x50 平面，立方体是 [-1, 1]³
+    glm::vec3 localMin = bPlane ? glm::vec3(-25.0f, -0.5f, -25.0f) : glm::vec3(-1.0f);
+    glm::vec3 localMax = bPlane ? glm::vec3(25.0f, -0.5f, 25.0f) : glm::vec3(1.0f);
+    SceneObject object{ model, glm::vec3(1e30f), glm::vec3(-1e30f), bPlane };
+    for (int i = 0; i < 8; i++)
+    {
+        glm::vec3 corner((i & 1) ? localMax.x : localMin.x, (i & 2) ? localMax.y : localMin.y, (i & 4) ? localMax.z : localMin.z);
+        glm::vec3 world = glm::vec3(model * glm::vec4(corner, 1.0f));
+        object.Min = glm::min(object.Min, world);
+        object.Max = glm::max(object.Max, world);
+    }
+    SceneObjects.push_back(object);
+}
+
+// 原来的地面和 3 个立方体，再在整个地面上散布 extraCubes 个柱子（原来 ±10 的光源视锥体覆盖不到）
+void BuildScene(unsigned int extraCubes)
+{
+    AddSceneObject(glm::mat4(1.0f), true);
     glm::mat4 model = glm::mat4(1.0f);
-    shader.SetMat4f("model", model);
-    glBindVertexArray(planeVAO);
-    glDrawArrays(GL_TRIANGLES, 0, 6);
-    // cube
-    model = glm::mat4(1.0f);
     model = glm::translate(model, glm::vec3(0.0f, 1.5f, 0.0));
     model = glm::scale(model, glm::vec3(0.5f));
-    shader.SetMat4f("model", model);
-    RenderCube();
+    AddSceneObject(model, false);
     model = glm::mat4(1.0f);
     model = glm::translate(model, glm::vec3(2.0f, 0.0f, 1.0));
     model = glm::scale(model, glm::vec3(0.5f));
-    shader.SetMat4f("model", model);
-    RenderCube();
+    AddSceneObject(model, false);
     model = glm::mat4(1.0f);
     model = glm::translate(model, glm::vec3(-1.0f, 0.0f, 2.0));
     model = glm::rotate(model, glm::radians(60.0f), glm::normalize(glm::vec3(1.0, 0.0, 1.0)));
     model = glm::scale(model, glm::vec3(0.25));
-    shader.SetMat4f("model", model);
-    RenderCube();
+    AddSceneObject(model, false);
+
+    for (unsigned int i = 0; i < extraCubes; i++)
+    {
+        float x = static_cast<float>(HashRandom(i, 0u) % 4600u) / 100.0f - 23.0f;
+        float z = static_cast<float>(HashRandom(i, 1u) % 4600u) / 100.0f - 23.0f;
+        float height = 0.5f + static_cast<float>(HashRandom(i, 2u) % 250u) / 100.0f;
+        model = glm::mat4(1.0f);
+        model = glm::translate(model, glm::vec3(x, height - 0.5f, z));
+        model = glm::rotate(model, glm::radians(static_cast<float>(HashRandom(i, 3u) % 90u)), glm::vec3(0.0f, 1.0f, 0.0f));
+        model = glm::scale(model, glm::vec3(0.3f, height, 0.3f));
+        AddSceneObject(model, false);
+    }
+}
+
+void RenderObject(const Shader &shader, const SceneObject &object)
+{
+    shader.SetMat4f("model", object.Model);
+    if (object.bPlane)
+    {
+        glBindVertexArray(planeVAO);
+        glDrawArrays(GL_TRIANGLES, 0, 6);
+    }
+    else
+        RenderCube();
+}
+
+void RenderScene(const Shader &shader)
+{
+    for (const SceneObject &object : SceneObjects)
+        RenderObject(shader, object);
 }
 
 int main(int argc, char **argv)
 {
+    unsigned int cascadeCount = 4u;
+    unsigned int cascadeResolution = 2048u;
+    unsigned int extraCubes = 64u;
+    float shadowDistance = 50.0f;
+    for (int i = 1; i < argc; i++)
+    {
+        std::string arg = argv[i];
+        if (arg == "--shadow=single")
+            bCascaded = false;
+        else if (arg.rfind("--cascades=", 0) == 0)
+            cascadeCount = static_cast<unsigned int>(std::max(1, std::atoi(arg.c_str() + 11)));
+        else if (arg.rfind("--shadow-resolution=", 0) == 0)
+            cascadeResolution = static_cast<unsigned int>(std::max(64, std::atoi(arg.c_str() + 20)));
+        else if (arg.rfind("--shadow-distance=", 0) == 0)
+            shadowDistance = std::max(1.0f, static_cast<float>(std::atof(arg.c_str() + 18)));
+        else if (arg.rfind("--cubes=", 0) == 0)
+            extraCubes = static_cast<unsigned int>(std::max(0, std::atoi(arg.c_str() + 8)));
+    }
+
     // glfw and glad initialize
     if (!glfwInit())
         return -1;
@@ -305,6 +403,7 @@ int main(int argc, char **argv)
     // Shader
     Shader shader("./src/27-ShadowMapping-2-RenderShadow/Shaders/shadow_mapping.vs", "./src/27-ShadowMapping-2-RenderShadow/Shaders/shadow_mapping.fs");
     Shader simpleDepthShader("./src/27-ShadowMapping-2-RenderShadow/Shaders/shadow_mapping_depth.vs", "./src/27-ShadowMapping-2-RenderShadow/Shaders/shadow_mapping_depth.fs");
+    Shader csmShader("./src/27-ShadowMapping-2-RenderShadow/Shaders/csm.vs", "./src/27-ShadowMapping-2-RenderShadow/Shaders/csm.fs");
     Shader debugDepthShader("./src/27-ShadowMapping-2-RenderShadow/Shaders/debug_quad.vs", "./src/27-ShadowMapping-2-RenderShadow/Shaders/debug_quad.fs");
 
     // set up vertex data (and buffer(s)) and configure vertex attributes
@@ -332,6 +431,7 @@ int main(int argc, char **argv)
     glEnableVertexAttribArray(2);
     glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void *)(6 * sizeof(float)));
     glBindVertexArray(0);
+    BuildScene(extraCubes);
 
     // load textures
     // -------------
@@ -367,11 +467,23 @@ int main(int argc, char **argv)
     glReadBuffer(GL_NONE);
     glBindFramebuffer(GL_FRAMEBUFFER, 0);
 
+    // 级联阴影：所有级联在一张深度纹理数组中
+    CascadedShadowMap cascadedShadowMap(cascadeResolution, cascadeCount);
+    CascadedShadowMap::Uniforms cascadeUniforms = CascadedShadowMap::GetUniforms(csmShader);
+    cascadedShadowMap.SetShadowDistance(shadowDistance);
+    std::cout << "shadow: " << (bCascaded ? "cascaded" : "single") << " (M to toggle, C to show cascades), "
+              << cascadedShadowMap.GetCascadeCount() << " cascades " << cascadeResolution << "x" << cascadeResolution
+              << ", distance " << shadowDistance << ", " << SceneObjects.size() << " objects" << std::endl;
+    unsigned int casterDraws[CascadedShadowMap::MaxCascades] = {};
+
     // shader configuration
     // --------------------
     shader.Use();
     shader.SetInt("diffuseTexture", 0);
     shader.SetInt("shadowMap", 1);
+    csmShader.Use();
+    csmShader.SetInt("diffuseTexture", 0);
+    csmShader.SetFloat("cascadeBlend", 0.1f);
     debugDepthShader.Use();
     debugDepthShader.SetInt("depthMap", 0);
     // lighting info
@@ -391,6 +503,14 @@ int main(int argc, char **argv)
             ss << "LearnOpenGL ( FPS: ";
             ss << nbFrames;
             ss << " )";
+            if (bCascaded)
+            {
+                // 每个级联实际画的投射体数量
+                ss << " casters:";
+                for (unsigned int i = 0; i < cascadedShadowMap.GetCascadeCount(); i++)
+                    ss << (i == 0 ? " " : "/") << casterDraws[i];
+                ss << " of " << SceneObjects.size();
+            }
             glfwSetWindowTitle(window, ss.str().c_str());
             nbFrames = 0;
             LastFrame += 1.0f;
@@ -402,61 +522,102 @@ int main(int argc, char **argv)
         glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
-        // 1. render depth of scene to texture (from light's perspective)
-        // --------------------------------------------------------------
-        glm::mat4 lightProjection, lightView;
-        glm::mat4 lightSpaceMatrix;
-        float near_plane = 1.0f, far_plane = 7.5f;
-        // 注意这里是正交（模拟平行光）
-        lightProjection = glm::ortho(-10.0f, 10.0f, -10.0f, 10.0f, near_plane, far_plane);
-        lightView = glm::lookAt(LightPos, glm::vec3(0.0f), glm::vec3(0.0, 1.0, 0.0));
-        // 用来转移到光空间的矩阵
-        lightSpaceMatrix = lightProjection * lightView;
-        // render scene from light's point of view
-        simpleDepthShader.Use();
-        simpleDepthShader.SetMat4f("lightSpaceMatrix", lightSpaceMatrix);
-
-        glViewport(0, 0, SHADOW_WIDTH, SHADOW_HEIGHT);
-        glBindFramebuffer(GL_FRAMEBUFFER, depthMapFBO);
-        glClear(GL_DEPTH_BUFFER_BIT);
-        glActiveTexture(GL_TEXTURE0);
-        glBindTexture(GL_TEXTURE_2D, woodTexture);
-        // 修复悬浮阴影，默认是剔除背面，测试 bias 值为 0.1，不过正常使用 bias 不会这么大，一般不会出现这样的问题
-        // glEnable(GL_CULL_FACE);
-        // glCullFace(GL_FRONT);
-        RenderScene(simpleDepthShader);
-        // glCullFace(GL_BACK); // 不要忘记设回原先的culling face
-        glBindFramebuffer(GL_FRAMEBUFFER, 0);
-
-        // reset viewport
-        glViewport(0, 0, SCREEN_WIDTH, SCREEN_HEIGHT);
-        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-
-        // 2. render scene as normal using the generated depth/shadow map  
-        // --------------------------------------------------------------
-        shader.Use();
         glm::mat4 projection = glm::perspective(glm::radians(camera.Fov), (float)SCREEN_WIDTH / (float)SCREEN_HEIGHT, 0.1f, 100.0f);
         glm::mat4 view = camera.GetViewMatrix();
-        shader.SetMat4f("projection", projection);
-        shader.SetMat4f("view", view);
-        // set light uniforms
-        shader.SetVec3f("viewPos", camera.Position);
-        shader.SetVec3f("lightPos", LightPos);
-        shader.SetMat4f("lightSpaceMatrix", lightSpaceMatrix);
-        glActiveTexture(GL_TEXTURE0);
-        glBindTexture(GL_TEXTURE_2D, woodTexture);
-        glActiveTexture(GL_TEXTURE1);
-        glBindTexture(GL_TEXTURE_2D, depthMap);
-        RenderScene(shader);
-
-        // render Depth map to quad for visual debugging
-        // ---------------------------------------------
-        debugDepthShader.Use();
-        debugDepthShader.SetFloat("near_plane", near_plane);
-        debugDepthShader.SetFloat("far_plane", far_plane);
-        glActiveTexture(GL_TEXTURE0);
-        glBindTexture(GL_TEXTURE_2D, depthMap);
-        // RenderQuad();
+        // 平行光从 LightPos 照向原点
+        glm::vec3 lightDirection = glm::normalize(-LightPos);
+        if (bCascaded)
+        {
+            // 1. 每个级联只画和它的光源视锥体相交的投射体
+            // --------------------------------------------------------------
+            cascadedShadowMap.Update(view, camera.Fov, (float)SCREEN_WIDTH / (float)SCREEN_HEIGHT, 0.1f, lightDirection);
+            simpleDepthShader.Use();
+            for (unsigned int c = 0; c < cascadedShadowMap.GetCascadeCount(); c++)
+            {
+                cascadedShadowMap.BeginCascade(c);
+                simpleDepthShader.SetMat4f("lightSpaceMatrix", cascadedShadowMap.GetLightSpaceMatrix(c));
+                casterDraws[c] = 0;
+                for (const SceneObject &object : SceneObjects)
+                {
+                    if (!cascadedShadowMap.IsCasterVisible(c, object.Min, object.Max))
+                        continue;
+                    RenderObject(simpleDepthShader, object);
+                    casterDraws[c]++;
+                }
+            }
+            cascadedShadowMap.End();
+
+            // 2. 按观察空间深度选择级联，硬件 PCF + 级联之间混合
+            // --------------------------------------------------------------
+            glViewport(0, 0, SCREEN_WIDTH, SCREEN_HEIGHT);
+            glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+            csmShader.Use();
+            csmShader.SetMat4f("projection", projection);
+            csmShader.SetMat4f("view", view);
+            csmShader.SetVec3f("viewPos", camera.Position);
+            csmShader.SetVec3f("lightDirection", lightDirection);
+            csmShader.SetInt("showCascades", showCascades ? 1 : 0);
+            cascadedShadowMap.Bind(csmShader, cascadeUniforms, 1u);
+            glActiveTexture(GL_TEXTURE0);
+            glBindTexture(GL_TEXTURE_2D, woodTexture);
+            RenderScene(csmShader);
+        }
+        else
+        {
+            // 1. render depth of scene to texture (from light's perspective)
+            // --------------------------------------------------------------
+            glm::mat4 lightProjection, lightView;
+            glm::mat4 lightSpaceMatrix;
+            float near_plane = 1.0f, far_plane = 7.5f;
+            // 注意这里是正交（模拟平行光）
+            lightProjection = glm::ortho(-10.0f, 10.0f, -10.0f, 10.0f, near_plane, far_plane);
+            lightView = glm::lookAt(LightPos, glm::vec3(0.0f), glm::vec3(0.0, 1.0, 0.0));
+            // 用来转移到光空间的矩阵
+            lightSpaceMatrix = lightProjection * lightView;
+            // render scene from light's point of view
+            simpleDepthShader.Use();
+            simpleDepthShader.SetMat4f("lightSpaceMatrix", lightSpaceMatrix);
+
+            glViewport(0, 0, SHADOW_WIDTH, SHADOW_HEIGHT);
+            glBindFramebuffer(GL_FRAMEBUFFER, depthMapFBO);
+            glClear(GL_DEPTH_BUFFER_BIT);
+            glActiveTexture(GL_TEXTURE0);
+            glBindTexture(GL_TEXTURE_2D, woodTexture);
+            // 修复悬浮阴影，默认是剔除背面，测试 bias 值为 0.1，不过正常使用 bias 不会这么大，一般不会出现这样的问题
+            // glEnable(GL_CULL_FACE);
+            // glCullFace(GL_FRONT);
+            RenderScene(simpleDepthShader);
+            // glCullFace(GL_BACK); // 不要忘记设回原先的culling face
+            glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+            // reset viewport
+            glViewport(0, 0, SCREEN_WIDTH, SCREEN_HEIGHT);
+            glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+            // 2. render scene as normal using the generated depth/shadow map  
+            // --------------------------------------------------------------
+            shader.Use();
+            shader.SetMat4f("projection", projection);
+            shader.SetMat4f("view", view);
+            // set light uniforms
+            shader.SetVec3f("viewPos", camera.Position);
+            shader.SetVec3f("lightPos", LightPos);
+            shader.SetMat4f("lightSpaceMatrix", lightSpaceMatrix);
+            glActiveTexture(GL_TEXTURE0);
+            glBindTexture(GL_TEXTURE_2D, woodTexture);
+            glActiveTexture(GL_TEXTURE1);
+            glBindTexture(GL_TEXTURE_2D, depthMap);
+            RenderScene(shader);
+
+            // render Depth map to quad for visual debugging
+            // ---------------------------------------------
+            debugDepthShader.Use();
+            debugDepthShader.SetFloat("near_plane", near_plane);
+            debugDepthShader.SetFloat("far_plane", far_plane);
+            glActiveTexture(GL_TEXTURE0);
+            glBindTexture(GL_TEXTURE_2D, depthMap);
+            // RenderQuad();
+        }
 
         // swap and poll events
         glfwSwapBuffers(window);
@@ -470,6 +631,7 @@ int main(int argc, char **argv)
     glDeleteVertexArrays(1, &planeVAO);
     glDeleteVertexArrays(1, &cubeVAO);
     glDeleteVertexArrays(1, &quadVAO);
+    cascadedShadowMap.Destroy();
 
     glfwTerminate();
     return 0;
@@ -0,0 +1,108 @@
+#version 330 core
+out vec4 FragColor;
+
+in VS_OUT {
+    vec3 FragPos;
+    vec3 Normal;
+    vec2 TexCoords;
+    float ViewDepth;
+} fs_in;
+
+const int MAX_CASCADES = 4;
+// 沿法线偏移几个 texel 再投影到阴影贴图（normal offset），代替固定的深度偏移，每个级联的 texel 大小不同
+const float NORMAL_OFFSET = 1.5;
+
+uniform sampler2D diffuseTexture;
+// 所有级联放在一张深度纹理数组里，比较模式打开，texture() 返回双线性过滤后的比较结果（硬件 PCF）
+uniform sampler2DArrayShadow shadowMap;
+
+uniform mat4 lightSpaceMatrices[MAX_CASCADES];
+uniform float cascadeSplits[MAX_CASCADES];
+uniform float cascadeTexelSizes[MAX_CASCADES];
+uniform int cascadeCount;
+// 每个级联最后这一部分和下一个级联混合，消除级联之间的接缝
+uniform float cascadeBlend;
+uniform bool showCascades;
+
+uniform vec3 lightDirection;
+uniform vec3 viewPos;
+
+// 在第 cascade 个级联中的阴影（0 没有阴影，1 完全在阴影中）
+float SampleCascade(int cascade, vec3 normal)
+{
+    vec3 offsetPos = fs_in.FragPos + normal * cascadeTexelSizes[cascade] * NORMAL_OFFSET;
+    // 正交投影，w = 1
+    vec3 projCoords = (lightSpaceMatrices[cascade] * vec4(offsetPos, 1.0)).xyz * 0.5 + 0.5;
+
+    // 3x3 次硬件 PCF（每次 2x2 个 texel），覆盖 4x4 个 texel
+    vec2 texelSize = 1.0 / vec2(textureSize(shadowMap, 0).xy);
+    float lit = 0.0;
+    for (int x = -1; x <= 1; ++x)
+    {
+        for (int y = -1; y <= 1; ++y)
+            lit += texture(shadowMap, vec4(projCoords.xy + vec2(x, y) * texelSize, float(cascade), projCoords.z));
+    }
+    return 1.0 - lit / 9.0;
+}
+
+float ShadowCalculation(vec3 normal, out int cascade)
+{
+    cascade = cascadeCount;
+    for (int i = 0; i < cascadeCount; ++i)
+    {
+        if (fs_in.ViewDepth < cascadeSplits[i])
+        {
+            cascade = i;
+            break;
+        }
+    }
+    // 超出阴影距离
+    if (cascade == cascadeCount)
+        return 0.0;
+
+    float shadow = SampleCascade(cascade, normal);
+    float splitStart = cascade == 0 ? 0.0 : cascadeSplits[cascade - 1];
+    float blendStart = cascadeSplits[cascade] - (cascadeSplits[cascade] - splitStart) * cascadeBlend;
+    if (fs_in.ViewDepth > blendStart)
+    {
+        float t = (fs_in.ViewDepth - blendStart) / (cascadeSplits[cascade] - blendStart);
+        // 最后一个级联淡出到没有阴影
+        float next = cascade + 1 < cascadeCount ? SampleCascade(cascade + 1, normal) : 0.0;
+        shadow = mix(shadow, next, t);
+    }
+    return shadow;
+}
+
+void main()
+{           
+    vec3 color = texture(diffuseTexture, fs_in.TexCoords).rgb;
+    vec3 normal = normalize(fs_in.Normal);
+    vec3 lightColor = vec3(0.3);
+    // ambient
+    vec3 ambient = 0.3 * lightColor;
+    // diffuse
+    vec3 lightDir = normalize(-lightDirection);
+    float diff = max(dot(lightDir, normal), 0.0);
+    vec3 diffuse = diff * lightColor;
+    // specular
+    vec3 viewDir = normalize(viewPos - fs_in.FragPos);
+    vec3 halfwayDir = normalize(lightDir + viewDir);  
+    float spec = pow(max(dot(normal, halfwayDir), 0.0), 64.0);
+    vec3 specular = spec * lightColor;    
+    // calculate shadow
+    int cascade;
+    float shadow = ShadowCalculation(normal, cascade);
+    vec3 lighting = (ambient + (1.0 - shadow) * (diffuse + specular)) * color;
+
+    // 调试：每个级联染上不同的颜色
+    if (showCascades && cascade < cascadeCount)
+    {
+        const vec3 CASCADE_COLORS[MAX_CASCADES] = vec3[](vec3(1.0, 0.3, 0.3), vec3(0.3, 1.0, 0.3), vec3(0.3, 0.3, 1.0), vec3(1.0, 1.0, 0.3));
+        lighting *= CASCADE_COLORS[cascade];
+    }
+
+    // gamma 校正
+    lighting = pow(lighting, vec3(1.0/2.2));
+    
+    FragColor = vec4(lighting, 1.0);
+}
@@ -1,5 +1,11 @@
 #include <iostream>
+#include <iomanip>
 #include <map>
+#include <string>
+#include <sstream>
+#include <vector>
+#include <chrono>
+#include <cstdlib>
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
 #include <tool/Shader.h>
@@ -9,6 +15,10 @@
 #include <glm/gtc/matrix_transform.hpp>
 
 #include <tool/Model.h>
+#include <tool/OmniShadowMap.h>
+#include <tool/ShadowAtlas.h>
+#include <tool/GpuProfiler.h>
+#include <tool/Random.h>
 
 const int SCREEN_WIDTH = 1280;
 const int SCREEN_HEIGHT = 720;
@@ -33,6 +43,26 @@ glm::vec3 LightPos{1.2f, 1.0f, 2.0f};
 bool bShadow = true;
 bool shadowKeyPressed = false;
 
+// 阴影贴图的渲染方式，M 键切换（跳过驱动不支持的方式）
+OmniShadowMode shadowMode = OmniShadowMode::VertexLayer;
+bool shadowModeKeyPressed = false;
+bool bVertexLayerSupported = false;
+
+// 多个光源共享的缓存阴影图集，K 键开关；P 键移动一个静态投射体（只重画受影响的面）
+bool bShadowAtlas = false;
+bool shadowAtlasKeyPressed = false;
+bool bMoveStaticCaster = false;
+bool moveCasterKeyPressed = false;
+
+OmniShadowMode GetNextShadowMode(OmniShadowMode mode)
+{
+    int count = static_cast<int>(OmniShadowMode::Count);
+    OmniShadowMode next = static_cast<OmniShadowMode>((static_cast<int>(mode) + 1) % count);
+    if (next == OmniShadowMode::VertexLayer && !bVertexLayerSupported)
+        next = static_cast<OmniShadowMode>((static_cast<int>(next) + 1) % count);
+    return next;
+}
+
 void FramebufferSizeCallback(GLFWwindow *window, int width, int height)
 {
     glViewport(0u, 0u, width, height);
@@ -65,6 +95,32 @@ void ProcessInput(GLFWwindow *window)
     {
         shadowKeyPressed = false;
     }
+
+    if (glfwGetKey(window, GLFW_KEY_M) == GLFW_PRESS && !shadowModeKeyPressed)
+    {
+        shadowMode = GetNextShadowMode(shadowMode);
+        shadowModeKeyPressed = true;
+        std::cout << "shadow: " << GetOmniShadowModeName(shadowMode) << std::endl;
+    }
+    if (glfwGetKey(window, GLFW_KEY_M) == GLFW_RELEASE)
+        shadowModeKeyPressed = false;
+
+    if (glfwGetKey(window, GLFW_KEY_K) == GLFW_PRESS && !shadowAtlasKeyPressed)
+    {
+        bShadowAtlas = !bShadowAtlas;
+        shadowAtlasKeyPressed = true;
+        std::cout << "shadow atlas: " << (bShadowAtlas ? "on" : "off") << std::endl;
+    }
+    if (glfwGetKey(window, GLFW_KEY_K) == GLFW_RELEASE)
+        shadowAtlasKeyPressed = false;
+
+    if (glfwGetKey(window, GLFW_KEY_P) == GLFW_PRESS && !moveCasterKeyPressed)
+    {
+        bMoveStaticCaster = true;
+        moveCasterKeyPressed = true;
+    }
+    if (glfwGetKey(window, GLFW_KEY_P) == GLFW_RELEASE)
+        moveCasterKeyPressed = false;
 }
 
 void CursorPosCallback(GLFWwindow *window, double xpos, double ypos)
@@ -130,7 +186,7 @@ unsigned int LoadCubemap(std::vector<std::string> &faces)
 // -------------------------------------------------
 unsigned int cubeVAO = 0;
 unsigned int cubeVBO = 0;
-void RenderCube()
+void RenderCube(GLsizei instanceCount = 1)
 {
     // initialize (if necessary)
     if (cubeVAO == 0)
@@ -197,7 +253,10 @@ void RenderCube()
     }
     // render Cube
     glBindVertexArray(cubeVAO);
-    glDrawArrays(GL_TRIANGLES, 0, 36);
+    if (instanceCount == 1)
+        glDrawArrays(GL_TRIANGLES, 0, 36);
+    else
+        glDrawArraysInstanced(GL_TRIANGLES, 0, 36, instanceCount);
     glBindVertexArray(0);
 }
 
@@ -236,48 +295,581 @@ void RenderQuad()
 // -------------------
 // meshes
 unsigned int planeVAO;
-void RenderScene(const Shader &shader)
+
+const unsigned int CUBE_TRIANGLES = 12u;
+
+// 阴影投射体：模型矩阵和世界空间 AABB（CPU 按光源范围、立方体贴图的面、抛物面的半球剔除）
+// 房间本身不在其中：光源在凸的房间内部，房间的墙不会挡住房间的任何部分
+struct SceneObject
 {
-    // room cube
+    glm::mat4 Model;
+    glm::vec3 Min;
+    glm::vec3 Max;
+};
+std::vector<SceneObject> ShadowCasters;
+// 每帧都在运动的投射体（阴影图集中叠加在静态缓存之上）
+std::vector<SceneObject> DynamicCasters;
+
+void UpdateBounds(SceneObject &object)
+{
+    object.Min = glm::vec3(1e30f);
+    object.Max = glm::vec3(-1e30f);
+    for (int i = 0; i < 8; i++)
+    {
+        glm::vec3 corner((i & 1) ? 1.0f : -1.0f, (i & 2) ? 1.0f : -1.0f, (i & 4) ? 1.0f : -1.0f);
+        glm::vec3 world = glm::vec3(object.Model * glm::vec4(corner, 1.0f));
+        object.Min = glm::min(object.Min, world);
+        object.Max = glm::max(object.Max, world);
+    }
+}
+
+void AddShadowCaster(std::vector<SceneObject> &casters, const glm::mat4 &model)
+{
+    SceneObject object{ model, glm::vec3(0.0f), glm::vec3(0.0f) };
+    UpdateBounds(object);
+    casters.push_back(object);
+}
+
+// 原来的 5 个立方体，再在房间里散布 extraCubes 个小立方体（避开光源附近）
+void BuildShadowCasters(std::vector<SceneObject> &casters, unsigned int extraCubes)
+{
+    casters.clear();
     glm::mat4 model = glm::mat4(1.0f);
-    model = glm::scale(model, glm::vec3(5.0f));
-    shader.SetMat4f("model", model);
-    glDisable(GL_CULL_FACE); // note that we disable culling here since we render 'inside' the cube instead of the usual 'outside' which throws off the normal culling methods.
-    shader.SetInt("reverse_normals", 1); // 在从内部绘制立方体时反转法线的小技巧，使照明仍然有效。
-    RenderCube();
-    shader.SetInt("reverse_normals", 0); // and of course disable it
-    glEnable(GL_CULL_FACE);
-    // cubes
-    model = glm::mat4(1.0f);
     model = glm::translate(model, glm::vec3(4.0f, -3.5f, 0.0));
     model = glm::scale(model, glm::vec3(0.5f));
-    shader.SetMat4f("model", model);
-    RenderCube();
+    AddShadowCaster(casters, model);
     model = glm::mat4(1.0f);
     model = glm::translate(model, glm::vec3(2.0f, 3.0f, 1.0));
     model = glm::scale(model, glm::vec3(0.75f));
-    shader.SetMat4f("model", model);
-    RenderCube();
+    AddShadowCaster(casters, model);
     model = glm::mat4(1.0f);
     model = glm::translate(model, glm::vec3(-3.0f, -1.0f, 0.0));
     model = glm::scale(model, glm::vec3(0.5f));
-    shader.SetMat4f("model", model);
-    RenderCube();
+    AddShadowCaster(casters, model);
     model = glm::mat4(1.0f);
     model = glm::translate(model, glm::vec3(-1.5f, 1.0f, 1.5));
     model = glm::scale(model, glm::vec3(0.5f));
-    shader.SetMat4f("model", model);
-    RenderCube();
+    AddShadowCaster(casters, model);
     model = glm::mat4(1.0f);
     model = glm::translate(model, glm::vec3(-1.5f, 2.0f, -3.0));
     model = glm::rotate(model, glm::radians(60.0f), glm::normalize(glm::vec3(1.0, 0.0, 1.0)));
     model = glm::scale(model, glm::vec3(0.75f));
+    AddShadowCaster(casters, model);
+
+    for (unsigned int i = 0; i < extraCubes; i++)
+    {
+        glm::vec3 position(HashRandomRange(i, 0u, -4.5f, 4.5f), HashRandomRange(i, 1u, -4.5f, 4.5f), HashRandomRange(i, 2u, -4.5f, 4.5f));
+        if (glm::length(position) < 1.5f)
+            position *= 1.5f / std::max(glm::length(position), 0.01f);
+        glm::vec3 axis = glm::normalize(glm::vec3(HashRandomRange(i, 3u, -1.0f, 1.0f), 1.0f, HashRandomRange(i, 4u, -1.0f, 1.0f)));
+        model = glm::mat4(1.0f);
+        model = glm::translate(model, position);
+        model = glm::rotate(model, glm::radians(HashRandomRange(i, 5u, 0.0f, 90.0f)), axis);
+        model = glm::scale(model, glm::vec3(HashRandomRange(i, 6u, 0.05f, 0.2f)));
+        AddShadowCaster(casters, model);
+    }
+}
+
+// 绕房间中心转动的立方体
+void UpdateDynamicCasters(std::vector<SceneObject> &casters, unsigned int count, float time)
+{
+    casters.clear();
+    for (unsigned int i = 0; i < count; i++)
+    {
+        float radius = HashRandomRange(i, 10u, 2.0f, 4.0f);
+        float speed = HashRandomRange(i, 11u, 0.3f, 0.8f);
+        float angle = time * speed + static_cast<float>(i) * 2.4f;
+        float height = HashRandomRange(i, 12u, -3.5f, 3.5f) + std::sin(time * speed * 1.7f) * 0.5f;
+        glm::mat4 model = glm::mat4(1.0f);
+        model = glm::translate(model, glm::vec3(std::cos(angle) * radius, height, std::sin(angle) * radius));
+        model = glm::rotate(model, time, glm::normalize(glm::vec3(1.0f, 1.0f, 0.0f)));
+        model = glm::scale(model, glm::vec3(0.3f));
+        AddShadowCaster(casters, model);
+    }
+}
+
+void RenderScene(const Shader &shader)
+{
+    // room cube
+    glm::mat4 model = glm::mat4(1.0f);
+    model = glm::scale(model, glm::vec3(5.0f));
     shader.SetMat4f("model", model);
+    glDisable(GL_CULL_FACE); // note that we disable culling here since we render 'inside' the cube instead of the usual 'outside' which throws off the normal culling methods.
+    shader.SetInt("reverse_normals", 1); // 在从内部绘制立方体时反转法线的小技巧，使照明仍然有效。
     RenderCube();
+    shader.SetInt("reverse_normals", 0); // and of course disable it
+    glEnable(GL_CULL_FACE);
+    // cubes
+    UniformHandle modelHandle = shader.GetUniform("model");
+    for (const SceneObject &object : ShadowCasters)
+    {
+        shader.SetMat4f(modelHandle, object.Model);
+        RenderCube();
+    }
+    for (const SceneObject &object : DynamicCasters)
+    {
+        shader.SetMat4f(modelHandle, object.Model);
+        RenderCube();
+    }
+}
+
+// 四种方式的深度着色器（片段着色器都是 point_shadow_depth.fs）
+struct ShadowShaders
+{
+    Shader *GeometryShader;
+    Shader *PerFace;
+    Shader *VertexLayer;    // 驱动不支持时为 nullptr
+    Shader *DualParaboloid;
+};
+
+// 一次阴影 pass 的统计
+struct ShadowPassStats
+{
+    unsigned int DrawCalls = 0;
+    unsigned int Triangles = 0;     // 进入光栅化的三角形数量（几何着色器放大之后）
+};
+
+// 把投射体渲染到 lightPos 的阴影贴图中
+void RenderShadowMap(OmniShadowMode mode, const ShadowShaders &shaders, OmniShadowMap &shadowMap, const std::vector<SceneObject> &casters,
+                     const glm::vec3 &lightPos, float nearPlane, float farPlane, ShadowPassStats &stats)
+{
+    static const char *const matrixNames[6] = {
+        "shadowMatrices[0]", "shadowMatrices[1]", "shadowMatrices[2]", "shadowMatrices[3]", "shadowMatrices[4]", "shadowMatrices[5]"
+    };
+    static const char *const faceIndexNames[6] = {
+        "faceIndices[0]", "faceIndices[1]", "faceIndices[2]", "faceIndices[3]", "faceIndices[4]", "faceIndices[5]"
+    };
+    // 每个投射体的可见性掩码（立方体贴图的面或者抛物面的半球），每个光源计算一次
+    static std::vector<unsigned char> masks;
+    masks.resize(casters.size());
+    for (size_t i = 0; i < casters.size(); i++)
+    {
+        masks[i] = static_cast<unsigned char>(mode == OmniShadowMode::DualParaboloid
+            ? GetHemisphereMask(lightPos, farPlane, casters[i].Min, casters[i].Max)
+            : GetCubeFaceMask(lightPos, farPlane, casters[i].Min, casters[i].Max));
+    }
+
+    switch (mode)
+    {
+    case OmniShadowMode::GeometryShader:
+    {
+        // 几何着色器会把三角形输出到全部 6 个面，CPU 端只能按光源范围剔除
+        Shader &shader = *shaders.GeometryShader;
+        shadowMap.BeginLayered();
+        shader.Use();
+        for (unsigned int face = 0; face < 6; ++face)
+            shader.SetMat4f(matrixNames[face], GetCubeFaceMatrix(lightPos, nearPlane, farPlane, face));
+        shader.SetFloat("far_plane", farPlane);
+        shader.SetVec3f("lightPos", lightPos);
+        UniformHandle modelHandle = shader.GetUniform("model");
+        for (size_t i = 0; i < casters.size(); i++)
+        {
+            if (masks[i] == 0u)
+                continue;
+            shader.SetMat4f(modelHandle, casters[i].Model);
+            RenderCube();
+            stats.DrawCalls++;
+            stats.Triangles += CUBE_TRIANGLES * 6u;
+        }
+        break;
+    }
+    case OmniShadowMode::PerFace:
+    {
+        Shader &shader = *shaders.PerFace;
+        shader.Use();
+        shader.SetFloat("far_plane", farPlane);
+        shader.SetVec3f("lightPos", lightPos);
+        UniformHandle matrixHandle = shader.GetUniform("shadowMatrix");
+        UniformHandle modelHandle = shader.GetUniform("model");
+        for (unsigned int face = 0; face < 6; ++face)
+        {
+            shadowMap.BeginFace(face);
+            shader.SetMat4f(matrixHandle, GetCubeFaceMatrix(lightPos, nearPlane, farPlane, face));
+            for (size_t i = 0; i < casters.size(); i++)
+            {
+                if ((masks[i] & (1u << face)) == 0u)
+                    continue;
+                shader.SetMat4f(modelHandle, casters[i].Model);
+                RenderCube();
+                stats.DrawCalls++;
+                stats.Triangles += CUBE_TRIANGLES;
+            }
+        }
+        break;
+    }
+    case OmniShadowMode::VertexLayer:
+    {
+        // 每个投射体一次实例化绘制，实例数 = 能看到它的面数
+        Shader &shader = *shaders.VertexLayer;
+        shadowMap.BeginLayered();
+        shader.Use();
+        for (unsigned int face = 0; face < 6; ++face)
+            shader.SetMat4f(matrixNames[face], GetCubeFaceMatrix(lightPos, nearPlane, farPlane, face));
+        shader.SetFloat("far_plane", farPlane);
+        shader.SetVec3f("lightPos", lightPos);
+        UniformHandle modelHandle = shader.GetUniform("model");
+        UniformHandle faceHandles[6];
+        for (unsigned int face = 0; face < 6; ++face)
+            faceHandles[face] = shader.GetUniform(faceIndexNames[face]);
+        for (size_t i = 0; i < casters.size(); i++)
+        {
+            if (masks[i] == 0u)
+                continue;
+            int instanceCount = 0;
+            for (int face = 0; face < 6; ++face)
+            {
+                if (masks[i] & (1u << face))
+                    shader.SetInt(faceHandles[instanceCount++], face);
+            }
+            shader.SetMat4f(modelHandle, casters[i].Model);
+            RenderCube(instanceCount);
+            stats.DrawCalls++;
+            stats.Triangles += CUBE_TRIANGLES * instanceCount;
+        }
+        break;
+    }
+    case OmniShadowMode::DualParaboloid:
+    {
+        Shader &shader = *shaders.DualParaboloid;
+        shader.Use();
+        shader.SetFloat("far_plane", farPlane);
+        shader.SetVec3f("lightPos", lightPos);
+        UniformHandle hemisphereHandle = shader.GetUniform("hemisphere");
+        UniformHandle modelHandle = shader.GetUniform("model");
+        for (unsigned int hemisphere = 0; hemisphere < 2; ++hemisphere)
+        {
+            shadowMap.BeginHemisphere(hemisphere);
+            shader.SetFloat(hemisphereHandle, OmniShadowMap::GetHemisphereSign(hemisphere));
+            for (size_t i = 0; i < casters.size(); i++)
+            {
+                if ((masks[i] & (1u << hemisphere)) == 0u)
+                    continue;
+                shader.SetMat4f(modelHandle, casters[i].Model);
+                RenderCube();
+                stats.DrawCalls++;
+                stats.Triangles += CUBE_TRIANGLES;
+            }
+        }
+        break;
+    }
+    default:
+        break;
+    }
+    shadowMap.End();
+}
+
+// 投射体数量和光源数量逐渐增加时，四种方式阴影 pass 的 CPU 提交时间和 GPU 时间
+// 多个光源依次渲染到同一张阴影贴图（只比较渲染开销，不需要为每个光源分配贴图）
+void RunShadowBenchmark(const ShadowShaders &shaders, OmniShadowMap &shadowMap, float nearPlane, float farPlane)
+{
+    const unsigned int casterCounts[3] = { 64u, 1024u, 8192u };
+    const unsigned int lightCounts[3] = { 1u, 4u, 16u };
+    const int ITERATIONS = 50;
+    const int WARMUP = 5;
+    std::cout << "omni shadow benchmark: cube faces " << shadowMap.GetResolution() << "x" << shadowMap.GetResolution()
+              << ", paraboloid " << shadowMap.GetParaboloidResolution() << "x" << shadowMap.GetParaboloidResolution()
+              << ", vertex layer " << (bVertexLayerSupported ? "supported" : "not supported") << std::endl;
+    std::cout << std::setw(9) << "casters" << std::setw(12) << "triangles" << std::setw(8) << "lights" << std::setw(12) << "mode"
+              << std::setw(10) << "draws" << std::setw(16) << "raster tris(K)" << std::setw(10) << "CPU(ms)" << std::setw(10) << "GPU(ms)" << std::endl;
+    std::vector<SceneObject> casters;
+    for (unsigned int casterCount : casterCounts)
+    {
+        BuildShadowCasters(casters, casterCount - 5u);
+        for (unsigned int lightCount : lightCounts)
+        {
+            std::vector<glm::vec3> lights;
+            for (unsigned int i = 0; i < lightCount; i++)
+                lights.push_back(i == 0u ? glm::vec3(0.0f) : glm::vec3(HashRandomRange(i, 7u, -3.0f, 3.0f), HashRandomRange(i, 8u, -3.0f, 3.0f), HashRandomRange(i, 9u, -3.0f, 3.0f)));
+            for (int m = 0; m < static_cast<int>(OmniShadowMode::Count); m++)
+            {
+                OmniShadowMode mode = static_cast<OmniShadowMode>(m);
+                if (mode == OmniShadowMode::VertexLayer && !bVertexLayerSupported)
+                    continue;
+                // 每次迭代都等 GPU 完成，保证查询结果不会被丢弃
+                GpuProfiler profiler;
+                ShadowPassStats stats;
+                double cpuMs = 0.0;
+                for (int iteration = 0; iteration < ITERATIONS + WARMUP; iteration++)
+                {
+                    stats = ShadowPassStats();
+                    profiler.BeginFrame();
+                    profiler.PushScope("shadow");
+                    auto start = std::chrono::high_resolution_clock::now();
+                    for (const glm::vec3 &lightPos : lights)
+                        RenderShadowMap(mode, shaders, shadowMap, casters, lightPos, nearPlane, farPlane, stats);
+                    if (iteration >= WARMUP)
+                        cpuMs += std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+                    profiler.PopScope();
+                    profiler.EndFrame();
+                    profiler.Flush();
+                }
+                double gpuMs = 0.0;
+                int frames = 0;
+                for (const GpuProfiler::FrameResult &frame : profiler.GetHistory())
+                {
+                    if (frame.Frame < static_cast<unsigned int>(WARMUP))
+                        continue;
+                    for (const GpuProfiler::ScopeResult &scope : frame.Scopes)
+                        gpuMs += scope.TotalMs;
+                    frames++;
+                }
+                frames = std::max(frames, 1);
+                std::cout << std::setw(9) << casterCount << std::setw(12) << casterCount * CUBE_TRIANGLES << std::setw(8) << lightCount
+                          << std::setw(12) << GetOmniShadowModeName(mode) << std::setw(10) << stats.DrawCalls
+                          << std::fixed << std::setprecision(1) << std::setw(16) << stats.Triangles / 1000.0
+                          << std::setprecision(3) << std::setw(10) << cpuMs / ITERATIONS << std::setw(10) << gpuMs / frames << std::endl;
+            }
+        }
+    }
+}
+
+// 和 point_shadow_atlas.fs 中的 AtlasLight 一致（std140，每个光源 8 个 vec4）
+struct AtlasLightData
+{
+    glm::vec4 PositionRange;
+    glm::vec4 Color;
+    glm::vec4 FaceRects[6];
+};
+const unsigned int MAX_ATLAS_LIGHTS = 64u;
+const unsigned int SHADOW_ATLAS_BINDING = 0u;
+
+// 图集中一帧的工作量
+struct ShadowAtlasStats
+{
+    unsigned int StaticFaces = 0;   // 重画静态缓存的面
+    unsigned int CopiedFaces = 0;   // 从静态缓存复制到最终图集的面
+    unsigned int DynamicFaces = 0;  // 叠加动态投射体的面
+    unsigned int DrawCalls = 0;
+};
+
+void DrawCastersToFace(const Shader &shader, UniformHandle modelHandle, const std::vector<SceneObject> &casters,
+                       const std::vector<unsigned char> &masks, unsigned int face, ShadowAtlasStats &stats)
+{
+    for (size_t i = 0; i < casters.size(); i++)
+    {
+        if ((masks[i] & (1u << face)) == 0u)
+            continue;
+        shader.SetMat4f(modelHandle, casters[i].Model);
+        RenderCube();
+        stats.DrawCalls++;
+    }
+}
+
+// 更新图集：静态缓存中脏的面重画，有动态投射体的面从缓存恢复后叠加动态投射体，其余的面这一帧完全不用动
+void RenderShadowAtlas(ShadowAtlas &atlas, Shader &shader, const std::vector<SceneObject> &staticCasters,
+                       const std::vector<SceneObject> &dynamicCasters, ShadowAtlasStats &stats)
+{
+    // 写入的深度是线性距离（gl_FragDepth），近平面只影响裁剪；图集中的光源范围比较小，近平面也要小，否则靠近光源的投射体会被裁掉
+    const float nearPlane = 0.05f;
+    static std::vector<unsigned char> staticMasks;
+    static std::vector<unsigned char> dynamicMasks;
+    staticMasks.resize(staticCasters.size());
+    dynamicMasks.resize(dynamicCasters.size());
+    shader.Use();
+    UniformHandle matrixHandle = shader.GetUniform("shadowMatrix");
+    UniformHandle modelHandle = shader.GetUniform("model");
+    UniformHandle farHandle = shader.GetUniform("far_plane");
+    UniformHandle lightPosHandle = shader.GetUniform("lightPos");
+    for (unsigned int index = 0; index < atlas.GetLightCount(); index++)
+    {
+        ShadowAtlasLight &light = atlas.GetLight(index);
+        if (light.FaceSize == 0u)
+            continue;
+        unsigned int dynamicFaces = 0u;
+        for (size_t i = 0; i < dynamicCasters.size(); i++)
+        {
+            dynamicMasks[i] = static_cast<unsigned char>(GetCubeFaceMask(light.Position, light.Range, dynamicCasters[i].Min, dynamicCasters[i].Max));
+            dynamicFaces |= dynamicMasks[i];
+        }
+        unsigned int copyFaces = light.StaticDirtyFaces | dynamicFaces | light.DynamicFaces;
+        if (copyFaces == 0u)
+            continue;
+
+        shader.SetFloat(farHandle, light.Range);
+        shader.SetVec3f(lightPosHandle, light.Position);
+        if (light.StaticDirtyFaces != 0u)
+        {
+            for (size_t i = 0; i < staticCasters.size(); i++)
+                staticMasks[i] = static_cast<unsigned char>(GetCubeFaceMask(light.Position, light.Range, staticCasters[i].Min, staticCasters[i].Max));
+            for (unsigned int face = 0; face < 6; ++face)
+            {
+                if ((light.StaticDirtyFaces & (1u << face)) == 0u)
+                    continue;
+                atlas.BeginStaticFace(index, face);
+                shader.SetMat4f(matrixHandle, GetCubeFaceMatrix(light.Position, nearPlane, light.Range, face));
+                DrawCastersToFace(shader, modelHandle, staticCasters, staticMasks, face, stats);
+                stats.StaticFaces++;
+            }
+        }
+        for (unsigned int face = 0; face < 6; ++face)
+        {
+            if ((copyFaces & (1u << face)) == 0u)
+                continue;
+            atlas.CopyStaticFace(index, face);
+            stats.CopiedFaces++;
+            if ((dynamicFaces & (1u << face)) == 0u)
+                continue;
+            atlas.BeginDynamicFace(index, face);
+            shader.SetMat4f(matrixHandle, GetCubeFaceMatrix(light.Position, nearPlane, light.Range, face));
+            DrawCastersToFace(shader, modelHandle, dynamicCasters, dynamicMasks, face, stats);
+            stats.DynamicFaces++;
+        }
+        light.StaticDirtyFaces = 0u;
+        light.DynamicFaces = dynamicFaces;
+    }
+    atlas.End();
+}
+
+// 光源 0 是原来房间中心的白光（范围 = far_plane），其余光源随机分布在房间里，颜色随机
+glm::vec3 GetAtlasLightPosition(unsigned int index, unsigned int movingLights, float time)
+{
+    if (index == 0u)
+        return LightPos;
+    glm::vec3 position(HashRandomRange(index, 20u, -4.0f, 4.0f), HashRandomRange(index, 21u, -4.0f, 4.0f), HashRandomRange(index, 22u, -4.0f, 4.0f));
+    if (index <= movingLights)
+        position += glm::vec3(std::cos(time + index), std::sin(time * 0.7f + index), std::sin(time + index)) * 0.5f;
+    return position;
+}
+
+glm::vec3 GetAtlasLightColor(unsigned int index)
+{
+    if (index == 0u)
+        return glm::vec3(0.3f);
+    return glm::vec3(HashRandomRange(index, 23u, 0.1f, 0.6f), HashRandomRange(index, 24u, 0.1f, 0.6f), HashRandomRange(index, 25u, 0.1f, 0.6f));
+}
+
+float GetAtlasLightRange(unsigned int index, float farPlane)
+{
+    return index == 0u ? farPlane : 5.0f;
+}
+
+ShadowAtlas *CreateShadowAtlas(unsigned int atlasSize, unsigned int lightCount, float farPlane)
+{
+    ShadowAtlas *atlas = new ShadowAtlas(atlasSize);
+    for (unsigned int i = 0; i < lightCount; i++)
+        atlas->AddLight(GetAtlasLightPosition(i, 0u, 0.0f), GetAtlasLightRange(i, farPlane));
+    return atlas;
+}
+
+void UploadAtlasLights(unsigned int buffer, const ShadowAtlas &atlas, bool bShadows)
+{
+    static std::vector<AtlasLightData> data;
+    data.resize(atlas.GetLightCount());
+    for (unsigned int i = 0; i < atlas.GetLightCount(); i++)
+    {
+        const ShadowAtlasLight &light = atlas.GetLight(i);
+        data[i].PositionRange = glm::vec4(light.Position, light.Range);
+        data[i].Color = glm::vec4(GetAtlasLightColor(i), bShadows && light.FaceSize != 0u ? 1.0f : 0.0f);
+        for (unsigned int face = 0; face < 6; ++face)
+            data[i].FaceRects[face] = atlas.GetFaceRect(i, face);
+    }
+    glBindBuffer(GL_UNIFORM_BUFFER, buffer);
+    glBufferSubData(GL_UNIFORM_BUFFER, 0, data.size() * sizeof(AtlasLightData), data.data());
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+}
+
+// 光源数量增加时，每帧全部重画（原来的做法，用同一个图集，只是每帧都把所有面标记为脏）和缓存之后每帧的开销
+void RunAtlasBenchmark(Shader &shader, unsigned int atlasSize, float farPlane, unsigned int dynamicCubes)
+{
+    const unsigned int lightCounts[4] = { 1u, 8u, 32u, 64u };
+    const int ITERATIONS = 50;
+    const int WARMUP = 5;
+    std::vector<SceneObject> staticCasters;
+    std::vector<SceneObject> dynamicCasters;
+    BuildShadowCasters(staticCasters, 1019u);
+    std::cout << "shadow atlas benchmark: atlas " << atlasSize << "x" << atlasSize << ", " << staticCasters.size()
+              << " static casters, " << dynamicCubes << " dynamic casters" << std::endl;
+    std::cout << std::setw(8) << "lights" << std::setw(10) << "mode" << std::setw(10) << "occupancy" << std::setw(14) << "static faces"
+              << std::setw(14) << "copied faces" << std::setw(15) << "dynamic faces" << std::setw(8) << "draws"
+              << std::setw(10) << "CPU(ms)" << std::setw(10) << "GPU(ms)" << std::endl;
+    for (unsigned int lightCount : lightCounts)
+    {
+        for (int cached = 0; cached < 2; cached++)
+        {
+            ShadowAtlas *atlas = CreateShadowAtlas(atlasSize, lightCount, farPlane);
+            atlas->UpdateTileSizes(glm::vec3(0.0f, 0.0f, 3.0f), 45.0f, SCREEN_HEIGHT);
+            GpuProfiler profiler;
+            ShadowAtlasStats stats;
+            double cpuMs = 0.0;
+            for (int iteration = 0; iteration < ITERATIONS + WARMUP; iteration++)
+            {
+                stats = ShadowAtlasStats();
+                if (!cached)
+                    atlas->InvalidateAll();
+                profiler.BeginFrame();
+                profiler.PushScope("atlas");
+                auto start = std::chrono::high_resolution_clock::now();
+                UpdateDynamicCasters(dynamicCasters, dynamicCubes, iteration * 0.016f);
+                RenderShadowAtlas(*atlas, shader, staticCasters, dynamicCasters, stats);
+                if (iteration >= WARMUP)
+                    cpuMs += std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+                profiler.PopScope();
+                profiler.EndFrame();
+                profiler.Flush();
+            }
+            double gpuMs = 0.0;
+            int frames = 0;
+            for (const GpuProfiler::FrameResult &frame : profiler.GetHistory())
+            {
+                if (frame.Frame < static_cast<unsigned int>(WARMUP))
+                    continue;
+                for (const GpuProfiler::ScopeResult &scope : frame.Scopes)
+                    gpuMs += scope.TotalMs;
+                frames++;
+            }
+            frames = std::max(frames, 1);
+            std::cout << std::setw(8) << lightCount << std::setw(10) << (cached ? "cached" : "uncached")
+                      << std::fixed << std::setprecision(1) << std::setw(9) << atlas->GetOccupancy() * 100.0f << "%"
+                      << std::setw(14) << stats.StaticFaces << std::setw(14) << stats.CopiedFaces << std::setw(15) << stats.DynamicFaces
+                      << std::setw(8) << stats.DrawCalls << std::setprecision(3) << std::setw(10) << cpuMs / ITERATIONS
+                      << std::setw(10) << gpuMs / frames << std::endl;
+            atlas->Destroy();
+            delete atlas;
+        }
+    }
+    glViewport(0, 0, SCREEN_WIDTH, SCREEN_HEIGHT);
 }
 
 int main(int argc, char **argv)
 {
+    // --shadow=gs|face|layer|paraboloid（M 键切换），--cubes=N（房间里额外的小立方体），--shadow-benchmark（输出对比结果后退出）
+    // --shadow-atlas（K 键切换），--lights=N（图集中的光源数量），--moving-lights=N，--dynamic-cubes=N，--atlas-size=N，--atlas-benchmark
+    unsigned int extraCubes = 0u;
+    bool bShadowBenchmark = false;
+    unsigned int atlasLightCount = 24u;
+    unsigned int movingLights = 0u;
+    unsigned int dynamicCubes = 0u;
+    unsigned int atlasSize = 4096u;
+    bool bAtlasBenchmark = false;
+    for (int i = 1; i < argc; i++)
+    {
+        std::string arg = argv[i];
+        if (arg.rfind("--shadow=", 0) == 0)
+        {
+            for (int m = 0; m < static_cast<int>(OmniShadowMode::Count); m++)
+            {
+                if (arg.substr(9) == GetOmniShadowModeName(static_cast<OmniShadowMode>(m)))
+                    shadowMode = static_cast<OmniShadowMode>(m);
+            }
+        }
+        else if (arg.rfind("--cubes=", 0) == 0)
+            extraCubes = static_cast<unsigned int>(std::max(0, std::atoi(arg.c_str() + 8)));
+        else if (arg == "--shadow-benchmark")
+            bShadowBenchmark = true;
+        else if (arg == "--shadow-atlas")
+            bShadowAtlas = true;
+        else if (arg.rfind("--lights=", 0) == 0)
+            atlasLightCount = static_cast<unsigned int>(std::min(std::max(1, std::atoi(arg.c_str() + 9)), static_cast<int>(MAX_ATLAS_LIGHTS)));
+        else if (arg.rfind("--moving-lights=", 0) == 0)
+            movingLights = static_cast<unsigned int>(std::max(0, std::atoi(arg.c_str() + 16)));
+        else if (arg.rfind("--dynamic-cubes=", 0) == 0)
+            dynamicCubes = static_cast<unsigned int>(std::max(0, std::atoi(arg.c_str() + 16)));
+        else if (arg.rfind("--atlas-size=", 0) == 0)
+            atlasSize = static_cast<unsigned int>(std::max(256, std::atoi(arg.c_str() + 13)));
+        else if (arg == "--atlas-benchmark")
+            bAtlasBenchmark = true;
+    }
+
     // glfw and glad initialize
     if (!glfwInit())
         return -1;
@@ -322,6 +914,24 @@ int main(int argc, char **argv)
     Shader shader("./src/28-PointShadow/Shaders/point_shadow.vs", "./src/28-PointShadow/Shaders/point_shadow.fs");
     Shader simpleDepthShader("./src/28-PointShadow/Shaders/point_shadow_depth.vs", "./src/28-PointShadow/Shaders/point_shadow_depth.fs",
                              "./src/28-PointShadow/Shaders/point_shadow_depth.gs");
+    Shader faceDepthShader("./src/28-PointShadow/Shaders/point_shadow_face.vs", "./src/28-PointShadow/Shaders/point_shadow_depth.fs");
+    Shader paraboloidDepthShader("./src/28-PointShadow/Shaders/point_shadow_paraboloid.vs", "./src/28-PointShadow/Shaders/point_shadow_depth.fs");
+    // 顶点着色器写 gl_Layer 需要扩展，不支持时不编译（也不能选择这种方式）
+    Shader *layerDepthShader = nullptr;
+    if (IsVertexLayerExtensionSupported())
+    {
+        layerDepthShader = new Shader("./src/28-PointShadow/Shaders/point_shadow_layer.vs", "./src/28-PointShadow/Shaders/point_shadow_depth.fs");
+        int linked = 0;
+        glGetProgramiv(layerDepthShader->GetID(), GL_LINK_STATUS, &linked);
+        bVertexLayerSupported = linked == GL_TRUE;
+    }
+    if (shadowMode == OmniShadowMode::VertexLayer && !bVertexLayerSupported)
+    {
+        std::cout << "gl_Layer in vertex shader is not supported, falling back to per-face shadow rendering" << std::endl;
+        shadowMode = OmniShadowMode::PerFace;
+    }
+    Shader atlasShader("./src/28-PointShadow/Shaders/point_shadow.vs", "./src/28-PointShadow/Shaders/point_shadow_atlas.fs");
+    ShadowShaders shadowShaders{ &simpleDepthShader, &faceDepthShader, bVertexLayerSupported ? layerDepthShader : nullptr, &paraboloidDepthShader };
 
     // load textures
     // -------------
@@ -329,33 +939,48 @@ int main(int argc, char **argv)
 
     // configure depth map FBO
     // -----------------------
-    const unsigned int SHADOW_WIDTH = 1024, SHADOW_HEIGHT = 1024;
-    unsigned int depthMapFBO;
-    glGenFramebuffers(1, &depthMapFBO);
-    // create depth cubemap texture
-    unsigned int depthCubemap;
-    glGenTextures(1, &depthCubemap);
-    glBindTexture(GL_TEXTURE_CUBE_MAP, depthCubemap);
-    for (unsigned int i = 0; i < 6; ++i)
-        glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, 0, GL_DEPTH_COMPONENT, SHADOW_WIDTH, SHADOW_HEIGHT, 0, GL_DEPTH_COMPONENT, GL_FLOAT, NULL);
-    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
-    // attach depth texture as FBO's depth buffer
-    glBindFramebuffer(GL_FRAMEBUFFER, depthMapFBO);
-    glFramebufferTexture(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, depthCubemap, 0);
-    // 不需要渲染具体场景
-    glDrawBuffer(GL_NONE);
-    glReadBuffer(GL_NONE);
-    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    // 立方体贴图每个面和抛物面每个半球的大小
+    const unsigned int SHADOW_SIZE = 1024;
+    OmniShadowMap shadowMap(SHADOW_SIZE, SHADOW_SIZE);
+    float near_plane = 1.0f;
+    float far_plane  = 25.0f;
+
+    if (bShadowBenchmark || bAtlasBenchmark)
+    {
+        if (bShadowBenchmark)
+            RunShadowBenchmark(shadowShaders, shadowMap, near_plane, far_plane);
+        if (bAtlasBenchmark)
+            RunAtlasBenchmark(faceDepthShader, atlasSize, far_plane, std::max(dynamicCubes, 4u));
+        shadowMap.Destroy();
+        delete layerDepthShader;
+        glfwTerminate();
+        return 0;
+    }
+    BuildShadowCasters(ShadowCasters, extraCubes);
+    std::cout << "shadow: " << GetOmniShadowModeName(shadowMode) << " (M to switch), " << ShadowCasters.size() << " casters" << std::endl;
+    ShadowPassStats shadowStats;
+    // 图集第一次打开时才创建（两张 atlasSize² 的深度纹理）
+    ShadowAtlas *shadowAtlas = nullptr;
+    ShadowAtlasStats atlasStats;
+    unsigned int atlasLightBuffer;
+    glGenBuffers(1, &atlasLightBuffer);
+    glBindBuffer(GL_UNIFORM_BUFFER, atlasLightBuffer);
+    glBufferData(GL_UNIFORM_BUFFER, MAX_ATLAS_LIGHTS * sizeof(AtlasLightData), NULL, GL_DYNAMIC_DRAW);
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+    glBindBufferBase(GL_UNIFORM_BUFFER, SHADOW_ATLAS_BINDING, atlasLightBuffer);
+    glUniformBlockBinding(atlasShader.GetID(), glGetUniformBlockIndex(atlasShader.GetID(), "ShadowAtlasLights"), SHADOW_ATLAS_BINDING);
+    // 不在图集模式时只有第一个光源
+    std::vector<SceneObject> allCasters;
 
     // shader configuration
     // --------------------
     shader.Use();
     shader.SetInt("diffuseTexture", 0);
     shader.SetInt("depthMap", 1);
+    shader.SetInt("paraboloidMap", 2);
+    atlasShader.Use();
+    atlasShader.SetInt("diffuseTexture", 0);
+    atlasShader.SetInt("shadowAtlas", 1);
 
     // lighting info
     // -------------
@@ -373,7 +998,13 @@ int main(int argc, char **argv)
             std::stringstream ss;
             ss << "LearnOpenGL ( FPS: ";
             ss << nbFrames;
-            ss << " )";
+            if (shadowAtlas != nullptr && bShadowAtlas)
+                ss << " ) atlas: " << shadowAtlas->GetLightCount() << " lights, " << static_cast<int>(shadowAtlas->GetOccupancy() * 100.0f)
+                   << "% used, faces static/copied/dynamic " << atlasStats.StaticFaces << "/" << atlasStats.CopiedFaces << "/"
+                   << atlasStats.DynamicFaces << ", " << atlasStats.DrawCalls << " draws";
+            else
+                ss << " ) shadow: " << GetOmniShadowModeName(shadowMode) << ", " << shadowStats.DrawCalls << " draws, "
+                   << shadowStats.Triangles << " triangles";
             glfwSetWindowTitle(window, ss.str().c_str());
             nbFrames = 0;
             LastFrame += 1.0f;
@@ -385,52 +1016,91 @@ int main(int argc, char **argv)
         glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
-        // 0. create depth cubemap transformation matrices
-        // -----------------------------------------------
-        float near_plane = 1.0f;
-        float far_plane  = 25.0f;
-        glm::mat4 shadowProj = glm::perspective(glm::radians(90.0f), (float)SHADOW_WIDTH / (float)SHADOW_HEIGHT, near_plane, far_plane);
-        std::vector<glm::mat4> shadowTransforms;
-        // 最后一个参数 up 方向是反的，看的是内部立方体（房间）
-        shadowTransforms.push_back(shadowProj * glm::lookAt(LightPos, LightPos + glm::vec3( 1.0f,  0.0f,  0.0f), glm::vec3(0.0f, -1.0f,  0.0f)));
-        shadowTransforms.push_back(shadowProj * glm::lookAt(LightPos, LightPos + glm::vec3(-1.0f,  0.0f,  0.0f), glm::vec3(0.0f, -1.0f,  0.0f)));
-        shadowTransforms.push_back(shadowProj * glm::lookAt(LightPos, LightPos + glm::vec3( 0.0f,  1.0f,  0.0f), glm::vec3(0.0f,  0.0f,  1.0f)));
-        shadowTransforms.push_back(shadowProj * glm::lookAt(LightPos, LightPos + glm::vec3( 0.0f, -1.0f,  0.0f), glm::vec3(0.0f,  0.0f, -1.0f)));
-        shadowTransforms.push_back(shadowProj * glm::lookAt(LightPos, LightPos + glm::vec3( 0.0f,  0.0f,  1.0f), glm::vec3(0.0f, -1.0f,  0.0f)));
-        shadowTransforms.push_back(shadowProj * glm::lookAt(LightPos, LightPos + glm::vec3( 0.0f,  0.0f, -1.0f), glm::vec3(0.0f, -1.0f,  0.0f)));
-
-        // 1. render scene to depth cubemap
-        // --------------------------------
-        glViewport(0, 0, SHADOW_WIDTH, SHADOW_HEIGHT);
-        glBindFramebuffer(GL_FRAMEBUFFER, depthMapFBO);
-        glClear(GL_DEPTH_BUFFER_BIT);
-        simpleDepthShader.Use();
-        for (unsigned int i = 0; i < 6; ++i)
-            simpleDepthShader.SetMat4f("shadowMatrices[" + std::to_string(i) + "]", shadowTransforms[i]);
-        simpleDepthShader.SetFloat("far_plane", far_plane);
-        simpleDepthShader.SetVec3f("lightPos", LightPos);
-        RenderScene(simpleDepthShader);
-        glBindFramebuffer(GL_FRAMEBUFFER, 0);
-
-        // 2. render scene as normal 
-        // -------------------------
-        glViewport(0, 0, SCREEN_WIDTH, SCREEN_HEIGHT);
-        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-        shader.Use();
+        UpdateDynamicCasters(DynamicCasters, dynamicCubes, CurrentTime);
+        if (bMoveStaticCaster)
+        {
+            // 静态投射体移动前后的区域都要失效
+            SceneObject &object = ShadowCasters[1];
+            if (shadowAtlas != nullptr)
+                shadowAtlas->InvalidateRegion(object.Min, object.Max);
+            object.Model = glm::translate(glm::mat4(1.0f), glm::vec3(object.Model[3]) * glm::vec3(-1.0f, 1.0f, -1.0f) - glm::vec3(object.Model[3])) * object.Model;
+            UpdateBounds(object);
+            if (shadowAtlas != nullptr)
+                shadowAtlas->InvalidateRegion(object.Min, object.Max);
+            bMoveStaticCaster = false;
+        }
         glm::mat4 projection = glm::perspective(glm::radians(camera.Fov), (float)SCREEN_WIDTH / (float)SCREEN_HEIGHT, 0.1f, 100.0f);
         glm::mat4 view = camera.GetViewMatrix();
-        shader.SetMat4f("projection", projection);
-        shader.SetMat4f("view", view);
-        // set lighting uniforms
-        shader.SetVec3f("lightPos", LightPos);
-        shader.SetVec3f("viewPos", camera.Position);
-        shader.SetInt("shadows", bShadow); // enable/disable shadows by pressing 'SPACE'
-        shader.SetFloat("far_plane", far_plane);
-        glActiveTexture(GL_TEXTURE0);
-        glBindTexture(GL_TEXTURE_2D, woodTexture);
-        glActiveTexture(GL_TEXTURE1);
-        glBindTexture(GL_TEXTURE_CUBE_MAP, depthCubemap);
-        RenderScene(shader);
+
+        if (bShadowAtlas)
+        {
+            if (shadowAtlas == nullptr)
+            {
+                shadowAtlas = CreateShadowAtlas(atlasSize, atlasLightCount, far_plane);
+                std::cout << "shadow atlas " << atlasSize << "x" << atlasSize << ", " << atlasLightCount << " lights ("
+                          << movingLights << " moving), " << dynamicCubes << " dynamic casters" << std::endl;
+            }
+            // 1. 只更新图集中变化的部分
+            // --------------------------------
+            for (unsigned int i = 1; i <= movingLights && i < shadowAtlas->GetLightCount(); i++)
+                shadowAtlas->SetLightPosition(i, GetAtlasLightPosition(i, movingLights, CurrentTime));
+            shadowAtlas->UpdateTileSizes(camera.Position, camera.Fov, SCREEN_HEIGHT);
+            atlasStats = ShadowAtlasStats();
+            RenderShadowAtlas(*shadowAtlas, faceDepthShader, ShadowCasters, DynamicCasters, atlasStats);
+            UploadAtlasLights(atlasLightBuffer, *shadowAtlas, bShadow);
+
+            // 2. 所有光源一起着色
+            // -------------------------
+            glViewport(0, 0, SCREEN_WIDTH, SCREEN_HEIGHT);
+            glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+            atlasShader.Use();
+            atlasShader.SetMat4f("projection", projection);
+            atlasShader.SetMat4f("view", view);
+            atlasShader.SetVec3f("viewPos", camera.Position);
+            atlasShader.SetInt("shadows", bShadow);
+            atlasShader.SetInt("lightCount", static_cast<int>(shadowAtlas->GetLightCount()));
+            atlasShader.SetFloat("atlasTexelSize", 1.0f / static_cast<float>(shadowAtlas->GetAtlasSize()));
+            glActiveTexture(GL_TEXTURE0);
+            glBindTexture(GL_TEXTURE_2D, woodTexture);
+            glActiveTexture(GL_TEXTURE1);
+            glBindTexture(GL_TEXTURE_2D, shadowAtlas->GetTexture());
+            RenderScene(atlasShader);
+        }
+        else
+        {
+            // 1. render scene to depth cubemap (or dual paraboloid map)
+            // --------------------------------
+            shadowStats = ShadowPassStats();
+            const std::vector<SceneObject> *casters = &ShadowCasters;
+            if (!DynamicCasters.empty())
+            {
+                allCasters = ShadowCasters;
+                allCasters.insert(allCasters.end(), DynamicCasters.begin(), DynamicCasters.end());
+                casters = &allCasters;
+            }
+            RenderShadowMap(shadowMode, shadowShaders, shadowMap, *casters, LightPos, near_plane, far_plane, shadowStats);
+
+            // 2. render scene as normal 
+            // -------------------------
+            glViewport(0, 0, SCREEN_WIDTH, SCREEN_HEIGHT);
+            glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+            shader.Use();
+            shader.SetMat4f("projection", projection);
+            shader.SetMat4f("view", view);
+            // set lighting uniforms
+            shader.SetVec3f("lightPos", LightPos);
+            shader.SetVec3f("viewPos", camera.Position);
+            shader.SetInt("shadows", bShadow); // enable/disable shadows by pressing 'SPACE'
+            shader.SetFloat("far_plane", far_plane);
+            shader.SetInt("dualParaboloid", shadowMode == OmniShadowMode::DualParaboloid);
+            glActiveTexture(GL_TEXTURE0);
+            glBindTexture(GL_TEXTURE_2D, woodTexture);
+            glActiveTexture(GL_TEXTURE1);
+            glBindTexture(GL_TEXTURE_CUBE_MAP, shadowMap.GetCubemap());
+            glActiveTexture(GL_TEXTURE2);
+            glBindTexture(GL_TEXTURE_2D_ARRAY, shadowMap.GetParaboloidMap());
+            RenderScene(shader);
+        }
 
         // swap and poll events
         glfwSwapBuffers(window);
@@ -443,6 +1113,18 @@ int main(int argc, char **argv)
     glDeleteVertexArrays(1, &cubeVAO);
     glDeleteVertexArrays(1, &quadVAO);
     glDeleteVertexArrays(1, &planeVAO);
+    shadowMap.Destroy();
+    glDeleteBuffers(1, &atlasLightBuffer);
+    if (shadowAtlas != nullptr)
+    {
+        shadowAtlas->Destroy();
+        delete shadowAtlas;
+    }
+    if (layerDepthShader != nullptr)
+    {
+        layerDepthShader->DeleteShaderProgram();
+        delete layerDepthShader;
+    }
 
     glfwTerminate();
     return 0;
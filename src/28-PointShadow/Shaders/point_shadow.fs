@@ -9,12 +9,14 @@ in VS_OUT {
 
 uniform sampler2D diffuseTexture;
 uniform samplerCube depthMap;
+uniform sampler2DArray paraboloidMap;
 
 uniform vec3 lightPos;
 uniform vec3 viewPos;  // 相机位置
 
 uniform float far_plane;
 uniform bool shadows;
+uniform bool dualParaboloid;    // 阴影贴图是对偶抛物面（否则是立方体贴图）
 
 // array of offset direction for sampling
 vec3 gridSamplingDisk[20] = vec3[]
@@ -26,12 +28,25 @@ vec3 gridSamplingDisk[20] = vec3[]
    vec3(0, 1,  1), vec3( 0, -1,  1), vec3( 0, -1, -1), vec3( 0, 1, -1)
 );
 
+// 沿光源到片段的方向读取最近的深度（[0, 1]）
+// 对偶抛物面：+Z 半球在第 0 层，-Z 半球在第 1 层，和 point_shadow_paraboloid.vs 的投影一致
+float SampleClosestDepth(vec3 direction)
+{
+    if (!dualParaboloid)
+        return texture(depthMap, direction).r;
+    vec3 d = normalize(direction);
+    float layer = d.z >= 0.0 ? 0.0 : 1.0;
+    d.z = abs(d.z);
+    vec2 uv = d.xy / (1.0 + d.z) * 0.5 + 0.5;
+    return texture(paraboloidMap, vec3(uv, layer)).r;
+}
+
 float ShadowCalculation(vec3 fragPos)
 {
     // get vector between fragment position and light position
     vec3 fragToLight = fragPos - lightPos;
     // ise the fragment to light vector to sample from the depth map
-    float closestDepth = texture(depthMap, fragToLight).r;
+    float closestDepth = SampleClosestDepth(fragToLight);
     // it is currently in linear range between [0,1], let's re-transform it back to original depth value
     closestDepth *= far_plane;
     // now get current linear depth as the length between the fragment and light position
@@ -68,7 +83,7 @@ float ShadowCalculation(vec3 fragPos)
     float diskRadius = (1.0 + (viewDistance / far_plane)) / 25.0;
     for(int i = 0; i < samples; ++i)
     {
-        float closestDepth = texture(depthMap, fragToLight + gridSamplingDisk[i] * diskRadius).r;
+        float closestDepth = SampleClosestDepth(fragToLight + gridSamplingDisk[i] * diskRadius);
         closestDepth *= far_plane;   // undo mapping [0;1]
         if(currentDepth - bias > closestDepth)
             shadow += 1.0;
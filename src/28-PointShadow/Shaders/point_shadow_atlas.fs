@@ -0,0 +1,115 @@
+#version 330 core
+out vec4 FragColor;
+
+in VS_OUT {
+    vec3 FragPos;
+    vec3 Normal;
+    vec2 TexCoords;
+} fs_in;
+
+#define MAX_ATLAS_LIGHTS 64
+
+// 和 Main.cpp 中的 AtlasLightData 一致（std140）
+struct AtlasLight
+{
+    vec4 PositionRange;     // xyz 位置，w 影响范围（也是写深度时的 far_plane）
+    vec4 Color;             // rgb 颜色，w = 1 表示在图集中有阴影
+    vec4 FaceRects[6];      // 立方体每个面在图集中的范围：xy 偏移，z 大小（归一化纹理坐标）
+};
+
+layout (std140) uniform ShadowAtlasLights
+{
+    AtlasLight lights[MAX_ATLAS_LIGHTS];
+};
+
+uniform int lightCount;
+uniform sampler2D diffuseTexture;
+uniform sampler2D shadowAtlas;
+uniform float atlasTexelSize;   // 1 / 图集大小
+
+uniform vec3 viewPos;
+uniform bool shadows;
+
+// 几十个光源，每个光源只用 8 个采样（point_shadow.fs 的 gridSamplingDisk 中立方体的 8 个角）
+vec3 sampleOffsets[8] = vec3[]
+(
+   vec3(1, 1,  1), vec3( 1, -1,  1), vec3(-1, -1,  1), vec3(-1, 1,  1),
+   vec3(1, 1, -1), vec3( 1, -1, -1), vec3(-1, -1, -1), vec3(-1, 1, -1)
+);
+
+// 按立方体贴图的规则（主轴和面内坐标 sc/tc 的对应表）选择面，再映射到图集中这个面的 tile
+float SampleAtlasDepth(int light, vec3 direction)
+{
+    vec3 a = abs(direction);
+    int face;
+    float ma;
+    vec2 sc;
+    if (a.x >= a.y && a.x >= a.z)
+    {
+        face = direction.x > 0.0 ? 0 : 1;
+        ma = a.x;
+        sc = vec2(direction.x > 0.0 ? -direction.z : direction.z, -direction.y);
+    }
+    else if (a.y >= a.z)
+    {
+        face = direction.y > 0.0 ? 2 : 3;
+        ma = a.y;
+        sc = vec2(direction.x, direction.y > 0.0 ? direction.z : -direction.z);
+    }
+    else
+    {
+        face = direction.z > 0.0 ? 4 : 5;
+        ma = a.z;
+        sc = vec2(direction.z > 0.0 ? direction.x : -direction.x, -direction.y);
+    }
+    vec4 rect = lights[light].FaceRects[face];
+    // 限制在 tile 内半个纹素以内，不会采样到相邻的 tile
+    float halfTexel = 0.5 * atlasTexelSize / rect.z;
+    vec2 uv = clamp(sc / ma * 0.5 + 0.5, vec2(halfTexel), vec2(1.0 - halfTexel));
+    return texture(shadowAtlas, rect.xy + uv * rect.z).r;
+}
+
+float ShadowCalculation(int light, vec3 fragToLight, float currentDepth, float farPlane)
+{
+    float shadow = 0.0;
+    float bias = 0.15;
+    float viewDistance = length(viewPos - fs_in.FragPos);
+    float diskRadius = (1.0 + (viewDistance / farPlane)) / 25.0;
+    for (int i = 0; i < 8; ++i)
+    {
+        float closestDepth = SampleAtlasDepth(light, fragToLight + sampleOffsets[i] * diskRadius) * farPlane;
+        if (currentDepth - bias > closestDepth)
+            shadow += 1.0;
+    }
+    return shadow / 8.0;
+}
+
+void main()
+{
+    vec3 color = texture(diffuseTexture, fs_in.TexCoords).rgb;
+    vec3 normal = normalize(fs_in.Normal);
+    vec3 viewDir = normalize(viewPos - fs_in.FragPos);
+    // ambient
+    vec3 lighting = vec3(0.3 * 0.3);
+    for (int i = 0; i < lightCount; ++i)
+    {
+        float range = lights[i].PositionRange.w;
+        vec3 fragToLight = fs_in.FragPos - lights[i].PositionRange.xyz;
+        float currentDepth = length(fragToLight);
+        if (currentDepth >= range)
+            continue;
+        vec3 lightDir = -fragToLight / currentDepth;
+        float diff = max(dot(lightDir, normal), 0.0);
+        // 背光的片段不需要采样阴影
+        if (diff <= 0.0)
+            continue;
+        vec3 halfwayDir = normalize(lightDir + viewDir);
+        float spec = pow(max(dot(normal, halfwayDir), 0.0), 64.0);
+        // 在影响范围边界平滑衰减到 0
+        float falloff = clamp(1.0 - pow(currentDepth / range, 4.0), 0.0, 1.0);
+        float shadow = (shadows && lights[i].Color.w > 0.0) ? ShadowCalculation(i, fragToLight, currentDepth, range) : 0.0;
+        lighting += (1.0 - shadow) * (diff + spec) * falloff * falloff * lights[i].Color.rgb;
+    }
+
+    FragColor = vec4(lighting * color, 1.0);
+}
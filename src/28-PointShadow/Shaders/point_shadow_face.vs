@@ -0,0 +1,14 @@
+#version 330 core
+layout (location = 0) in vec3 aPos;
+
+uniform mat4 model;
+uniform mat4 shadowMatrix;  // 当前面的投影 * 观察矩阵
+
+out vec4 FragPos;
+
+// 每个面单独绘制，不需要几何着色器
+void main()
+{
+    FragPos = model * vec4(aPos, 1.0);
+    gl_Position = shadowMatrix * FragPos;
+}
@@ -0,0 +1,19 @@
+#version 330 core
+// 顶点着色器写 gl_Layer，驱动支持其中一个扩展即可（使用前 CPU 端已经检查过）
+#extension GL_ARB_shader_viewport_layer_array : enable
+#extension GL_AMD_vertex_shader_layer : enable
+layout (location = 0) in vec3 aPos;
+
+uniform mat4 model;
+uniform mat4 shadowMatrices[6];
+uniform int faceIndices[6];     // 第 i 个实例画到第 faceIndices[i] 个面（CPU 剔除之后能看到物体的面）
+
+out vec4 FragPos;
+
+void main()
+{
+    int face = faceIndices[gl_InstanceID];
+    gl_Layer = face;
+    FragPos = model * vec4(aPos, 1.0);
+    gl_Position = shadowMatrices[face] * FragPos;
+}
@@ -0,0 +1,22 @@
+#version 330 core
+layout (location = 0) in vec3 aPos;
+
+uniform mat4 model;
+uniform vec3 lightPos;
+uniform float far_plane;
+uniform float hemisphere;   // 1.0：+Z 半球，-1.0：-Z 半球
+
+out vec4 FragPos;
+
+// 对偶抛物面投影：单位方向 d（z 朝向当前半球）映射到 d.xy / (1 + d.z)，整个半球落在单位圆内
+void main()
+{
+    FragPos = model * vec4(aPos, 1.0);
+    vec3 direction = FragPos.xyz - lightPos;
+    direction.z *= hemisphere;
+    float distance = length(direction);
+    direction /= distance;
+    // 另一个半球的部分裁掉
+    gl_ClipDistance[0] = direction.z;
+    gl_Position = vec4(direction.xy / (1.0 + direction.z), distance / far_plane * 2.0 - 1.0, 1.0);
+}
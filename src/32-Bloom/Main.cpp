@@ -1,4 +1,5 @@
 #include <iostream>
+#include <iomanip>
 #include <map>
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
@@ -9,6 +10,8 @@
 #include <glm/gtc/matrix_transform.hpp>
 
 #include <tool/Model.h>
+#include <tool/Headless.h>
+#include <tool/GpuProfiler.h>
 
 const int SCREEN_WIDTH = 1280;
 const int SCREEN_HEIGHT = 720;
@@ -32,6 +35,9 @@ glm::vec3 LightPos{1.2f, 1.0f, 2.0f};
 float exposure = 1.0f;
 bool bloom = true;
 bool bloomKeyPressed = false;
+// bloom 模糊方式：mip 链（dual filter）或原来的 ping-pong 高斯模糊，M 键切换
+bool bMipBloom = true;
+bool bloomMethodKeyPressed = false;
 
 void FramebufferSizeCallback(GLFWwindow *window, int width, int height)
 {
@@ -54,6 +60,14 @@ void ProcessInput(GLFWwindow *window)
         camera.ProcessKeyboard(UP, DeltaTime);
     if (glfwGetKey(window, GLFW_KEY_Q) == GLFW_PRESS)
         camera.ProcessKeyboard(DOWN, DeltaTime);
+
+    if (glfwGetKey(window, GLFW_KEY_M) == GLFW_PRESS && !bloomMethodKeyPressed)
+    {
+        bMipBloom = !bMipBloom;
+        bloomMethodKeyPressed = true;
+    }
+    if (glfwGetKey(window, GLFW_KEY_M) == GLFW_RELEASE)
+        bloomMethodKeyPressed = false;
 }
 
 void CursorPosCallback(GLFWwindow *window, double xpos, double ypos)
@@ -221,14 +235,285 @@ void RenderQuad()
     glBindVertexArray(0);
 }
 
+// ping-pong-framebuffer for blurring
+struct PingPongTargets
+{
+    unsigned int FBO[2];
+    unsigned int ColorBuffers[2];
+
+    void Create(int width, int height)
+    {
+        glGenFramebuffers(2, FBO);
+        glGenTextures(2, ColorBuffers);
+        for (unsigned int i = 0; i < 2; i++)
+        {
+            glBindFramebuffer(GL_FRAMEBUFFER, FBO[i]);
+            glBindTexture(GL_TEXTURE_2D, ColorBuffers[i]);
+            glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA16F, width, height, 0, GL_RGBA, GL_FLOAT, NULL);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE); // we clamp to the edge as the blur filter would otherwise sample repeated texture values!
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+            glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, ColorBuffers[i], 0);
+            // also check if framebuffers are complete (no need for depth buffer)
+            if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+                std::cout << "Framebuffer not complete!" << std::endl;
+        }
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    }
+
+    void Destroy()
+    {
+        glDeleteTextures(2, ColorBuffers);
+        glDeleteFramebuffers(2, FBO);
+    }
+};
+
+// blur bright fragments with two-pass Gaussian Blur：水平/竖直交替 amount 次，返回结果所在的纹理
+const unsigned int PING_PONG_AMOUNT = 10;
+unsigned int BlurPingPong(Shader& shaderBlur, const PingPongTargets& targets, unsigned int source)
+{
+    bool horizontal = true, first_iteration = true;
+    shaderBlur.Use();
+    glActiveTexture(GL_TEXTURE0);
+    for (unsigned int i = 0; i < PING_PONG_AMOUNT; i++)
+    {
+        glBindFramebuffer(GL_FRAMEBUFFER, targets.FBO[horizontal]);
+        shaderBlur.SetInt("horizontal", horizontal);
+        // bind texture of other framebuffer (or scene if first iteration)
+        glBindTexture(GL_TEXTURE_2D, first_iteration ? source : targets.ColorBuffers[!horizontal]);
+        RenderQuad();
+        horizontal = !horizontal;
+        if (first_iteration)
+            first_iteration = false;
+    }
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    return targets.ColorBuffers[!horizontal];
+}
+
+// 每次全分辨率模糊 9 次采样
+double GetPingPongFetches(int width, int height)
+{
+    return static_cast<double>(width) * height * 9.0 * PING_PONG_AMOUNT;
+}
+
+// mip 链 bloom（dual filter）：一张 RGBA16F 纹理，第 0 级是源的一半分辨率
+// 1. 降采样：源 -> 0 -> 1 -> ... -> N-1，每一级读上一级
+// 2. 升采样：N-1 -> N-2 -> ... -> 0，每一级读小一级并加法混合到自己身上
+// 读写同一张纹理的不同级别时，用 GL_TEXTURE_BASE_LEVEL/MAX_LEVEL 把可采样的范围限制在被读的那一级，避免反馈回路
+// 光晕半径由级数决定（每一级覆盖的范围翻倍），和全分辨率的模糊次数无关
+class BloomMipChain
+{
+public:
+    void Create(int width, int height, unsigned int levels)
+    {
+        // 最小的一级至少 2x2
+        Sizes.clear();
+        int levelWidth = width / 2, levelHeight = height / 2;
+        while (Sizes.size() < levels && levelWidth >= 2 && levelHeight >= 2)
+        {
+            Sizes.push_back(glm::ivec2(levelWidth, levelHeight));
+            levelWidth /= 2;
+            levelHeight /= 2;
+        }
+        glGenTextures(1, &Texture);
+        glBindTexture(GL_TEXTURE_2D, Texture);
+        for (size_t level = 0; level < Sizes.size(); level++)
+            glTexImage2D(GL_TEXTURE_2D, static_cast<GLint>(level), GL_RGBA16F, Sizes[level].x, Sizes[level].y, 0, GL_RGBA, GL_FLOAT, NULL);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        SetSourceLevel(0);
+
+        FBOs.resize(Sizes.size());
+        glGenFramebuffers(static_cast<GLsizei>(FBOs.size()), FBOs.data());
+        for (size_t level = 0; level < Sizes.size(); level++)
+        {
+            glBindFramebuffer(GL_FRAMEBUFFER, FBOs[level]);
+            glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, Texture, static_cast<GLint>(level));
+            if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+                std::cout << "Bloom mip " << level << " framebuffer not complete!" << std::endl;
+        }
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    }
+
+    void Destroy()
+    {
+        glDeleteFramebuffers(static_cast<GLsizei>(FBOs.size()), FBOs.data());
+        glDeleteTextures(1, &Texture);
+        FBOs.clear();
+        Sizes.clear();
+    }
+
+    // 返回结果所在的纹理（第 0 级），调用之后需要恢复视口
+    unsigned int Render(unsigned int source, Shader& shaderDownsample, Shader& shaderUpsample, float filterRadius)
+    {
+        shaderDownsample.Use();
+        glActiveTexture(GL_TEXTURE0);
+        for (size_t level = 0; level < Sizes.size(); level++)
+        {
+            glBindFramebuffer(GL_FRAMEBUFFER, FBOs[level]);
+            glViewport(0, 0, Sizes[level].x, Sizes[level].y);
+            if (level == 0)
+                glBindTexture(GL_TEXTURE_2D, source);
+            else
+            {
+                glBindTexture(GL_TEXTURE_2D, Texture);
+                SetSourceLevel(static_cast<int>(level) - 1);
+            }
+            RenderQuad();
+        }
+
+        shaderUpsample.Use();
+        shaderUpsample.SetFloat("filterRadius", filterRadius);
+        glBindTexture(GL_TEXTURE_2D, Texture);
+        glEnable(GL_BLEND);
+        glBlendFunc(GL_ONE, GL_ONE);
+        for (int level = static_cast<int>(Sizes.size()) - 2; level >= 0; level--)
+        {
+            glBindFramebuffer(GL_FRAMEBUFFER, FBOs[level]);
+            glViewport(0, 0, Sizes[level].x, Sizes[level].y);
+            SetSourceLevel(level + 1);
+            RenderQuad();
+        }
+        glDisable(GL_BLEND);
+        SetSourceLevel(0);
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        return Texture;
+    }
+
+    // 降采样每个输出 texel 5 次采样，升采样 8 次
+    double GetTexelFetches() const
+    {
+        double fetches = 0.0;
+        for (size_t level = 0; level < Sizes.size(); level++)
+        {
+            double texels = static_cast<double>(Sizes[level].x) * Sizes[level].y;
+            fetches += texels * 5.0;
+            if (level + 1 < Sizes.size())
+                fetches += texels * 8.0;
+        }
+        return fetches;
+    }
+
+    inline unsigned int GetLevelCount() const { return static_cast<unsigned int>(Sizes.size()); }
+    inline unsigned int GetTexture() const { return Texture; }
+
+private:
+    unsigned int Texture = 0;
+    std::vector<unsigned int> FBOs;
+    std::vector<glm::ivec2> Sizes;
+
+    // 需要先绑定 Texture
+    void SetSourceLevel(int level)
+    {
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, level);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, level);
+    }
+};
+
+// 1080p 和 4K 下两种 bloom 的 GPU 耗时和纹理采样次数（源是一张填满亮色的 RGBA16F 纹理，耗时和内容无关）
+void RunBloomBenchmark(Shader& shaderBlur, Shader& shaderDownsample, Shader& shaderUpsample, unsigned int levels, float filterRadius)
+{
+    const int resolutions[2][2] = { { 1920, 1080 }, { 3840, 2160 } };
+    const int ITERATIONS = 100;
+    const int WARMUP = 10;
+    std::cout << std::setw(12) << "resolution" << std::setw(14) << "method" << std::setw(8) << "passes"
+              << std::setw(12) << "GPU(ms)" << std::setw(14) << "fetches(M)" << std::endl;
+    for (const auto& resolution : resolutions)
+    {
+        const int width = resolution[0], height = resolution[1];
+        unsigned int sourceFBO;
+        unsigned int source;
+        glGenFramebuffers(1, &sourceFBO);
+        glBindFramebuffer(GL_FRAMEBUFFER, sourceFBO);
+        glGenTextures(1, &source);
+        glBindTexture(GL_TEXTURE_2D, source);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA16F, width, height, 0, GL_RGBA, GL_FLOAT, NULL);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, source, 0);
+        glClearColor(2.0f, 2.0f, 2.0f, 1.0f);
+        glClear(GL_COLOR_BUFFER_BIT);
+        glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+
+        PingPongTargets pingpong;
+        pingpong.Create(width, height);
+        BloomMipChain mipChain;
+        mipChain.Create(width, height, levels);
+
+        // 每次迭代都等 GPU 完成，保证查询结果不会被丢弃
+        GpuProfiler profiler;
+        for (int i = 0; i < ITERATIONS + WARMUP; i++)
+        {
+            profiler.BeginFrame();
+            profiler.PushScope("ping-pong");
+            glViewport(0, 0, width, height);
+            BlurPingPong(shaderBlur, pingpong, source);
+            profiler.PopScope();
+            profiler.PushScope("mip chain");
+            mipChain.Render(source, shaderDownsample, shaderUpsample, filterRadius);
+            profiler.PopScope();
+            profiler.EndFrame();
+            profiler.Flush();
+        }
+
+        double pingpongMs = 0.0, mipMs = 0.0;
+        int frames = 0;
+        for (const GpuProfiler::FrameResult& frame : profiler.GetHistory())
+        {
+            if (frame.Frame < static_cast<unsigned int>(WARMUP))
+                continue;
+            for (const GpuProfiler::ScopeResult& scope : frame.Scopes)
+                (scope.Name == "ping-pong" ? pingpongMs : mipMs) += scope.TotalMs;
+            frames++;
+        }
+        frames = std::max(frames, 1);
+        std::cout << std::fixed << std::setw(7) << width << "x" << std::setw(4) << std::left << height << std::right
+                  << std::setw(14) << "ping-pong" << std::setw(8) << PING_PONG_AMOUNT
+                  << std::setprecision(3) << std::setw(12) << pingpongMs / frames
+                  << std::setprecision(1) << std::setw(14) << GetPingPongFetches(width, height) / 1e6 << std::endl;
+        std::cout << std::setw(12) << "" << std::setw(14) << "mip chain" << std::setw(8) << mipChain.GetLevelCount() * 2 - 1
+                  << std::setprecision(3) << std::setw(12) << mipMs / frames
+                  << std::setprecision(1) << std::setw(14) << mipChain.GetTexelFetches() / 1e6 << std::endl;
+
+        mipChain.Destroy();
+        pingpong.Destroy();
+        glDeleteTextures(1, &source);
+        glDeleteFramebuffers(1, &sourceFBO);
+    }
+    glViewport(0, 0, SCREEN_WIDTH, SCREEN_HEIGHT);
+}
+
 int main(int argc, char **argv)
 {
+    // headless mode: --headless --frames=N --capture=F1,F2 --output=DIR
+    HeadlessOptions headlessOptions = ParseHeadlessOptions(argc, argv);
+    ConfigureHeadlessPlatform(headlessOptions);
+    // bloom: --bloom=mip|pingpong, --bloom-levels=N (mip 链级数，决定光晕半径), --bloom-benchmark（1080p / 4K 对比后退出）
+    unsigned int bloomLevels = 6u;
+    bool bBloomBenchmark = false;
+    for (int i = 1; i < argc; i++)
+    {
+        std::string arg = argv[i];
+        if (arg == "--bloom=pingpong")
+            bMipBloom = false;
+        else if (arg.rfind("--bloom-levels=", 0) == 0)
+            bloomLevels = static_cast<unsigned int>(std::max(1, std::atoi(arg.c_str() + 15)));
+        else if (arg == "--bloom-benchmark")
+            bBloomBenchmark = true;
+    }
+
     // glfw and glad initialize
     if (!glfwInit())
         return -1;
     glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
     glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
     glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+    ConfigureHeadlessWindowHints(headlessOptions);
 
     GLFWwindow *window = glfwCreateWindow(SCREEN_WIDTH, SCREEN_HEIGHT, "LearnOpenGL", nullptr, nullptr);
     if (window == nullptr)
@@ -265,6 +550,9 @@ int main(int argc, char **argv)
     Shader shaderLight("./src/32-Bloom/Shaders/bloom.vs", "./src/32-Bloom/Shaders/light_box.fs");
     Shader shaderBlur("./src/32-Bloom/Shaders/blur.vs", "./src/32-Bloom/Shaders/blur.fs");
     Shader shaderBloomFinal("./src/32-Bloom/Shaders/bloom_final.vs", "./src/32-Bloom/Shaders/bloom_final.fs");
+    Shader shaderDownsample("./src/32-Bloom/Shaders/blur.vs", "./src/32-Bloom/Shaders/bloom_downsample.fs");
+    Shader shaderUpsample("./src/32-Bloom/Shaders/blur.vs", "./src/32-Bloom/Shaders/bloom_upsample.fs");
+    const float bloomFilterRadius = 1.0f;
 
     // load textures (enable gamma correct)
     // note that we're loading the texture as an SRGB texture
@@ -306,24 +594,11 @@ int main(int argc, char **argv)
     glBindFramebuffer(GL_FRAMEBUFFER, 0);
 
     // ping-pong-framebuffer for blurring
-    unsigned int pingpongFBO[2];
-    unsigned int pingpongColorbuffers[2];
-    glGenFramebuffers(2, pingpongFBO);
-    glGenTextures(2, pingpongColorbuffers);
-    for (unsigned int i = 0; i < 2; i++)
-    {
-        glBindFramebuffer(GL_FRAMEBUFFER, pingpongFBO[i]);
-        glBindTexture(GL_TEXTURE_2D, pingpongColorbuffers[i]);
-        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA16F, SCREEN_WIDTH, SCREEN_HEIGHT, 0, GL_RGBA, GL_FLOAT, NULL);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE); // we clamp to the edge as the blur filter would otherwise sample repeated texture values!
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, pingpongColorbuffers[i], 0);
-        // also check if framebuffers are complete (no need for depth buffer)
-        if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
-            std::cout << "Framebuffer not complete!" << std::endl;
-    }
+    PingPongTargets pingpong;
+    pingpong.Create(SCREEN_WIDTH, SCREEN_HEIGHT);
+    // mip chain for the dual-filter bloom
+    BloomMipChain bloomMipChain;
+    bloomMipChain.Create(SCREEN_WIDTH, SCREEN_HEIGHT, bloomLevels);
 
     // lighting info
     // -------------
@@ -350,9 +625,31 @@ int main(int argc, char **argv)
     shaderBloomFinal.Use();
     shaderBloomFinal.SetInt("scene", 0);
     shaderBloomFinal.SetInt("bloomBlur", 1);
+    shaderDownsample.Use();
+    shaderDownsample.SetInt("image", 0);
+    shaderUpsample.Use();
+    shaderUpsample.SetInt("image", 0);
+
+    if (bBloomBenchmark)
+    {
+        shaderBlur.Use();
+        RunBloomBenchmark(shaderBlur, shaderDownsample, shaderUpsample, bloomLevels, bloomFilterRadius);
+        bloomMipChain.Destroy();
+        pingpong.Destroy();
+        glfwTerminate();
+        return 0;
+    }
+
+    // scripted camera path, timings and captures for headless runs
+    HeadlessRunner headlessRunner(headlessOptions, CameraPath::Orbit(glm::vec3(0.0f, 0.0f, 0.0f), 6.0f, 1.5f, 4.0f), SCREEN_WIDTH, SCREEN_HEIGHT);
+    headlessRunner.AddCapture("hdrScene", hdrFBO, GL_COLOR_ATTACHMENT0, true);
+    headlessRunner.AddCapture("brightPass", hdrFBO, GL_COLOR_ATTACHMENT1, true);
+
+    // per-pass GPU timings, exported on exit
+    GpuProfiler profiler;
 
     // render loop
-    while (!glfwWindowShouldClose(window))
+    while (!glfwWindowShouldClose(window) && !headlessRunner.IsFinished())
     {
         float CurrentTime = static_cast<float>(glfwGetTime());
         DeltaTime = CurrentTime - LastTime;
@@ -370,6 +667,8 @@ int main(int argc, char **argv)
         }
 
         ProcessInput(window);
+        headlessRunner.BeginFrame(camera, DeltaTime);
+        profiler.BeginFrame();
 
         // render
         glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
@@ -377,6 +676,8 @@ int main(int argc, char **argv)
 
         // 1. render scene into floating point framebuffer
         // -----------------------------------------------
+        // 亮度提取作为 MRT 的第二个输出和场景一起写入，所以 bright pass 就是整个场景 pass
+        profiler.PushScope("bright pass");
         glBindFramebuffer(GL_FRAMEBUFFER, hdrFBO);
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
         glm::mat4 projection = glm::perspective(glm::radians(camera.Fov), (float)SCREEN_WIDTH / (float)SCREEN_HEIGHT, 0.1f, 100.0f);
@@ -454,38 +755,46 @@ int main(int argc, char **argv)
             RenderCube();
         }
         glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        profiler.PopScope();
 
-        // 2. blur bright fragments with two-pass Gaussian Blur 
-        // --------------------------------------------------
-        bool horizontal = true, first_iteration = true;
-        unsigned int amount = 10;
-        shaderBlur.Use();
-        for (unsigned int i = 0; i < amount; i++)
+        // 2. blur bright fragments: mip-chain (dual filter) or two-pass Gaussian Blur
+        // --------------------------------------------------------------------------
+        unsigned int bloomTexture;
+        if (bMipBloom)
         {
-            glBindFramebuffer(GL_FRAMEBUFFER, pingpongFBO[horizontal]);
-            shaderBlur.SetInt("horizontal", horizontal);
-            // bind texture of other framebuffer (or scene if first iteration)
-            glBindTexture(GL_TEXTURE_2D, first_iteration ? colorBuffers[1] : pingpongColorbuffers[!horizontal]);
-            RenderQuad();
-            horizontal = !horizontal;
-            if (first_iteration)
-                first_iteration = false;
+            profiler.PushScope("mip-chain bloom");
+            bloomTexture = bloomMipChain.Render(colorBuffers[1], shaderDownsample, shaderUpsample, bloomFilterRadius);
+            glViewport(0, 0, SCREEN_WIDTH, SCREEN_HEIGHT);
+            profiler.PopScope();
+        }
+        else
+        {
+            profiler.PushScope("ping-pong blur");
+            bloomTexture = BlurPingPong(shaderBlur, pingpong, colorBuffers[1]);
+            profiler.PopScope();
         }
-        glBindFramebuffer(GL_FRAMEBUFFER, 0);
 
         // 3. now render floating point color buffer to 2D quad and tonemap HDR colors to default framebuffer's (clamped) color range
         // --------------------------------------------------------------------------------------------------------------------------
+        profiler.PushScope("composite");
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
         shaderBloomFinal.Use();
         glActiveTexture(GL_TEXTURE0);
         glBindTexture(GL_TEXTURE_2D, colorBuffers[0]);
         glActiveTexture(GL_TEXTURE1);
-        glBindTexture(GL_TEXTURE_2D, pingpongColorbuffers[!horizontal]);
+        glBindTexture(GL_TEXTURE_2D, bloomTexture);
         shaderBloomFinal.SetInt("bloom", bloom);
+        shaderBloomFinal.SetFloat("bloomIntensity", bMipBloom ? 1.0f / bloomMipChain.GetLevelCount() : 1.0f);
         shaderBloomFinal.SetFloat("exposure", exposure);
         RenderQuad();
+        profiler.PopScope();
+
+        // headless 运行时每帧输出会淹没 CSV 结果
+        if (!headlessOptions.bEnabled)
+            std::cout << "bloom: " << (bloom ? "on" : "off") << "| exposure: " << exposure << std::endl;
 
-        std::cout << "bloom: " << (bloom ? "on" : "off") << "| exposure: " << exposure << std::endl;
+        profiler.EndFrame();
+        headlessRunner.EndFrame();
 
         // swap and poll events
         glfwSwapBuffers(window);
@@ -497,6 +806,13 @@ int main(int argc, char **argv)
     glDeleteBuffers(1, &cubeVBO);
     glDeleteVertexArrays(1, &quadVAO);
     glDeleteVertexArrays(1, &cubeVAO);
+    bloomMipChain.Destroy();
+    pingpong.Destroy();
+
+    profiler.Flush();
+    profiler.PrintSummary();
+    profiler.ExportCSV(headlessOptions.OutputDir + "/gpu_profile.csv");
+    profiler.ExportChromeTrace(headlessOptions.OutputDir + "/gpu_profile.json");
 
     glfwTerminate();
     return 0;
@@ -0,0 +1,19 @@
+#version 330 core
+out vec4 FragColor;
+
+in vec2 TexCoords;
+
+// dual filter 降采样：输出 texel 的中心正好在 4 个源 texel 的交点，中心一次双线性采样（2x2 平均）占 4 份，
+// 四个对角方向偏移一个源 texel 的采样各占 1 份，每个输出 texel 覆盖 4x4 个源 texel
+uniform sampler2D image;
+
+void main()
+{
+    vec2 texel = 1.0 / vec2(textureSize(image, 0));
+    vec3 result = texture(image, TexCoords).rgb * 4.0;
+    result += texture(image, TexCoords + vec2(-texel.x, -texel.y)).rgb;
+    result += texture(image, TexCoords + vec2( texel.x, -texel.y)).rgb;
+    result += texture(image, TexCoords + vec2(-texel.x,  texel.y)).rgb;
+    result += texture(image, TexCoords + vec2( texel.x,  texel.y)).rgb;
+    FragColor = vec4(result / 8.0, 1.0);
+}
@@ -7,6 +7,8 @@ uniform sampler2D scene;
 uniform sampler2D bloomBlur;
 uniform bool bloom;
 uniform float exposure;
+// mip 链的结果是所有级别叠加，按级数归一化（ping-pong 高斯模糊为 1）
+uniform float bloomIntensity = 1.0;
 
 void main()
 {             
@@ -14,7 +16,7 @@ void main()
     vec3 hdrColor = texture(scene, TexCoords).rgb;      
     vec3 bloomColor = texture(bloomBlur, TexCoords).rgb;
     if(bloom)
-        hdrColor += bloomColor; // additive blending
+        hdrColor += bloomColor * bloomIntensity; // additive blending
     // tone mapping
     vec3 result = vec3(1.0) - exp(-hdrColor * exposure);
     // also gamma correct while we're at it       
@@ -0,0 +1,24 @@
+#version 330 core
+out vec4 FragColor;
+
+in vec2 TexCoords;
+
+// dual filter 升采样：小一级的 mip 用 8 个双线性采样（4 个轴向、4 个对角且权重加倍）放大，
+// 结果加法混合到当前这一级（这一级里已经是降采样的结果），逐级叠加得到大半径的光晕
+uniform sampler2D image;
+// 采样偏移（源 texel 为单位），越大光晕越散
+uniform float filterRadius;
+
+void main()
+{
+    vec2 offset = 0.5 * filterRadius / vec2(textureSize(image, 0));
+    vec3 result = texture(image, TexCoords + vec2(-offset.x * 2.0, 0.0)).rgb;
+    result += texture(image, TexCoords + vec2( offset.x * 2.0, 0.0)).rgb;
+    result += texture(image, TexCoords + vec2(0.0, -offset.y * 2.0)).rgb;
+    result += texture(image, TexCoords + vec2(0.0,  offset.y * 2.0)).rgb;
+    result += texture(image, TexCoords + vec2(-offset.x, -offset.y)).rgb * 2.0;
+    result += texture(image, TexCoords + vec2( offset.x, -offset.y)).rgb * 2.0;
+    result += texture(image, TexCoords + vec2(-offset.x,  offset.y)).rgb * 2.0;
+    result += texture(image, TexCoords + vec2( offset.x,  offset.y)).rgb * 2.0;
+    FragColor = vec4(result / 12.0, 1.0);
+}
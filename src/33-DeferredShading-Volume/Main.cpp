@@ -1,5 +1,7 @@
 #include <iostream>
+#include <iomanip>
 #include <map>
+#include <chrono>
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
 #include <tool/Shader.h>
@@ -10,6 +12,11 @@
 #include <glm/gtc/type_ptr.hpp>
 
 #include <tool/Model.h>
+#include <tool/JobSystem.h>
+#include <tool/ClusteredLights.h>
+#include <tool/StreamBuffer.h>
+#include <tool/GpuProfiler.h>
+#include <tool/Headless.h>
 
 const int SCREEN_WIDTH = 1280;
 const int SCREEN_HEIGHT = 720;
@@ -34,6 +41,34 @@ float exposure = 1.0f;
 bool bloom = true;
 bool bloomKeyPressed = false;
 
+// 光照方式：全屏四边形遍历簇中的光源，或者光体积（每个光源画一个球，只着色它覆盖的像素），V 键切换
+enum class LightingMode
+{
+    FullScreen = 0,
+    Volumes = 1
+};
+const char* LightingModeNames[2] = { "full-screen", "volumes" };
+LightingMode lightingMode = LightingMode::Volumes;
+bool lightingKeyPressed = false;
+
+// 衰减参数和光体积半径，radiusScale < 1 时缩小光体积并相应加大二次衰减系数，
+// 光源很多时保持每个像素受到的光源数量大致不变
+ClusterLight MakeClusterLight(const glm::vec3& position, const glm::vec3& color, float linear, float radiusScale)
+{
+    const float constant = 1.0f; // note that we don't send this to the shader, we assume it is always 1.0 (in our case)
+    float quadratic = 1.8f;
+    // then calculate radius of light volume/sphere
+    // 计算光体积
+    const float maxBrightness = std::fmaxf(std::fmaxf(color.r, color.g), color.b);
+    float radius = (-linear + std::sqrt(linear * linear - 4 * quadratic * (constant - (256.0f / 5.0f) * maxBrightness))) / (2.0f * quadratic);
+    if (radiusScale < 1.0f)
+    {
+        radius *= radiusScale;
+        quadratic = ((256.0f / 5.0f) * maxBrightness - constant - linear * radius) / (radius * radius);
+    }
+    return ClusterLight{ position, radius, color, quadratic };
+}
+
 void FramebufferSizeCallback(GLFWwindow *window, int width, int height)
 {
     glViewport(0u, 0u, width, height);
@@ -55,6 +90,14 @@ void ProcessInput(GLFWwindow *window)
         camera.ProcessKeyboard(UP, DeltaTime);
     if (glfwGetKey(window, GLFW_KEY_Q) == GLFW_PRESS)
         camera.ProcessKeyboard(DOWN, DeltaTime);
+
+    if (glfwGetKey(window, GLFW_KEY_V) == GLFW_PRESS && !lightingKeyPressed)
+    {
+        lightingMode = lightingMode == LightingMode::Volumes ? LightingMode::FullScreen : LightingMode::Volumes;
+        lightingKeyPressed = true;
+    }
+    if (glfwGetKey(window, GLFW_KEY_V) == GLFW_RELEASE)
+        lightingKeyPressed = false;
 }
 
 void CursorPosCallback(GLFWwindow *window, double xpos, double ypos)
@@ -223,14 +266,198 @@ void RenderQuad()
     glBindVertexArray(0);
 }
 
+// 光体积网格：细分的正二十面体，顶点放大到所有面都在单位球外面（网格完整包住光体积）
+// -------------------------------------------------------------------------------
+unsigned int sphereVAO = 0;
+unsigned int sphereVBO = 0;
+unsigned int sphereEBO = 0;
+unsigned int sphereIndexCount = 0;
+void CreateIcosphere(unsigned int subdivisions)
+{
+    const float t = (1.0f + std::sqrt(5.0f)) / 2.0f;
+    std::vector<glm::vec3> positions = {
+        {-1,  t,  0}, { 1,  t,  0}, {-1, -t,  0}, { 1, -t,  0},
+        { 0, -1,  t}, { 0,  1,  t}, { 0, -1, -t}, { 0,  1, -t},
+        { t,  0, -1}, { t,  0,  1}, {-t,  0, -1}, {-t,  0,  1}
+    };
+    std::vector<unsigned int> indices = {
+        0, 11, 5,   0, 5, 1,    0, 1, 7,    0, 7, 10,   0, 10, 11,
+        1, 5, 9,    5, 11, 4,   11, 10, 2,  10, 7, 6,   7, 1, 8,
+        3, 9, 4,    3, 4, 2,    3, 2, 6,    3, 6, 8,    3, 8, 9,
+        4, 9, 5,    2, 4, 11,   6, 2, 10,   8, 6, 7,    9, 8, 1
+    };
+    for (glm::vec3& position : positions)
+        position = glm::normalize(position);
+    for (unsigned int level = 0; level < subdivisions; level++)
+    {
+        // 每个三角形分成 4 个，边的中点投影到球面上（共享边的中点只生成一次）
+        std::map<std::pair<unsigned int, unsigned int>, unsigned int> midpoints;
+        auto midpoint = [&](unsigned int a, unsigned int b)
+        {
+            std::pair<unsigned int, unsigned int> key(std::min(a, b), std::max(a, b));
+            auto it = midpoints.find(key);
+            if (it != midpoints.end())
+                return it->second;
+            positions.push_back(glm::normalize(positions[a] + positions[b]));
+            unsigned int index = static_cast<unsigned int>(positions.size() - 1);
+            midpoints[key] = index;
+            return index;
+        };
+        std::vector<unsigned int> subdivided;
+        for (size_t i = 0; i < indices.size(); i += 3)
+        {
+            unsigned int a = indices[i], b = indices[i + 1], c = indices[i + 2];
+            unsigned int ab = midpoint(a, b), bc = midpoint(b, c), ca = midpoint(c, a);
+            subdivided.insert(subdivided.end(), { a, ab, ca,  b, bc, ab,  c, ca, bc,  ab, bc, ca });
+        }
+        indices.swap(subdivided);
+    }
+    // 顶点在单位球上时三角形面会切进球里，按离球心最近的面放大
+    float minDistance = 1.0f;
+    for (size_t i = 0; i < indices.size(); i += 3)
+    {
+        const glm::vec3& a = positions[indices[i]];
+        glm::vec3 normal = glm::normalize(glm::cross(positions[indices[i + 1]] - a, positions[indices[i + 2]] - a));
+        minDistance = std::min(minDistance, std::fabs(glm::dot(normal, a)));
+    }
+    for (glm::vec3& position : positions)
+        position /= minDistance;
+
+    glGenVertexArrays(1, &sphereVAO);
+    glGenBuffers(1, &sphereVBO);
+    glGenBuffers(1, &sphereEBO);
+    glBindVertexArray(sphereVAO);
+    glBindBuffer(GL_ARRAY_BUFFER, sphereVBO);
+    glBufferData(GL_ARRAY_BUFFER, positions.size() * sizeof(glm::vec3), positions.data(), GL_STATIC_DRAW);
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(glm::vec3), (void*)0);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, sphereEBO);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int), indices.data(), GL_STATIC_DRAW);
+    glBindVertexArray(0);
+    sphereIndexCount = static_cast<unsigned int>(indices.size());
+}
+
+// 每个实例的光源数据（ClusterLight 的两个 vec4）在流式缓冲中的位置每帧都不同，画之前重新指向当前段
+void RenderLightVolumes(unsigned int instanceBuffer, size_t offset, unsigned int lightCount)
+{
+    glBindVertexArray(sphereVAO);
+    glBindBuffer(GL_ARRAY_BUFFER, instanceBuffer);
+    glEnableVertexAttribArray(1);
+    glVertexAttribPointer(1, 4, GL_FLOAT, GL_FALSE, sizeof(ClusterLight), (void*)offset);
+    glVertexAttribDivisor(1, 1);
+    glEnableVertexAttribArray(2);
+    glVertexAttribPointer(2, 4, GL_FLOAT, GL_FALSE, sizeof(ClusterLight), (void*)(offset + sizeof(glm::vec4)));
+    glVertexAttribDivisor(2, 1);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glDrawElementsInstanced(GL_TRIANGLES, sphereIndexCount, GL_UNSIGNED_INT, 0, static_cast<GLsizei>(lightCount));
+    glBindVertexArray(0);
+}
+
+// GL_ARB_pipeline_statistics_query（GL 4.6 核心），glad 只生成了 3.3 core，没有这个常量
+#ifndef GL_FRAGMENT_SHADER_INVOCATIONS_ARB
+#define GL_FRAGMENT_SHADER_INVOCATIONS_ARB 0x82F4
+#endif
+
+// 统计光照着色的片段数用的查询：片段着色器的执行次数包括被丢弃的片段和不写颜色的模板预处理；
+// 不支持时退回 GL_SAMPLES_PASSED，它不包括被丢弃的片段和深度测试失败的片段（模板预处理增减模板的正是这些片段）
+GLenum GetFragmentQueryTarget()
+{
+    int major = 0;
+    glGetIntegerv(GL_MAJOR_VERSION, &major);
+    int minor = 0;
+    glGetIntegerv(GL_MINOR_VERSION, &minor);
+    bool bSupported = major > 4 || (major == 4 && minor >= 6) || glfwExtensionSupported("GL_ARB_pipeline_statistics_query");
+    return bSupported ? GL_FRAGMENT_SHADER_INVOCATIONS_ARB : GL_SAMPLES_PASSED;
+}
+
+// 每种光照方式的统计，退出时输出对比
+struct LightingModeStats
+{
+    unsigned int Frames = 0;
+    double FrameMs = 0.0;
+    // 光照 pass 的片段数（查询见 GetFragmentQueryTarget）
+    double Fragments = 0.0;
+    unsigned int FragmentFrames = 0;
+};
+
+void PrintLightingReport(const LightingModeStats stats[2], const GpuProfiler& profiler, unsigned int lightCount, GLenum fragmentQueryTarget)
+{
+    // 光照 pass 的 GPU 时间从分析器的历史记录中按区间名字统计
+    double gpuMs[2] = { 0.0, 0.0 };
+    unsigned int gpuFrames[2] = { 0u, 0u };
+    for (const GpuProfiler::FrameResult& frame : profiler.GetHistory())
+    {
+        for (const GpuProfiler::ScopeResult& scope : frame.Scopes)
+        {
+            for (int mode = 0; mode < 2; mode++)
+            {
+                if (scope.Name == std::string("lighting: ") + LightingModeNames[mode])
+                {
+                    gpuMs[mode] += scope.TotalMs;
+                    gpuFrames[mode]++;
+                }
+            }
+        }
+    }
+    const double pixels = static_cast<double>(SCREEN_WIDTH) * SCREEN_HEIGHT;
+    std::cout << "lighting report (" << lightCount << " lights, " << SCREEN_WIDTH << "x" << SCREEN_HEIGHT << ")" << std::endl;
+    std::cout << std::left << std::setw(14) << "mode" << std::right
+              << std::setw(8) << "frames" << std::setw(12) << "frame(ms)" << std::setw(15) << "lighting(ms)"
+              << std::setw(16) << "fragments(M)" << std::setw(16) << "fragments/px" << std::endl;
+    for (int mode = 0; mode < 2; mode++)
+    {
+        if (stats[mode].Frames == 0)
+            continue;
+        double fragments = stats[mode].FragmentFrames > 0 ? stats[mode].Fragments / stats[mode].FragmentFrames : 0.0;
+        std::cout << std::left << std::setw(14) << LightingModeNames[mode] << std::right << std::fixed << std::setprecision(3)
+                  << std::setw(8) << stats[mode].Frames
+                  << std::setw(12) << stats[mode].FrameMs / stats[mode].Frames
+                  << std::setw(15) << (gpuFrames[mode] > 0 ? gpuMs[mode] / gpuFrames[mode] : 0.0)
+                  << std::setw(16) << fragments / 1e6
+                  << std::setw(16) << fragments / pixels << std::endl;
+    }
+    // 片段数包括哪些 pass
+    if (fragmentQueryTarget == GL_FRAGMENT_SHADER_INVOCATIONS_ARB)
+        std::cout << "fragments: fragment shader invocations, full-screen = lighting quad, "
+                  << "volumes = ambient quad + stencil pass + lighting volumes (discarded fragments included)" << std::endl;
+    else
+        std::cout << "fragments: GL_SAMPLES_PASSED (no GL_ARB_pipeline_statistics_query), full-screen = lighting quad, "
+                  << "volumes = ambient quad + stencil pass + lighting volumes, excluding discarded fragments and "
+                  << "stencil pass fragments that fail the depth test (volumes is a lower bound)" << std::endl;
+}
+
 int main(int argc, char **argv)
 {
+    // headless mode: --headless --frames=N --capture=F1,F2 --output=DIR
+    HeadlessOptions headlessOptions = ParseHeadlessOptions(argc, argv);
+    ConfigureHeadlessPlatform(headlessOptions);
+    // light count: --lights=N (default 32), light assignment: --light-culling=cpu|compute
+    // lighting: --lighting=volume|fullscreen|compare（compare 每 120 帧切换一次，用于对比报告）
+    unsigned int lightCount = 32u;
+    bool bComputeCulling = false;
+    bool bCompareLighting = false;
+    for (int i = 1; i < argc; i++)
+    {
+        std::string arg = argv[i];
+        if (arg.rfind("--lights=", 0) == 0)
+            lightCount = static_cast<unsigned int>(std::max(1, std::atoi(arg.c_str() + 9)));
+        else if (arg == "--light-culling=compute")
+            bComputeCulling = true;
+        else if (arg == "--lighting=fullscreen")
+            lightingMode = LightingMode::FullScreen;
+        else if (arg == "--lighting=compare")
+            bCompareLighting = true;
+    }
+
     // glfw and glad initialize
     if (!glfwInit())
         return -1;
     glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
     glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
     glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+    // 默认帧缓冲需要模板缓冲（光体积的模板预处理）
+    glfwWindowHint(GLFW_STENCIL_BITS, 8);
+    ConfigureHeadlessWindowHints(headlessOptions);
 
     GLFWwindow *window = glfwCreateWindow(SCREEN_WIDTH, SCREEN_HEIGHT, "LearnOpenGL", nullptr, nullptr);
     if (window == nullptr)
@@ -266,6 +493,9 @@ int main(int argc, char **argv)
     Shader shaderGeometryPass("./src/33-DeferredShading-Volume/Shaders/g_buffer.vs", "./src/33-DeferredShading-Volume/Shaders/g_buffer.fs");
     Shader shaderLightingPass("./src/33-DeferredShading-Volume/Shaders/deferred_shading.vs", "./src/33-DeferredShading-Volume/Shaders/deferred_shading.fs");
     Shader shaderLightBox("./src/33-DeferredShading-Volume/Shaders/deferred_light_box.vs", "./src/33-DeferredShading-Volume/Shaders/deferred_light_box.fs");
+    Shader shaderAmbient("./src/33-DeferredShading-Volume/Shaders/deferred_shading.vs", "./src/33-DeferredShading-Volume/Shaders/deferred_ambient.fs");
+    Shader shaderLightStencil("./src/33-DeferredShading-Volume/Shaders/light_volume.vs", "./src/33-DeferredShading-Volume/Shaders/light_stencil.fs");
+    Shader shaderLightVolume("./src/33-DeferredShading-Volume/Shaders/light_volume.vs", "./src/33-DeferredShading-Volume/Shaders/light_volume.fs");
 
     // load models
     // -----------
@@ -313,11 +543,12 @@ int main(int argc, char **argv)
     unsigned int attachments[3] = { GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1, GL_COLOR_ATTACHMENT2 };
     glDrawBuffers(3, attachments);
     // create and attach depth buffer (renderbuffer)
+    // 和默认帧缓冲一样使用 24 位深度 + 8 位模板，blit 深度时格式才能匹配
     unsigned int rboDepth;
     glGenRenderbuffers(1, &rboDepth);
     glBindRenderbuffer(GL_RENDERBUFFER, rboDepth);
-    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT, SCREEN_WIDTH, SCREEN_HEIGHT);
-    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, rboDepth);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, SCREEN_WIDTH, SCREEN_HEIGHT);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, rboDepth);
     // finally check if framebuffer is complete
     if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
         std::cout << "Framebuffer not complete!" << std::endl;
@@ -325,7 +556,7 @@ int main(int argc, char **argv)
 
     // lighting info
     // -------------
-    const unsigned int NR_LIGHTS = 32;
+    const unsigned int NR_LIGHTS = lightCount;
     std::vector<glm::vec3> lightPositions;
     std::vector<glm::vec3> lightColors;
     srand(13);
@@ -349,9 +580,56 @@ int main(int argc, char **argv)
     shaderLightingPass.SetInt("gPosition", 0);
     shaderLightingPass.SetInt("gNormal", 1);
     shaderLightingPass.SetInt("gAlbedoSpec", 2);
+    shaderLightingPass.SetInt("lightData", 3);
+    shaderLightingPass.SetInt("lightGrid", 4);
+    shaderLightingPass.SetInt("lightIndices", 5);
+    UniformHandle viewPosUniform = shaderLightingPass.GetUniform("viewPos");
+    UniformHandle viewUniform = shaderLightingPass.GetUniform("view");
+    UniformHandle lightLinearUniform = shaderLightingPass.GetUniform("lightLinear");
+    UniformHandle clusterNearUniform = shaderLightingPass.GetUniform("clusterNear");
+    UniformHandle clusterSliceScaleUniform = shaderLightingPass.GetUniform("clusterSliceScale");
+
+    // per-frame light data, computed on the job system
+    std::vector<ClusterLight> clusterLights(NR_LIGHTS);
+    std::vector<glm::mat4> lightBoxModels(NR_LIGHTS);
+    const float radiusScale = std::min(1.0f, std::sqrt(32.0f / static_cast<float>(NR_LIGHTS)));
+    JobSystem jobs;
+    ClusteredLights clusteredLights(&jobs);
+    if (bComputeCulling && !clusteredLights.InitCompute("./src/33-DeferredShading-Volume/Shaders/light_culling.cs"))
+    {
+        std::cout << "[CLUSTERED LIGHTS]: compute shaders are not supported, using the CPU path" << std::endl;
+        bComputeCulling = false;
+    }
+    // 光源分配的 CPU 耗时（compute 路径只包含提交命令的时间），在标题栏显示每秒的平均值
+    double cullMsTotal = 0.0;
+
+    // light volumes: instanced icospheres, light data streamed per frame
+    CreateIcosphere(1);
+    StreamBuffer lightInstanceBuffer(GL_ARRAY_BUFFER, NR_LIGHTS * sizeof(ClusterLight));
+    shaderAmbient.Use();
+    shaderAmbient.SetInt("gAlbedoSpec", 2);
+    shaderLightVolume.Use();
+    shaderLightVolume.SetInt("gPosition", 0);
+    shaderLightVolume.SetInt("gNormal", 1);
+    shaderLightVolume.SetInt("gAlbedoSpec", 2);
+    shaderLightVolume.SetVec2f("screenSize", glm::vec2((float)SCREEN_WIDTH, (float)SCREEN_HEIGHT));
+
+    // timing report: GPU time per pass, shaded fragments (fragment shader invocations or GL_SAMPLES_PASSED, read a few frames later), frame time
+    const GLenum fragmentQueryTarget = GetFragmentQueryTarget();
+    GpuProfiler profiler;
+    LightingModeStats lightingStats[2];
+    unsigned int samplesQueries[GpuProfiler::FramesInFlight];
+    int samplesQueryModes[GpuProfiler::FramesInFlight];
+    glGenQueries(GpuProfiler::FramesInFlight, samplesQueries);
+    std::fill(samplesQueryModes, samplesQueryModes + GpuProfiler::FramesInFlight, -1);
+    unsigned int frameIndex = 0u;
+    int previousMode = -1;
+
+    // scripted camera path, timings and captures for headless runs
+    HeadlessRunner headlessRunner(headlessOptions, CameraPath::Orbit(glm::vec3(0.0f, -0.5f, 0.0f), 6.0f, 2.0f, 4.0f), SCREEN_WIDTH, SCREEN_HEIGHT);
 
     // render loop
-    while (!glfwWindowShouldClose(window))
+    while (!glfwWindowShouldClose(window) && !headlessRunner.IsFinished())
     {
         float CurrentTime = static_cast<float>(glfwGetTime());
         DeltaTime = CurrentTime - LastTime;
@@ -362,7 +640,13 @@ int main(int argc, char **argv)
             std::stringstream ss;
             ss << "LearnOpenGL ( FPS: ";
             ss << nbFrames;
+            ss << " | lights: " << NR_LIGHTS << (bComputeCulling ? ", compute" : ", cpu") << " culling: " << cullMsTotal / nbFrames << " ms";
+            // 光体积方式不分配光源，统计只在 CPU 分配时有效
+            if (!bComputeCulling && lightingMode == LightingMode::FullScreen)
+                ss << ", avg/cluster: " << clusteredLights.GetStats().IndexCount / std::max(1u, clusteredLights.GetStats().NonEmptyClusters);
+            ss << " | lighting (V): " << LightingModeNames[static_cast<int>(lightingMode)];
             ss << " )";
+            cullMsTotal = 0.0;
             glfwSetWindowTitle(window, ss.str().c_str());
             nbFrames = 0;
             LastFrame += 1.0f;
@@ -371,6 +655,32 @@ int main(int argc, char **argv)
         // input
         // -----
         ProcessInput(window);
+        headlessRunner.BeginFrame(camera, DeltaTime);
+        if (bCompareLighting)
+            lightingMode = (frameIndex / 120u) % 2u == 0u ? LightingMode::Volumes : LightingMode::FullScreen;
+        // DeltaTime 是上一帧的时间
+        if (previousMode >= 0)
+        {
+            lightingStats[previousMode].Frames++;
+            lightingStats[previousMode].FrameMs += DeltaTime * 1000.0;
+        }
+        previousMode = static_cast<int>(lightingMode);
+
+        // 读取几帧前的片段数查询（结果还没准备好就丢弃，不等待 GPU）
+        unsigned int querySlot = frameIndex % GpuProfiler::FramesInFlight;
+        if (samplesQueryModes[querySlot] >= 0)
+        {
+            int available = 0;
+            glGetQueryObjectiv(samplesQueries[querySlot], GL_QUERY_RESULT_AVAILABLE, &available);
+            if (available)
+            {
+                GLuint64 samples = 0;
+                glGetQueryObjectui64v(samplesQueries[querySlot], GL_QUERY_RESULT, &samples);
+                lightingStats[samplesQueryModes[querySlot]].Fragments += static_cast<double>(samples);
+                lightingStats[samplesQueryModes[querySlot]].FragmentFrames++;
+            }
+        }
+        profiler.BeginFrame();
 
         // render
         // ------
@@ -379,6 +689,7 @@ int main(int argc, char **argv)
 
         // 1. geometry pass: render scene's geometry/color data into gbuffer
         // -----------------------------------------------------------------
+        profiler.PushScope("G-buffer");
         glBindFramebuffer(GL_FRAMEBUFFER, gBuffer);
             glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
             glm::mat4 projection = glm::perspective(glm::radians(camera.Fov), (float)SCREEN_WIDTH / (float)SCREEN_HEIGHT, 0.1f, 100.0f);
@@ -396,37 +707,123 @@ int main(int argc, char **argv)
                 backpack.Draw(shaderGeometryPass);
             }
         glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        profiler.PopScope();
 
         // 2. lighting pass: calculate lighting by iterating over a screen filled quad pixel-by-pixel using the gbuffer's content.
         // -----------------------------------------------------------------------------------------------------------------------
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-        shaderLightingPass.Use();
+        // update attenuation parameters and calculate radius
+        const float linear = 0.7f;
+        // 每个光源的光体积半径和光源立方体的模型矩阵互相独立，交给任务系统并行计算，OpenGL 调用仍然在主线程
+        jobs.ParallelFor(0u, static_cast<unsigned int>(lightPositions.size()), 256u, [&](unsigned int first, unsigned int last)
+        {
+            for (unsigned int i = first; i < last; i++)
+            {
+                clusterLights[i] = MakeClusterLight(lightPositions[i], lightColors[i], linear, radiusScale);
+                lightBoxModels[i] = glm::scale(glm::translate(glm::mat4(1.0f), lightPositions[i]), glm::vec3(0.125f));
+            }
+        });
         glActiveTexture(GL_TEXTURE0);
         glBindTexture(GL_TEXTURE_2D, gPosition);
         glActiveTexture(GL_TEXTURE1);
         glBindTexture(GL_TEXTURE_2D, gNormal);
         glActiveTexture(GL_TEXTURE2);
         glBindTexture(GL_TEXTURE_2D, gAlbedoSpec);
-        // send light relevant uniforms
-        for (unsigned int i = 0; i < lightPositions.size(); i++)
+        if (lightingMode == LightingMode::FullScreen)
         {
-            shaderLightingPass.SetVec3f("lights[" + std::to_string(i) + "].Position", lightPositions[i]);
-            shaderLightingPass.SetVec3f("lights[" + std::to_string(i) + "].Color", lightColors[i]);
-            // update attenuation parameters and calculate radius
-            const float constant = 1.0f; // note that we don't send this to the shader, we assume it is always 1.0 (in our case)
-            const float linear = 0.7f;
-            const float quadratic = 1.8f;
-            shaderLightingPass.SetFloat("lights[" + std::to_string(i) + "].Linear", linear);
-            shaderLightingPass.SetFloat("lights[" + std::to_string(i) + "].Quadratic", quadratic);
-            // then calculate radius of light volume/sphere
-            // 计算光体积
-            const float maxBrightness = std::fmaxf(std::fmaxf(lightColors[i].r, lightColors[i].g), lightColors[i].b);
-            float radius = (-linear + std::sqrt(linear * linear - 4 * quadratic * (constant - (256.0f / 5.0f) * maxBrightness))) / (2.0f * quadratic);
-            shaderLightingPass.SetFloat("lights[" + std::to_string(i) + "].Radius", radius);
+            // assign lights to clusters (CPU jobs + SSE, or a compute shader)
+            auto cullStart = std::chrono::high_resolution_clock::now();
+            clusteredLights.UploadLights(clusterLights);
+            clusteredLights.SetProjection(glm::radians(camera.Fov), (float)SCREEN_WIDTH / (float)SCREEN_HEIGHT, 0.1f, 100.0f);
+            if (bComputeCulling)
+                clusteredLights.CullCompute(view);
+            else
+            {
+                clusteredLights.Cull(clusterLights, view);
+                clusteredLights.UploadClusters();
+            }
+            cullMsTotal += std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - cullStart).count();
+
+            profiler.PushScope("lighting: full-screen");
+            glBeginQuery(fragmentQueryTarget, samplesQueries[querySlot]);
+            shaderLightingPass.Use();
+            // bind the light lists
+            clusteredLights.Bind(3);
+            shaderLightingPass.SetMat4f(viewUniform, view);
+            shaderLightingPass.SetFloat(lightLinearUniform, linear);
+            shaderLightingPass.SetFloat(clusterNearUniform, clusteredLights.GetNear());
+            shaderLightingPass.SetFloat(clusterSliceScaleUniform, clusteredLights.GetSliceScale());
+            shaderLightingPass.SetVec3f(viewPosUniform, camera.Position);
+            // finally render quad
+            RenderQuad();
+            glEndQuery(fragmentQueryTarget);
+            profiler.PopScope();
         }
-        shaderLightingPass.SetVec3f("viewPos", camera.Position);
-        // finally render quad
-        RenderQuad();
+        else
+        {
+            // 光体积需要场景的深度，先把 G-buffer 的深度拷贝到默认帧缓冲，并清空模板
+            glBindFramebuffer(GL_READ_FRAMEBUFFER, gBuffer);
+            glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
+            glBlitFramebuffer(0, 0, SCREEN_WIDTH, SCREEN_HEIGHT, 0, 0, SCREEN_WIDTH, SCREEN_HEIGHT, GL_DEPTH_BUFFER_BIT, GL_NEAREST);
+            glBindFramebuffer(GL_FRAMEBUFFER, 0);
+            glClear(GL_STENCIL_BUFFER_BIT);
+
+            ClusterLight* instanceData = static_cast<ClusterLight*>(lightInstanceBuffer.Map());
+            std::copy(clusterLights.begin(), clusterLights.end(), instanceData);
+            lightInstanceBuffer.Unmap();
+
+            profiler.PushScope("lighting: volumes");
+            // 片段数统计环境光、模板预处理和光照三个 pass，和全屏方式比较的是整个光照阶段的片段
+            glBeginQuery(fragmentQueryTarget, samplesQueries[querySlot]);
+            // a. 环境光：全屏，不做深度测试（也就不会写深度）
+            glDisable(GL_DEPTH_TEST);
+            shaderAmbient.Use();
+            RenderQuad();
+            glEnable(GL_DEPTH_TEST);
+
+            // b. 模板预处理：不写颜色和深度，两面都画。背面深度测试失败（场景表面在背面前面）+1，正面深度测试失败（表面在正面前面）-1，
+            //    结果是包含这个表面点的光体积个数。相机在光体积内部时正面被近平面裁掉，只有背面 +1，结果仍然正确。
+            glEnable(GL_STENCIL_TEST);
+            glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+            glDepthMask(GL_FALSE);
+            glDisable(GL_CULL_FACE);
+            glStencilFunc(GL_ALWAYS, 0, 0xFF);
+            glStencilOpSeparate(GL_BACK, GL_KEEP, GL_INCR_WRAP, GL_KEEP);
+            glStencilOpSeparate(GL_FRONT, GL_KEEP, GL_DECR_WRAP, GL_KEEP);
+            shaderLightStencil.Use();
+            shaderLightStencil.SetMat4f("projection", projection);
+            shaderLightStencil.SetMat4f("view", view);
+            RenderLightVolumes(lightInstanceBuffer.GetID(), lightInstanceBuffer.GetOffset(), NR_LIGHTS);
+
+            // c. 光照：只画背面（相机在光体积内部也能画出来），表面在背面前面（GL_GEQUAL）并且模板不为 0 的像素才着色，
+            //    着色器再按半径丢弃属于其他光体积的像素，结果加法混合
+            glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+            glStencilFunc(GL_NOTEQUAL, 0, 0xFF);
+            glStencilOp(GL_KEEP, GL_KEEP, GL_KEEP);
+            glDepthFunc(GL_GEQUAL);
+            glEnable(GL_CULL_FACE);
+            glCullFace(GL_FRONT);
+            glEnable(GL_BLEND);
+            glBlendEquation(GL_FUNC_ADD);
+            glBlendFunc(GL_ONE, GL_ONE);
+            shaderLightVolume.Use();
+            shaderLightVolume.SetMat4f("projection", projection);
+            shaderLightVolume.SetMat4f("view", view);
+            shaderLightVolume.SetFloat("lightLinear", linear);
+            shaderLightVolume.SetVec3f("viewPos", camera.Position);
+            RenderLightVolumes(lightInstanceBuffer.GetID(), lightInstanceBuffer.GetOffset(), NR_LIGHTS);
+            glEndQuery(fragmentQueryTarget);
+            lightInstanceBuffer.Fence();
+
+            glDisable(GL_BLEND);
+            glCullFace(GL_BACK);
+            glDisable(GL_CULL_FACE);
+            glDepthFunc(GL_LESS);
+            glDepthMask(GL_TRUE);
+            glDisable(GL_STENCIL_TEST);
+            profiler.PopScope();
+        }
+        samplesQueryModes[querySlot] = static_cast<int>(lightingMode);
 
         // 2.5. copy content of geometry's depth buffer to default framebuffer's depth buffer
         // ----------------------------------------------------------------------------------
@@ -443,22 +840,34 @@ int main(int argc, char **argv)
         shaderLightBox.Use();
         shaderLightBox.SetMat4f("projection", projection);
         shaderLightBox.SetMat4f("view", view);
-        for (unsigned int i = 0; i < lightPositions.size(); i++)
+        // 光源很多时每个光源一次 draw call 会盖过光照本身的开销，只画前 1024 个
+        for (unsigned int i = 0; i < std::min<size_t>(lightPositions.size(), 1024u); i++)
         {
-            model = glm::mat4(1.0f);
-            model = glm::translate(model, lightPositions[i]);
-            model = glm::scale(model, glm::vec3(0.125f));
-            shaderLightBox.SetMat4f("model", model);
+            shaderLightBox.SetMat4f("model", lightBoxModels[i]);
             shaderLightBox.SetVec3f("lightColor", lightColors[i]);
             RenderCube();
         }
 
+        profiler.EndFrame();
+        headlessRunner.EndFrame();
+        frameIndex++;
+
         // swap and poll events
         glfwSwapBuffers(window);
         glfwPollEvents();
     }
 
+    profiler.Flush();
+    profiler.PrintSummary();
+    PrintLightingReport(lightingStats, profiler, NR_LIGHTS, fragmentQueryTarget);
+
     // clear resources
+    glDeleteQueries(GpuProfiler::FramesInFlight, samplesQueries);
+    lightInstanceBuffer.Destroy();
+    clusteredLights.Destroy();
+    glDeleteBuffers(1, &sphereVBO);
+    glDeleteBuffers(1, &sphereEBO);
+    glDeleteVertexArrays(1, &sphereVAO);
     glDeleteBuffers(1, &quadVBO);
     glDeleteBuffers(1, &cubeVBO);
     glDeleteVertexArrays(1, &quadVAO);
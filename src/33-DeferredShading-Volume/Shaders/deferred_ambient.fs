@@ -0,0 +1,13 @@
+#version 330 core
+out vec4 FragColor;
+
+in vec2 TexCoords;
+
+uniform sampler2D gAlbedoSpec;
+
+// 光体积只覆盖被照亮的像素，环境光单独用一个全屏 pass
+void main()
+{
+    vec3 Diffuse = texture(gAlbedoSpec, TexCoords).rgb;
+    FragColor = vec4(Diffuse * 0.1, 1.0); // hard-coded ambient component
+}
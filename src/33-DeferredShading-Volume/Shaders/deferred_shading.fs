@@ -7,16 +7,20 @@ uniform sampler2D gPosition;
 uniform sampler2D gNormal;
 uniform sampler2D gAlbedoSpec;
 
-struct Light {
-    vec3 Position;
-    vec3 Color;
-    
-    float Linear;
-    float Quadratic;
-    float Radius;
-};
-const int NR_LIGHTS = 32;
-uniform Light lights[NR_LIGHTS];
+// 分簇光照：只计算像素所在簇的光源列表（见 include/tool/ClusteredLights.h，常量要和那里一致）
+const int CLUSTER_X = 16;
+const int CLUSTER_Y = 9;
+const int CLUSTER_Z = 24;
+// 每个光源两个 texel：(位置, 半径)、(颜色, 二次衰减系数)
+uniform samplerBuffer lightData;
+// 每个簇 (在 lightIndices 中的偏移, 数量)
+uniform usamplerBuffer lightGrid;
+uniform usamplerBuffer lightIndices;
+uniform float lightLinear;
+// 深度层：floor(log(depth / clusterNear) * clusterSliceScale)
+uniform float clusterNear;
+uniform float clusterSliceScale;
+uniform mat4 view;
 uniform vec3 viewPos;
 
 void main()
@@ -27,28 +31,37 @@ void main()
     vec3 Diffuse = texture(gAlbedoSpec, TexCoords).rgb;
     float Specular = texture(gAlbedoSpec, TexCoords).a;
     
+    // 像素所在的簇
+    float depth = max(-(view * vec4(FragPos, 1.0)).z, clusterNear);
+    int slice = clamp(int(floor(log(depth / clusterNear) * clusterSliceScale)), 0, CLUSTER_Z - 1);
+    ivec2 tile = min(ivec2(TexCoords * vec2(CLUSTER_X, CLUSTER_Y)), ivec2(CLUSTER_X - 1, CLUSTER_Y - 1));
+    uvec2 range = texelFetch(lightGrid, (slice * CLUSTER_Y + tile.y) * CLUSTER_X + tile.x).xy;
+
     // then calculate lighting as usual
     vec3 lighting  = Diffuse * 0.1; // hard-coded ambient component
     vec3 viewDir  = normalize(viewPos - FragPos);
-    for(int i = 0; i < NR_LIGHTS; ++i)
+    for(uint i = 0u; i < range.y; ++i)
     {
-        float distance = length(lights[i].Position - FragPos);
-        if (distance < lights[i].Radius)
+        int light = int(texelFetch(lightIndices, int(range.x + i)).r);
+        vec4 positionRadius = texelFetch(lightData, light * 2);
+        vec4 colorQuadratic = texelFetch(lightData, light * 2 + 1);
+        // 簇的包围盒是偏保守的，还要按光体积半径判断一次
+        float distance = length(positionRadius.xyz - FragPos);
+        if (distance < positionRadius.w)
         {
             // diffuse
-            vec3 lightDir = normalize(lights[i].Position - FragPos);
-            vec3 diffuse = max(dot(Normal, lightDir), 0.0) * Diffuse * lights[i].Color;
+            vec3 lightDir = normalize(positionRadius.xyz - FragPos);
+            vec3 diffuse = max(dot(Normal, lightDir), 0.0) * Diffuse * colorQuadratic.rgb;
             // specular
             vec3 halfwayDir = normalize(lightDir + viewDir);  
             float spec = pow(max(dot(Normal, halfwayDir), 0.0), 16.0);
-            vec3 specular = lights[i].Color * spec * Specular;
+            vec3 specular = colorQuadratic.rgb * spec * Specular;
             // attenuation
-            float distance = length(lights[i].Position - FragPos);
-            float attenuation = 1.0 / (1.0 + lights[i].Linear * distance + lights[i].Quadratic * distance * distance);
+            float attenuation = 1.0 / (1.0 + lightLinear * distance + colorQuadratic.w * distance * distance);
             diffuse *= attenuation;
             specular *= attenuation;
             lighting += diffuse + specular;
         }
     }
     FragColor = vec4(lighting, 1.0);
-}
\ No newline at end of file
+}
@@ -0,0 +1,97 @@
+#version 430 core
+// 分簇光照的光源分配（GL 4.3 可用时代替 CPU 路径，见 include/tool/ClusteredLights.h）
+// 每个工作组处理一个深度层，每个线程处理一个簇
+const uint CLUSTER_X = 16u;
+const uint CLUSTER_Y = 9u;
+const uint CLUSTER_Z = 24u;
+const uint GROUP_SIZE = CLUSTER_X * CLUSTER_Y;
+layout(local_size_x = 16, local_size_y = 9, local_size_z = 1) in;
+
+// 每个光源两个 vec4：(世界空间位置, 半径)、(颜色, 二次衰减系数)
+layout(std430, binding = 0) readonly buffer LightData { vec4 lightData[]; };
+// 每个簇 (偏移, 数量)
+layout(std430, binding = 1) writeonly buffer LightGrid { uvec2 lightGrid[]; };
+layout(std430, binding = 2) writeonly buffer LightIndices { uint lightIndices[]; };
+layout(std430, binding = 3) buffer IndexCounter { uint indexCount; };
+
+uniform mat4 view;
+uniform int lightCount;
+uniform float clusterNear;
+uniform float clusterFar;
+uniform vec2 tanHalfFov;
+uniform uint indexCapacity;
+
+// 观察空间包围球 (x, y, 深度, 半径)
+shared vec4 sharedSpheres[GROUP_SIZE];
+
+float SliceDepth(uint slice)
+{
+    return clusterNear * pow(clusterFar / clusterNear, float(slice) / float(CLUSTER_Z));
+}
+
+bool SphereIntersectsAABB(vec4 sphere, vec3 aabbMin, vec3 aabbMax)
+{
+    vec3 d = max(aabbMin - sphere.xyz, 0.0) + max(sphere.xyz - aabbMax, 0.0);
+    return dot(d, d) <= sphere.w * sphere.w;
+}
+
+// 把一批光源读入共享内存，返回这一批的数量
+int LoadBatch(int first)
+{
+    int index = first + int(gl_LocalInvocationIndex);
+    if (index < lightCount)
+    {
+        vec4 light = lightData[index * 2];
+        vec3 center = (view * vec4(light.xyz, 1.0)).xyz;
+        sharedSpheres[gl_LocalInvocationIndex] = vec4(center.xy, -center.z, light.w);
+    }
+    barrier();
+    return min(int(GROUP_SIZE), lightCount - first);
+}
+
+void main()
+{
+    uvec3 tile = gl_GlobalInvocationID;
+    uint cluster = (tile.z * CLUSTER_Y + tile.y) * CLUSTER_X + tile.x;
+
+    // 簇的观察空间 AABB（和 CPU 路径相同）
+    float zNear = SliceDepth(tile.z);
+    float zFar = SliceDepth(tile.z + 1u);
+    vec2 ndcMin = vec2(-1.0) + 2.0 * vec2(tile.xy) / vec2(CLUSTER_X, CLUSTER_Y);
+    vec2 ndcMax = vec2(-1.0) + 2.0 * vec2(tile.xy + 1u) / vec2(CLUSTER_X, CLUSTER_Y);
+    vec2 viewMin = ndcMin * tanHalfFov;
+    vec2 viewMax = ndcMax * tanHalfFov;
+    vec3 aabbMin = vec3(min(viewMin * zNear, viewMin * zFar), zNear);
+    vec3 aabbMax = vec3(max(viewMax * zNear, viewMax * zFar), zFar);
+
+    // 1. 统计数量
+    uint count = 0u;
+    for (int first = 0; first < lightCount; first += int(GROUP_SIZE))
+    {
+        int batch = LoadBatch(first);
+        for (int i = 0; i < batch; i++)
+        {
+            if (SphereIntersectsAABB(sharedSpheres[i], aabbMin, aabbMax))
+                count++;
+        }
+        barrier();
+    }
+
+    // 2. 分配连续的空间，超出容量的部分丢弃
+    uint offset = atomicAdd(indexCount, count);
+    uint stored = offset < indexCapacity ? min(count, indexCapacity - offset) : 0u;
+    lightGrid[cluster] = uvec2(offset, stored);
+
+    // 3. 再测试一遍，写入下标
+    uint written = 0u;
+    for (int first = 0; first < lightCount; first += int(GROUP_SIZE))
+    {
+        int batch = LoadBatch(first);
+        for (int i = 0; i < batch; i++)
+        {
+            if (written < stored && SphereIntersectsAABB(sharedSpheres[i], aabbMin, aabbMax))
+                lightIndices[offset + written++] = uint(first + i);
+        }
+        barrier();
+    }
+}
@@ -0,0 +1,5 @@
+#version 330 core
+// 模板预处理只写模板缓冲，不输出颜色
+void main()
+{
+}
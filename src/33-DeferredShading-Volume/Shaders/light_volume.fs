@@ -0,0 +1,41 @@
+#version 330 core
+out vec4 FragColor;
+
+flat in vec4 LightPositionRadius;
+flat in vec4 LightColorQuadratic;
+
+uniform sampler2D gPosition;
+uniform sampler2D gNormal;
+uniform sampler2D gAlbedoSpec;
+
+uniform vec2 screenSize;
+uniform float lightLinear;
+uniform vec3 viewPos;
+
+// 每个片段只计算一个光源，结果加法混合到颜色缓冲
+void main()
+{
+    vec2 TexCoords = gl_FragCoord.xy / screenSize;
+    vec3 FragPos = texture(gPosition, TexCoords).rgb;
+
+    // 模板只保证片段在某一个光体积中，不一定是当前这个
+    float distance = length(LightPositionRadius.xyz - FragPos);
+    if (distance >= LightPositionRadius.w)
+        discard;
+
+    vec3 Normal = texture(gNormal, TexCoords).rgb;
+    vec3 Diffuse = texture(gAlbedoSpec, TexCoords).rgb;
+    float Specular = texture(gAlbedoSpec, TexCoords).a;
+    vec3 viewDir  = normalize(viewPos - FragPos);
+
+    // diffuse
+    vec3 lightDir = normalize(LightPositionRadius.xyz - FragPos);
+    vec3 diffuse = max(dot(Normal, lightDir), 0.0) * Diffuse * LightColorQuadratic.rgb;
+    // specular
+    vec3 halfwayDir = normalize(lightDir + viewDir);  
+    float spec = pow(max(dot(Normal, halfwayDir), 0.0), 16.0);
+    vec3 specular = LightColorQuadratic.rgb * spec * Specular;
+    // attenuation
+    float attenuation = 1.0 / (1.0 + lightLinear * distance + LightColorQuadratic.w * distance * distance);
+    FragColor = vec4((diffuse + specular) * attenuation, 1.0);
+}
@@ -0,0 +1,19 @@
+#version 330 core
+layout (location = 0) in vec3 aPos;
+// 每个实例一个光源：(位置, 半径)、(颜色, 二次衰减系数)
+layout (location = 1) in vec4 aLightPositionRadius;
+layout (location = 2) in vec4 aLightColorQuadratic;
+
+flat out vec4 LightPositionRadius;
+flat out vec4 LightColorQuadratic;
+
+uniform mat4 projection;
+uniform mat4 view;
+
+void main()
+{
+    LightPositionRadius = aLightPositionRadius;
+    LightColorQuadratic = aLightColorQuadratic;
+    // 单位球网格缩放到光体积半径
+    gl_Position = projection * view * vec4(aLightPositionRadius.xyz + aPos * aLightPositionRadius.w, 1.0);
+}
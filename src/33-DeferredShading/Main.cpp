@@ -1,5 +1,7 @@
 #include <iostream>
 #include <map>
+#include <chrono>
+#include <iomanip>
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
 #include <tool/Shader.h>
@@ -10,6 +12,11 @@
 #include <glm/gtc/type_ptr.hpp>
 
 #include <tool/Model.h>
+#include <tool/Headless.h>
+#include <tool/GBuffer.h>
+#include <tool/JobSystem.h>
+#include <tool/ClusteredLights.h>
+#include <tool/GpuProfiler.h>
 
 const int SCREEN_WIDTH = 1280;
 const int SCREEN_HEIGHT = 720;
@@ -34,6 +41,22 @@ float exposure = 1.0f;
 bool bloom = true;
 bool bloomKeyPressed = false;
 
+// 衰减参数和光体积半径，radiusScale < 1 时缩小光体积并相应加大二次衰减系数，
+// 光源很多时保持每个像素受到的光源数量大致不变
+ClusterLight MakeClusterLight(const glm::vec3& position, const glm::vec3& color, float linear, float radiusScale)
+{
+    const float constant = 1.0f;
+    float quadratic = 1.8f;
+    const float maxBrightness = std::fmaxf(std::fmaxf(color.r, color.g), color.b);
+    float radius = (-linear + std::sqrt(linear * linear - 4 * quadratic * (constant - (256.0f / 5.0f) * maxBrightness))) / (2.0f * quadratic);
+    if (radiusScale < 1.0f)
+    {
+        radius *= radiusScale;
+        quadratic = ((256.0f / 5.0f) * maxBrightness - constant - linear * radius) / (radius * radius);
+    }
+    return ClusterLight{ position, radius, color, quadratic };
+}
+
 void FramebufferSizeCallback(GLFWwindow *window, int width, int height)
 {
     glViewport(0u, 0u, width, height);
@@ -225,12 +248,46 @@ void RenderQuad()
 
 int main(int argc, char **argv)
 {
+    // headless mode: --headless --frames=N --capture=F1,F2 --output=DIR
+    HeadlessOptions headlessOptions = ParseHeadlessOptions(argc, argv);
+    ConfigureHeadlessPlatform(headlessOptions);
+    // vertex layout: --vertex-layout=full|compressed|quantized
+    // light count: --lights=N (default 32), light assignment: --light-culling=cpu|compute
+    // G-buffer layout: --gbuffer=full|compact
+    // depth prepass: --depth-prepass（只读位置流先写深度，G-buffer pass 只着色可见的片段）
+    // --uniform-benchmark: 沿固定的相机路径渲染，输出每帧发出 / 过滤的 glUniform 调用后退出
+    VertexLayout vertexLayout = VertexLayout::Full;
+    GBufferLayout gBufferLayout = GBufferLayout::Full;
+    unsigned int lightCount = 32u;
+    bool bComputeCulling = false;
+    bool bUniformBenchmark = false;
+    bool bDepthPrepass = false;
+    for (int i = 1; i < argc; i++)
+    {
+        std::string arg = argv[i];
+        if (arg == "--vertex-layout=compressed")
+            vertexLayout = VertexLayout::Compressed;
+        else if (arg == "--vertex-layout=quantized")
+            vertexLayout = VertexLayout::Quantized;
+        else if (arg.rfind("--lights=", 0) == 0)
+            lightCount = static_cast<unsigned int>(std::max(1, std::atoi(arg.c_str() + 9)));
+        else if (arg == "--light-culling=compute")
+            bComputeCulling = true;
+        else if (arg == "--gbuffer=compact")
+            gBufferLayout = GBufferLayout::Compact;
+        else if (arg == "--uniform-benchmark")
+            bUniformBenchmark = true;
+        else if (arg == "--depth-prepass")
+            bDepthPrepass = true;
+    }
+
     // glfw and glad initialize
     if (!glfwInit())
         return -1;
     glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
     glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
     glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+    ConfigureHeadlessWindowHints(headlessOptions);
 
     GLFWwindow *window = glfwCreateWindow(SCREEN_WIDTH, SCREEN_HEIGHT, "LearnOpenGL", nullptr, nullptr);
     if (window == nullptr)
@@ -266,10 +323,19 @@ int main(int argc, char **argv)
     Shader shaderGeometryPass("./src/33-DeferredShading/Shaders/g_buffer.vs", "./src/33-DeferredShading/Shaders/g_buffer.fs");
     Shader shaderLightingPass("./src/33-DeferredShading/Shaders/deferred_shading.vs", "./src/33-DeferredShading/Shaders/deferred_shading.fs");
     Shader shaderLightBox("./src/33-DeferredShading/Shaders/deferred_light_box.vs", "./src/33-DeferredShading/Shaders/deferred_light_box.fs");
+    Shader shaderDepthPrepass("./src/33-DeferredShading/Shaders/depth_prepass.vs", "./src/33-DeferredShading/Shaders/depth_prepass.fs");
 
     // load models
     // -----------
-    Model backpack("./res/models/nanosuit/nanosuit.obj");
+    Model backpack("./res/models/nanosuit/nanosuit.obj", false, true, nullptr, vertexLayout);
+    // 各种顶点布局的显存占用
+    std::cout << "vertex memory (KB): full " << backpack.GetVertexMemory(VertexLayout::Full) / 1024
+              << ", compressed " << backpack.GetVertexMemory(VertexLayout::Compressed) / 1024
+              << ", quantized " << backpack.GetVertexMemory(VertexLayout::Quantized) / 1024
+              << ", using " << backpack.GetVertexMemory() / 1024 << std::endl;
+    // 深度预处理每画一次模型读取的顶点数据：完整布局的位置和其它属性交错存放，要读整个 Vertex
+    std::cout << "depth prepass: " << (bDepthPrepass ? "on" : "off") << ", vertex fetch per draw (KB): "
+              << backpack.GetPositionMemory() / 1024 << " (full interleaved " << backpack.GetVertexMemory(VertexLayout::Full) / 1024 << ")" << std::endl;
     std::vector<glm::vec3> objectPositions;
     objectPositions.push_back(glm::vec3(-3.0,  -0.5, -3.0));
     objectPositions.push_back(glm::vec3( 0.0,  -0.5, -3.0));
@@ -284,48 +350,13 @@ int main(int argc, char **argv)
 
     // configure g-buffer framebuffer
     // ------------------------------
-    unsigned int gBuffer;
-    glGenFramebuffers(1, &gBuffer);
-    glBindFramebuffer(GL_FRAMEBUFFER, gBuffer);
-    unsigned int gPosition, gNormal, gAlbedoSpec;
-    // position color buffer
-    glGenTextures(1, &gPosition);
-    glBindTexture(GL_TEXTURE_2D, gPosition);
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA16F, SCREEN_WIDTH, SCREEN_HEIGHT, 0, GL_RGBA, GL_FLOAT, NULL);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, gPosition, 0);
-    // normal color buffer
-    glGenTextures(1, &gNormal);
-    glBindTexture(GL_TEXTURE_2D, gNormal);
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA16F, SCREEN_WIDTH, SCREEN_HEIGHT, 0, GL_RGBA, GL_FLOAT, NULL);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT1, GL_TEXTURE_2D, gNormal, 0);
-    // color + specular color buffer
-    glGenTextures(1, &gAlbedoSpec);
-    glBindTexture(GL_TEXTURE_2D, gAlbedoSpec);
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, SCREEN_WIDTH, SCREEN_HEIGHT, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT2, GL_TEXTURE_2D, gAlbedoSpec, 0);
-    // tell OpenGL which color attachments we'll use (of this framebuffer) for rendering 
-    unsigned int attachments[3] = { GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1, GL_COLOR_ATTACHMENT2 };
-    glDrawBuffers(3, attachments);
-    // create and attach depth buffer (renderbuffer)
-    unsigned int rboDepth;
-    glGenRenderbuffers(1, &rboDepth);
-    glBindRenderbuffer(GL_RENDERBUFFER, rboDepth);
-    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT, SCREEN_WIDTH, SCREEN_HEIGHT);
-    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, rboDepth);
-    // finally check if framebuffer is complete
-    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
-        std::cout << "Framebuffer not complete!" << std::endl;
-    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    GBuffer gBuffer(SCREEN_WIDTH, SCREEN_HEIGHT, gBufferLayout);
+    // 光照 pass 读一次 G-buffer
+    GBuffer::PrintBandwidthReport(1u);
 
     // lighting info
     // -------------
-    const unsigned int NR_LIGHTS = 32;
+    const unsigned int NR_LIGHTS = lightCount;
     std::vector<glm::vec3> lightPositions;
     std::vector<glm::vec3> lightColors;
     srand(13);
@@ -343,15 +374,70 @@ int main(int argc, char **argv)
         lightColors.push_back(glm::vec3(rColor, gColor, bColor));
     }
 
+    // 光源是静止的，上传一次就够了
+    const float linear = 0.7f;
+    const float radiusScale = std::min(1.0f, std::sqrt(32.0f / static_cast<float>(NR_LIGHTS)));
+    std::vector<ClusterLight> clusterLights;
+    for (unsigned int i = 0; i < NR_LIGHTS; i++)
+        clusterLights.push_back(MakeClusterLight(lightPositions[i], lightColors[i], linear, radiusScale));
+    JobSystem jobs;
+    ClusteredLights clusteredLights(&jobs);
+    clusteredLights.UploadLights(clusterLights);
+    if (bComputeCulling && !clusteredLights.InitCompute("./src/33-DeferredShading/Shaders/light_culling.cs"))
+    {
+        std::cout << "[CLUSTERED LIGHTS]: compute shaders are not supported, using the CPU path" << std::endl;
+        bComputeCulling = false;
+    }
+
     // shader configuration
     // --------------------
     shaderLightingPass.Use();
     shaderLightingPass.SetInt("gPosition", 0);
     shaderLightingPass.SetInt("gNormal", 1);
     shaderLightingPass.SetInt("gAlbedoSpec", 2);
+    shaderLightingPass.SetInt("lightData", 3);
+    shaderLightingPass.SetInt("lightGrid", 4);
+    shaderLightingPass.SetInt("lightIndices", 5);
+    shaderLightingPass.SetInt("gDepth", 6);
+    shaderLightingPass.SetInt("uGBufferLayout", static_cast<int>(gBufferLayout));
+    UniformHandle inverseViewProjectionUniform = shaderLightingPass.GetUniform("inverseViewProjection");
+    shaderLightingPass.SetFloat("lightLinear", linear);
+    UniformHandle viewPosUniform = shaderLightingPass.GetUniform("viewPos");
+    UniformHandle viewUniform = shaderLightingPass.GetUniform("view");
+    UniformHandle clusterNearUniform = shaderLightingPass.GetUniform("clusterNear");
+    UniformHandle clusterSliceScaleUniform = shaderLightingPass.GetUniform("clusterSliceScale");
+    // 光照 pass 的 uniform 全部设置完之后再切换到几何 pass（glUniform* 作用于当前的 program）
+    shaderGeometryPass.Use();
+    shaderGeometryPass.SetInt("uGBufferLayout", static_cast<int>(gBufferLayout));
+    // 光源分配的 CPU 耗时（compute 路径只包含提交命令的时间），在标题栏显示每秒的平均值
+    double cullMsTotal = 0.0;
+
+    // scripted camera path, timings and captures for headless runs
+    HeadlessRunner headlessRunner(headlessOptions, CameraPath::Orbit(glm::vec3(0.0f, -0.5f, 0.0f), 6.0f, 2.0f, 4.0f), SCREEN_WIDTH, SCREEN_HEIGHT);
+    if (gBufferLayout == GBufferLayout::Full)
+        headlessRunner.AddCapture("gPosition", gBuffer.GetFBO(), GL_COLOR_ATTACHMENT0, true);
+    headlessRunner.AddCapture("gNormal", gBuffer.GetFBO(), GL_COLOR_ATTACHMENT1, gBufferLayout == GBufferLayout::Full);
+    headlessRunner.AddCapture("gAlbedoSpec", gBuffer.GetFBO(), GL_COLOR_ATTACHMENT2);
+
+    // uniform benchmark：同一条相机路径跑三遍，cached 由 Shader 过滤重复的设置（字符串在哈希表中查找），
+    // uncached 每帧开始时清空值缓存，每次设置都发出 glUniform*，
+    // legacy 是加缓存之前的做法：每次设置都调用 glGetUniformLocation + glUniform*
+    const int BENCHMARK_WARMUP = 5;
+    const int BENCHMARK_ITERATIONS = 50;
+    const int BENCHMARK_PASS_FRAMES = BENCHMARK_WARMUP + BENCHMARK_ITERATIONS;
+    const int BENCHMARK_MODES = 3;
+    const char* benchmarkModes[BENCHMARK_MODES] = { "cached", "uncached", "legacy" };
+    CameraPath benchmarkPath = CameraPath::Orbit(glm::vec3(0.0f, -0.5f, 0.0f), 6.0f, 2.0f, 4.0f);
+    UniformStats benchmarkStats[BENCHMARK_MODES];
+    double benchmarkCpuMs[BENCHMARK_MODES] = { 0.0, 0.0, 0.0 };
+    int benchmarkFrame = 0;
+    std::chrono::high_resolution_clock::time_point benchmarkStart;
+
+    // 深度预处理和 G-buffer pass 的 GPU 耗时，退出时输出（开关 --depth-prepass 对比）
+    GpuProfiler profiler;
 
     // render loop
-    while (!glfwWindowShouldClose(window))
+    while (!glfwWindowShouldClose(window) && !headlessRunner.IsFinished())
     {
         float CurrentTime = static_cast<float>(glfwGetTime());
         DeltaTime = CurrentTime - LastTime;
@@ -359,11 +445,21 @@ int main(int argc, char **argv)
         nbFrames++;
         if (CurrentTime - LastFrame >= 1.0f)
         {
+            // 每帧平均的 uniform 调用：实际发出的 glUniform、被过滤的重复设置、字符串查找次数
+            UniformStats& uniformStats = Shader::GetUniformStats();
             std::stringstream ss;
             ss << "LearnOpenGL ( FPS: ";
             ss << nbFrames;
+            ss << " | glUniform/frame: " << uniformStats.Calls / nbFrames;
+            ss << ", filtered/frame: " << uniformStats.Redundant / nbFrames;
+            ss << ", name lookups/frame: " << uniformStats.NameLookups / nbFrames;
+            ss << " | lights: " << NR_LIGHTS << (bComputeCulling ? ", compute" : ", cpu") << " culling: " << cullMsTotal / nbFrames << " ms";
+            if (!bComputeCulling)
+                ss << ", avg/cluster: " << clusteredLights.GetStats().IndexCount / std::max(1u, clusteredLights.GetStats().NonEmptyClusters);
             ss << " )";
+            cullMsTotal = 0.0;
             glfwSetWindowTitle(window, ss.str().c_str());
+            uniformStats.Reset();
             nbFrames = 0;
             LastFrame += 1.0f;
         }
@@ -371,6 +467,23 @@ int main(int argc, char **argv)
         // input
         // -----
         ProcessInput(window);
+        headlessRunner.BeginFrame(camera, DeltaTime);
+        if (bUniformBenchmark)
+        {
+            benchmarkPath.Apply(camera, static_cast<float>(benchmarkFrame % BENCHMARK_PASS_FRAMES) / 60.0f);
+            int mode = benchmarkFrame / BENCHMARK_PASS_FRAMES;
+            if (mode == 1)
+            {
+                shaderGeometryPass.InvalidateUniformCache();
+                shaderLightingPass.InvalidateUniformCache();
+                shaderLightBox.InvalidateUniformCache();
+                shaderDepthPrepass.InvalidateUniformCache();
+            }
+            Shader::LegacyUniformsEnabled() = mode == 2;
+            Shader::GetUniformStats().Reset();
+            benchmarkStart = std::chrono::high_resolution_clock::now();
+        }
+        profiler.BeginFrame();
 
         // render
         // ------
@@ -379,11 +492,33 @@ int main(int argc, char **argv)
 
         // 1. geometry pass: render scene's geometry/color data into gbuffer
         // -----------------------------------------------------------------
-        glBindFramebuffer(GL_FRAMEBUFFER, gBuffer);
+        glBindFramebuffer(GL_FRAMEBUFFER, gBuffer.GetFBO());
             glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
             glm::mat4 projection = glm::perspective(glm::radians(camera.Fov), (float)SCREEN_WIDTH / (float)SCREEN_HEIGHT, 0.1f, 100.0f);
             glm::mat4 view = camera.GetViewMatrix();
             glm::mat4 model = glm::mat4(1.0f);
+            if (bDepthPrepass)
+            {
+                // 只写深度，G-buffer pass 用 GL_LEQUAL 并且不再写深度，被挡住的片段不会执行 g_buffer.fs
+                profiler.PushScope("depth prepass");
+                glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+                shaderDepthPrepass.Use();
+                shaderDepthPrepass.SetMat4f("projection", projection);
+                shaderDepthPrepass.SetMat4f("view", view);
+                for (unsigned int i = 0; i < objectPositions.size(); i++)
+                {
+                    model = glm::mat4(1.0f);
+                    model = glm::translate(model, objectPositions[i]);
+                    model = glm::scale(model, glm::vec3(0.25f));
+                    shaderDepthPrepass.SetMat4f("model", model);
+                    backpack.DrawPositions(shaderDepthPrepass);
+                }
+                glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+                glDepthFunc(GL_LEQUAL);
+                glDepthMask(GL_FALSE);
+                profiler.PopScope();
+            }
+            profiler.PushScope("G-buffer");
             shaderGeometryPass.Use();
             shaderGeometryPass.SetMat4f("projection", projection);
             shaderGeometryPass.SetMat4f("view", view);
@@ -395,36 +530,50 @@ int main(int argc, char **argv)
                 shaderGeometryPass.SetMat4f("model", model);
                 backpack.Draw(shaderGeometryPass);
             }
+            if (bDepthPrepass)
+            {
+                glDepthFunc(GL_LESS);
+                glDepthMask(GL_TRUE);
+            }
+            profiler.PopScope();
         glBindFramebuffer(GL_FRAMEBUFFER, 0);
 
         // 2. lighting pass: calculate lighting by iterating over a screen filled quad pixel-by-pixel using the gbuffer's content.
         // -----------------------------------------------------------------------------------------------------------------------
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+        // assign lights to clusters (CPU jobs + SSE, or a compute shader)
+        auto cullStart = std::chrono::high_resolution_clock::now();
+        clusteredLights.SetProjection(glm::radians(camera.Fov), (float)SCREEN_WIDTH / (float)SCREEN_HEIGHT, 0.1f, 100.0f);
+        if (bComputeCulling)
+            clusteredLights.CullCompute(view);
+        else
+        {
+            clusteredLights.Cull(clusterLights, view);
+            clusteredLights.UploadClusters();
+        }
+        cullMsTotal += std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - cullStart).count();
         shaderLightingPass.Use();
         glActiveTexture(GL_TEXTURE0);
-        glBindTexture(GL_TEXTURE_2D, gPosition);
+        glBindTexture(GL_TEXTURE_2D, gBuffer.GetPosition());
         glActiveTexture(GL_TEXTURE1);
-        glBindTexture(GL_TEXTURE_2D, gNormal);
+        glBindTexture(GL_TEXTURE_2D, gBuffer.GetNormal());
         glActiveTexture(GL_TEXTURE2);
-        glBindTexture(GL_TEXTURE_2D, gAlbedoSpec);
-        // send light relevant uniforms
-        for (unsigned int i = 0; i < lightPositions.size(); i++)
-        {
-            shaderLightingPass.SetVec3f("lights[" + std::to_string(i) + "].Position", lightPositions[i]);
-            shaderLightingPass.SetVec3f("lights[" + std::to_string(i) + "].Color", lightColors[i]);
-            // update attenuation parameters and calculate radius
-            const float linear = 0.7f;
-            const float quadratic = 1.8f;
-            shaderLightingPass.SetFloat("lights[" + std::to_string(i) + "].Linear", linear);
-            shaderLightingPass.SetFloat("lights[" + std::to_string(i) + "].Quadratic", quadratic);
-        }
-        shaderLightingPass.SetVec3f("viewPos", camera.Position);
+        glBindTexture(GL_TEXTURE_2D, gBuffer.GetAlbedoSpec());
+        glActiveTexture(GL_TEXTURE6);
+        glBindTexture(GL_TEXTURE_2D, gBuffer.GetDepth());
+        // bind the light lists
+        clusteredLights.Bind(3);
+        shaderLightingPass.SetMat4f(viewUniform, view);
+        shaderLightingPass.SetMat4f(inverseViewProjectionUniform, glm::inverse(projection * view));
+        shaderLightingPass.SetFloat(clusterNearUniform, clusteredLights.GetNear());
+        shaderLightingPass.SetFloat(clusterSliceScaleUniform, clusteredLights.GetSliceScale());
+        shaderLightingPass.SetVec3f(viewPosUniform, camera.Position);
         // finally render quad
         RenderQuad();
 
         // 2.5. copy content of geometry's depth buffer to default framebuffer's depth buffer
         // ----------------------------------------------------------------------------------
-        glBindFramebuffer(GL_READ_FRAMEBUFFER, gBuffer);
+        glBindFramebuffer(GL_READ_FRAMEBUFFER, gBuffer.GetFBO());
         glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0); // write to default framebuffer
         // blit to default framebuffer. Note that this may or may not work as the internal formats of both the FBO and default framebuffer have to match.
         // the internal formats are implementation defined. This works on all of my systems, but if it doesn't on yours you'll likely have to write to the 		
@@ -437,7 +586,8 @@ int main(int argc, char **argv)
         shaderLightBox.Use();
         shaderLightBox.SetMat4f("projection", projection);
         shaderLightBox.SetMat4f("view", view);
-        for (unsigned int i = 0; i < lightPositions.size(); i++)
+        // 光源很多时每个光源一次 draw call 会盖过光照本身的开销，只画前 1024 个
+        for (unsigned int i = 0; i < std::min<size_t>(lightPositions.size(), 1024u); i++)
         {
             model = glm::mat4(1.0f);
             model = glm::translate(model, lightPositions[i]);
@@ -447,12 +597,49 @@ int main(int argc, char **argv)
             RenderCube();
         }
 
+        profiler.EndFrame();
+
+        if (bUniformBenchmark)
+        {
+            int pass = benchmarkFrame / BENCHMARK_PASS_FRAMES;
+            if (benchmarkFrame % BENCHMARK_PASS_FRAMES >= BENCHMARK_WARMUP)
+            {
+                const UniformStats& frameStats = Shader::GetUniformStats();
+                benchmarkStats[pass].Calls += frameStats.Calls;
+                benchmarkStats[pass].Redundant += frameStats.Redundant;
+                benchmarkStats[pass].NameLookups += frameStats.NameLookups;
+                benchmarkCpuMs[pass] += std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - benchmarkStart).count();
+            }
+            if (++benchmarkFrame == BENCHMARK_MODES * BENCHMARK_PASS_FRAMES)
+            {
+                Shader::LegacyUniformsEnabled() = false;
+                std::cout << "uniform benchmark: " << BENCHMARK_ITERATIONS << " frames per row, " << objectPositions.size() << " models, "
+                          << std::min<size_t>(lightPositions.size(), 1024u) << " light boxes, per-frame averages" << std::endl;
+                // lookups：cached / uncached 是哈希表查找，legacy 是 glGetUniformLocation
+                std::cout << std::setw(10) << "mode" << std::setw(11) << "glUniform" << std::setw(10) << "filtered"
+                          << std::setw(10) << "lookups" << std::setw(10) << "CPU(ms)" << std::endl;
+                for (int i = 0; i < BENCHMARK_MODES; i++)
+                    std::cout << std::setw(10) << benchmarkModes[i] << std::setw(11) << benchmarkStats[i].Calls / BENCHMARK_ITERATIONS
+                              << std::setw(10) << benchmarkStats[i].Redundant / BENCHMARK_ITERATIONS
+                              << std::setw(10) << benchmarkStats[i].NameLookups / BENCHMARK_ITERATIONS
+                              << std::fixed << std::setprecision(3) << std::setw(10) << benchmarkCpuMs[i] / BENCHMARK_ITERATIONS << std::endl;
+                break;
+            }
+        }
+
+        headlessRunner.EndFrame();
+
         // swap and poll events
         glfwSwapBuffers(window);
         glfwPollEvents();
     }
 
+    profiler.Flush();
+    profiler.PrintSummary();
+
     // clear resources
+    clusteredLights.Destroy();
+    gBuffer.Destroy();
     glDeleteBuffers(1, &quadVBO);
     glDeleteBuffers(1, &cubeVBO);
     glDeleteVertexArrays(1, &quadVAO);
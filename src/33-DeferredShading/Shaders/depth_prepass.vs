@@ -0,0 +1,22 @@
+#version 330 core
+// 深度预处理：只读取位置流（Mesh::DrawPositions），压缩布局下不会读到法线、切线和 UV
+layout (location = 0) in vec3 aPos;
+
+uniform mat4 model;
+uniform mat4 view;
+uniform mat4 projection;
+
+// 顶点布局（Mesh.h 中的 VertexLayout）：2 是量化位置，按网格包围盒还原
+uniform int uVertexLayout;
+uniform vec3 uPositionScale;
+uniform vec3 uPositionBias;
+
+// 和 g_buffer.vs 的计算完全相同，G-buffer pass 才能用 GL_LEQUAL 通过预处理写下的深度
+invariant gl_Position;
+
+void main()
+{
+    vec3 position = uVertexLayout == 2 ? aPos * uPositionScale + uPositionBias : aPos;
+    vec4 worldPos = model * vec4(position, 1.0);
+    gl_Position = projection * view * worldPos;
+}
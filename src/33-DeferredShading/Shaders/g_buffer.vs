@@ -11,14 +11,35 @@ uniform mat4 model;
 uniform mat4 view;
 uniform mat4 projection;
 
+// 顶点布局（Mesh.h 中的 VertexLayout）：0 完整 float，1 八面体编码法线，2 八面体编码法线 + 量化位置
+uniform int uVertexLayout;
+uniform vec3 uPositionScale;
+uniform vec3 uPositionBias;
+
+// 深度预处理（depth_prepass.vs）用相同的计算，开启预处理时深度必须一致
+invariant gl_Position;
+
+// 八面体编码还原成单位向量
+vec3 OctahedralDecode(vec2 e)
+{
+    vec3 v = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+    float t = max(-v.z, 0.0);
+    v.xy += vec2(v.x >= 0.0 ? -t : t, v.y >= 0.0 ? -t : t);
+    return normalize(v);
+}
+
 void main()
 {
-    vec4 worldPos = model * vec4(aPos, 1.0);
+    vec3 position = uVertexLayout == 2 ? aPos * uPositionScale + uPositionBias : aPos;
+    // 压缩布局下 location 1 只有两个分量（z 读出来是 0）
+    vec3 normal = uVertexLayout == 0 ? aNormal : OctahedralDecode(aNormal.xy);
+
+    vec4 worldPos = model * vec4(position, 1.0);
     FragPos = worldPos.xyz; 
     TexCoords = aTexCoords;
     
     mat3 normalMatrix = transpose(inverse(mat3(model)));
-    Normal = normalMatrix * aNormal;
+    Normal = normalMatrix * normal;
 
     gl_Position = projection * view * worldPos;
-}
\ No newline at end of file
+}
@@ -12,6 +12,9 @@
 #include <glm/gtc/type_ptr.hpp>
 
 #include <tool/Model.h>
+#include <tool/Headless.h>
+#include <tool/GpuProfiler.h>
+#include <tool/GBuffer.h>
 
 const int SCREEN_WIDTH = 1280;
 const int SCREEN_HEIGHT = 720;
@@ -36,6 +39,26 @@ float exposure = 1.0f;
 bool bloom = true;
 bool bloomKeyPressed = false;
 
+// SSAO 质量档位（1-4 键切换）：采样数和半径
+struct SSAOQuality
+{
+    const char* Name;
+    unsigned int KernelSize;
+    float Radius;
+};
+const SSAOQuality SSAO_QUALITY_TIERS[4] =
+{
+    { "low",    8u,  0.35f },
+    { "medium", 16u, 0.4f },
+    { "high",   32u, 0.5f },
+    { "ultra",  64u, 0.5f }
+};
+int ssaoQuality = 3;
+// SSAO 分辨率（R 键切换）：0 全分辨率，1 1/2，2 1/4
+const char* SSAO_RESOLUTION_NAMES[3] = { "full", "half", "quarter" };
+int ssaoResolution = 0;
+bool ssaoResolutionKeyPressed = false;
+
 void FramebufferSizeCallback(GLFWwindow *window, int width, int height)
 {
     glViewport(0u, 0u, width, height);
@@ -57,6 +80,19 @@ void ProcessInput(GLFWwindow *window)
         camera.ProcessKeyboard(UP, DeltaTime);
     if (glfwGetKey(window, GLFW_KEY_Q) == GLFW_PRESS)
         camera.ProcessKeyboard(DOWN, DeltaTime);
+
+    for (int tier = 0; tier < 4; tier++)
+    {
+        if (glfwGetKey(window, GLFW_KEY_1 + tier) == GLFW_PRESS)
+            ssaoQuality = tier;
+    }
+    if (glfwGetKey(window, GLFW_KEY_R) == GLFW_PRESS && !ssaoResolutionKeyPressed)
+    {
+        ssaoResolution = (ssaoResolution + 1) % 3;
+        ssaoResolutionKeyPressed = true;
+    }
+    if (glfwGetKey(window, GLFW_KEY_R) == GLFW_RELEASE)
+        ssaoResolutionKeyPressed = false;
 }
 
 void CursorPosCallback(GLFWwindow *window, double xpos, double ypos)
@@ -231,14 +267,106 @@ float ourLerp(float a, float b, float f)
     return a + f * (b - a);
 }
 
+// generate sample kernel：采样点越靠后离中心越远，采样数变化时重新生成，保证少量采样也覆盖整个半球
+std::vector<glm::vec3> GenerateSSAOKernel(unsigned int kernelSize)
+{
+    std::uniform_real_distribution<GLfloat> randomFloats(0.0, 1.0); // generates random floats between 0.0 and 1.0
+    std::default_random_engine generator;
+    std::vector<glm::vec3> ssaoKernel;
+    for (unsigned int i = 0; i < kernelSize; ++i)
+    {
+        glm::vec3 sample(randomFloats(generator) * 2.0 - 1.0, randomFloats(generator) * 2.0 - 1.0, randomFloats(generator));
+        sample = glm::normalize(sample);
+        sample *= randomFloats(generator);
+        float scale = float(i) / float(kernelSize);
+
+        // scale samples s.t. they're more aligned to center of kernel
+        scale = ourLerp(0.1f, 1.0f, scale * scale);
+        sample *= scale;
+        ssaoKernel.push_back(sample);
+    }
+    return ssaoKernel;
+}
+
+// 单个颜色附件的帧缓冲（SSAO 的中间结果）
+unsigned int CreateColorTarget(int width, int height, GLenum internalFormat, GLenum format, unsigned int& framebuffer)
+{
+    unsigned int texture;
+    glGenFramebuffers(1, &framebuffer);
+    glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+    glGenTextures(1, &texture);
+    glBindTexture(GL_TEXTURE_2D, texture);
+    glTexImage2D(GL_TEXTURE_2D, 0, internalFormat, width, height, 0, format, GL_FLOAT, NULL);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, texture, 0);
+    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+        std::cout << "SSAO Framebuffer not complete!" << std::endl;
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    return texture;
+}
+
+// 低分辨率 SSAO 的一层：深度/法线金字塔的这一层，以及这个分辨率下的 AO 和模糊中间结果
+struct SSAOLevel
+{
+    int Width;
+    int Height;
+    unsigned int DepthNormalFBO, DepthNormal;   // RGBA16F：xyz 观察空间法线，w 观察空间深度
+    unsigned int AOFBO, AO;
+    unsigned int BlurFBO, Blur;                 // 水平模糊的结果，竖直模糊写回 AO
+
+    void Create(int width, int height)
+    {
+        Width = width;
+        Height = height;
+        DepthNormal = CreateColorTarget(width, height, GL_RGBA16F, GL_RGBA, DepthNormalFBO);
+        AO = CreateColorTarget(width, height, GL_R8, GL_RED, AOFBO);
+        Blur = CreateColorTarget(width, height, GL_R8, GL_RED, BlurFBO);
+    }
+
+    void Destroy()
+    {
+        unsigned int textures[3] = { DepthNormal, AO, Blur };
+        unsigned int framebuffers[3] = { DepthNormalFBO, AOFBO, BlurFBO };
+        glDeleteTextures(3, textures);
+        glDeleteFramebuffers(3, framebuffers);
+    }
+};
+
 int main(int argc, char **argv)
 {
+    // headless mode: --headless --frames=N --capture=F1,F2 --output=DIR
+    HeadlessOptions headlessOptions = ParseHeadlessOptions(argc, argv);
+    ConfigureHeadlessPlatform(headlessOptions);
+    // G-buffer layout: --gbuffer=full|compact
+    // SSAO: --ssao-resolution=full|half|quarter, --ssao-quality=low|medium|high|ultra
+    GBufferLayout gBufferLayout = GBufferLayout::Full;
+    for (int i = 1; i < argc; i++)
+    {
+        std::string arg = argv[i];
+        if (arg == "--gbuffer=compact")
+            gBufferLayout = GBufferLayout::Compact;
+        for (int level = 0; level < 3; level++)
+        {
+            if (arg == std::string("--ssao-resolution=") + SSAO_RESOLUTION_NAMES[level])
+                ssaoResolution = level;
+        }
+        for (int tier = 0; tier < 4; tier++)
+        {
+            if (arg == std::string("--ssao-quality=") + SSAO_QUALITY_TIERS[tier].Name)
+                ssaoQuality = tier;
+        }
+    }
+
     // glfw and glad initialize
     if (!glfwInit())
         return -1;
     glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
     glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
     glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+    ConfigureHeadlessWindowHints(headlessOptions);
 
     GLFWwindow *window = glfwCreateWindow(SCREEN_WIDTH, SCREEN_HEIGHT, "LearnOpenGL", nullptr, nullptr);
     if (window == nullptr)
@@ -275,6 +403,9 @@ int main(int argc, char **argv)
     Shader shaderLightingPass("./src/34-SSAO/Shaders/ssao.vs", "./src/34-SSAO/Shaders/ssao_lighting.fs");
     Shader shaderSSAO("./src/34-SSAO/Shaders/ssao.vs", "./src/34-SSAO/Shaders/ssao.fs");
     Shader shaderSSAOBlur("./src/34-SSAO/Shaders/ssao.vs", "./src/34-SSAO/Shaders/ssao_blur.fs");
+    Shader shaderSSAODownsample("./src/34-SSAO/Shaders/ssao.vs", "./src/34-SSAO/Shaders/ssao_downsample.fs");
+    Shader shaderSSAOBilateralBlur("./src/34-SSAO/Shaders/ssao.vs", "./src/34-SSAO/Shaders/ssao_bilateral_blur.fs");
+    Shader shaderSSAOUpsample("./src/34-SSAO/Shaders/ssao.vs", "./src/34-SSAO/Shaders/ssao_upsample.fs");
 
     // load models
     // -----------
@@ -282,46 +413,9 @@ int main(int argc, char **argv)
 
     // configure g-buffer framebuffer
     // ------------------------------
-    unsigned int gBuffer;
-    glGenFramebuffers(1, &gBuffer);
-    glBindFramebuffer(GL_FRAMEBUFFER, gBuffer);
-    unsigned int gPosition, gNormal, gAlbedo;
-    // position color buffer
-    glGenTextures(1, &gPosition);
-    glBindTexture(GL_TEXTURE_2D, gPosition);
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA16F, SCREEN_WIDTH, SCREEN_HEIGHT, 0, GL_RGBA, GL_FLOAT, NULL);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, gPosition, 0);
-    // normal color buffer
-    glGenTextures(1, &gNormal);
-    glBindTexture(GL_TEXTURE_2D, gNormal);
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA16F, SCREEN_WIDTH, SCREEN_HEIGHT, 0, GL_RGBA, GL_FLOAT, NULL);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT1, GL_TEXTURE_2D, gNormal, 0);
-    // color + specular color buffer
-    glGenTextures(1, &gAlbedo);
-    glBindTexture(GL_TEXTURE_2D, gAlbedo);
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, SCREEN_WIDTH, SCREEN_HEIGHT, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT2, GL_TEXTURE_2D, gAlbedo, 0);
-    // tell OpenGL which color attachments we'll use (of this framebuffer) for rendering 
-    unsigned int attachments[3] = { GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1, GL_COLOR_ATTACHMENT2 };
-    glDrawBuffers(3, attachments);
-    // create and attach depth buffer (renderbuffer)
-    unsigned int rboDepth;
-    glGenRenderbuffers(1, &rboDepth);
-    glBindRenderbuffer(GL_RENDERBUFFER, rboDepth);
-    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT, SCREEN_WIDTH, SCREEN_HEIGHT);
-    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, rboDepth);
-    // finally check if framebuffer is complete
-    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
-        std::cout << "Framebuffer not complete!" << std::endl;
-    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    GBuffer gBuffer(SCREEN_WIDTH, SCREEN_HEIGHT, gBufferLayout);
+    // SSAO 和光照 pass 各读一次 G-buffer
+    GBuffer::PrintBandwidthReport(2u);
 
     // also create framebuffer to hold SSAO processing stage 
     // -----------------------------------------------------
@@ -350,26 +444,15 @@ int main(int argc, char **argv)
         std::cout << "SSAO Blur Framebuffer not complete!" << std::endl;
     glBindFramebuffer(GL_FRAMEBUFFER, 0);
 
-    // generate sample kernel
-    // ----------------------
-    std::uniform_real_distribution<GLfloat> randomFloats(0.0, 1.0); // generates random floats between 0.0 and 1.0
-    std::default_random_engine generator;
-    std::vector<glm::vec3> ssaoKernel;
-    for (unsigned int i = 0; i < 64; ++i)
-    {
-        glm::vec3 sample(randomFloats(generator) * 2.0 - 1.0, randomFloats(generator) * 2.0 - 1.0, randomFloats(generator));
-        sample = glm::normalize(sample);
-        sample *= randomFloats(generator);
-        float scale = float(i) / 64.0f;
-
-        // scale samples s.t. they're more aligned to center of kernel
-        scale = ourLerp(0.1f, 1.0f, scale * scale);
-        sample *= scale;
-        ssaoKernel.push_back(sample);
-    }
+    // 低分辨率 SSAO：1/2 和 1/4 分辨率两层（1/4 的金字塔从 1/2 那一层生成）
+    SSAOLevel ssaoLevels[2];
+    ssaoLevels[0].Create(SCREEN_WIDTH / 2, SCREEN_HEIGHT / 2);
+    ssaoLevels[1].Create(SCREEN_WIDTH / 4, SCREEN_HEIGHT / 4);
 
     // generate noise texture
     // ----------------------
+    std::uniform_real_distribution<GLfloat> randomFloats(0.0, 1.0); // generates random floats between 0.0 and 1.0
+    std::default_random_engine generator;
     std::vector<glm::vec3> ssaoNoise;
     for (unsigned int i = 0; i < 16; i++)
     {
@@ -397,15 +480,56 @@ int main(int argc, char **argv)
     shaderLightingPass.SetInt("gNormal", 1);
     shaderLightingPass.SetInt("gAlbedo", 2);
     shaderLightingPass.SetInt("ssao", 3);
+    shaderLightingPass.SetInt("gDepth", 4);
+    shaderLightingPass.SetInt("uGBufferLayout", static_cast<int>(gBufferLayout));
     shaderSSAO.Use();
     shaderSSAO.SetInt("gPosition", 0);
     shaderSSAO.SetInt("gNormal", 1);
     shaderSSAO.SetInt("texNoise", 2);
+    shaderSSAO.SetInt("gDepth", 4);
+    shaderSSAO.SetInt("depthNormal", 5);
+    shaderSSAO.SetInt("uGBufferLayout", static_cast<int>(gBufferLayout));
+    UniformHandle useDepthNormalUniform = shaderSSAO.GetUniform("useDepthNormal");
+    UniformHandle noiseScaleUniform = shaderSSAO.GetUniform("noiseScale");
+    shaderSSAODownsample.Use();
+    shaderSSAODownsample.SetInt("gPosition", 0);
+    shaderSSAODownsample.SetInt("gNormal", 1);
+    shaderSSAODownsample.SetInt("gDepth", 4);
+    shaderSSAODownsample.SetInt("depthNormalInput", 5);
+    shaderSSAODownsample.SetInt("uGBufferLayout", static_cast<int>(gBufferLayout));
+    shaderSSAOBilateralBlur.Use();
+    shaderSSAOBilateralBlur.SetInt("ssaoInput", 0);
+    shaderSSAOBilateralBlur.SetInt("depthNormal", 5);
+    shaderSSAOUpsample.Use();
+    shaderSSAOUpsample.SetInt("ssaoInput", 3);
+    shaderSSAOUpsample.SetInt("gPosition", 0);
+    shaderSSAOUpsample.SetInt("gNormal", 1);
+    shaderSSAOUpsample.SetInt("gDepth", 4);
+    shaderSSAOUpsample.SetInt("depthNormal", 5);
+    shaderSSAOUpsample.SetInt("uGBufferLayout", static_cast<int>(gBufferLayout));
+    shaderGeometryPass.Use();
+    shaderGeometryPass.SetInt("uGBufferLayout", static_cast<int>(gBufferLayout));
+    // 预先解析采样核 uniform 句柄，渲染循环中不再拼接字符串
+    std::vector<UniformHandle> sampleUniforms;
+    for (unsigned int i = 0; i < 64; ++i)
+        sampleUniforms.push_back(shaderSSAO.GetUniform("samples[" + std::to_string(i) + "]"));
     shaderSSAOBlur.Use();
     shaderSSAOBlur.SetInt("ssaoInput", 0);
 
+    // scripted camera path, timings and captures for headless runs
+    HeadlessRunner headlessRunner(headlessOptions, CameraPath::Orbit(glm::vec3(0.0f, 0.5f, 5.0f), 3.0f, 1.5f, 4.0f), SCREEN_WIDTH, SCREEN_HEIGHT);
+    if (gBufferLayout == GBufferLayout::Full)
+        headlessRunner.AddCapture("gPosition", gBuffer.GetFBO(), GL_COLOR_ATTACHMENT0, true);
+    headlessRunner.AddCapture("gNormal", gBuffer.GetFBO(), GL_COLOR_ATTACHMENT1, gBufferLayout == GBufferLayout::Full);
+    headlessRunner.AddCapture("ssao", ssaoBlurFBO, GL_COLOR_ATTACHMENT0, true);
+
+    // per-pass GPU timings, exported on exit
+    GpuProfiler profiler;
+    // 当前上传的采样核对应的质量档位
+    int uploadedQuality = -1;
+
     // render loop
-    while (!glfwWindowShouldClose(window))
+    while (!glfwWindowShouldClose(window) && !headlessRunner.IsFinished())
     {
         float CurrentTime = static_cast<float>(glfwGetTime());
         DeltaTime = CurrentTime - LastTime;
@@ -413,11 +537,18 @@ int main(int argc, char **argv)
         nbFrames++;
         if (CurrentTime - LastFrame >= 1.0f)
         {
+            // 每帧平均的 uniform 调用：实际发出的 glUniform、被过滤的重复设置、字符串查找次数
+            UniformStats& uniformStats = Shader::GetUniformStats();
             std::stringstream ss;
             ss << "LearnOpenGL ( FPS: ";
             ss << nbFrames;
+            ss << " | glUniform/frame: " << uniformStats.Calls / nbFrames;
+            ss << ", filtered/frame: " << uniformStats.Redundant / nbFrames;
+            ss << ", name lookups/frame: " << uniformStats.NameLookups / nbFrames;
+            ss << " | SSAO (R, 1-4): " << SSAO_RESOLUTION_NAMES[ssaoResolution] << ", " << SSAO_QUALITY_TIERS[ssaoQuality].Name;
             ss << " )";
             glfwSetWindowTitle(window, ss.str().c_str());
+            uniformStats.Reset();
             nbFrames = 0;
             LastFrame += 1.0f;
         }
@@ -425,6 +556,8 @@ int main(int argc, char **argv)
         // input
         // -----
         ProcessInput(window);
+        headlessRunner.BeginFrame(camera, DeltaTime);
+        profiler.BeginFrame();
 
         // render
         // ------
@@ -433,7 +566,8 @@ int main(int argc, char **argv)
 
         // 1. geometry pass: render scene's geometry/color data into gbuffer
         // -----------------------------------------------------------------
-        glBindFramebuffer(GL_FRAMEBUFFER, gBuffer);
+        profiler.PushScope("G-buffer");
+        glBindFramebuffer(GL_FRAMEBUFFER, gBuffer.GetFBO());
             glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
             glm::mat4 projection = glm::perspective(glm::radians(camera.Fov), (float)SCREEN_WIDTH / (float)SCREEN_HEIGHT, 0.1f, 50.0f);
             glm::mat4 view = camera.GetViewMatrix();
@@ -457,39 +591,118 @@ int main(int argc, char **argv)
             shaderGeometryPass.SetMat4f("model", model);
             backpack.Draw(shaderGeometryPass);
         glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        profiler.PopScope();
 
         // 2. generate SSAO texture
         // ------------------------
-        glBindFramebuffer(GL_FRAMEBUFFER, ssaoFBO);
-            glClear(GL_COLOR_BUFFER_BIT);
+        profiler.PushScope("SSAO");
+        const SSAOQuality& quality = SSAO_QUALITY_TIERS[ssaoQuality];
+        shaderSSAO.Use();
+        if (uploadedQuality != ssaoQuality)
+        {
+            // Send kernel
+            std::vector<glm::vec3> ssaoKernel = GenerateSSAOKernel(quality.KernelSize);
+            for (unsigned int i = 0; i < quality.KernelSize; ++i)
+                shaderSSAO.SetVec3f(sampleUniforms[i], ssaoKernel[i]);
+            shaderSSAO.SetInt("kernelSize", static_cast<int>(quality.KernelSize));
+            shaderSSAO.SetFloat("radius", quality.Radius);
+            uploadedQuality = ssaoQuality;
+        }
+        shaderSSAO.SetMat4f("projection", projection);
+        shaderSSAO.SetMat4f("inverseProjection", glm::inverse(projection));
+        glActiveTexture(GL_TEXTURE0);
+        glBindTexture(GL_TEXTURE_2D, gBuffer.GetPosition());
+        glActiveTexture(GL_TEXTURE1);
+        glBindTexture(GL_TEXTURE_2D, gBuffer.GetNormal());
+        glActiveTexture(GL_TEXTURE2);
+        glBindTexture(GL_TEXTURE_2D, noiseTexture);
+        glActiveTexture(GL_TEXTURE4);
+        glBindTexture(GL_TEXTURE_2D, gBuffer.GetDepth());
+        if (ssaoResolution == 0)
+        {
+            shaderSSAO.SetInt(useDepthNormalUniform, 0);
+            shaderSSAO.SetVec2f(noiseScaleUniform, glm::vec2(SCREEN_WIDTH, SCREEN_HEIGHT) / 4.0f);
+            glBindFramebuffer(GL_FRAMEBUFFER, ssaoFBO);
+                glClear(GL_COLOR_BUFFER_BIT);
+                RenderQuad();
+            glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+
+            // 3. blur SSAO texture to remove noise
+            // ------------------------------------
+            profiler.PushScope("SSAO blur");    // nested in "SSAO"
+            glBindFramebuffer(GL_FRAMEBUFFER, ssaoBlurFBO);
+                glClear(GL_COLOR_BUFFER_BIT);
+                shaderSSAOBlur.Use();
+                glActiveTexture(GL_TEXTURE0);
+                glBindTexture(GL_TEXTURE_2D, ssaoColorBuffer);
+                RenderQuad();
+            glBindFramebuffer(GL_FRAMEBUFFER, 0);
+            profiler.PopScope();
+        }
+        else
+        {
+            // 2a. 深度/法线金字塔：每层 2x2 取一个像素，直到 AO 的分辨率
+            profiler.PushScope("SSAO downsample");
+            shaderSSAODownsample.Use();
+            // 紧凑 G-buffer 没有位置，第 0 层从深度重建视空间位置
+            shaderSSAODownsample.SetMat4f("inverseProjection", glm::inverse(projection));
+            for (int level = 0; level < ssaoResolution; level++)
+            {
+                glBindFramebuffer(GL_FRAMEBUFFER, ssaoLevels[level].DepthNormalFBO);
+                glViewport(0, 0, ssaoLevels[level].Width, ssaoLevels[level].Height);
+                shaderSSAODownsample.SetInt("fromGBuffer", level == 0 ? 1 : 0);
+                if (level > 0)
+                {
+                    glActiveTexture(GL_TEXTURE5);
+                    glBindTexture(GL_TEXTURE_2D, ssaoLevels[level - 1].DepthNormal);
+                }
+                RenderQuad();
+            }
+            profiler.PopScope();
+
+            // 2b. 低分辨率 AO，噪声纹理按 AO 的分辨率平铺
+            const SSAOLevel& target = ssaoLevels[ssaoResolution - 1];
+            glActiveTexture(GL_TEXTURE5);
+            glBindTexture(GL_TEXTURE_2D, target.DepthNormal);
             shaderSSAO.Use();
-            // Send kernel + rotation 
-            for (unsigned int i = 0; i < 64; ++i)
-                shaderSSAO.SetVec3f("samples[" + std::to_string(i) + "]", ssaoKernel[i]);
-            shaderSSAO.SetMat4f("projection", projection);
-            glActiveTexture(GL_TEXTURE0);
-            glBindTexture(GL_TEXTURE_2D, gPosition);
-            glActiveTexture(GL_TEXTURE1);
-            glBindTexture(GL_TEXTURE_2D, gNormal);
-            glActiveTexture(GL_TEXTURE2);
-            glBindTexture(GL_TEXTURE_2D, noiseTexture);
+            shaderSSAO.SetInt(useDepthNormalUniform, 1);
+            shaderSSAO.SetVec2f(noiseScaleUniform, glm::vec2(target.Width, target.Height) / 4.0f);
+            glBindFramebuffer(GL_FRAMEBUFFER, target.AOFBO);
             RenderQuad();
-        glBindFramebuffer(GL_FRAMEBUFFER, 0);
 
-
-        // 3. blur SSAO texture to remove noise
-        // ------------------------------------
-        glBindFramebuffer(GL_FRAMEBUFFER, ssaoBlurFBO);
-            glClear(GL_COLOR_BUFFER_BIT);
-            shaderSSAOBlur.Use();
+            // 3. 可分离的深度感知模糊：水平写到 Blur，竖直写回 AO
+            profiler.PushScope("SSAO blur");    // nested in "SSAO"
+            shaderSSAOBilateralBlur.Use();
+            glBindFramebuffer(GL_FRAMEBUFFER, target.BlurFBO);
             glActiveTexture(GL_TEXTURE0);
-            glBindTexture(GL_TEXTURE_2D, ssaoColorBuffer);
+            glBindTexture(GL_TEXTURE_2D, target.AO);
+            shaderSSAOBilateralBlur.SetVec2f("direction", glm::vec2(1.0f / target.Width, 0.0f));
             RenderQuad();
-        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+            glBindFramebuffer(GL_FRAMEBUFFER, target.AOFBO);
+            glBindTexture(GL_TEXTURE_2D, target.Blur);
+            shaderSSAOBilateralBlur.SetVec2f("direction", glm::vec2(0.0f, 1.0f / target.Height));
+            RenderQuad();
+            profiler.PopScope();
+
+            // 3a. 双边上采样到全分辨率，结果和全分辨率路径一样写到 ssaoColorBufferBlur
+            profiler.PushScope("SSAO upsample");
+            glBindFramebuffer(GL_FRAMEBUFFER, ssaoBlurFBO);
+            glViewport(0, 0, SCREEN_WIDTH, SCREEN_HEIGHT);
+            shaderSSAOUpsample.Use();
+            shaderSSAOUpsample.SetMat4f("inverseProjection", glm::inverse(projection));
+            glActiveTexture(GL_TEXTURE3);
+            glBindTexture(GL_TEXTURE_2D, target.AO);
+            RenderQuad();
+            glBindFramebuffer(GL_FRAMEBUFFER, 0);
+            profiler.PopScope();
+        }
+        profiler.PopScope();
 
 
         // 4. lighting pass: traditional deferred Blinn-Phong lighting with added screen-space ambient occlusion
         // -----------------------------------------------------------------------------------------------------
+        profiler.PushScope("lighting");
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
         shaderLightingPass.Use();
         // send light relevant uniforms
@@ -501,15 +714,22 @@ int main(int argc, char **argv)
         const float quadratic = 0.032f;
         shaderLightingPass.SetFloat("light.Linear", linear);
         shaderLightingPass.SetFloat("light.Quadratic", quadratic);
+        shaderLightingPass.SetMat4f("inverseProjection", glm::inverse(projection));
         glActiveTexture(GL_TEXTURE0);
-        glBindTexture(GL_TEXTURE_2D, gPosition);
+        glBindTexture(GL_TEXTURE_2D, gBuffer.GetPosition());
         glActiveTexture(GL_TEXTURE1);
-        glBindTexture(GL_TEXTURE_2D, gNormal);
+        glBindTexture(GL_TEXTURE_2D, gBuffer.GetNormal());
         glActiveTexture(GL_TEXTURE2);
-        glBindTexture(GL_TEXTURE_2D, gAlbedo);
+        glBindTexture(GL_TEXTURE_2D, gBuffer.GetAlbedoSpec());
+        glActiveTexture(GL_TEXTURE4);
+        glBindTexture(GL_TEXTURE_2D, gBuffer.GetDepth());
         glActiveTexture(GL_TEXTURE3); // add extra SSAO texture to lighting pass
         glBindTexture(GL_TEXTURE_2D, ssaoColorBufferBlur);
         RenderQuad();
+        profiler.PopScope();
+
+        profiler.EndFrame();
+        headlessRunner.EndFrame();
 
         // swap and poll events
         glfwSwapBuffers(window);
@@ -521,6 +741,14 @@ int main(int argc, char **argv)
     glDeleteBuffers(1, &cubeVBO);
     glDeleteVertexArrays(1, &quadVAO);
     glDeleteVertexArrays(1, &cubeVAO);
+    gBuffer.Destroy();
+    ssaoLevels[0].Destroy();
+    ssaoLevels[1].Destroy();
+
+    profiler.Flush();
+    profiler.PrintSummary();
+    profiler.ExportCSV(headlessOptions.OutputDir + "/gpu_profile.csv");
+    profiler.ExportChromeTrace(headlessOptions.OutputDir + "/gpu_profile.json");
 
     glfwTerminate();
     return 0;
@@ -7,23 +7,67 @@ uniform sampler2D gPosition;
 uniform sampler2D gNormal;
 uniform sampler2D texNoise;
 
+// G-buffer 布局：0 完整，1 紧凑（观察空间位置从深度重建，法线八面体解码）
+uniform int uGBufferLayout;
+uniform sampler2D gDepth;
+uniform mat4 inverseProjection;
+
+vec3 OctahedralDecode(vec2 e)
+{
+    vec3 v = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+    float t = max(-v.z, 0.0);
+    v.xy += vec2(v.x >= 0.0 ? -t : t, v.y >= 0.0 ? -t : t);
+    return normalize(v);
+}
+
+vec3 GetViewPosition(vec2 uv)
+{
+    if (uGBufferLayout == 0)
+        return texture(gPosition, uv).xyz;
+    vec4 ndc = vec4(vec3(uv, texture(gDepth, uv).r) * 2.0 - 1.0, 1.0);
+    vec4 position = inverseProjection * ndc;
+    return position.xyz / position.w;
+}
+
+vec3 GetViewNormal(vec2 uv)
+{
+    if (uGBufferLayout == 0)
+        return normalize(texture(gNormal, uv).rgb);
+    return OctahedralDecode(texture(gNormal, uv).rg * 2.0 - 1.0);
+}
+
 uniform vec3 samples[64];
 
-// parameters (you'd probably want to use them as uniforms to more easily tweak the effect)
-int kernelSize = 64;
-float radius = 0.5;
+// 质量档位：采样数（不超过 64）和半径
+uniform int kernelSize;
+uniform float radius;
 float bias = 0.025;
 
 // tile noise texture over screen based on screen dimensions divided by noise size
-const vec2 noiseScale = vec2(800.0/4.0, 600.0/4.0); 
+// （AO 渲染目标的分辨率 / 4，由程序设置）
+uniform vec2 noiseScale;
 
 uniform mat4 projection;
 
+// 低分辨率路径：从深度/法线金字塔读取（RGBA16F，xyz 观察空间法线，w 观察空间深度），
+// 位置由深度和投影矩阵重建
+uniform bool useDepthNormal;
+uniform sampler2D depthNormal;
+
+vec3 GetSamplePosition(vec2 uv)
+{
+    if (!useDepthNormal)
+        return GetViewPosition(uv);
+    float z = texture(depthNormal, uv).w;
+    vec2 ndc = uv * 2.0 - 1.0;
+    return vec3(ndc.x * -z / projection[0][0], ndc.y * -z / projection[1][1], z);
+}
+
 void main()
 {
     // get input for SSAO algorithm
-    vec3 fragPos = texture(gPosition, TexCoords).xyz;
-    vec3 normal = normalize(texture(gNormal, TexCoords).rgb);
+    vec3 fragPos = GetSamplePosition(TexCoords);
+    vec3 normal = useDepthNormal ? normalize(texture(depthNormal, TexCoords).xyz) : GetViewNormal(TexCoords);
     vec3 randomVec = normalize(texture(texNoise, TexCoords * noiseScale).xyz);
     // create TBN change-of-basis matrix: from tangent-space to view-space
     vec3 tangent = normalize(randomVec - normal * dot(randomVec, normal));
@@ -44,7 +88,7 @@ void main()
         offset.xyz = offset.xyz * 0.5 + 0.5; // transform to range 0.0 - 1.0
         
         // get sample depth
-        float sampleDepth = texture(gPosition, offset.xy).z; // get depth value of kernel sample
+        float sampleDepth = GetSamplePosition(offset.xy).z; // get depth value of kernel sample
         
         // range check & accumulate
         float rangeCheck = smoothstep(0.0, 1.0, radius / abs(fragPos.z - sampleDepth));
@@ -0,0 +1,35 @@
+#version 330 core
+out float FragColor;
+
+in vec2 TexCoords;
+
+// 可分离的深度感知模糊：水平、竖直各一次，权重 = 高斯权重 * 深度相似度，不会跨过深度边缘
+uniform sampler2D ssaoInput;
+uniform sampler2D depthNormal;
+// 一个 texel 的步长：(1 / width, 0) 或 (0, 1 / height)
+uniform vec2 direction;
+
+const int BLUR_RADIUS = 4;
+// sigma = 2 的高斯权重
+const float weights[BLUR_RADIUS + 1] = float[](0.2042, 0.1802, 0.1238, 0.0663, 0.0276);
+// 相对深度差 1 / DEPTH_SHARPNESS（约 5%）时权重降到 1 / e
+const float DEPTH_SHARPNESS = 20.0;
+
+void main()
+{
+    float centerDepth = texture(depthNormal, TexCoords).w;
+    float result = texture(ssaoInput, TexCoords).r * weights[0];
+    float total = weights[0];
+    for (int i = 1; i <= BLUR_RADIUS; i++)
+    {
+        for (int side = -1; side <= 1; side += 2)
+        {
+            vec2 uv = TexCoords + direction * float(i * side);
+            float difference = (texture(depthNormal, uv).w - centerDepth) / max(-centerDepth, 0.1) * DEPTH_SHARPNESS;
+            float weight = weights[i] * exp(-difference * difference);
+            result += texture(ssaoInput, uv).r * weight;
+            total += weight;
+        }
+    }
+    FragColor = result / total;
+}
@@ -0,0 +1,64 @@
+#version 330 core
+out vec4 FragColor;
+
+in vec2 TexCoords;
+
+// 深度/法线金字塔的下一层：xyz 观察空间法线，w 观察空间深度
+// 第一层（1/2 分辨率）从 G-buffer 读取，之后每层从上一层读取
+uniform bool fromGBuffer;
+uniform sampler2D depthNormalInput;
+
+uniform sampler2D gPosition;
+uniform sampler2D gNormal;
+
+// G-buffer 布局：0 完整，1 紧凑（观察空间位置从深度重建，法线八面体解码）
+uniform int uGBufferLayout;
+uniform sampler2D gDepth;
+uniform mat4 inverseProjection;
+
+vec3 OctahedralDecode(vec2 e)
+{
+    vec3 v = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+    float t = max(-v.z, 0.0);
+    v.xy += vec2(v.x >= 0.0 ? -t : t, v.y >= 0.0 ? -t : t);
+    return normalize(v);
+}
+
+vec3 GetViewPosition(vec2 uv)
+{
+    if (uGBufferLayout == 0)
+        return texture(gPosition, uv).xyz;
+    vec4 ndc = vec4(vec3(uv, texture(gDepth, uv).r) * 2.0 - 1.0, 1.0);
+    vec4 position = inverseProjection * ndc;
+    return position.xyz / position.w;
+}
+
+vec3 GetViewNormal(vec2 uv)
+{
+    if (uGBufferLayout == 0)
+        return normalize(texture(gNormal, uv).rgb);
+    return OctahedralDecode(texture(gNormal, uv).rg * 2.0 - 1.0);
+}
+
+void main()
+{
+    // 2x2 个像素中取离相机最近的一个（观察空间 z 最大），法线也取同一个像素的，保证深度和法线属于同一个表面
+    ivec2 inputSize = fromGBuffer ? textureSize(gNormal, 0) : textureSize(depthNormalInput, 0);
+    ivec2 base = ivec2(gl_FragCoord.xy) * 2;
+    vec4 result = vec4(0.0, 0.0, 1.0, -1e30);
+    for (int i = 0; i < 4; i++)
+    {
+        ivec2 coord = min(base + ivec2(i & 1, i >> 1), inputSize - 1);
+        vec4 value;
+        if (fromGBuffer)
+        {
+            vec2 uv = (vec2(coord) + 0.5) / vec2(inputSize);
+            value = vec4(GetViewNormal(uv), GetViewPosition(uv).z);
+        }
+        else
+            value = texelFetch(depthNormalInput, coord, 0);
+        if (value.w > result.w)
+            result = value;
+    }
+    FragColor = result;
+}
@@ -7,12 +7,25 @@ in vec2 TexCoords;
 in vec3 FragPos;
 in vec3 Normal;
 
+// G-buffer 布局（GBuffer.h 中的 GBufferLayout）：0 完整，1 紧凑（不写位置，法线八面体编码到 RG16）
+uniform int uGBufferLayout;
+
+// 单位向量编码成八面体展开后的 [-1, 1]^2
+vec2 OctahedralEncode(vec3 n)
+{
+    n /= abs(n.x) + abs(n.y) + abs(n.z);
+    vec2 p = n.xy;
+    if (n.z < 0.0)
+        p = (1.0 - abs(n.yx)) * vec2(n.x >= 0.0 ? 1.0 : -1.0, n.y >= 0.0 ? 1.0 : -1.0);
+    return p;
+}
+
 void main()
 {    
-    // store the fragment position vector in the first gbuffer texture
+    // store the fragment position vector in the first gbuffer texture (紧凑布局下这个输出没有绑定附件)
     gPosition = FragPos;
     // also store the per-fragment normals into the gbuffer
-    gNormal = normalize(Normal);
+    gNormal = uGBufferLayout == 0 ? normalize(Normal) : vec3(OctahedralEncode(normalize(Normal)) * 0.5 + 0.5, 0.0);
     // and the diffuse per-fragment color
     gAlbedo.rgb = vec3(0.95);
 }
\ No newline at end of file
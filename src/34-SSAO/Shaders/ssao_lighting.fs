@@ -8,6 +8,35 @@ uniform sampler2D gNormal;
 uniform sampler2D gAlbedo;
 uniform sampler2D ssao;
 
+// G-buffer 布局：0 完整，1 紧凑（观察空间位置从深度重建，法线八面体解码）
+uniform int uGBufferLayout;
+uniform sampler2D gDepth;
+uniform mat4 inverseProjection;
+
+vec3 OctahedralDecode(vec2 e)
+{
+    vec3 v = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+    float t = max(-v.z, 0.0);
+    v.xy += vec2(v.x >= 0.0 ? -t : t, v.y >= 0.0 ? -t : t);
+    return normalize(v);
+}
+
+vec3 GetViewPosition(vec2 uv)
+{
+    if (uGBufferLayout == 0)
+        return texture(gPosition, uv).xyz;
+    vec4 ndc = vec4(vec3(uv, texture(gDepth, uv).r) * 2.0 - 1.0, 1.0);
+    vec4 position = inverseProjection * ndc;
+    return position.xyz / position.w;
+}
+
+vec3 GetViewNormal(vec2 uv)
+{
+    if (uGBufferLayout == 0)
+        return normalize(texture(gNormal, uv).rgb);
+    return OctahedralDecode(texture(gNormal, uv).rg * 2.0 - 1.0);
+}
+
 struct Light {
     vec3 Position;
     vec3 Color;
@@ -20,8 +49,8 @@ uniform Light light;
 void main()
 {             
     // retrieve data from gbuffer
-    vec3 FragPos = texture(gPosition, TexCoords).rgb;
-    vec3 Normal = texture(gNormal, TexCoords).rgb;
+    vec3 FragPos = GetViewPosition(TexCoords);
+    vec3 Normal = GetViewNormal(TexCoords);
     vec3 Diffuse = texture(gAlbedo, TexCoords).rgb;
     float AmbientOcclusion = texture(ssao, TexCoords).r;
     
@@ -0,0 +1,68 @@
+#version 330 core
+out float FragColor;
+
+in vec2 TexCoords;
+
+// 双边上采样：覆盖当前像素的 2x2 个低分辨率 texel，双线性权重再乘上深度和法线的相似度，
+// 物体边缘的像素只使用同一个表面上的 AO
+uniform sampler2D ssaoInput;
+uniform sampler2D depthNormal;
+
+uniform sampler2D gPosition;
+uniform sampler2D gNormal;
+
+// G-buffer 布局：0 完整，1 紧凑（观察空间位置从深度重建，法线八面体解码）
+uniform int uGBufferLayout;
+uniform sampler2D gDepth;
+uniform mat4 inverseProjection;
+
+vec3 OctahedralDecode(vec2 e)
+{
+    vec3 v = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+    float t = max(-v.z, 0.0);
+    v.xy += vec2(v.x >= 0.0 ? -t : t, v.y >= 0.0 ? -t : t);
+    return normalize(v);
+}
+
+vec3 GetViewPosition(vec2 uv)
+{
+    if (uGBufferLayout == 0)
+        return texture(gPosition, uv).xyz;
+    vec4 ndc = vec4(vec3(uv, texture(gDepth, uv).r) * 2.0 - 1.0, 1.0);
+    vec4 position = inverseProjection * ndc;
+    return position.xyz / position.w;
+}
+
+vec3 GetViewNormal(vec2 uv)
+{
+    if (uGBufferLayout == 0)
+        return normalize(texture(gNormal, uv).rgb);
+    return OctahedralDecode(texture(gNormal, uv).rg * 2.0 - 1.0);
+}
+
+void main()
+{
+    vec2 lowSize = vec2(textureSize(ssaoInput, 0));
+    vec2 position = TexCoords * lowSize - 0.5;
+    vec2 f = fract(position);
+    ivec2 base = ivec2(floor(position));
+    float depth = GetViewPosition(TexCoords).z;
+    vec3 normal = GetViewNormal(TexCoords);
+
+    float result = 0.0;
+    float total = 0.0;
+    for (int i = 0; i < 4; i++)
+    {
+        ivec2 offset = ivec2(i & 1, i >> 1);
+        ivec2 coord = clamp(base + offset, ivec2(0), ivec2(lowSize) - 1);
+        vec4 lowDepthNormal = texelFetch(depthNormal, coord, 0);
+        float bilinear = (offset.x == 1 ? f.x : 1.0 - f.x) * (offset.y == 1 ? f.y : 1.0 - f.y);
+        float depthWeight = 1.0 / (1e-3 + abs(lowDepthNormal.w - depth) / max(-depth, 0.1));
+        float normalWeight = pow(max(dot(lowDepthNormal.xyz, normal), 0.0), 8.0);
+        // 四个都不相似时退化成双线性
+        float weight = bilinear * (depthWeight * normalWeight + 1e-4);
+        result += texelFetch(ssaoInput, coord, 0).r * weight;
+        total += weight;
+    }
+    FragColor = result / total;
+}
@@ -380,7 +380,7 @@ int main(int argc, char **argv)
 
     // pbr: load the HDR environment map
     // ---------------------------------
-    stbi_set_flip_vertically_on_load(true);
+    SetTextureFlip(true);
     int width, height, nrComponents;
     float *data = stbi_loadf("./res/textures/hdr/newport_loft.hdr", &width, &height, &nrComponents, 0);
     unsigned int hdrTexture;
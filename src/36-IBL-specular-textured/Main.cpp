@@ -2,6 +2,9 @@
 #include <map>
 #include <iostream>
 #include <random>
+#include <string>
+#include <chrono>
+#include <iomanip>
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
 #include <tool/Shader.h>
@@ -11,11 +14,14 @@
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
 
+#include <tool/IBLPrecompute.h>
 #include <tool/Model.h>
 
 const int SCREEN_WIDTH = 1280;
 const int SCREEN_HEIGHT = 720;
 
+const char* const HDR_PATH = "./res/textures/hdr/newport_loft.hdr";
+
 // Camera
 Camera camera(glm::vec3(-1.2f, 0.0f, 9.2f));
 float LastX{};
@@ -36,6 +42,10 @@ float exposure = 1.0f;
 bool bloom = true;
 bool bloomKeyPressed = false;
 
+// 漫反射辐照度使用球谐（默认）还是辐照度贴图，H 键切换
+bool bSHIrradiance = true;
+bool bSHKeyPressed = false;
+
 void FramebufferSizeCallback(GLFWwindow *window, int width, int height)
 {
     glViewport(0u, 0u, width, height);
@@ -57,6 +67,15 @@ void ProcessInput(GLFWwindow *window)
         camera.ProcessKeyboard(UP, DeltaTime);
     if (glfwGetKey(window, GLFW_KEY_Q) == GLFW_PRESS)
         camera.ProcessKeyboard(DOWN, DeltaTime);
+
+    if (glfwGetKey(window, GLFW_KEY_H) == GLFW_PRESS && !bSHKeyPressed)
+    {
+        bSHIrradiance = !bSHIrradiance;
+        bSHKeyPressed = true;
+        std::cout << "irradiance: " << (bSHIrradiance ? "sh" : "cubemap") << std::endl;
+    }
+    if (glfwGetKey(window, GLFW_KEY_H) == GLFW_RELEASE)
+        bSHKeyPressed = false;
 }
 
 void CursorPosCallback(GLFWwindow *window, double xpos, double ypos)
@@ -321,122 +340,9 @@ void RenderQuad()
     glBindVertexArray(0);
 }
 
-int main(int argc, char **argv)
+// 原来的 GPU 预计算：逐个 pass 渲染环境立方体贴图、辐照度、预过滤和 BRDF LUT（--ibl=gpu）
+IBLTextures PrecomputeIBLOnGPU(Shader& equirectangularToCubemapShader, Shader& irradianceShader, Shader& prefilterShader, Shader& brdfShader)
 {
-    // glfw and glad initialize
-    if (!glfwInit())
-        return -1;
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
-    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
-
-    GLFWwindow *window = glfwCreateWindow(SCREEN_WIDTH, SCREEN_HEIGHT, "LearnOpenGL", nullptr, nullptr);
-    if (window == nullptr)
-    {
-        std::cout << "Failed to Create GLFW Widnow!" << std::endl;
-        glfwTerminate();
-        return -1;
-    }
-    glfwMakeContextCurrent(window);
-
-    if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress))
-    {
-        std::cout << "Failed to Create GLFW Widnow!" << std::endl;
-        glfwTerminate();
-        return -1;
-    }
-
-    glViewport(0, 0, SCREEN_WIDTH, SCREEN_HEIGHT);
-
-    glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
-
-    // glfw callback functions
-    glfwSetFramebufferSizeCallback(window, FramebufferSizeCallback);
-    glfwSetCursorPosCallback(window, CursorPosCallback);
-    glfwSetScrollCallback(window, ScrollCallback);
-
-    // config global opengl state
-    // 1. 启用深度测试
-    glEnable(GL_DEPTH_TEST);
-
-    // 使用了立方体贴图
-    // set depth function to less than AND equal for skybox depth trick.
-    glDepthFunc(GL_LEQUAL);
-
-    // Shader
-    // -------------------------
-    Shader pbrShader("./src/36-IBL-specular-textured/Shaders/pbr.vs", "./src/36-IBL-specular-textured/Shaders/pbr.fs");
-    Shader equirectangularToCubemapShader("./src/36-IBL-specular-textured/Shaders/cubemap.vs", "./src/36-IBL-specular-textured/Shaders/equirectangular_to_cubemap.fs");
-    Shader irradianceShader("./src/36-IBL-specular-textured/Shaders/cubemap.vs", "./src/36-IBL-specular-textured/Shaders/irradiance_convolution.fs");
-    Shader prefilterShader("./src/36-IBL-specular-textured/Shaders/cubemap.vs", "./src/36-IBL-specular-textured/Shaders/prefilter.fs");
-    Shader brdfShader("./src/36-IBL-specular-textured/Shaders/brdf.vs", "./src/36-IBL-specular-textured/Shaders/brdf.fs");
-    Shader backgroundShader("./src/36-IBL-specular-textured/Shaders/background.vs", "./src/36-IBL-specular-textured/Shaders/background.fs");
-    
-    pbrShader.Use();
-    pbrShader.SetInt("irradianceMap", 0);
-    pbrShader.SetInt("prefilterMap", 1);
-    pbrShader.SetInt("brdfLUT", 2);
-    pbrShader.SetInt("albedoMap", 3);
-    pbrShader.SetInt("normalMap", 4);
-    pbrShader.SetInt("metallicMap", 5);
-    pbrShader.SetInt("roughnessMap", 6);
-    pbrShader.SetInt("aoMap", 7);
-
-    backgroundShader.Use();
-    backgroundShader.SetInt("environmentMap", 0);
-
-    // load PBR material textures
-    // --------------------------
-    // rusted iron
-    unsigned int ironAlbedoMap = TextureFromFile("albedo.png", "./res/textures/pbr/rusted_iron/");
-    unsigned int ironNormalMap = TextureFromFile("normal.png", "./res/textures/pbr/rusted_iron/");
-    unsigned int ironMetallicMap = TextureFromFile("metallic.png", "./res/textures/pbr/rusted_iron/");
-    unsigned int ironRoughnessMap = TextureFromFile("roughness.png", "./res/textures/pbr/rusted_iron/");
-    unsigned int ironAOMap = TextureFromFile("ao.png", "./res/textures/pbr/rusted_iron/");
-
-    // gold
-    unsigned int goldAlbedoMap = TextureFromFile("albedo.png", "./res/textures/pbr/gold/");
-    unsigned int goldNormalMap = TextureFromFile("normal.png", "./res/textures/pbr/gold/");
-    unsigned int goldMetallicMap = TextureFromFile("metallic.png", "./res/textures/pbr/gold/");
-    unsigned int goldRoughnessMap = TextureFromFile("roughness.png", "./res/textures/pbr/gold/");
-    unsigned int goldAOMap = TextureFromFile("ao.png", "./res/textures/pbr/gold/");
-
-    // grass
-    unsigned int grassAlbedoMap = TextureFromFile("albedo.png", "./res/textures/pbr/grass/");
-    unsigned int grassNormalMap = TextureFromFile("normal.png", "./res/textures/pbr/grass/");
-    unsigned int grassMetallicMap = TextureFromFile("metallic.png", "./res/textures/pbr/grass/");
-    unsigned int grassRoughnessMap = TextureFromFile("roughness.png", "./res/textures/pbr/grass/");
-    unsigned int grassAOMap = TextureFromFile("ao.png", "./res/textures/pbr/grass/");
-
-    // plastic
-    unsigned int plasticAlbedoMap = TextureFromFile("albedo.png", "./res/textures/pbr/plastic/");
-    unsigned int plasticNormalMap = TextureFromFile("normal.png", "./res/textures/pbr/plastic/");
-    unsigned int plasticMetallicMap = TextureFromFile("metallic.png", "./res/textures/pbr/plastic/");
-    unsigned int plasticRoughnessMap = TextureFromFile("roughness.png", "./res/textures/pbr/plastic/");
-    unsigned int plasticAOMap = TextureFromFile("ao.png", "./res/textures/pbr/plastic/");
-
-    // wall
-    unsigned int wallAlbedoMap = TextureFromFile("albedo.png", "./res/textures/pbr/wall/");
-    unsigned int wallNormalMap = TextureFromFile("normal.png", "./res/textures/pbr/wall/");
-    unsigned int wallMetallicMap = TextureFromFile("metallic.png", "./res/textures/pbr/wall/");
-    unsigned int wallRoughnessMap = TextureFromFile("roughness.png", "./res/textures/pbr/wall/");
-    unsigned int wallAOMap = TextureFromFile("ao.png", "./res/textures/pbr/wall/");
-
-    // lights
-    // ------
-    glm::vec3 lightPositions[] = {
-        glm::vec3(-10.0f,  10.0f, 10.0f),
-        glm::vec3( 10.0f,  10.0f, 10.0f),
-        glm::vec3(-10.0f, -10.0f, 10.0f),
-        glm::vec3( 10.0f, -10.0f, 10.0f),
-    };
-    glm::vec3 lightColors[] = {
-        glm::vec3(300.0f, 300.0f, 300.0f),
-        glm::vec3(300.0f, 300.0f, 300.0f),
-        glm::vec3(300.0f, 300.0f, 300.0f),
-        glm::vec3(300.0f, 300.0f, 300.0f)
-    };
-
     // pbr: setup framebuffer
     // ----------------------
     unsigned int captureFBO;
@@ -451,9 +357,9 @@ int main(int argc, char **argv)
 
     // pbr: load the HDR environment map
     // ---------------------------------
-    stbi_set_flip_vertically_on_load(true);
+    SetTextureFlip(true);
     int width, height, nrComponents;
-    float *data = stbi_loadf("./res/textures/hdr/newport_loft.hdr", &width, &height, &nrComponents, 0);
+    float *data = stbi_loadf(HDR_PATH, &width, &height, &nrComponents, 0);
     unsigned int hdrTexture;
     if (data)
     {
@@ -640,6 +546,176 @@ int main(int argc, char **argv)
 
     glBindFramebuffer(GL_FRAMEBUFFER, 0);
 
+    glDeleteTextures(1, &hdrTexture);
+    glDeleteRenderbuffers(1, &captureRBO);
+    glDeleteFramebuffers(1, &captureFBO);
+
+    IBLTextures textures;
+    textures.Environment = envCubemap;
+    textures.Irradiance = irradianceMap;
+    textures.Prefilter = prefilterMap;
+    textures.BRDFLUT = brdfLUTTexture;
+    return textures;
+}
+
+int main(int argc, char **argv)
+{
+    bool bGPUPrecompute = false;
+    for (int i = 1; i < argc; i++)
+    {
+        if (std::string(argv[i]) == "--ibl=gpu")
+            bGPUPrecompute = true;
+        else if (std::string(argv[i]) == "--irradiance=cubemap")
+            bSHIrradiance = false;
+    }
+
+    // glfw and glad initialize
+    if (!glfwInit())
+        return -1;
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+
+    GLFWwindow *window = glfwCreateWindow(SCREEN_WIDTH, SCREEN_HEIGHT, "LearnOpenGL", nullptr, nullptr);
+    if (window == nullptr)
+    {
+        std::cout << "Failed to Create GLFW Widnow!" << std::endl;
+        glfwTerminate();
+        return -1;
+    }
+    glfwMakeContextCurrent(window);
+
+    if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress))
+    {
+        std::cout << "Failed to Create GLFW Widnow!" << std::endl;
+        glfwTerminate();
+        return -1;
+    }
+
+    glViewport(0, 0, SCREEN_WIDTH, SCREEN_HEIGHT);
+
+    glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
+
+    // glfw callback functions
+    glfwSetFramebufferSizeCallback(window, FramebufferSizeCallback);
+    glfwSetCursorPosCallback(window, CursorPosCallback);
+    glfwSetScrollCallback(window, ScrollCallback);
+
+    // config global opengl state
+    // 1. 启用深度测试
+    glEnable(GL_DEPTH_TEST);
+
+    // 使用了立方体贴图
+    // set depth function to less than AND equal for skybox depth trick.
+    glDepthFunc(GL_LEQUAL);
+
+    // Shader
+    // -------------------------
+    Shader pbrShader("./src/36-IBL-specular-textured/Shaders/pbr.vs", "./src/36-IBL-specular-textured/Shaders/pbr.fs");
+    Shader equirectangularToCubemapShader("./src/36-IBL-specular-textured/Shaders/cubemap.vs", "./src/36-IBL-specular-textured/Shaders/equirectangular_to_cubemap.fs");
+    Shader irradianceShader("./src/36-IBL-specular-textured/Shaders/cubemap.vs", "./src/36-IBL-specular-textured/Shaders/irradiance_convolution.fs");
+    Shader prefilterShader("./src/36-IBL-specular-textured/Shaders/cubemap.vs", "./src/36-IBL-specular-textured/Shaders/prefilter.fs");
+    Shader brdfShader("./src/36-IBL-specular-textured/Shaders/brdf.vs", "./src/36-IBL-specular-textured/Shaders/brdf.fs");
+    Shader backgroundShader("./src/36-IBL-specular-textured/Shaders/background.vs", "./src/36-IBL-specular-textured/Shaders/background.fs");
+    
+    pbrShader.Use();
+    pbrShader.SetInt("irradianceMap", 0);
+    pbrShader.SetInt("prefilterMap", 1);
+    pbrShader.SetInt("brdfLUT", 2);
+    pbrShader.SetInt("albedoMap", 3);
+    pbrShader.SetInt("normalMap", 4);
+    pbrShader.SetInt("metallicMap", 5);
+    pbrShader.SetInt("roughnessMap", 6);
+    pbrShader.SetInt("aoMap", 7);
+
+    backgroundShader.Use();
+    backgroundShader.SetInt("environmentMap", 0);
+
+    // load PBR material textures
+    // --------------------------
+    // rusted iron
+    unsigned int ironAlbedoMap = TextureFromFile("albedo.png", "./res/textures/pbr/rusted_iron/");
+    unsigned int ironNormalMap = TextureFromFile("normal.png", "./res/textures/pbr/rusted_iron/");
+    unsigned int ironMetallicMap = TextureFromFile("metallic.png", "./res/textures/pbr/rusted_iron/");
+    unsigned int ironRoughnessMap = TextureFromFile("roughness.png", "./res/textures/pbr/rusted_iron/");
+    unsigned int ironAOMap = TextureFromFile("ao.png", "./res/textures/pbr/rusted_iron/");
+
+    // gold
+    unsigned int goldAlbedoMap = TextureFromFile("albedo.png", "./res/textures/pbr/gold/");
+    unsigned int goldNormalMap = TextureFromFile("normal.png", "./res/textures/pbr/gold/");
+    unsigned int goldMetallicMap = TextureFromFile("metallic.png", "./res/textures/pbr/gold/");
+    unsigned int goldRoughnessMap = TextureFromFile("roughness.png", "./res/textures/pbr/gold/");
+    unsigned int goldAOMap = TextureFromFile("ao.png", "./res/textures/pbr/gold/");
+
+    // grass
+    unsigned int grassAlbedoMap = TextureFromFile("albedo.png", "./res/textures/pbr/grass/");
+    unsigned int grassNormalMap = TextureFromFile("normal.png", "./res/textures/pbr/grass/");
+    unsigned int grassMetallicMap = TextureFromFile("metallic.png", "./res/textures/pbr/grass/");
+    unsigned int grassRoughnessMap = TextureFromFile("roughness.png", "./res/textures/pbr/grass/");
+    unsigned int grassAOMap = TextureFromFile("ao.png", "./res/textures/pbr/grass/");
+
+    // plastic
+    unsigned int plasticAlbedoMap = TextureFromFile("albedo.png", "./res/textures/pbr/plastic/");
+    unsigned int plasticNormalMap = TextureFromFile("normal.png", "./res/textures/pbr/plastic/");
+    unsigned int plasticMetallicMap = TextureFromFile("metallic.png", "./res/textures/pbr/plastic/");
+    unsigned int plasticRoughnessMap = TextureFromFile("roughness.png", "./res/textures/pbr/plastic/");
+    unsigned int plasticAOMap = TextureFromFile("ao.png", "./res/textures/pbr/plastic/");
+
+    // wall
+    unsigned int wallAlbedoMap = TextureFromFile("albedo.png", "./res/textures/pbr/wall/");
+    unsigned int wallNormalMap = TextureFromFile("normal.png", "./res/textures/pbr/wall/");
+    unsigned int wallMetallicMap = TextureFromFile("metallic.png", "./res/textures/pbr/wall/");
+    unsigned int wallRoughnessMap = TextureFromFile("roughness.png", "./res/textures/pbr/wall/");
+    unsigned int wallAOMap = TextureFromFile("ao.png", "./res/textures/pbr/wall/");
+
+    // lights
+    // ------
+    glm::vec3 lightPositions[] = {
+        glm::vec3(-10.0f,  10.0f, 10.0f),
+        glm::vec3( 10.0f,  10.0f, 10.0f),
+        glm::vec3(-10.0f, -10.0f, 10.0f),
+        glm::vec3( 10.0f, -10.0f, 10.0f),
+    };
+    glm::vec3 lightColors[] = {
+        glm::vec3(300.0f, 300.0f, 300.0f),
+        glm::vec3(300.0f, 300.0f, 300.0f),
+        glm::vec3(300.0f, 300.0f, 300.0f),
+        glm::vec3(300.0f, 300.0f, 300.0f)
+    };
+
+    // pbr: 准备 IBL 贴图
+    // 默认直接加载 HDR 文件旁边的 .iblcache（缓存不存在或过期时先在 CPU 上多线程预计算并写缓存），--ibl=gpu 使用原来逐个 pass 渲染的方式
+    // ---------------------------------
+    auto iblStart = std::chrono::high_resolution_clock::now();
+    IBLTextures ibl;
+    IrradianceSH irradianceSH = {};
+    const char* iblSource = "gpu";
+    if (bGPUPrecompute)
+    {
+        ibl = PrecomputeIBLOnGPU(equirectangularToCubemapShader, irradianceShader, prefilterShader, brdfShader);
+        // 读回环境贴图 64² 的那一级投影球谐
+        IBLImage environment;
+        ReadCubemapLevel(ibl.Environment, 3u, environment);
+        irradianceSH = ProjectIrradianceSH(environment, 0u);
+    }
+    else
+    {
+        bool bBaked = false;
+        if (!LoadOrBakeIBL(HDR_PATH, ibl, irradianceSH, bBaked))
+            std::cout << "Failed to load IBL maps." << std::endl;
+        iblSource = bBaked ? "cpu bake" : "cache";
+    }
+    glFinish();
+    std::cout << "IBL setup (" << iblSource << "): " << std::fixed << std::setprecision(1)
+              << std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - iblStart).count() << " ms" << std::endl;
+    unsigned int envCubemap = ibl.Environment;
+    unsigned int irradianceMap = ibl.Irradiance;
+    unsigned int prefilterMap = ibl.Prefilter;
+    unsigned int brdfLUTTexture = ibl.BRDFLUT;
+    unsigned int irradianceSHBuffer = CreateIrradianceSHBuffer(irradianceSH);
+    BindIrradianceSHBlock(pbrShader.GetID());
+    std::cout << "irradiance: " << (bSHIrradiance ? "sh" : "cubemap") << " (H to toggle)" << std::endl;
+
 
     // initialize static shader uniforms before rendering
     // --------------------------------------------------
@@ -689,6 +765,7 @@ int main(int argc, char **argv)
         glm::mat4 view = camera.GetViewMatrix();
         pbrShader.SetMat4f("view", view);
         pbrShader.SetVec3f("camPos", camera.Position);
+        pbrShader.SetInt("uIrradianceMode", bSHIrradiance ? 1 : 0);
 
         // bind pre-computed IBL data
         glActiveTexture(GL_TEXTURE0);
@@ -827,6 +904,7 @@ int main(int argc, char **argv)
 
     // clear ./res
     glDeleteVertexArrays(1, &sphereVAO);
+    glDeleteBuffers(1, &irradianceSHBuffer);
 
     glfwTerminate();
     return 0;
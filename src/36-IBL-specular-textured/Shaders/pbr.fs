@@ -16,6 +16,13 @@ uniform samplerCube irradianceMap;
 uniform samplerCube prefilterMap;
 uniform sampler2D brdfLUT;
 
+// 漫反射辐照度：0 采样辐照度贴图，1 用 L2 球谐求值（9 个 RGB 系数由 CPU 从环境贴图投影，见 IBLPrecompute.h）
+uniform int uIrradianceMode;
+layout (std140) uniform IrradianceSH
+{
+    vec4 shCoefficients[9];
+};
+
 // lights
 uniform vec3 lightPositions[4];
 uniform vec3 lightColors[4];
@@ -90,6 +97,20 @@ vec3 fresnelSchlickRoughness(float cosTheta, vec3 F0, float roughness)
     return F0 + (max(vec3(1.0 - roughness), F0) - F0) * pow(clamp(1.0 - cosTheta, 0.0, 1.0), 5.0);
 }   
 // ----------------------------------------------------------------------------
+vec3 EvaluateIrradianceSH(vec3 n)
+{
+    vec3 result = shCoefficients[0].rgb * 0.282095
+                + shCoefficients[1].rgb * (0.488603 * n.y)
+                + shCoefficients[2].rgb * (0.488603 * n.z)
+                + shCoefficients[3].rgb * (0.488603 * n.x)
+                + shCoefficients[4].rgb * (1.092548 * n.x * n.y)
+                + shCoefficients[5].rgb * (1.092548 * n.y * n.z)
+                + shCoefficients[6].rgb * (0.315392 * (3.0 * n.z * n.z - 1.0))
+                + shCoefficients[7].rgb * (1.092548 * n.x * n.z)
+                + shCoefficients[8].rgb * (0.546274 * (n.x * n.x - n.y * n.y));
+    return max(result, vec3(0.0));
+}
+// ----------------------------------------------------------------------------
 void main()
 {		
     // material properties
@@ -153,7 +174,11 @@ void main()
     vec3 kD = 1.0 - kS;
     kD *= 1.0 - metallic;	  
     
-    vec3 irradiance = texture(irradianceMap, N).rgb;
+    vec3 irradiance;
+    if (uIrradianceMode == 1)
+        irradiance = EvaluateIrradianceSH(N);
+    else
+        irradiance = texture(irradianceMap, N).rgb;
     vec3 diffuse      = irradiance * albedo;
     
     // sample both the pre-filter map and the BRDF lut and combine them together as per the Split-Sum approximation to get the IBL specular part.
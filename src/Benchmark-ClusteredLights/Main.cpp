@@ -0,0 +1,194 @@
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <vector>
+#include <string>
+#include <cmath>
+#include <cstdlib>
+#include <thread>
+#include <algorithm>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <tool/ClusteredLights.h>
+#include <tool/Random.h>
+
+// 分簇光照的 CPU 光源分配：32 到 16384 个光源
+// 运行：make run dir=Benchmark-ClusteredLights（可选 args="--threads=N"）
+// 1. scalar : 单线程，逐个簇做包围球/AABB 测试
+// 2. sse    : 单线程，SSE 一次测试 4 个簇
+// 3. jobs   : SSE + JobSystem，每个深度层一个任务
+// 同时输出平均每个非空簇的光源数（光照着色器每个像素实际循环的次数，原来固定循环全部光源），
+// 并检查 scalar 和 sse 的结果完全一致、所有结果都包含在暴力测试（每个光源对每个簇）的结果中，
+// 以及每个簇都没有漏掉和它真实形状相交的光源（所有簇、所有光源都检查）。
+// GPU 端（compute 路径和光照 pass）的耗时用章节的 headless 模式测量：
+//   make run dir=33-DeferredShading args="--headless --frames=300 --lights=4096 --light-culling=compute"
+
+const unsigned int LIGHT_COUNTS[] = { 32u, 128u, 512u, 2048u, 8192u, 16384u };
+const int REPEAT = 20;
+
+// 和 33-DeferredShading 相同的光源分布和光体积缩放
+std::vector<ClusterLight> GenerateLights(unsigned int count)
+{
+    const float linear = 0.7f;
+    const float constant = 1.0f;
+    float radiusScale = std::min(1.0f, std::sqrt(32.0f / static_cast<float>(count)));
+    std::vector<ClusterLight> lights(count);
+    for (unsigned int i = 0; i < count; i++)
+    {
+        glm::vec3 position = glm::vec3(HashRandom(i, 0u) % 100, HashRandom(i, 1u) % 100, HashRandom(i, 2u) % 100) * 0.06f - glm::vec3(3.0f, 4.0f, 3.0f);
+        glm::vec3 color = glm::vec3(HashRandom(i, 3u) % 100, HashRandom(i, 4u) % 100, HashRandom(i, 5u) % 100) / 200.0f + 0.5f;
+        float quadratic = 1.8f;
+        float maxBrightness = std::fmaxf(std::fmaxf(color.r, color.g), color.b);
+        float radius = (-linear + std::sqrt(linear * linear - 4 * quadratic * (constant - (256.0f / 5.0f) * maxBrightness))) / (2.0f * quadratic);
+        if (radiusScale < 1.0f)
+        {
+            radius *= radiusScale;
+            quadratic = ((256.0f / 5.0f) * maxBrightness - constant - linear * radius) / (radius * radius);
+        }
+        lights[i] = ClusterLight{ position, radius, color, quadratic };
+    }
+    return lights;
+}
+
+template<typename Function>
+double BestOfMs(const Function& function)
+{
+    double best = 1e30;
+    for (int i = 0; i < REPEAT; i++)
+    {
+        auto start = std::chrono::high_resolution_clock::now();
+        function();
+        best = std::min(best, std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count());
+    }
+    return best;
+}
+
+// 簇的真实形状是视锥体的一小块，比 AABB 小。在它上面按 5x5x5 取样（包括边界和角点），
+// 光源包围球包含任何一个样本点就一定和这个簇相交，列表中必须有这个光源（用来发现簇边界上的差一错误）
+bool SphereCoversClusterSample(const glm::vec3& center, float radius, unsigned int cluster, float fovY, float aspect, float nearPlane, float farPlane)
+{
+    const unsigned int SAMPLES = 5u;
+    unsigned int x = cluster % ClusteredLights::TileCountX;
+    unsigned int y = (cluster / ClusteredLights::TileCountX) % ClusteredLights::TileCountY;
+    unsigned int slice = cluster / (ClusteredLights::TileCountX * ClusteredLights::TileCountY);
+    float tanHalfY = std::tan(fovY * 0.5f);
+    float tanHalfX = tanHalfY * aspect;
+    float x0 = (-1.0f + 2.0f * x / ClusteredLights::TileCountX) * tanHalfX;
+    float x1 = (-1.0f + 2.0f * (x + 1u) / ClusteredLights::TileCountX) * tanHalfX;
+    float y0 = (-1.0f + 2.0f * y / ClusteredLights::TileCountY) * tanHalfY;
+    float y1 = (-1.0f + 2.0f * (y + 1u) / ClusteredLights::TileCountY) * tanHalfY;
+    float z0 = nearPlane * std::pow(farPlane / nearPlane, static_cast<float>(slice) / ClusteredLights::SliceCount);
+    float z1 = nearPlane * std::pow(farPlane / nearPlane, static_cast<float>(slice + 1u) / ClusteredLights::SliceCount);
+    for (unsigned int k = 0; k < SAMPLES; k++)
+    {
+        float depth = z0 + (z1 - z0) * k / (SAMPLES - 1u);
+        for (unsigned int j = 0; j < SAMPLES; j++)
+        {
+            float v = y0 + (y1 - y0) * j / (SAMPLES - 1u);
+            for (unsigned int i = 0; i < SAMPLES; i++)
+            {
+                float u = x0 + (x1 - x0) * i / (SAMPLES - 1u);
+                // 观察空间看向 -Z
+                glm::vec3 offset = glm::vec3(u * depth, v * depth, -depth) - center;
+                if (glm::dot(offset, offset) <= radius * radius)
+                    return true;
+            }
+        }
+    }
+    return false;
+}
+
+// 每个簇的光源集合
+std::vector<std::vector<unsigned int>> CollectLists(const ClusteredLights& clusters)
+{
+    std::vector<std::vector<unsigned int>> lists(ClusteredLights::ClusterCount);
+    for (unsigned int c = 0; c < ClusteredLights::ClusterCount; c++)
+    {
+        glm::uvec2 range = clusters.GetGrid()[c];
+        lists[c].assign(clusters.GetIndices().begin() + range.x, clusters.GetIndices().begin() + range.x + range.y);
+    }
+    return lists;
+}
+
+int main(int argc, char **argv)
+{
+    unsigned int threads = std::max(1u, std::thread::hardware_concurrency());
+    for (int i = 1; i < argc; i++)
+    {
+        std::string arg = argv[i];
+        if (arg.rfind("--threads=", 0) == 0)
+            threads = static_cast<unsigned int>(std::max(1, std::atoi(arg.c_str() + 10)));
+    }
+
+    // 33-DeferredShading 的初始相机
+    glm::mat4 view = glm::lookAt(glm::vec3(0.0f, 0.0f, 5.0f), glm::vec3(0.0f, 0.0f, 4.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+    const float fovY = glm::radians(45.0f);
+    const float aspect = 1280.0f / 720.0f;
+
+    JobSystem jobs(threads);
+    ClusteredLights serial;
+    ClusteredLights parallel(&jobs);
+    serial.SetProjection(fovY, aspect, 0.1f, 100.0f);
+    parallel.SetProjection(fovY, aspect, 0.1f, 100.0f);
+
+    std::cout << "jobs: " << threads << " threads" << std::endl;
+    std::cout << std::setw(8) << "lights"
+              << std::setw(13) << "scalar(ms)" << std::setw(10) << "sse(ms)" << std::setw(11) << "jobs(ms)"
+              << std::setw(10) << "indices" << std::setw(13) << "avg/cluster" << std::setw(13) << "max/cluster"
+              << std::setw(9) << "missed" << std::setw(10) << "check" << std::endl;
+    for (unsigned int count : LIGHT_COUNTS)
+    {
+        std::vector<ClusterLight> lights = GenerateLights(count);
+
+        double scalarMs = BestOfMs([&] { serial.Cull(lights, view, false); });
+        std::vector<std::vector<unsigned int>> scalarLists = CollectLists(serial);
+        double sseMs = BestOfMs([&] { serial.Cull(lights, view, true); });
+        std::vector<std::vector<unsigned int>> sseLists = CollectLists(serial);
+        double jobsMs = BestOfMs([&] { parallel.Cull(lights, view, true); });
+        std::vector<std::vector<unsigned int>> jobsLists = CollectLists(parallel);
+
+        // 验证：三条路径结果一致，并且都包含在暴力测试的结果中（暴力测试只用 AABB，比投影范围更保守，会多出一些）
+        bool bMatch = scalarLists == sseLists && sseLists == jobsLists;
+        for (unsigned int c = 0; c < ClusteredLights::ClusterCount && bMatch; c++)
+        {
+            for (unsigned int light : sseLists[c])
+            {
+                if (!serial.IntersectsCluster(lights[light], view, c))
+                {
+                    bMatch = false;
+                    break;
+                }
+            }
+        }
+        // 反过来检查每个簇、每个光源：和簇的真实形状相交的光源不能漏掉（AABB 不相交时真实形状也不相交，先用它排除）
+        unsigned int missed = 0u;
+        for (unsigned int c = 0; c < ClusteredLights::ClusterCount; c++)
+        {
+            for (unsigned int light = 0; light < count; light++)
+            {
+                if (!serial.IntersectsCluster(lights[light], view, c))
+                    continue;
+                glm::vec3 center = glm::vec3(view * glm::vec4(lights[light].Position, 1.0f));
+                if (!SphereCoversClusterSample(center, lights[light].Radius, c, fovY, aspect, 0.1f, 100.0f))
+                    continue;
+                if (std::find(sseLists[c].begin(), sseLists[c].end(), light) == sseLists[c].end())
+                    missed++;
+            }
+        }
+        bMatch = bMatch && missed == 0u;
+
+        const ClusteredLights::CullStats& stats = serial.GetStats();
+        std::cout << std::fixed << std::setprecision(3) << std::setw(8) << count
+                  << std::setw(13) << scalarMs << std::setw(10) << sseMs
+                  << std::setw(11) << jobsMs
+                  << std::setw(10) << stats.IndexCount
+                  << std::setprecision(1) << std::setw(13) << static_cast<double>(stats.IndexCount) / std::max(1u, stats.NonEmptyClusters)
+                  << std::setw(13) << stats.MaxPerCluster
+                  << std::setw(9) << missed
+                  << std::setw(10) << (bMatch ? "ok" : "MISMATCH") << std::endl;
+    }
+
+    return 0;
+}
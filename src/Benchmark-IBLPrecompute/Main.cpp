@@ -0,0 +1,109 @@
+#include <tool/IBLPrecompute.h>
+
+#define STB_IMAGE_IMPLEMENTATION
+#include <tool/stb_image.h>
+
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <string>
+#include <cstdlib>
+#include <thread>
+
+// IBL 贴图的离线预计算（36-IBL-specular、36-IBL-specular-textured 启动时加载的 .iblcache）
+// 运行：make run dir=Benchmark-IBLPrecompute（可选 args="--threads=N --input=xxx.hdr"）
+// 1. 分别用 1 个线程和 N 个线程预计算，输出每一步的耗时，以及辐照度球谐和卷积结果的误差
+// 2. 写缓存文件（默认放在 HDR 文件旁边，章节直接使用）
+// 3. 模拟章节启动：哈希 HDR 文件、映射并校验缓存、读取全部数据
+// 不创建窗口，也不调用 OpenGL，可以在没有 GPU 的构建机上运行
+
+void PrintRow(const char* name, const IBLBakeTimings& timings)
+{
+    std::cout << std::left << std::setw(12) << name << std::right << std::fixed << std::setprecision(1)
+              << std::setw(10) << timings.LoadMs << std::setw(14) << timings.EnvironmentMs
+              << std::setw(14) << timings.IrradianceMs << std::setw(13) << timings.PrefilterMs
+              << std::setw(10) << timings.BRDFMs << std::setw(8) << timings.SHMs << std::setw(11) << timings.GetTotalMs() << std::endl;
+}
+
+int main(int argc, char **argv)
+{
+    unsigned int threads = std::max(1u, std::thread::hardware_concurrency());
+    std::string input = "./res/textures/hdr/newport_loft.hdr";
+    for (int i = 1; i < argc; i++)
+    {
+        std::string arg = argv[i];
+        if (arg.rfind("--threads=", 0) == 0)
+            threads = static_cast<unsigned int>(std::max(1, std::atoi(arg.c_str() + 10)));
+        else if (arg.rfind("--input=", 0) == 0)
+            input = arg.substr(8);
+    }
+    std::string cachePath = input + IBL_CACHE_EXTENSION;
+
+    IBLBakeSettings settings;
+    std::cout << input << std::endl;
+    std::cout << "environment " << settings.EnvironmentSize << ", irradiance " << settings.IrradianceSize
+              << ", prefilter " << settings.PrefilterSize << " x " << settings.PrefilterMipCount << " mips, brdf lut "
+              << settings.BRDFLUTSize << ", " << settings.SampleCount << " samples" << std::endl;
+#ifdef IBL_PRECOMPUTE_SSE
+    std::cout << "simd: sse" << std::endl;
+#else
+    std::cout << "simd: none" << std::endl;
+#endif
+    std::cout << std::left << std::setw(12) << "threads" << std::right
+              << std::setw(10) << "load(ms)" << std::setw(14) << "environment" << std::setw(14) << "irradiance"
+              << std::setw(13) << "prefilter" << std::setw(10) << "brdf" << std::setw(8) << "sh" << std::setw(11) << "total" << std::endl;
+
+    IBLMaps maps;
+    IBLBakeTimings timings;
+    {
+        JobSystem jobs(1u);
+        if (!BakeIBL(input, settings, maps, timings, &jobs))
+            return -1;
+        PrintRow("1", timings);
+    }
+    if (threads > 1u)
+    {
+        JobSystem jobs(threads);
+        BakeIBL(input, settings, maps, timings, &jobs);
+        PrintRow(std::to_string(threads).c_str(), timings);
+    }
+    PrintIrradianceSHError(CompareIrradianceSH(maps.SH, maps.Images[IBL_IRRADIANCE]));
+
+    uint64_t sourceHash = HashIBLSource(input);
+    auto start = std::chrono::high_resolution_clock::now();
+    if (!WriteIBLCache(cachePath, sourceHash, settings.SampleCount, maps))
+    {
+        std::cout << "Failed to write IBL cache: " << cachePath << std::endl;
+        return -1;
+    }
+    double writeMs = IBLElapsedMs(start);
+
+    // 章节启动时 CPU 端的工作（不含 glTexImage2D 上传）
+    start = std::chrono::high_resolution_clock::now();
+    IBLCacheView cache;
+    if (!cache.Open(cachePath, HashIBLSource(input)))
+    {
+        std::cout << "Failed to open IBL cache: " << cachePath << std::endl;
+        return -1;
+    }
+    uint64_t checksum = 0;
+    for (unsigned int i = 0; i < IBL_IMAGE_COUNT; i++)
+    {
+        const IBLCacheImage& image = cache.GetImage(i);
+        for (uint32_t mip = 0; mip < image.MipCount; mip++)
+        {
+            for (uint32_t face = 0; face < image.FaceCount; face++)
+            {
+                const uint16_t* level = cache.GetLevel(i, mip, face);
+                uint64_t count = GetIBLLevelByteSize(image, mip) / sizeof(uint16_t);
+                for (uint64_t t = 0; t < count; t++)
+                    checksum += level[t];
+            }
+        }
+    }
+    double loadMs = IBLElapsedMs(start);
+
+    std::cout << cachePath << ": " << std::setprecision(2) << cache.GetFileSize() / (1024.0 * 1024.0) << " MB, write "
+              << std::setprecision(1) << writeMs << " ms, load " << loadMs << " ms (checksum " << checksum << ")" << std::endl;
+    return 0;
+}
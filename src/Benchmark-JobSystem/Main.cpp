@@ -0,0 +1,175 @@
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <vector>
+#include <cmath>
+#include <thread>
+#include <string>
+#include <cstdlib>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <tool/JobSystem.h>
+#include <tool/Random.h>
+
+// 任务系统从 1 到 N 个线程的扩展性测试
+// 运行：make run dir=Benchmark-JobSystem（可选 args="--threads=N"）
+// 1. asteroids : 生成 1,000,000 个小行星变换矩阵（23-Instance-Asteroids-UseInstance 的生成代码）
+// 2. lights    : 16384 个光源的每帧更新（位置动画 + 光体积半径 + 模型矩阵，33-DeferredShading-Volume 的计算）
+// 3. graph     : 用依赖计数器串起来的两个阶段：先生成矩阵，再由依赖它的任务计算包围球
+
+const unsigned int ASTEROID_COUNT = 1000000;
+const unsigned int LIGHT_COUNT = 16384;
+const int REPEAT = 5;
+
+glm::mat4 GenerateAsteroidMatrix(unsigned int i, unsigned int amount)
+{
+    const float radius = 50.0;
+    const float offset = 2.5f;
+    glm::mat4 model = glm::mat4(1.0f);
+    float angle = (float)i / (float)amount * 360.0f;
+    float displacement = (HashRandom(i, 0u) % (int)(2 * offset * 100)) / 100.0f - offset;
+    float x = sin(angle) * radius + displacement;
+    displacement = (HashRandom(i, 1u) % (int)(2 * offset * 100)) / 100.0f - offset;
+    float y = displacement * 0.4f;
+    displacement = (HashRandom(i, 2u) % (int)(2 * offset * 100)) / 100.0f - offset;
+    float z = cos(angle) * radius + displacement;
+    model = glm::translate(model, glm::vec3(x, y, z));
+    float scale = static_cast<float>((HashRandom(i, 3u) % 20) / 100.0 + 0.05);
+    model = glm::scale(model, glm::vec3(scale));
+    float rotAngle = static_cast<float>((HashRandom(i, 4u) % 360));
+    model = glm::rotate(model, rotAngle, glm::vec3(0.4f, 0.6f, 0.8f));
+    return model;
+}
+
+struct LightData
+{
+    glm::vec3 BasePosition;
+    glm::vec3 Color;
+    glm::vec3 Position;
+    float Radius;
+    glm::mat4 Model;
+};
+
+void UpdateLight(LightData& light, float time, unsigned int i)
+{
+    const float constant = 1.0f;
+    const float linear = 0.7f;
+    const float quadratic = 1.8f;
+    float phase = time + static_cast<float>(i) * 0.37f;
+    light.Position = light.BasePosition + glm::vec3(std::sin(phase), std::cos(phase * 1.3f) * 0.5f, std::cos(phase));
+    const float maxBrightness = std::fmaxf(std::fmaxf(light.Color.r, light.Color.g), light.Color.b);
+    light.Radius = (-linear + std::sqrt(linear * linear - 4 * quadratic * (constant - (256.0f / 5.0f) * maxBrightness))) / (2.0f * quadratic);
+    light.Model = glm::scale(glm::translate(glm::mat4(1.0f), light.Position), glm::vec3(0.125f));
+}
+
+// 多次运行取最快的一次
+template<typename Function>
+double BestOfMs(const Function& function)
+{
+    double best = 1e30;
+    for (int i = 0; i < REPEAT; i++)
+    {
+        auto start = std::chrono::high_resolution_clock::now();
+        function();
+        best = std::min(best, std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count());
+    }
+    return best;
+}
+
+int main(int argc, char **argv)
+{
+    // --threads=N 指定测试的最大线程数（默认硬件线程数）
+    unsigned int maxThreads = std::max(1u, std::thread::hardware_concurrency());
+    for (int i = 1; i < argc; i++)
+    {
+        std::string arg = argv[i];
+        if (arg.rfind("--threads=", 0) == 0)
+            maxThreads = static_cast<unsigned int>(std::max(1, std::atoi(arg.c_str() + 10)));
+    }
+
+    std::vector<glm::mat4> matrices(ASTEROID_COUNT);
+    std::vector<glm::vec4> spheres(ASTEROID_COUNT);
+    std::vector<LightData> lights(LIGHT_COUNT);
+    for (unsigned int i = 0; i < LIGHT_COUNT; i++)
+    {
+        lights[i].BasePosition = glm::vec3(HashRandom(i, 5u) % 100, HashRandom(i, 6u) % 100, HashRandom(i, 7u) % 100) * 0.06f - 3.0f;
+        lights[i].Color = glm::vec3(HashRandom(i, 8u) % 100, HashRandom(i, 9u) % 100, HashRandom(i, 10u) % 100) / 200.0f + 0.5f;
+    }
+
+    std::cout << std::setw(8) << "threads"
+              << std::setw(16) << "asteroids(ms)" << std::setw(10) << "speedup"
+              << std::setw(14) << "lights(ms)" << std::setw(10) << "speedup"
+              << std::setw(13) << "graph(ms)" << std::setw(10) << "speedup"
+              << std::setw(10) << "steals" << std::endl;
+
+    double baseAsteroids = 0.0, baseLights = 0.0, baseGraph = 0.0;
+    for (unsigned int threads = 1; threads <= maxThreads; threads++)
+    {
+        JobSystem jobs(threads);
+
+        double asteroidsMs = BestOfMs([&]
+        {
+            jobs.ParallelFor(0u, ASTEROID_COUNT, 4096u, [&](unsigned int first, unsigned int last)
+            {
+                for (unsigned int i = first; i < last; i++)
+                    matrices[i] = GenerateAsteroidMatrix(i, ASTEROID_COUNT);
+            });
+        });
+
+        float time = 0.0f;
+        double lightsMs = BestOfMs([&]
+        {
+            time += 1.0f / 60.0f;
+            jobs.ParallelFor(0u, LIGHT_COUNT, 256u, [&](unsigned int first, unsigned int last)
+            {
+                for (unsigned int i = first; i < last; i++)
+                    UpdateLight(lights[i], time, i);
+            });
+        });
+
+        // 阶段二的任务依赖阶段一的计数器，阶段一全部完成后才会进入队列
+        double graphMs = BestOfMs([&]
+        {
+            JobCounter generated, bounded;
+            const unsigned int chunk = 16384u;
+            for (unsigned int first = 0; first < ASTEROID_COUNT; first += chunk)
+            {
+                unsigned int last = std::min(first + chunk, ASTEROID_COUNT);
+                jobs.Run([&matrices, first, last]
+                {
+                    for (unsigned int i = first; i < last; i++)
+                        matrices[i] = GenerateAsteroidMatrix(i, ASTEROID_COUNT);
+                }, &generated);
+            }
+            for (unsigned int first = 0; first < ASTEROID_COUNT; first += chunk)
+            {
+                unsigned int last = std::min(first + chunk, ASTEROID_COUNT);
+                jobs.Run([&matrices, &spheres, first, last]
+                {
+                    for (unsigned int i = first; i < last; i++)
+                    {
+                        const glm::mat4& m = matrices[i];
+                        spheres[i] = glm::vec4(glm::vec3(m[3]), glm::length(glm::vec3(m[0])));
+                    }
+                }, &bounded, &generated);
+            }
+            jobs.Wait(bounded);
+        });
+
+        if (threads == 1)
+        {
+            baseAsteroids = asteroidsMs;
+            baseLights = lightsMs;
+            baseGraph = graphMs;
+        }
+        std::cout << std::fixed << std::setprecision(2) << std::setw(8) << threads
+                  << std::setw(16) << asteroidsMs << std::setw(9) << baseAsteroids / asteroidsMs << "x"
+                  << std::setw(14) << lightsMs << std::setw(9) << baseLights / lightsMs << "x"
+                  << std::setw(13) << graphMs << std::setw(9) << baseGraph / graphMs << "x"
+                  << std::setw(10) << jobs.GetStealCount() << std::endl;
+    }
+
+    return 0;
+}
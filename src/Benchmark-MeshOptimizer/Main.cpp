@@ -0,0 +1,125 @@
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <vector>
+#include <string>
+
+#include <assimp/Importer.hpp>
+#include <assimp/scene.h>
+#include <assimp/postprocess.h>
+
+#include <tool/MeshOptimizer.h>
+#include <tool/Model.h>
+
+// 导入时网格优化每一步的效果（顶点缓存按 16 项 FIFO 模拟）
+// 运行：make run dir=Benchmark-MeshOptimizer
+// 1. raw       : Assimp 导入的原始数据（obj 每个面的顶点都是独立的）
+// 2. weld      : 合并重复顶点
+// 3. cache     : Forsyth 顶点缓存重排
+// 4. overdraw  : 按簇重排减少 overdraw
+// 5. fetch     : 按第一次使用的顺序重排顶点
+// 只用 Assimp 读取数据，不需要 OpenGL 上下文
+
+struct MeshData
+{
+    std::vector<Vertex> Vertices;
+    std::vector<unsigned int> Indices;
+};
+
+// 和 Model::ProcessMesh 相同的顶点数据（不含材质）
+void CollectMeshes(aiNode* node, const aiScene* scene, std::vector<MeshData>& meshes)
+{
+    for (unsigned int m = 0; m < node->mNumMeshes; m++)
+    {
+        aiMesh* mesh = scene->mMeshes[node->mMeshes[m]];
+        MeshData data;
+        for (unsigned int i = 0; i < mesh->mNumVertices; i++)
+        {
+            Vertex vertex = {};
+            vertex.Position = glm::vec3(mesh->mVertices[i].x, mesh->mVertices[i].y, mesh->mVertices[i].z);
+            if (mesh->HasNormals())
+                vertex.Normal = glm::vec3(mesh->mNormals[i].x, mesh->mNormals[i].y, mesh->mNormals[i].z);
+            if (mesh->mTextureCoords[0])
+            {
+                vertex.TexCoord = glm::vec2(mesh->mTextureCoords[0][i].x, mesh->mTextureCoords[0][i].y);
+                vertex.Tangent = glm::vec3(mesh->mTangents[i].x, mesh->mTangents[i].y, mesh->mTangents[i].z);
+                vertex.Bitangent = glm::vec3(mesh->mBitangents[i].x, mesh->mBitangents[i].y, mesh->mBitangents[i].z);
+            }
+            data.Vertices.push_back(vertex);
+        }
+        for (unsigned int i = 0; i < mesh->mNumFaces; i++)
+            for (unsigned int j = 0; j < mesh->mFaces[i].mNumIndices; j++)
+                data.Indices.push_back(mesh->mFaces[i].mIndices[j]);
+        meshes.push_back(std::move(data));
+    }
+    for (unsigned int i = 0; i < node->mNumChildren; i++)
+        CollectMeshes(node->mChildren[i], scene, meshes);
+}
+
+// 所有网格合计的 ACMR / ATVR
+void PrintStage(const char* stage, const std::vector<MeshData>& meshes, double ms)
+{
+    size_t vertices = 0, triangles = 0, transformed = 0;
+    for (const MeshData& mesh : meshes)
+    {
+        vertices += mesh.Vertices.size();
+        triangles += mesh.Indices.size() / 3;
+        transformed += AnalyzeVertexCache(mesh.Indices, mesh.Vertices.size()).Transformed;
+    }
+    std::cout << "    " << std::left << std::setw(12) << stage << std::right << std::fixed
+              << std::setw(10) << vertices
+              << std::setw(10) << triangles
+              << std::setprecision(3)
+              << std::setw(10) << static_cast<double>(transformed) / triangles
+              << std::setw(10) << static_cast<double>(transformed) / vertices
+              << std::setprecision(2)
+              << std::setw(10) << ms << std::endl;
+}
+
+template<typename Function>
+double StageMs(std::vector<MeshData>& meshes, const Function& function)
+{
+    auto start = std::chrono::high_resolution_clock::now();
+    for (MeshData& mesh : meshes)
+        function(mesh);
+    return std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+}
+
+int main()
+{
+    const char* models[] =
+    {
+        "./res/models/nanosuit/nanosuit.obj",
+        "./res/models/rock/rock.obj",
+        "./res/models/planet/planet.obj"
+    };
+
+    for (const char* path : models)
+    {
+        Assimp::Importer importer;
+        const aiScene* scene = importer.ReadFile(path, Model::ImportFlags);
+        if (!scene || scene->mFlags & AI_SCENE_FLAGS_INCOMPLETE || !scene->mRootNode)
+        {
+            std::cout << "[ASSIMP ERROR]: " << importer.GetErrorString() << std::endl;
+            continue;
+        }
+        std::vector<MeshData> meshes;
+        CollectMeshes(scene->mRootNode, scene, meshes);
+
+        std::cout << path << std::endl;
+        std::cout << "    " << std::left << std::setw(12) << "stage" << std::right
+                  << std::setw(10) << "vertices" << std::setw(10) << "triangles"
+                  << std::setw(10) << "ACMR" << std::setw(10) << "ATVR" << std::setw(10) << "ms" << std::endl;
+        PrintStage("raw", meshes, 0.0);
+        double ms = StageMs(meshes, [](MeshData& mesh) { WeldVertices(mesh.Vertices, mesh.Indices); });
+        PrintStage("weld", meshes, ms);
+        ms = StageMs(meshes, [](MeshData& mesh) { OptimizeVertexCache(mesh.Indices, mesh.Vertices.size()); });
+        PrintStage("cache", meshes, ms);
+        ms = StageMs(meshes, [](MeshData& mesh) { OptimizeOverdraw(mesh.Indices, mesh.Vertices); });
+        PrintStage("overdraw", meshes, ms);
+        ms = StageMs(meshes, [](MeshData& mesh) { OptimizeVertexFetch(mesh.Vertices, mesh.Indices); });
+        PrintStage("fetch", meshes, ms);
+    }
+
+    return 0;
+}
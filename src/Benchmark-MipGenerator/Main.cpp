@@ -0,0 +1,197 @@
+#include <tool/MipGenerator.h>
+
+#define STB_IMAGE_IMPLEMENTATION
+#include <tool/stb_image.h>
+
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <string>
+#include <vector>
+#include <cstdlib>
+#include <thread>
+
+// CPU mip 生成（MipGenerator.h）的吞吐量和质量
+// 运行：make run dir=Benchmark-MipGenerator（可选 args="--threads=N --input=xxx.png"，--input 可以有多个）
+// 1. 吞吐量：每张图片、每种滤波分别用标量 / SSE / AVX2 单线程生成完整的 mip 链，再用 N 个线程，
+//    输出耗时和 MPix/s（按第 0 级的像素数计算），并检查 SIMD 版本和标量版本的结果是否逐位一致
+// 2. 质量：和 glGenerateMipmap 的做法（gamma 空间 2x2 平均，不归一化，不处理 alpha）对比
+//    颜色：第 4 级线性空间的平均亮度相对第 0 级的比例（gamma 空间平均会让高对比度的纹理变暗）
+//    法线：第 4 级法线的平均长度（不归一化时小于 1，光照变暗）
+//    alpha：每一级 alpha >= 0.5 的覆盖率（不处理时草和窗框在远处越来越稀）
+// 批量生成 .dds 使用 Benchmark-TextureCompression（--mip-filter=box|kaiser|lanczos）
+// 不创建窗口，也不调用 OpenGL
+
+const int ITERATIONS = 5;
+const float ALPHA_REFERENCE = 0.5f;
+
+struct SourceImage
+{
+    std::string Path;
+    unsigned char* Data = nullptr;
+    int Width = 0;
+    int Height = 0;
+    int Channels = 0;
+};
+
+double ElapsedMs(std::chrono::high_resolution_clock::time_point start)
+{
+    return std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+}
+
+// 返回一次完整 mip 链的平均耗时
+double TimeMipChain(const SourceImage& image, const MipSettings& settings, JobSystem* jobs, std::vector<std::vector<unsigned char>>& levels)
+{
+    GenerateMipChain(image.Data, image.Width, image.Height, settings, levels, jobs);
+    auto start = std::chrono::high_resolution_clock::now();
+    for (int i = 0; i < ITERATIONS; i++)
+        GenerateMipChain(image.Data, image.Width, image.Height, settings, levels, jobs);
+    return ElapsedMs(start) / ITERATIONS;
+}
+
+// 线性空间的平均亮度（显示器最终输出的光能），正确的 mip 每一级都应该和第 0 级相同
+float GetMeanLuminance(const std::vector<unsigned char>& level)
+{
+    const float* decode = GetSRGBDecodeTable();
+    double sum = 0.0;
+    size_t pixelCount = level.size() / 4u;
+    for (size_t i = 0; i < pixelCount; i++)
+        sum += 0.2126 * decode[level[i * 4u]] + 0.7152 * decode[level[i * 4u + 1u]] + 0.0722 * decode[level[i * 4u + 2u]];
+    return static_cast<float>(sum / std::max<size_t>(pixelCount, 1u));
+}
+
+float GetMeanNormalLength(const std::vector<unsigned char>& level)
+{
+    double sum = 0.0;
+    size_t pixelCount = level.size() / 4u;
+    for (size_t i = 0; i < pixelCount; i++)
+    {
+        float x = level[i * 4u] / 127.5f - 1.0f;
+        float y = level[i * 4u + 1u] / 127.5f - 1.0f;
+        float z = level[i * 4u + 2u] / 127.5f - 1.0f;
+        sum += std::sqrt(x * x + y * y + z * z);
+    }
+    return static_cast<float>(sum / std::max<size_t>(pixelCount, 1u));
+}
+
+void PrintQuality(const SourceImage& image, const MipSettings& settings)
+{
+    // glGenerateMipmap 的等价做法
+    MipSettings reference;
+    reference.Filter = MipFilter::Box;
+    reference.bSRGB = false;
+    reference.bWrap = settings.bWrap;
+    std::vector<std::vector<unsigned char>> referenceLevels, levels;
+    GenerateMipChain(image.Data, image.Width, image.Height, reference, referenceLevels);
+    GenerateMipChain(image.Data, image.Width, image.Height, settings, levels);
+    size_t mip = std::min<size_t>(4u, levels.size() - 1u);
+
+    std::cout << std::fixed << std::setprecision(3);
+    if (settings.bNormalMap)
+    {
+        std::cout << "  normal length: mip 0 " << GetMeanNormalLength(levels[0]) << ", mip " << mip << " box " << GetMeanNormalLength(referenceLevels[mip])
+                  << ", " << GetMipFilterName(settings.Filter) << " + renormalize " << GetMeanNormalLength(levels[mip]) << std::endl;
+    }
+    else
+    {
+        float base = GetMeanLuminance(levels[0]);
+        std::cout << "  luminance at mip " << mip << " / mip 0: gamma-space box " << GetMeanLuminance(referenceLevels[mip]) / base
+                  << ", " << GetMipFilterName(settings.Filter) << (settings.bSRGB ? " (linear)" : "") << " " << GetMeanLuminance(levels[mip]) / base << std::endl;
+    }
+    if (image.Channels == 4)
+    {
+        MipSettings coverage = settings;
+        coverage.AlphaCoverageReference = ALPHA_REFERENCE;
+        GenerateMipChain(image.Data, image.Width, image.Height, coverage, levels);
+        std::cout << "  alpha coverage (>= " << ALPHA_REFERENCE << ") box / preserved:";
+        for (size_t level = 0; level < std::min<size_t>(levels.size(), 8u); level++)
+        {
+            size_t pixelCount = levels[level].size() / 4u;
+            std::cout << "  " << GetAlphaCoverage(referenceLevels[level].data(), pixelCount, ALPHA_REFERENCE)
+                      << "/" << GetAlphaCoverage(levels[level].data(), pixelCount, ALPHA_REFERENCE);
+        }
+        std::cout << std::endl;
+    }
+}
+
+int main(int argc, char **argv)
+{
+    unsigned int threads = std::max(1u, std::thread::hardware_concurrency());
+    std::vector<std::string> inputs;
+    for (int i = 1; i < argc; i++)
+    {
+        std::string arg = argv[i];
+        if (arg.rfind("--threads=", 0) == 0)
+            threads = static_cast<unsigned int>(std::max(1, std::atoi(arg.c_str() + 10)));
+        else if (arg.rfind("--input=", 0) == 0)
+            inputs.push_back(arg.substr(8));
+    }
+    if (inputs.empty())
+    {
+        inputs =
+        {
+            "./res/models/nanosuit/body_dif.png",
+            "./res/models/nanosuit/body_showroom_ddn.png",
+            "./res/textures/grass.png",
+            "./res/textures/blending_transparent_window.png"
+        };
+    }
+
+    std::cout << "simd:";
+    for (int simd = 0; simd < static_cast<int>(MipSimd::Count); simd++)
+    {
+        if (IsMipSimdSupported(static_cast<MipSimd>(simd)))
+            std::cout << " " << GetMipSimdName(static_cast<MipSimd>(simd));
+    }
+    std::cout << ", " << threads << " threads, " << ITERATIONS << " iterations" << std::endl;
+
+    JobSystem jobs(threads);
+    for (const std::string& path : inputs)
+    {
+        SourceImage image;
+        image.Path = path;
+        image.Data = stbi_load(path.c_str(), &image.Width, &image.Height, &image.Channels, 4);
+        if (image.Data == nullptr)
+        {
+            std::cout << "Failed to load texture at path: " << path << std::endl;
+            continue;
+        }
+        // 和 TextureCompression.h 的规则一致：模型的 _ddn 是法线贴图，模型目录以外有 alpha 的图片边缘不环绕
+        MipSettings settings;
+        std::string stem = path.substr(0, path.find_last_of('.'));
+        settings.bNormalMap = stem.size() >= 4u && stem.compare(stem.size() - 4u, 4u, "_ddn") == 0;
+        settings.bWrap = image.Channels != 4 || path.find("/models/") != std::string::npos;
+        double megapixels = static_cast<double>(image.Width) * image.Height / 1e6;
+
+        std::cout << std::endl << path << " (" << image.Width << "x" << image.Height << ", " << image.Channels << " channels"
+                  << (settings.bNormalMap ? ", normal map" : "") << ")" << std::endl;
+        std::cout << std::left << std::setw(10) << "filter" << std::setw(10) << "simd" << std::right << std::setw(10) << "threads"
+                  << std::setw(12) << "time(ms)" << std::setw(10) << "MPix/s" << std::setw(12) << "identical" << std::endl;
+        for (int filter = 0; filter < static_cast<int>(MipFilter::Count); filter++)
+        {
+            settings.Filter = static_cast<MipFilter>(filter);
+            std::vector<std::vector<unsigned char>> scalarLevels, levels;
+            for (int simd = 0; simd < static_cast<int>(MipSimd::Count); simd++)
+            {
+                settings.Simd = static_cast<MipSimd>(simd);
+                if (!IsMipSimdSupported(settings.Simd))
+                    continue;
+                double ms = TimeMipChain(image, settings, nullptr, simd == 0 ? scalarLevels : levels);
+                std::cout << std::left << std::setw(10) << GetMipFilterName(settings.Filter) << std::setw(10) << GetMipSimdName(settings.Simd)
+                          << std::right << std::setw(10) << 1 << std::fixed << std::setprecision(2) << std::setw(12) << ms
+                          << std::setw(10) << megapixels * 1000.0 / ms << std::setw(12) << (simd == 0 ? "-" : (levels == scalarLevels ? "yes" : "NO")) << std::endl;
+            }
+            settings.Simd = GetBestMipSimd();
+            double ms = TimeMipChain(image, settings, &jobs, levels);
+            std::cout << std::left << std::setw(10) << GetMipFilterName(settings.Filter) << std::setw(10) << GetMipSimdName(settings.Simd)
+                      << std::right << std::setw(10) << threads << std::fixed << std::setprecision(2) << std::setw(12) << ms
+                      << std::setw(10) << megapixels * 1000.0 / ms << std::setw(12) << (levels == scalarLevels ? "yes" : "NO") << std::endl;
+        }
+
+        settings.Filter = MipFilter::Kaiser;
+        settings.Simd = GetBestMipSimd();
+        PrintQuality(image, settings);
+        stbi_image_free(image.Data);
+    }
+    return 0;
+}
@@ -0,0 +1,90 @@
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <cstdio>
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+
+#include <tool/Model.h>
+
+// 二进制网格缓存的冷/热启动对比
+// 运行：make run dir=Benchmark-ModelCache
+// 1. Assimp : 不使用缓存，每次都由 Assimp 解析
+// 2. Cold   : 删除缓存后加载（Assimp 解析 + 写缓存）
+// 3. Warm   : 缓存命中，直接映射缓存文件
+// 纹理由 TextureRegistry 共享，计时前先加载一次把纹理放进注册表，这样三列都只包含网格加载的开销
+
+double LoadModelMs(const std::string& path, bool useCache, bool& fromCache)
+{
+    auto start = std::chrono::high_resolution_clock::now();
+    Model model(path, false, useCache);
+    glFinish();
+    auto end = std::chrono::high_resolution_clock::now();
+    fromCache = model.LoadedFromCache;
+    return std::chrono::duration<double, std::milli>(end - start).count();
+}
+
+int main()
+{
+    // glfw and glad initialize
+    if (!glfwInit())
+        return -1;
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+    // 只需要 OpenGL 上下文，不显示窗口
+    glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+
+    GLFWwindow *window = glfwCreateWindow(64, 64, "LearnOpenGL", nullptr, nullptr);
+    if (window == nullptr)
+    {
+        std::cout << "Failed to Create GLFW Widnow!" << std::endl;
+        glfwTerminate();
+        return -1;
+    }
+    glfwMakeContextCurrent(window);
+
+    if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress))
+    {
+        std::cout << "Failed to Create GLFW Widnow!" << std::endl;
+        glfwTerminate();
+        return -1;
+    }
+
+    const char* models[] =
+    {
+        "./res/models/nanosuit/nanosuit.obj",
+        "./res/models/planet/planet.obj",
+        "./res/models/rock/rock.obj"
+    };
+
+    std::cout << std::left << std::setw(40) << "model"
+              << std::right << std::setw(12) << "assimp(ms)"
+              << std::setw(12) << "cold(ms)"
+              << std::setw(12) << "warm(ms)"
+              << std::setw(10) << "speedup" << std::endl;
+    for (const char* path : models)
+    {
+        bool fromCache = false;
+        LoadModelMs(path, false, fromCache);
+        double assimpMs = LoadModelMs(path, false, fromCache);
+
+        std::remove((std::string(path) + MESH_CACHE_EXTENSION).c_str());
+        double coldMs = LoadModelMs(path, true, fromCache);
+        double warmMs = LoadModelMs(path, true, fromCache);
+        if (!fromCache)
+            std::cout << "[MESH CACHE ERROR]: warm load did not hit the cache: " << path << std::endl;
+
+        std::cout << std::left << std::setw(40) << path << std::right << std::fixed << std::setprecision(2)
+                  << std::setw(12) << assimpMs
+                  << std::setw(12) << coldMs
+                  << std::setw(12) << warmMs
+                  << std::setw(9) << assimpMs / warmMs << "x" << std::endl;
+    }
+
+    TextureRegistry::Get().PrintStatistics();
+    TextureRegistry::Get().EvictUnused();
+
+    glfwTerminate();
+    return 0;
+}
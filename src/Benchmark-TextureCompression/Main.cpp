@@ -0,0 +1,187 @@
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <filesystem>
+#include <cctype>
+#include <cstdlib>
+#include <thread>
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+
+#include <tool/Model.h>
+
+// 纹理的离线块压缩（BC1/BC3/BC5/BC7）和加载对比
+// 运行：make run dir=Benchmark-TextureCompression（可选 args="--threads=N --bc7 --input=目录 --mip-filter=box|kaiser|lanczos --report-only"）
+// 1. 把 --input（默认 ./res/models 和 ./res/textures）下的图片压缩成 .dds 放在原图旁边，包含 CPU 生成的完整 mip 链
+//    （MipGenerator.h，默认 Kaiser），之后 TextureFromFile / Model 加载这些图片时直接上传压缩数据，不再调用 glGenerateMipmap
+// 2. 每个模型分别用原图和 .dds 加载（纹理都从注册表中清掉，重新解码/上传），输出纹理显存和加载时间（包括 glFinish）
+// --report-only 不重新压缩，只做第 2 步
+
+bool IsImageFile(const std::filesystem::path& path)
+{
+    std::string extension = path.extension().string();
+    std::transform(extension.begin(), extension.end(), extension.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+    return extension == ".png" || extension == ".jpg" || extension == ".jpeg" || extension == ".tga" || extension == ".bmp";
+}
+
+// 加载模型，返回耗时，textureBytes 为模型所有纹理的显存，compressedCount 为其中压缩纹理的数量
+double LoadModelMs(const std::string& path, size_t& textureBytes, unsigned int& compressedCount, unsigned int& textureCount)
+{
+    auto start = std::chrono::high_resolution_clock::now();
+    double loadMs = 0.0;
+    {
+        Model model(path);
+        glFinish();
+        loadMs = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+        textureBytes = 0u;
+        compressedCount = 0u;
+        textureCount = static_cast<unsigned int>(model.TexturesLoaded.size());
+        for (const Texture& texture : model.TexturesLoaded)
+        {
+            textureBytes += GetTextureMemorySize(texture.ID);
+            GLint compressed = GL_FALSE;
+            glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_COMPRESSED, &compressed);
+            if (compressed == GL_TRUE)
+                compressedCount++;
+        }
+    }
+    // 下一次加载重新解码/上传纹理
+    TextureRegistry::Get().EvictUnused();
+    return loadMs;
+}
+
+int main(int argc, char **argv)
+{
+    unsigned int threads = std::max(1u, std::thread::hardware_concurrency());
+    TextureCompressionSettings settings;
+    std::vector<std::string> inputs;
+    bool bReportOnly = false;
+    for (int i = 1; i < argc; i++)
+    {
+        std::string arg = argv[i];
+        if (arg.rfind("--threads=", 0) == 0)
+            threads = static_cast<unsigned int>(std::max(1, std::atoi(arg.c_str() + 10)));
+        else if (arg.rfind("--input=", 0) == 0)
+            inputs.push_back(arg.substr(8));
+        else if (arg == "--bc7")
+            settings.bUseBC7 = true;
+        else if (arg.rfind("--mip-filter=", 0) == 0)
+        {
+            for (int filter = 0; filter < static_cast<int>(MipFilter::Count); filter++)
+            {
+                if (arg.substr(13) == GetMipFilterName(static_cast<MipFilter>(filter)))
+                    settings.Filter = static_cast<MipFilter>(filter);
+            }
+        }
+        else if (arg == "--report-only")
+            bReportOnly = true;
+    }
+    if (inputs.empty())
+        inputs = { "./res/models", "./res/textures" };
+
+    if (!bReportOnly)
+    {
+        std::vector<std::string> files;
+        for (const std::string& input : inputs)
+        {
+            std::error_code error;
+            for (const auto& entry : std::filesystem::recursive_directory_iterator(input, error))
+            {
+                if (entry.is_regular_file() && IsImageFile(entry.path()))
+                    files.push_back(entry.path().generic_string());
+            }
+        }
+        std::sort(files.begin(), files.end());
+
+        std::cout << "compressing " << files.size() << " textures with " << threads << " threads" << (settings.bUseBC7 ? " (bc7)" : "")
+                  << ", " << GetMipFilterName(settings.Filter) << " mip filter (" << GetMipSimdName(GetBestMipSimd()) << ")" << std::endl;
+        std::cout << std::left << std::setw(56) << "texture" << std::right << std::setw(6) << "format" << std::setw(12) << "size"
+                  << std::setw(6) << "mips" << std::setw(12) << "raw(KB)" << std::setw(12) << "bcn(KB)" << std::setw(11) << "decode(ms)"
+                  << std::setw(9) << "mip(ms)" << std::setw(11) << "encode(ms)" << std::endl;
+        JobSystem jobs(threads);
+        uint64_t totalUncompressed = 0ull;
+        uint64_t totalCompressed = 0ull;
+        double totalEncodeMs = 0.0;
+        for (const std::string& file : files)
+        {
+            TextureCompressionResult result;
+            if (!CompressTextureFile(file, settings, &jobs, result))
+            {
+                std::cout << "Failed to compress texture: " << file << std::endl;
+                continue;
+            }
+            totalUncompressed += result.UncompressedBytes;
+            totalCompressed += result.CompressedBytes;
+            totalEncodeMs += result.MipMs + result.EncodeMs;
+            std::string size = std::to_string(result.Width) + "x" + std::to_string(result.Height);
+            std::cout << std::left << std::setw(56) << file << std::right << std::setw(6) << GetTextureBlockFormatName(result.Format)
+                      << std::setw(12) << size << std::setw(6) << result.MipCount << std::fixed << std::setprecision(1)
+                      << std::setw(12) << result.UncompressedBytes / 1024.0 << std::setw(12) << result.CompressedBytes / 1024.0
+                      << std::setw(11) << result.DecodeMs << std::setw(9) << result.MipMs << std::setw(11) << result.EncodeMs << std::endl;
+        }
+        std::cout << "total: " << std::setprecision(2) << totalUncompressed / (1024.0 * 1024.0) << " MB -> "
+                  << totalCompressed / (1024.0 * 1024.0) << " MB, encode " << std::setprecision(1) << totalEncodeMs << " ms" << std::endl;
+    }
+
+    // glfw and glad initialize
+    if (!glfwInit())
+        return -1;
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+    // 只需要 OpenGL 上下文，不显示窗口
+    glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+
+    GLFWwindow *window = glfwCreateWindow(64, 64, "LearnOpenGL", nullptr, nullptr);
+    if (window == nullptr)
+    {
+        std::cout << "Failed to Create GLFW Widnow!" << std::endl;
+        glfwTerminate();
+        return -1;
+    }
+    glfwMakeContextCurrent(window);
+
+    if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress))
+    {
+        std::cout << "Failed to Create GLFW Widnow!" << std::endl;
+        glfwTerminate();
+        return -1;
+    }
+
+    const char* models[] =
+    {
+        "./res/models/nanosuit/nanosuit.obj",
+        "./res/models/planet/planet.obj",
+        "./res/models/rock/rock.obj"
+    };
+
+    std::cout << std::left << std::setw(40) << "model" << std::right << std::setw(10) << "bcn/all"
+              << std::setw(12) << "raw(MB)" << std::setw(12) << "bcn(MB)" << std::setw(10) << "saved"
+              << std::setw(12) << "raw(ms)" << std::setw(12) << "bcn(ms)" << std::setw(10) << "speedup" << std::endl;
+    for (const char* path : models)
+    {
+        size_t rawBytes = 0u, compressedBytes = 0u;
+        unsigned int rawCount = 0u, compressedCount = 0u, textureCount = 0u;
+        // 第一次加载生成网格缓存，之后两次只有纹理的差别
+        CompressedTexturesEnabled() = false;
+        LoadModelMs(path, rawBytes, rawCount, textureCount);
+        double rawMs = LoadModelMs(path, rawBytes, rawCount, textureCount);
+        CompressedTexturesEnabled() = true;
+        double compressedMs = LoadModelMs(path, compressedBytes, compressedCount, textureCount);
+
+        std::string ratio = std::to_string(compressedCount) + "/" + std::to_string(textureCount);
+        std::cout << std::left << std::setw(40) << path << std::right << std::setw(10) << ratio << std::fixed << std::setprecision(2)
+                  << std::setw(12) << rawBytes / (1024.0 * 1024.0) << std::setw(12) << compressedBytes / (1024.0 * 1024.0)
+                  << std::setw(9) << (rawBytes > 0u ? 100.0 * (1.0 - static_cast<double>(compressedBytes) / rawBytes) : 0.0) << "%"
+                  << std::setw(12) << rawMs << std::setw(12) << compressedMs << std::setw(9) << rawMs / std::max(compressedMs, 1e-3) << "x" << std::endl;
+    }
+
+    TextureRegistry::Get().PrintStatistics();
+    TextureRegistry::Get().EvictUnused();
+
+    glfwTerminate();
+    return 0;
+}